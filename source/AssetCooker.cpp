@@ -0,0 +1,312 @@
+#include "pch.h"
+
+#include <cctype>
+#include <chrono>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <string_view>
+#include "MeshCooker.h"
+#include "MipGenerator.h"
+#include "ParallelFor.h"
+#include "SdfBaker.h"
+#include "TextureCooker.h"
+#include "VertexLightBaker.h"
+
+using namespace dae;
+
+//Cooks every OBJ and PNG under a directory into the files the renderer loads instead of its sources:
+//meshes with their levels of detail, optimized index order and compact vertices, textures with their mip chain,
+//and on request the signed distance field of every mesh.
+//Cooked files remember the size, timestamp and content hash of their source, only sources that changed get cooked again.
+//Settings an asset needs but its source can't say, like the blending of a mesh, live in a sidecar next to it: name.obj.cook.
+namespace
+{
+	//The layout Mesh loads OBJs in by default, cooked meshes in any other layout get cooked again by the renderer, baked ones aside
+	constexpr VertexLayout MeshLayout{ VertexLayout::CompactQuantized };
+	//gLightDirection of PosCol3D.fx, the light the opaque meshes are shaded with
+	const Vector3 BakedLightDirection{ Vector3{ .577f, -.577f, .577f }.Normalized() };
+
+	enum class AssetType
+	{
+		Mesh,
+		Texture,
+		//The signed distance field of an OBJ, cooked next to it as .sdf
+		Sdf
+	};
+
+	struct Asset
+	{
+		std::string path;
+		AssetType type;
+		uintmax_t size;
+		//Meshes drawn with a blending effect keep their triangle order
+		bool isOpaque;
+		//What a texture's texels hold
+		MipContent content;
+	};
+
+	struct Options
+	{
+		std::string directory{ "Resources" };
+		size_t numThreads{ Utils::GetWorkerCount() };
+		bool force{ false };
+		//Measure the overdraw of opaque meshes, it rasterizes every mesh from 16 views
+		bool printStats{ false };
+		MipFilter mipFilter{ MipFilter::Kaiser };
+		CompressionQuality compression{ CompressionQuality::High };
+		//Occlusion rays per vertex baked into opaque meshes, which then keep the full layout for its color, 0 bakes nothing
+		uint32_t lightSamples{ 0 };
+		//Voxels along the longest axis of the signed distance fields, 0 bakes none
+		uint32_t sdfResolution{ 0 };
+	};
+
+	void PrintUsage()
+	{
+		std::cout << "Usage: AssetCooker [--force] [--stats] [--threads <count>] [--mip-filter box|kaiser] [--compression none|fast|high] [--bake-light <rays>] [--sdf <resolution>] [directory]\n"
+			<< "Cooks every OBJ and PNG under directory, Resources by default, whose cooked file is missing or older than its source.\n"
+			<< "  --force              cook everything, up to date or not\n"
+			<< "  --stats              also print the overdraw of opaque meshes before and after sorting, slower\n"
+			<< "  --threads <count>    worker threads, every core by default\n"
+			<< "  --mip-filter <name>  filter the mips of textures with box or kaiser, kaiser by default\n"
+			<< "  --compression <name> block compress textures: none keeps RGBA8, fast uses BC1 for color maps, high BC7, the default\n"
+			<< "  --bake-light <rays>  bake ambient occlusion from rays per vertex and the effect's light into opaque meshes, " << VertexLightBaker::DefaultSampleCount
+			<< " is typical. They keep the full layout, the one with a vertex color\n"
+			<< "  --sdf <resolution>   also bake the signed distance field of every OBJ, resolution voxels along its longest axis, " << SdfBaker::DefaultResolution << " is typical\n"
+			<< "An OBJ drawn with a blending effect, like fireFX.obj, has a sidecar name.obj.cook that says blended, its triangle order is kept.\n"
+			<< "Textures named *_normal.png are filtered as normal maps, *_specular.png and *_gloss.png as they are stored, any other as sRGB colors.\n"
+			<< "Compressed normal maps keep x and y, specular and gloss maps red, the channels the effects read.\n";
+	}
+
+	bool ParseArguments(int argc, char* args[], Options& options)
+	{
+		for (int argIdx = 1; argIdx < argc; ++argIdx)
+		{
+			const std::string_view argument{ args[argIdx] };
+			if (argument == "--force")
+			{
+				options.force = true;
+			}
+			else if (argument == "--stats")
+			{
+				options.printStats = true;
+			}
+			else if (argument == "--threads" && argIdx + 1 < argc)
+			{
+				options.numThreads = std::max(std::strtoul(args[++argIdx], nullptr, 10), 1ul);
+			}
+			else if (argument == "--mip-filter" && argIdx + 1 < argc)
+			{
+				const std::string_view filter{ args[++argIdx] };
+				if (filter == "box")
+					options.mipFilter = MipFilter::Box;
+				else if (filter == "kaiser")
+					options.mipFilter = MipFilter::Kaiser;
+				else
+					return false;
+			}
+			else if (argument == "--compression" && argIdx + 1 < argc)
+			{
+				const std::string_view compression{ args[++argIdx] };
+				if (compression == "none")
+					options.compression = CompressionQuality::None;
+				else if (compression == "fast")
+					options.compression = CompressionQuality::Fast;
+				else if (compression == "high")
+					options.compression = CompressionQuality::High;
+				else
+					return false;
+			}
+			else if (argument == "--bake-light" && argIdx + 1 < argc)
+			{
+				const unsigned long numSamples{ std::strtoul(args[++argIdx], nullptr, 10) };
+				if (numSamples == 0 || numSamples > 4096)
+					return false;
+				options.lightSamples = static_cast<uint32_t>(numSamples);
+			}
+			else if (argument == "--sdf" && argIdx + 1 < argc)
+			{
+				const unsigned long resolution{ std::strtoul(args[++argIdx], nullptr, 10) };
+				if (resolution == 0 || resolution > 1024)
+					return false;
+				options.sdfResolution = static_cast<uint32_t>(resolution);
+			}
+			else if (!argument.empty() && argument[0] != '-')
+			{
+				options.directory = argument;
+			}
+			else
+			{
+				return false;
+			}
+		}
+		return true;
+	}
+
+	std::string ToLower(std::string text)
+	{
+		std::transform(text.begin(), text.end(), text.begin(), [](char c) { return static_cast<char>(std::tolower(static_cast<unsigned char>(c))); });
+		return text;
+	}
+
+	bool HasExtension(const std::filesystem::path& path, const char* extension)
+	{
+		return ToLower(path.extension().string()) == extension;
+	}
+
+	//Whitespace separated words in the sidecar of sourcePath, # starts a comment. No sidecar is no words.
+	std::vector<std::string> ReadSidecar(const std::filesystem::path& sourcePath)
+	{
+		std::vector<std::string> words{};
+		std::ifstream file{ sourcePath.string() + ".cook" };
+		std::string line{};
+		while (std::getline(file, line))
+		{
+			std::istringstream stream{ line.substr(0, line.find('#')) };
+			std::string word{};
+			while (stream >> word)
+				words.push_back(word);
+		}
+		return words;
+	}
+
+	//Meshes are opaque unless their sidecar says blended
+	bool IsOpaqueMesh(const std::filesystem::path& objPath)
+	{
+		bool isOpaque{ true };
+		for (const std::string& word : ReadSidecar(objPath))
+		{
+			if (word == "blended")
+				isOpaque = false;
+			else if (word != "opaque")
+				std::cout << "Unknown setting " << word << " in " << objPath.generic_string() << ".cook\n";
+		}
+		return isOpaque;
+	}
+
+	std::vector<Asset> FindAssets(const Options& options)
+	{
+		std::vector<Asset> assets{};
+		std::error_code error{};
+		for (const std::filesystem::directory_entry& entry : std::filesystem::recursive_directory_iterator{ options.directory, error })
+		{
+			if (!entry.is_regular_file())
+				continue;
+
+			const std::filesystem::path& path = entry.path();
+			if (HasExtension(path, ".obj"))
+			{
+				const bool isOpaque{ IsOpaqueMesh(path) };
+				assets.push_back(Asset{ path.generic_string(), AssetType::Mesh, entry.file_size(), isOpaque, MipContent::Color });
+				if (options.sdfResolution > 0)
+					assets.push_back(Asset{ path.generic_string(), AssetType::Sdf, entry.file_size(), isOpaque, MipContent::Color });
+			}
+			else if (HasExtension(path, ".png"))
+			{
+				assets.push_back(Asset{ path.generic_string(), AssetType::Texture, entry.file_size(), true, MipGenerator::GetContentFromName(path.generic_string()) });
+			}
+		}
+
+		//Directory order differs between file systems, the output shouldn't. A mesh and its field share their path.
+		std::sort(assets.begin(), assets.end(), [](const Asset& a, const Asset& b) { return a.path != b.path ? a.path < b.path : a.type < b.type; });
+		return assets;
+	}
+
+	//Blended meshes are drawn unlit, only opaque ones get the light baked
+	bool IsBaked(const Asset& asset, const Options& options)
+	{
+		return asset.isOpaque && options.lightSamples > 0;
+	}
+
+	bool IsUpToDate(const Asset& asset, const Options& options)
+	{
+		if (asset.type == AssetType::Mesh && IsBaked(asset, options))
+			return MeshCooker::IsUpToDate(asset.path, VertexLayout::Full, asset.isOpaque, &BakedLightDirection, options.lightSamples);
+		if (asset.type == AssetType::Mesh)
+			return MeshCooker::IsUpToDate(asset.path, MeshLayout, asset.isOpaque);
+		if (asset.type == AssetType::Sdf)
+			return SdfBaker::IsUpToDate(asset.path, options.sdfResolution);
+
+		return TextureCooker::IsUpToDate(asset.path, asset.content, options.mipFilter, options.compression);
+	}
+
+	bool Cook(const Asset& asset, const Options& options, size_t numThreads, std::ostream& log)
+	{
+		if (asset.type == AssetType::Mesh)
+		{
+			//The renderer's layout drops the vertex color, only the full layout has somewhere to bake the light into
+			CookedMeshData data{};
+			if (IsBaked(asset, options))
+				return MeshCooker::CookObj(asset.path, VertexLayout::Full, asset.isOpaque, &BakedLightDirection, options.lightSamples, numThreads, data, log, options.printStats);
+			return MeshCooker::CookObj(asset.path, MeshLayout, asset.isOpaque, nullptr, 0, numThreads, data, log, options.printStats);
+		}
+		if (asset.type == AssetType::Sdf)
+		{
+			SignedDistanceField field{};
+			return SdfBaker::CookObj(asset.path, options.sdfResolution, numThreads, field, log);
+		}
+
+		CookedTextureData data{};
+		return TextureCooker::CookPng(asset.path, asset.content, options.mipFilter, options.compression, numThreads, data, log);
+	}
+}
+
+int main(int argc, char* args[])
+{
+	Options options{};
+	if (!ParseArguments(argc, args, options))
+	{
+		PrintUsage();
+		return 1;
+	}
+
+	if (!std::filesystem::is_directory(options.directory))
+	{
+		std::cout << "No directory " << options.directory << "\n";
+		PrintUsage();
+		return 1;
+	}
+
+	const auto start = std::chrono::steady_clock::now();
+	std::vector<Asset> assets{ FindAssets(options) };
+	const size_t numAssets{ assets.size() };
+	if (!options.force)
+		assets.erase(std::remove_if(assets.begin(), assets.end(), [&](const Asset& asset) { return IsUpToDate(asset, options); }), assets.end());
+
+	//Assets are independent, each job cooks every numJobs-th one, largest first so the big ones don't all end up on one job.
+	//Threads left over when there are fewer assets than threads go to the assets themselves.
+	std::stable_sort(assets.begin(), assets.end(), [](const Asset& a, const Asset& b) { return a.size > b.size; });
+	const size_t numJobs{ std::min(options.numThreads, assets.size()) };
+	const size_t threadsPerAsset{ std::max(options.numThreads / std::max(numJobs, size_t{ 1 }), size_t{ 1 }) };
+	std::vector<std::string> logs(assets.size());
+	std::vector<uint8_t> results(assets.size());
+	Utils::ParallelFor(numJobs, numJobs, [&](size_t beginJob, size_t endJob)
+		{
+			for (size_t job = beginJob; job < endJob; ++job)
+			{
+				for (size_t assetIdx = job; assetIdx < assets.size(); assetIdx += numJobs)
+				{
+					const auto assetStart = std::chrono::steady_clock::now();
+					std::ostringstream log{};
+					results[assetIdx] = Cook(assets[assetIdx], options, threadsPerAsset, log);
+
+					const std::chrono::duration<float, std::milli> duration = std::chrono::steady_clock::now() - assetStart;
+					log << (results[assetIdx] ? "Cooked " : "Couldn't cook ") << assets[assetIdx].path << " in " << duration.count() << " ms\n";
+					logs[assetIdx] = log.str();
+				}
+			}
+		});
+
+	size_t numFailed{};
+	for (size_t assetIdx = 0; assetIdx < assets.size(); ++assetIdx)
+	{
+		std::cout << logs[assetIdx];
+		numFailed += results[assetIdx] == 0;
+	}
+
+	const std::chrono::duration<float, std::milli> duration = std::chrono::steady_clock::now() - start;
+	std::cout << numAssets << " assets in " << options.directory << ": " << assets.size() - numFailed << " cooked, " << numFailed << " failed, "
+		<< numAssets - assets.size() << " up to date, " << duration.count() << " ms on " << options.numThreads << " threads\n";
+	return numFailed == 0 ? 0 : 1;
+}
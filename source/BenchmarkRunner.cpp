@@ -0,0 +1,36 @@
+#include "pch.h"
+
+#include <cstdlib>
+#include <string_view>
+#include "Benchmarks.h"
+#include "ParallelFor.h"
+
+using namespace dae;
+
+//The renderer runs the benchmarks when built with DAE_BENCHMARK, this runs them without a window or a GPU
+int main(int argc, char* args[])
+{
+	std::string objPath{ "Resources/vehicle.obj" };
+	size_t numThreads{ Utils::GetWorkerCount() };
+	for (int argIdx = 1; argIdx < argc; ++argIdx)
+	{
+		const std::string_view argument{ args[argIdx] };
+		if (argument == "--threads" && argIdx + 1 < argc)
+		{
+			numThreads = std::max(std::strtoul(args[++argIdx], nullptr, 10), 1ul);
+		}
+		else if (!argument.empty() && argument[0] != '-')
+		{
+			objPath = argument;
+		}
+		else
+		{
+			std::cout << "Usage: BenchmarkRunner [--threads <count>] [OBJ file]\n"
+				<< "Times the CPU asset pipelines on the OBJ, Resources/vehicle.obj by default, and on synthetic meshes and images.\n"
+				<< "Exits with 1 when a benchmark's results don't check out.\n";
+			return 1;
+		}
+	}
+
+	return Benchmarks::Run(objPath, numThreads) ? 0 : 1;
+}
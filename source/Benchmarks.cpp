@@ -0,0 +1,658 @@
+#include "pch.h"
+#include "Benchmarks.h"
+
+#include <cfloat>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <filesystem>
+#include <random>
+#include "BlockCompressor.h"
+#include "HalfEdgeMesh.h"
+#include "MeshCodec.h"
+#include "MeshOptimizer.h"
+#include "MeshSplitter.h"
+#include "PngDecoder.h"
+#include "SdfBaker.h"
+#include "StaticBatcher.h"
+#include "TangentSpace.h"
+#include "TextureSampler.h"
+#include "Tests/ReferenceTextureSampler.h"
+#include "TriangleBvh.h"
+#include "Utils.h"
+#include "VertexLayout.h"
+#include "VertexLightBaker.h"
+
+namespace dae
+{
+	namespace Benchmarks
+	{
+		namespace
+		{
+			//Milliseconds job takes
+			template<typename Job>
+			float Time(const Job& job)
+			{
+				const auto start = std::chrono::steady_clock::now();
+				job();
+				const std::chrono::duration<float, std::milli> duration = std::chrono::steady_clock::now() - start;
+				return duration.count();
+			}
+
+			//Peak signal to noise ratio of image against reference over their first numChannels channels, in dB. Infinite when they're the same.
+			double GetPsnr(const Image& reference, const Image& image, uint32_t numChannels)
+			{
+				double squaredError{};
+				for (size_t i = 0; i < reference.pixels.size(); i += 4)
+				{
+					for (uint32_t channel = 0; channel < numChannels; ++channel)
+					{
+						const double difference{ static_cast<double>(reference.pixels[i + channel]) - image.pixels[i + channel] };
+						squaredError += difference * difference;
+					}
+				}
+				const double meanSquaredError{ squaredError / (static_cast<double>(reference.pixels.size() / 4) * numChannels) };
+				return 10.0 * std::log10(255.0 * 255.0 / meanSquaredError);
+			}
+
+			void GetBounds(const std::vector<Vertex>& vertices, Vector3& boundsMin, Vector3& boundsMax)
+			{
+				boundsMin = Vector3{ FLT_MAX, FLT_MAX, FLT_MAX };
+				boundsMax = Vector3{ -FLT_MAX, -FLT_MAX, -FLT_MAX };
+				for (const Vertex& vertex : vertices)
+				{
+					for (int axis = 0; axis < 3; ++axis)
+					{
+						boundsMin[axis] = std::min(boundsMin[axis], vertex.position[axis]);
+						boundsMax[axis] = std::max(boundsMax[axis], vertex.position[axis]);
+					}
+				}
+			}
+
+			//The number of rays is a multiple of TriangleBvh::PacketSize
+			struct Rays
+			{
+				std::vector<Vector3> origins{};
+				std::vector<Vector3> directions{};
+			};
+
+			//Distance to the closest hit of every ray, FLT_MAX for a miss. With usePackets consecutive rays are traced together.
+			std::vector<float> Trace(const TriangleBvh& bvh, const Rays& rays, bool usePackets, size_t numThreads)
+			{
+				constexpr uint32_t packetSize{ TriangleBvh::PacketSize };
+				std::vector<float> distances(rays.origins.size(), FLT_MAX);
+				Utils::ParallelFor(rays.origins.size() / packetSize, numThreads, [&](size_t begin, size_t end)
+					{
+						float maxDistances[packetSize];
+						std::fill(maxDistances, maxDistances + packetSize, FLT_MAX);
+						TriangleBvh::RayHit hits[packetSize]{};
+						for (size_t packet = begin; packet < end; ++packet)
+						{
+							const size_t first{ packet * packetSize };
+							if (usePackets)
+							{
+								const uint32_t hitMask{ bvh.IntersectPacket(&rays.origins[first], &rays.directions[first], maxDistances, hits) };
+								for (uint32_t ray = 0; ray < packetSize; ++ray)
+								{
+									if (hitMask & (1u << ray))
+										distances[first + ray] = hits[ray].distance;
+								}
+								continue;
+							}
+
+							for (size_t rayIdx = first; rayIdx < first + packetSize; ++rayIdx)
+							{
+								if (bvh.Intersect(rays.origins[rayIdx], rays.directions[rayIdx], FLT_MAX, hits[0]))
+									distances[rayIdx] = hits[0].distance;
+							}
+						}
+					});
+				return distances;
+			}
+
+			//Closest hit against every triangle, the same test the tree's leaves do
+			float IntersectBruteForce(const std::vector<Vertex>& vertices, const std::vector<uint32_t>& indices, const Vector3& origin, const Vector3& direction)
+			{
+				float closest{ FLT_MAX };
+				for (size_t index = 0; index + 2 < indices.size(); index += 3)
+				{
+					const Vector3& a = vertices[indices[index]].position;
+					const Vector3 ab{ vertices[indices[index + 1]].position - a };
+					const Vector3 ac{ vertices[indices[index + 2]].position - a };
+					const Vector3 p{ Vector3::Cross(direction, ac) };
+					const float determinant{ Vector3::Dot(ab, p) };
+					if (determinant == 0.f)
+						continue;
+
+					const float inverseDeterminant{ 1.f / determinant };
+					const Vector3 ao{ origin - a };
+					const float u{ Vector3::Dot(ao, p) * inverseDeterminant };
+					if (u < 0.f || u > 1.f)
+						continue;
+
+					const Vector3 q{ Vector3::Cross(ao, ab) };
+					const float v{ Vector3::Dot(direction, q) * inverseDeterminant };
+					if (v < 0.f || u + v > 1.f)
+						continue;
+
+					const float distance{ Vector3::Dot(ac, q) * inverseDeterminant };
+					if (distance > 0.f && distance < closest)
+						closest = distance;
+				}
+				return closest;
+			}
+		}
+
+		void CreateGrid(size_t numTriangles, std::vector<Vertex>& vertices, std::vector<uint32_t>& indices)
+		{
+			uint32_t numQuads{ 1 };
+			while (size_t(numQuads) * numQuads * 2 < numTriangles)
+				++numQuads;
+
+			const uint32_t numColumns{ numQuads + 1 };
+			vertices.resize(size_t(numColumns) * numColumns);
+			for (uint32_t y = 0; y < numColumns; ++y)
+			{
+				for (uint32_t x = 0; x < numColumns; ++x)
+				{
+					Vertex& vertex = vertices[size_t(y) * numColumns + x];
+					vertex.position = Vector3{ static_cast<float>(x), 0.f, static_cast<float>(y) };
+					vertex.uv = Vector2{ static_cast<float>(x) / numQuads, static_cast<float>(y) / numQuads };
+					vertex.normal = Vector3::UnitY;
+				}
+			}
+
+			indices.clear();
+			indices.reserve(size_t(numQuads) * numQuads * 6);
+			for (uint32_t y = 0; y < numQuads; ++y)
+			{
+				for (uint32_t x = 0; x < numQuads; ++x)
+				{
+					const uint32_t corner{ y * numColumns + x };
+					indices.insert(indices.end(), { corner, corner + numColumns, corner + 1, corner + 1, corner + numColumns, corner + numColumns + 1 });
+				}
+			}
+		}
+
+		void CreateImage(uint32_t width, uint32_t height, MipContent content, Image& image)
+		{
+			std::mt19937 generator{ 7 };
+			std::uniform_real_distribution<float> noise{ -.1f, .1f };
+			image.width = width;
+			image.height = height;
+			image.pixels.resize(size_t(width) * height * 4);
+			for (uint32_t y = 0; y < height; ++y)
+			{
+				for (uint32_t x = 0; x < width; ++x)
+				{
+					const float u{ static_cast<float>(x) / width };
+					const float v{ static_cast<float>(y) / height };
+					float texel[4]{ u + noise(generator), v + noise(generator), .5f + .5f * sinf(40.f * u * v) + noise(generator), 1.f - u * v };
+					if (content == MipContent::Normal)
+					{
+						//Bumps leaning up to 45 degrees, mapped to [0, 1]
+						const Vector3 normal{ Vector3{ texel[0] - .5f, texel[1] - .5f, 1.f }.Normalized() };
+						for (int axis = 0; axis < 3; ++axis)
+							texel[axis] = normal[axis] * .5f + .5f;
+					}
+
+					uint8_t* pTexel = image.pixels.data() + (size_t(y) * width + x) * 4;
+					for (int channel = 0; channel < 4; ++channel)
+						pTexel[channel] = static_cast<uint8_t>(std::clamp(texel[channel], 0.f, 1.f) * 255.f + .5f);
+				}
+			}
+		}
+
+		void BakeSdf(const std::vector<Vertex>& vertices, const std::vector<uint32_t>& indices, const std::vector<uint32_t>& resolutions, size_t numThreads)
+		{
+			for (const uint32_t resolution : resolutions)
+			{
+				SignedDistanceField field{};
+				const float serialTime{ Time([&]() { field = SdfBaker::Bake(vertices, indices, resolution, 1); }) };
+				const float parallelTime{ Time([&]() { field = SdfBaker::Bake(vertices, indices, resolution, numThreads); }) };
+
+				const float megaVoxels{ static_cast<float>(field.distances.size()) / 1e6f };
+				std::cout << "SDF " << resolution << ": " << field.dimensions[0] << "x" << field.dimensions[1] << "x" << field.dimensions[2]
+					<< ", 1 thread " << serialTime << " ms, " << numThreads << " threads " << parallelTime << " ms ("
+					<< megaVoxels / (parallelTime / 1000.f) << " Mvoxels/s, x" << serialTime / parallelTime << ")\n";
+			}
+		}
+
+		bool BakeVertexLighting(const std::vector<Vertex>& vertices, const std::vector<uint32_t>& indices, size_t numThreads)
+		{
+			const Vector3 lightDirection{ Vector3{ .577f, -.577f, .577f }.Normalized() };
+			std::vector<Vertex> serialVertices{ vertices };
+			std::vector<Vertex> parallelVertices{ vertices };
+			const float serialTime{ Time([&]() { VertexLightBaker::Bake(serialVertices, indices, &lightDirection, VertexLightBaker::DefaultSampleCount, 0, 1); }) };
+			const float parallelTime{ Time([&]() { VertexLightBaker::Bake(parallelVertices, indices, &lightDirection, VertexLightBaker::DefaultSampleCount, 0, numThreads); }) };
+
+			float occlusion{};
+			bool isSame{ true };
+			for (size_t vertexIdx = 0; vertexIdx < vertices.size(); ++vertexIdx)
+			{
+				const ColorRGB& serial = serialVertices[vertexIdx].color;
+				const ColorRGB& parallel = parallelVertices[vertexIdx].color;
+				isSame = isSame && serial.r == parallel.r && serial.g == parallel.g && serial.b == parallel.b;
+				occlusion += 1.f - serial.r;
+			}
+
+			//Every vertex casts its occlusion rays and one shadow ray
+			const float megaRays{ static_cast<float>(vertices.size()) * (VertexLightBaker::DefaultSampleCount + 1) / 1e6f };
+			std::cout << "Vertex lighting of " << vertices.size() << " vertices (mean occlusion " << (vertices.empty() ? 0.f : occlusion / vertices.size())
+				<< (isSame ? "" : ", DIFFERS BETWEEN THREAD COUNTS") << "): 1 thread " << serialTime << " ms, " << numThreads << " threads "
+				<< parallelTime << " ms (" << megaRays / (parallelTime / 1000.f) << " Mrays/s, x" << serialTime / parallelTime << ")\n";
+			return isSame;
+		}
+
+		bool BuildBvh(const std::vector<Vertex>& vertices, const std::vector<uint32_t>& indices, size_t numThreads)
+		{
+			TriangleBvh serialBvh{};
+			TriangleBvh parallelBvh{};
+			const float serialTime{ Time([&]() { serialBvh = TriangleBvh{ vertices, indices, 1 }; }) };
+			const float parallelTime{ Time([&]() { parallelBvh = TriangleBvh{ vertices, indices, numThreads }; }) };
+
+			const bool isSame{ serialBvh.GetNodeCount() == parallelBvh.GetNodeCount() && serialBvh.GetTriangleCount() == parallelBvh.GetTriangleCount() };
+			const float megaTriangles{ static_cast<float>(indices.size() / 3) / 1e6f };
+			std::cout << "BVH of " << indices.size() / 3 << " triangles (" << serialBvh.GetNodeCount() << " nodes"
+				<< (isSame ? "" : ", DIFFERS BETWEEN THREAD COUNTS") << "): 1 thread " << serialTime << " ms, " << numThreads << " threads "
+				<< parallelTime << " ms (" << megaTriangles / (parallelTime / 1000.f) << " Mtriangles/s, x" << serialTime / parallelTime << ")\n";
+			return isSame;
+		}
+
+		bool TraceRays(const std::vector<Vertex>& vertices, const std::vector<uint32_t>& indices, uint32_t numBruteForceRays, size_t numThreads)
+		{
+			constexpr uint32_t imageSize{ 512 };
+			const TriangleBvh bvh{ vertices, indices, numThreads };
+			Vector3 boundsMin{};
+			Vector3 boundsMax{};
+			GetBounds(vertices, boundsMin, boundsMax);
+			const Vector3 center{ (boundsMin + boundsMax) * .5f };
+			const float radius{ (boundsMax - boundsMin).Magnitude() * .5f };
+
+			//Camera above and in front of the mesh, 2x2 pixel quads make up a packet
+			Rays cameraRays{};
+			const Vector3 eye{ center + Vector3{ 0.f, radius * .5f, -radius * 1.5f } };
+			const Vector3 forward{ (center - eye).Normalized() };
+			const Vector3 right{ Vector3::Cross(Vector3::UnitY, forward).Normalized() };
+			const Vector3 up{ Vector3::Cross(forward, right) };
+			constexpr float fov{ .41421356f }; //tan(45 degrees / 2)
+			for (uint32_t quadY = 0; quadY < imageSize; quadY += 2)
+			{
+				for (uint32_t quadX = 0; quadX < imageSize; quadX += 2)
+				{
+					for (uint32_t pixel = 0; pixel < 4; ++pixel)
+					{
+						const float x{ (2.f * (quadX + (pixel & 1) + .5f) / imageSize - 1.f) * fov };
+						const float y{ (1.f - 2.f * (quadY + (pixel >> 1) + .5f) / imageSize) * fov };
+						cameraRays.origins.push_back(eye);
+						cameraRays.directions.push_back((forward + right * x + up * y).Normalized());
+					}
+				}
+			}
+
+			//Random points in the bounds, random directions
+			Rays randomRays{};
+			std::mt19937 generator{ 19 };
+			std::uniform_real_distribution<float> unit{ 0.f, 1.f };
+			while (randomRays.origins.size() < cameraRays.origins.size())
+			{
+				const Vector3 direction{ unit(generator) * 2.f - 1.f, unit(generator) * 2.f - 1.f, unit(generator) * 2.f - 1.f };
+				const float sqrLength{ direction.SqrMagnitude() };
+				if (sqrLength > 1.f || sqrLength < 1e-6f)
+					continue;
+
+				randomRays.origins.push_back(Vector3{ boundsMin.x + (boundsMax.x - boundsMin.x) * unit(generator),
+					boundsMin.y + (boundsMax.y - boundsMin.y) * unit(generator), boundsMin.z + (boundsMax.z - boundsMin.z) * unit(generator) });
+				randomRays.directions.push_back(direction / std::sqrt(sqrLength));
+			}
+
+			const float megaRays{ static_cast<float>(cameraRays.origins.size()) / 1e6f };
+			bool isCorrect{ true };
+			const auto report = [&](const char* name, const Rays& rays)
+				{
+					std::vector<float> singleDistances{};
+					std::vector<float> packetDistances{};
+					const float serialTime{ Time([&]() { singleDistances = Trace(bvh, rays, false, 1); }) };
+					const float parallelTime{ Time([&]() { singleDistances = Trace(bvh, rays, false, numThreads); }) };
+					const float packetTime{ Time([&]() { packetDistances = Trace(bvh, rays, true, numThreads); }) };
+
+					size_t numHits{};
+					for (const float distance : singleDistances)
+						numHits += distance < FLT_MAX;
+					isCorrect = isCorrect && singleDistances == packetDistances;
+
+					std::cout << name << " rays (" << 100.f * numHits / rays.origins.size() << "% hit" << (singleDistances == packetDistances ? "" : ", PACKETS DIFFER")
+						<< "): 1 thread " << megaRays / (serialTime / 1000.f) << " Mrays/s, " << numThreads << " threads " << megaRays / (parallelTime / 1000.f)
+						<< " Mrays/s, packets of " << TriangleBvh::PacketSize << " " << megaRays / (packetTime / 1000.f) << " Mrays/s\n";
+					return singleDistances;
+				};
+
+			std::cout << "Ray tracing " << indices.size() / 3 << " triangles, " << imageSize << "x" << imageSize << " rays:\n";
+			report("Camera", cameraRays);
+			const std::vector<float> randomDistances{ report("Random", randomRays) };
+
+			numBruteForceRays = std::min(numBruteForceRays, static_cast<uint32_t>(randomRays.origins.size()));
+			if (numBruteForceRays == 0)
+				return isCorrect;
+
+			size_t numDifferences{};
+			const float bruteForceTime{ Time([&]()
+				{
+					for (uint32_t rayIdx = 0; rayIdx < numBruteForceRays; ++rayIdx)
+						numDifferences += IntersectBruteForce(vertices, indices, randomRays.origins[rayIdx], randomRays.directions[rayIdx]) != randomDistances[rayIdx];
+				}) };
+			std::cout << "Brute force on " << numBruteForceRays << " random rays" << (numDifferences == 0 ? "" : ", DIFFERS FROM THE BVH") << ": 1 thread "
+				<< static_cast<float>(numBruteForceRays) / 1e6f / (bruteForceTime / 1000.f) << " Mrays/s\n";
+			return isCorrect && numDifferences == 0;
+		}
+
+		bool GenerateTangents(const std::vector<Vertex>& vertices, const std::vector<uint32_t>& indices, size_t numThreads)
+		{
+			std::vector<Vertex> serialVertices{ vertices };
+			std::vector<uint32_t> serialIndices{ indices };
+			std::vector<Vertex> parallelVertices{ vertices };
+			std::vector<uint32_t> parallelIndices{ indices };
+			const float serialTime{ Time([&]() { TangentSpace::Generate(serialVertices, serialIndices, 1); }) };
+			const float parallelTime{ Time([&]() { TangentSpace::Generate(parallelVertices, parallelIndices, numThreads); }) };
+
+			//Mirrored uvs split vertices, both runs have to split the same ones
+			const bool isSame{ serialIndices == parallelIndices && serialVertices.size() == parallelVertices.size() &&
+				std::memcmp(serialVertices.data(), parallelVertices.data(), serialVertices.size() * sizeof(Vertex)) == 0 };
+			const float megaTriangles{ static_cast<float>(indices.size() / 3) / 1e6f };
+			std::cout << "Tangents of " << indices.size() / 3 << " triangles (" << serialVertices.size() - vertices.size() << " vertices split"
+				<< (isSame ? "" : ", DIFFERS BETWEEN THREAD COUNTS") << "): 1 thread " << serialTime << " ms, " << numThreads << " threads "
+				<< parallelTime << " ms (" << megaTriangles / (parallelTime / 1000.f) << " Mtriangles/s, x" << serialTime / parallelTime << ")\n";
+			return isSame;
+		}
+
+		void BuildHalfEdges(const std::vector<Vertex>& vertices, const std::vector<uint32_t>& indices, size_t numThreads)
+		{
+			uint32_t numBorders{};
+			const float serialTime{ Time([&]() { numBorders = HalfEdgeMesh{ vertices, indices, 1 }.GetBorderCount(); }) };
+			const float parallelTime{ Time([&]() { numBorders = HalfEdgeMesh{ vertices, indices, numThreads }.GetBorderCount(); }) };
+
+			const float megaTriangles{ static_cast<float>(indices.size() / 3) / 1e6f };
+			std::cout << "Half-edges of " << indices.size() / 3 << " triangles (" << numBorders << " border edges): 1 thread " << serialTime << " ms, "
+				<< numThreads << " threads " << parallelTime << " ms (" << megaTriangles / (parallelTime / 1000.f) << " Mtriangles/s, x"
+				<< serialTime / parallelTime << ")\n";
+		}
+
+		bool CompressMesh(const std::vector<Vertex>& vertices, const std::vector<uint32_t>& indices, size_t sourceSize, size_t numThreads)
+		{
+			//Cooked meshes are in vertex cache and fetch order, which is what the index codec predicts best
+			std::vector<Vertex> orderedVertices{ vertices };
+			std::vector<uint32_t> orderedIndices{ indices };
+			MeshOptimizer::OptimizeVertexCache(orderedIndices, orderedVertices.size());
+			MeshOptimizer::OptimizeVertexFetch(orderedVertices, orderedIndices);
+			const EncodedIndices encodedIndices = MeshSplitter::EncodeShortIndices(orderedVertices, orderedIndices);
+
+			constexpr VertexLayout layouts[]{ VertexLayout::Full, VertexLayout::Compact, VertexLayout::CompactQuantized };
+			constexpr const char* layoutNames[]{ "full", "compact", "quantized" };
+			bool isCorrect{ true };
+			for (size_t layoutIdx = 0; layoutIdx < std::size(layouts); ++layoutIdx)
+			{
+				const EncodedVertices encodedVertices = VertexCodec::Encode(orderedVertices, layouts[layoutIdx]);
+				const size_t rawSize{ encodedVertices.data.size() + encodedIndices.data.size() };
+
+				std::vector<uint8_t> vertexData{};
+				std::vector<uint8_t> indexData{};
+				const float encodeTime{ Time([&]()
+					{
+						vertexData = MeshCodec::EncodeVertices(encodedVertices.data.data(), encodedVertices.count, encodedVertices.stride);
+						indexData = MeshCodec::EncodeIndices(encodedIndices.data.data(), encodedIndices.count, encodedIndices.stride);
+					}) };
+
+				std::vector<uint8_t> decodedVertices(encodedVertices.data.size());
+				std::vector<uint8_t> decodedIndices(encodedIndices.data.size());
+				bool isDecoded{};
+				const auto decode = [&](size_t decodeThreads)
+					{
+						isDecoded = MeshCodec::DecodeVertices(decodedVertices.data(), encodedVertices.count, encodedVertices.stride, vertexData.data(), vertexData.size(), decodeThreads) &&
+							MeshCodec::DecodeIndices(decodedIndices.data(), encodedIndices.count, encodedIndices.stride, indexData.data(), indexData.size(), decodeThreads);
+					};
+				const float serialTime{ Time([&]() { decode(1); }) };
+				const float parallelTime{ Time([&]() { decode(numThreads); }) };
+
+				if (!isDecoded || decodedVertices != encodedVertices.data || decodedIndices != encodedIndices.data)
+				{
+					std::cout << "Mesh codec, " << layoutNames[layoutIdx] << " layout: ROUND TRIP FAILED\n";
+					isCorrect = false;
+					continue;
+				}
+
+				const float rawMegabytes{ static_cast<float>(rawSize) / 1e6f };
+				const size_t compressedSize{ vertexData.size() + indexData.size() };
+				std::cout << "Mesh codec, " << layoutNames[layoutIdx] << " layout: " << rawSize << " -> " << compressedSize << " bytes ("
+					<< static_cast<float>(compressedSize) / (sourceSize > 0 ? sourceSize : rawSize) << " of " << (sourceSize > 0 ? "the source" : "raw")
+					<< "; vertices " << static_cast<float>(vertexData.size()) / encodedVertices.data.size() << ", indices "
+					<< static_cast<float>(indexData.size()) / encodedIndices.data.size() << "), encode " << rawMegabytes / (encodeTime / 1000.f)
+					<< " MB/s, decode 1 thread " << rawMegabytes / (serialTime / 1000.f) << " MB/s, " << numThreads << " threads "
+					<< rawMegabytes / (parallelTime / 1000.f) << " MB/s\n";
+			}
+			return isCorrect;
+		}
+
+		bool GenerateMips(const Image& image, MipContent content, size_t numThreads)
+		{
+			constexpr const char* contentNames[]{ "color", "linear", "normal" };
+			constexpr const char* filterNames[]{ "box", "kaiser" };
+			bool isCorrect{ true };
+			for (const MipFilter filter : { MipFilter::Box, MipFilter::Kaiser })
+			{
+				std::vector<Image> serialMips{};
+				std::vector<Image> parallelMips{};
+				const float serialTime{ Time([&]() { serialMips = MipGenerator::Generate(image, content, filter, 1); }) };
+				const float parallelTime{ Time([&]() { parallelMips = MipGenerator::Generate(image, content, filter, numThreads); }) };
+
+				bool isSame{ serialMips.size() == parallelMips.size() };
+				for (size_t level = 0; isSame && level < serialMips.size(); ++level)
+					isSame = serialMips[level].pixels == parallelMips[level].pixels;
+				isCorrect = isCorrect && isSame;
+
+				//Throughput in texels of the image the chain starts from
+				const float megaTexels{ static_cast<float>(image.width) * image.height / 1e6f };
+				std::cout << "Mips of a " << image.width << "x" << image.height << " " << contentNames[static_cast<uint32_t>(content)] << " image, "
+					<< filterNames[static_cast<uint32_t>(filter)] << " filter (" << serialMips.size() << " levels" << (isSame ? "" : ", DIFFERS BETWEEN THREAD COUNTS")
+					<< "): 1 thread " << serialTime << " ms, " << numThreads << " threads " << parallelTime << " ms ("
+					<< megaTexels / (parallelTime / 1000.f) << " Mtexels/s, x" << serialTime / parallelTime << ")\n";
+			}
+			return isCorrect;
+		}
+
+		bool CompressTexture(const Image& image, MipContent content, size_t numThreads)
+		{
+			constexpr const char* formatNames[]{ "R8G8B8A8", "BC1", "BC4", "BC5", "BC7" };
+			constexpr uint32_t numChannels[]{ 4, 3, 1, 2, 4 };
+			constexpr const char* qualityNames[]{ "none", "fast", "high" };
+
+			//Color gets BC1 when opaque and quality allows, compare it with BC7 either way
+			std::vector<TextureFormat> formats{};
+			switch (content)
+			{
+			case MipContent::Normal:
+				formats = { TextureFormat::BC5 };
+				break;
+			case MipContent::Linear:
+				formats = { TextureFormat::BC4 };
+				break;
+			default:
+				formats = { TextureFormat::BC1, TextureFormat::BC7 };
+				break;
+			}
+
+			bool isCorrect{ true };
+			for (const TextureFormat format : formats)
+			{
+				for (const CompressionQuality quality : { CompressionQuality::Fast, CompressionQuality::High })
+				{
+					std::vector<uint8_t> serialBlocks{};
+					std::vector<uint8_t> parallelBlocks{};
+					const float serialTime{ Time([&]() { serialBlocks = BlockCompressor::Encode(image, format, quality, 1); }) };
+					const float parallelTime{ Time([&]() { parallelBlocks = BlockCompressor::Encode(image, format, quality, numThreads); }) };
+
+					Image decoded{};
+					const bool isDecoded{ BlockCompressor::Decode(parallelBlocks.data(), image.width, image.height, format, decoded) };
+					isCorrect = isCorrect && isDecoded && serialBlocks == parallelBlocks;
+
+					const float megaTexels{ static_cast<float>(image.width) * image.height / 1e6f };
+					const uint32_t formatIndex{ static_cast<uint32_t>(format) };
+					std::cout << formatNames[formatIndex] << " " << qualityNames[static_cast<uint32_t>(quality)] << " (" << image.pixels.size() / parallelBlocks.size()
+						<< ":1" << (serialBlocks == parallelBlocks ? "" : ", DIFFERS BETWEEN THREAD COUNTS") << "): ";
+					if (isDecoded)
+						std::cout << GetPsnr(image, decoded, numChannels[formatIndex]) << " dB, ";
+					else
+						std::cout << "DOESN'T DECODE, ";
+					std::cout << "1 thread " << serialTime << " ms, " << numThreads << " threads " << parallelTime << " ms ("
+						<< megaTexels / (parallelTime / 1000.f) << " Mtexels/s, x" << serialTime / parallelTime << ")\n";
+				}
+			}
+			return isCorrect;
+		}
+
+		bool SampleTexture(const Image& image, MipContent content, size_t numSamples)
+		{
+			const std::vector<Image> mips{ MipGenerator::Generate(image, content, MipFilter::Kaiser) };
+			TextureSampler sampler{ mips, content };
+
+			//A few times around the texture and every level of detail
+			std::mt19937 generator{ 11 };
+			std::uniform_real_distribution<float> coordinate{ -2.f, 3.f };
+			std::uniform_real_distribution<float> levelOfDetail{ 0.f, static_cast<float>(mips.size()) };
+			std::vector<Vector2> uvs(numSamples);
+			std::vector<float> lods(numSamples);
+			for (size_t sample = 0; sample < numSamples; ++sample)
+			{
+				uvs[sample] = Vector2{ coordinate(generator), coordinate(generator) };
+				lods[sample] = levelOfDetail(generator);
+			}
+
+			constexpr const char* filterNames[]{ "point", "bilinear", "trilinear" };
+			constexpr const char* addressNames[]{ "wrap", "clamp", "mirror" };
+			constexpr size_t numReferenceSamples{ 10'000 };
+			std::vector<Vector4> texels(numSamples);
+			std::vector<Vector4> batchedTexels(numSamples);
+			bool isCorrect{ true };
+			for (const SampleFilter filter : { SampleFilter::Point, SampleFilter::Bilinear, SampleFilter::Trilinear })
+			{
+				for (const AddressMode addressMode : { AddressMode::Wrap, AddressMode::Clamp, AddressMode::Mirror })
+				{
+					sampler.SetFilter(filter);
+					sampler.SetAddressMode(addressMode);
+					const float singleTime{ Time([&]()
+						{
+							for (size_t sample = 0; sample < numSamples; ++sample)
+								texels[sample] = sampler.Sample(uvs[sample], lods[sample]);
+						}) };
+					const float batchTime{ Time([&]() { sampler.SampleN(uvs.data(), lods.data(), numSamples, batchedTexels.data()); }) };
+
+					const bool isSame{ std::memcmp(texels.data(), batchedTexels.data(), numSamples * sizeof(Vector4)) == 0 };
+					isCorrect = isCorrect && isSame;
+					float maxError{};
+					for (size_t sample = 0; sample < std::min(numSamples, numReferenceSamples); ++sample)
+					{
+						const Vector4 reference{ Tests::SampleReference(mips, content, filter, addressMode, uvs[sample], lods[sample]) };
+						for (int channel = 0; channel < 4; ++channel)
+							maxError = std::max(maxError, std::abs(reference[channel] - texels[sample][channel]));
+					}
+
+					const bool isAccurate{ maxError <= Tests::MaxSampleError };
+					isCorrect = isCorrect && isAccurate;
+
+					const float megaSamples{ numSamples / 1e6f };
+					std::cout << "Sampling " << filterNames[static_cast<uint32_t>(filter)] << " " << addressNames[static_cast<uint32_t>(addressMode)]
+						<< (isSame ? "" : ", BATCHES DIFFER FROM SINGLE SAMPLES") << (isAccurate ? "" : ", OFF THE REFERENCE") << ": one at a time " << megaSamples / (singleTime / 1000.f) << " Msamples/s, "
+						<< TextureSampler::BatchSize << " at a time " << megaSamples / (batchTime / 1000.f) << " Msamples/s (x" << singleTime / batchTime
+						<< "), max error " << maxError << "\n";
+				}
+			}
+			return isCorrect;
+		}
+
+		bool Run(const std::string& objPath, size_t numThreads)
+		{
+			std::vector<Vertex> vertices{};
+			std::vector<uint32_t> indices{};
+			bool isCorrect{ true };
+			if (Utils::ParseOBJ(objPath, vertices, indices, true, true, numThreads))
+			{
+				std::cout << objPath << ":\n";
+				BakeSdf(vertices, indices, { 32, 64, 128, 256 }, numThreads);
+				isCorrect = BakeVertexLighting(vertices, indices, numThreads) && isCorrect;
+				isCorrect = GenerateTangents(vertices, indices, numThreads) && isCorrect;
+				BuildHalfEdges(vertices, indices, numThreads);
+
+				std::error_code error{};
+				const uintmax_t objSize{ std::filesystem::file_size(objPath, error) };
+				isCorrect = CompressMesh(vertices, indices, error ? 0 : static_cast<size_t>(objSize), numThreads) && isCorrect;
+				isCorrect = BuildBvh(vertices, indices, numThreads) && isCorrect;
+				isCorrect = TraceRays(vertices, indices, 4096, numThreads) && isCorrect;
+
+				//A lot of the same mesh merged into one, the size of a level rather than a single prop
+				constexpr int sceneSize{ 10 };
+				Vector3 boundsMin{};
+				Vector3 boundsMax{};
+				GetBounds(vertices, boundsMin, boundsMax);
+				const float spacing{ (boundsMax - boundsMin).Magnitude() };
+				std::vector<StaticInstance> instances{};
+				for (int z = 0; z < sceneSize; ++z)
+				{
+					for (int x = 0; x < sceneSize; ++x)
+					{
+						const Matrix world{ Matrix::CreateRotationY(static_cast<float>(x * sceneSize + z)) * Matrix::CreateTranslation(x * spacing, 0.f, z * spacing) };
+						instances.push_back(StaticInstance{ &vertices, &indices, nullptr, world });
+					}
+				}
+
+				const StaticBatch scene{ StaticBatcher::Merge(instances, numThreads) };
+				std::cout << sceneSize * sceneSize << " instances of " << objPath << ":\n";
+				isCorrect = BuildBvh(scene.vertices, scene.indices, numThreads) && isCorrect;
+				isCorrect = TraceRays(scene.vertices, scene.indices, 0, numThreads) && isCorrect;
+			}
+
+			//The textures next to the OBJ, compressed the way the cooker does
+			std::filesystem::path directory{ std::filesystem::path{ objPath }.parent_path() };
+			if (directory.empty())
+				directory = ".";
+			std::error_code error{};
+			std::vector<std::filesystem::path> texturePaths{};
+			for (const std::filesystem::directory_entry& entry : std::filesystem::directory_iterator{ directory, error })
+			{
+				if (entry.is_regular_file(error) && entry.path().extension() == ".png")
+					texturePaths.push_back(entry.path());
+			}
+			std::sort(texturePaths.begin(), texturePaths.end());
+			for (const std::filesystem::path& path : texturePaths)
+			{
+				Image image{};
+				if (!PngDecoder::DecodeFile(path.string(), image))
+					continue;
+
+				std::cout << path.generic_string() << " (" << image.width << "x" << image.height << "):\n";
+				isCorrect = CompressTexture(image, MipGenerator::GetContentFromName(path.generic_string()), numThreads) && isCorrect;
+			}
+
+			std::cout << "Synthetic grids:\n";
+			CreateGrid(5'000'000, vertices, indices);
+			isCorrect = GenerateTangents(vertices, indices, numThreads) && isCorrect;
+			CreateGrid(10'000'000, vertices, indices);
+			BuildHalfEdges(vertices, indices, numThreads);
+			isCorrect = CompressMesh(vertices, indices, 0, numThreads) && isCorrect;
+
+			std::cout << "Texture sampling of a 1K image:\n";
+			{
+				Image image{};
+				CreateImage(1024, 1024, MipContent::Color, image);
+				isCorrect = SampleTexture(image, MipContent::Color, 4'000'000) && isCorrect;
+			}
+
+			std::cout << "Synthetic 4K images:\n";
+			for (const MipContent content : { MipContent::Color, MipContent::Linear, MipContent::Normal })
+			{
+				Image image{};
+				CreateImage(4096, 4096, content, image);
+				isCorrect = GenerateMips(image, content, numThreads) && isCorrect;
+			}
+			return isCorrect;
+		}
+	}
+}
@@ -0,0 +1,47 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "Image.h"
+#include "MipGenerator.h"
+#include "Vertex.h"
+
+namespace dae
+{
+	//Headless timings of the CPU asset pipelines, printed to std::cout.
+	//The ones that check their results print what differs in capitals and return false then.
+	namespace Benchmarks
+	{
+		//Flat grid of at least numTriangles triangles, a stand-in for meshes far larger than the ones in Resources
+		void CreateGrid(size_t numTriangles, std::vector<Vertex>& vertices, std::vector<uint32_t>& indices);
+		//Smooth gradients under noise with the texels content stands for, a stand-in for textures far larger than the ones in Resources
+		void CreateImage(uint32_t width, uint32_t height, MipContent content, Image& image);
+
+		void BakeSdf(const std::vector<Vertex>& vertices, const std::vector<uint32_t>& indices, const std::vector<uint32_t>& resolutions, size_t numThreads);
+		//Ambient occlusion with the default sample count and a light, checks that the thread count doesn't change the result
+		bool BakeVertexLighting(const std::vector<Vertex>& vertices, const std::vector<uint32_t>& indices, size_t numThreads);
+		//Builds the ray tracing tree on one and on numThreads threads, checks both come out the same
+		bool BuildBvh(const std::vector<Vertex>& vertices, const std::vector<uint32_t>& indices, size_t numThreads);
+		//Closest hits of a camera's rays through every pixel of an image and of as many rays from random points in random directions,
+		//one ray at a time and in packets. Checks packets against single rays and, on numBruteForceRays of the random rays, against every triangle.
+		bool TraceRays(const std::vector<Vertex>& vertices, const std::vector<uint32_t>& indices, uint32_t numBruteForceRays, size_t numThreads);
+		//Tangent frames on one and on numThreads threads, checks both come out the same
+		bool GenerateTangents(const std::vector<Vertex>& vertices, const std::vector<uint32_t>& indices, size_t numThreads);
+		void BuildHalfEdges(const std::vector<Vertex>& vertices, const std::vector<uint32_t>& indices, size_t numThreads);
+		//Compresses the mesh in every vertex layout the way it gets cooked and checks that it decodes back unchanged.
+		//sourceSize is what the ratio is taken against, the uncompressed buffers when 0.
+		bool CompressMesh(const std::vector<Vertex>& vertices, const std::vector<uint32_t>& indices, size_t sourceSize, size_t numThreads);
+		//The full mip chain with every filter, checks that the thread count doesn't change it
+		bool GenerateMips(const Image& image, MipContent content, size_t numThreads);
+		//Block compresses the image into the formats its content gets cooked to at every quality, decodes it back and prints the PSNR
+		//over the channels each format keeps. Checks that the thread count doesn't change the blocks.
+		bool CompressTexture(const Image& image, MipContent content, size_t numThreads);
+
+		//numSamples random UVs and levels of detail through TextureSampler one at a time and in batches, with every filter and address mode.
+		//Checks batches against single samples and single samples against a plain sampler on the rows of the mips, to within Tests::MaxSampleError.
+		bool SampleTexture(const Image& image, MipContent content, size_t numSamples);
+
+		//Every benchmark on the OBJ at objPath and on synthetic meshes, on one thread and on numThreads threads
+		bool Run(const std::string& objPath, size_t numThreads);
+	}
+}
@@ -0,0 +1,1058 @@
+#include "pch.h"
+#include "BlockCompressor.h"
+
+#include <cfloat>
+#include <cmath>
+#include <cstring>
+#include "ParallelFor.h"
+
+namespace dae
+{
+	namespace BlockCompressor
+	{
+		namespace
+		{
+			constexpr uint32_t BlockTexels{ 16 };
+
+			//Texels of BC7's 64 two subset partitions that belong to the second subset, bit i for texel i
+			constexpr uint16_t Partitions2[64]
+			{
+				0xCCCC, 0x8888, 0xEEEE, 0xECC8, 0xC880, 0xFEEC, 0xFEC8, 0xEC80, 0xC800, 0xFFEC, 0xFE80, 0xE800, 0xFFE8, 0xFF00, 0xFFF0, 0xF000,
+				0xF710, 0x008E, 0x7100, 0x08CE, 0x008C, 0x7310, 0x3100, 0x8CCE, 0x088C, 0x3110, 0x6666, 0x366C, 0x17E8, 0x0FF0, 0x718E, 0x399C,
+				0xAAAA, 0xF0F0, 0x5A5A, 0x33CC, 0x3C3C, 0x55AA, 0x9696, 0xA55A, 0x73CE, 0x13C8, 0x324C, 0x3BDC, 0x6996, 0xC33C, 0x9966, 0x0660,
+				0x0272, 0x04E4, 0x4E40, 0x2720, 0xC936, 0x936C, 0x39C6, 0x639C, 0x9336, 0x9CC6, 0x817E, 0xE718, 0xCCF0, 0x0FCC, 0x7744, 0xEE22
+			};
+
+			//Texel of the second subset whose index drops its top bit, the first subset's is always texel 0
+			constexpr uint8_t Anchors2[64]
+			{
+				15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15,
+				15, 2, 8, 2, 2, 8, 8, 15, 2, 8, 2, 2, 8, 8, 2, 2,
+				15, 15, 6, 8, 2, 8, 15, 15, 2, 8, 2, 2, 2, 15, 15, 6,
+				6, 2, 6, 8, 15, 15, 2, 2, 15, 15, 15, 15, 15, 2, 2, 15
+			};
+
+			//Interpolation weights of BC7's 3 and 4 bit indices, in 64ths
+			constexpr uint8_t Bc7Weights3[8]{ 0, 9, 18, 27, 37, 46, 55, 64 };
+			constexpr uint8_t Bc7Weights4[16]{ 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+
+			//Texels of a 4x4 block row by row, or of one subset of it
+			struct Points
+			{
+				uint8_t texels[BlockTexels][4];
+				uint32_t count;
+			};
+
+			void ReadBlock(const Image& image, uint32_t blockX, uint32_t blockY, Points& block)
+			{
+				for (uint32_t y = 0; y < 4; ++y)
+				{
+					const uint32_t imageY{ std::min(blockY * 4 + y, image.height - 1) };
+					for (uint32_t x = 0; x < 4; ++x)
+					{
+						const uint32_t imageX{ std::min(blockX * 4 + x, image.width - 1) };
+						std::memcpy(block.texels[y * 4 + x], image.pixels.data() + (size_t(imageY) * image.width + imageX) * 4, 4);
+					}
+				}
+				block.count = BlockTexels;
+			}
+
+			//BC7 blocks are a stream of fields from the least significant bit of the first byte on, the data starts zeroed
+			class BitWriter final
+			{
+			public:
+				explicit BitWriter(uint8_t* pData) : m_pData{ pData } {}
+
+				void Write(uint32_t value, uint32_t numBits)
+				{
+					for (uint32_t bit = 0; bit < numBits; ++bit, ++m_Position)
+						m_pData[m_Position >> 3] |= static_cast<uint8_t>(((value >> bit) & 1u) << (m_Position & 7));
+				}
+
+			private:
+				uint8_t* m_pData;
+				uint32_t m_Position{};
+			};
+
+			class BitReader final
+			{
+			public:
+				explicit BitReader(const uint8_t* pData) : m_pData{ pData } {}
+
+				uint32_t Read(uint32_t numBits)
+				{
+					uint32_t value{};
+					for (uint32_t bit = 0; bit < numBits; ++bit, ++m_Position)
+						value |= ((m_pData[m_Position >> 3] >> (m_Position & 7)) & 1u) << bit;
+					return value;
+				}
+
+			private:
+				const uint8_t* m_pData;
+				uint32_t m_Position{};
+			};
+
+			//Replicates the top bits into the bottom ones, the way the GPU widens endpoints to 8 bits
+			uint8_t ExpandBits(uint32_t value, uint32_t numBits)
+			{
+				return static_cast<uint8_t>((value << (8 - numBits)) | (value >> (2 * numBits - 8)));
+			}
+
+			//---------------------
+			// BC4
+			//---------------------
+
+			//The 8 values a BC4 block's 3 bit indices pick from. Endpoint 0 above endpoint 1 interpolates 6 values, else 4 and adds 0 and 255.
+			void GetBc4Palette(uint32_t endpoint0, uint32_t endpoint1, uint32_t palette[8])
+			{
+				palette[0] = endpoint0;
+				palette[1] = endpoint1;
+				if (endpoint0 > endpoint1)
+				{
+					for (uint32_t index = 2; index < 8; ++index)
+						palette[index] = ((8 - index) * endpoint0 + (index - 1) * endpoint1 + 3) / 7;
+					return;
+				}
+
+				for (uint32_t index = 2; index < 6; ++index)
+					palette[index] = ((6 - index) * endpoint0 + (index - 1) * endpoint1 + 2) / 5;
+				palette[6] = 0;
+				palette[7] = 255;
+			}
+
+			//Squared error of the values against their nearest palette entries, which go to indices
+			uint32_t MatchBc4(const uint8_t values[BlockTexels], const uint32_t palette[8], uint8_t indices[BlockTexels])
+			{
+				uint32_t error{};
+				for (uint32_t texel = 0; texel < BlockTexels; ++texel)
+				{
+					uint32_t bestError{ UINT32_MAX };
+					for (uint32_t index = 0; index < 8; ++index)
+					{
+						const int difference{ int(values[texel]) - int(palette[index]) };
+						const uint32_t texelError{ static_cast<uint32_t>(difference * difference) };
+						if (texelError < bestError)
+						{
+							bestError = texelError;
+							indices[texel] = static_cast<uint8_t>(index);
+						}
+					}
+					error += bestError;
+				}
+				return error;
+			}
+
+			void EncodeBc4(const uint8_t values[BlockTexels], CompressionQuality quality, uint8_t* pDestination)
+			{
+				uint32_t minValue{ 255 };
+				uint32_t maxValue{ 0 };
+				//Without 0 and 255, which the 4 value palette has for free
+				uint32_t innerMin{ 255 };
+				uint32_t innerMax{ 0 };
+				for (uint32_t texel = 0; texel < BlockTexels; ++texel)
+				{
+					minValue = std::min(minValue, uint32_t(values[texel]));
+					maxValue = std::max(maxValue, uint32_t(values[texel]));
+					if (values[texel] != 0 && values[texel] != 255)
+					{
+						innerMin = std::min(innerMin, uint32_t(values[texel]));
+						innerMax = std::max(innerMax, uint32_t(values[texel]));
+					}
+				}
+
+				uint32_t bestEndpoints[2]{ maxValue, minValue };
+				uint8_t bestIndices[BlockTexels]{};
+				uint32_t palette[8]{};
+				GetBc4Palette(maxValue, minValue, palette);
+				uint32_t bestError{ MatchBc4(values, palette, bestIndices) };
+
+				const auto tryEndpoints = [&](uint32_t endpoint0, uint32_t endpoint1)
+					{
+						uint8_t indices[BlockTexels]{};
+						GetBc4Palette(endpoint0, endpoint1, palette);
+						const uint32_t error{ MatchBc4(values, palette, indices) };
+						if (error < bestError)
+						{
+							bestError = error;
+							bestEndpoints[0] = endpoint0;
+							bestEndpoints[1] = endpoint1;
+							std::copy(indices, indices + BlockTexels, bestIndices);
+						}
+					};
+
+				if (quality == CompressionQuality::High && bestError > 0)
+				{
+					//Pulling the endpoints in spends the interpolated values where the texels are
+					const uint32_t step{ std::max((maxValue - minValue) / 28, 1u) };
+					for (uint32_t shrinkMax = 0; shrinkMax < 4; ++shrinkMax)
+					{
+						for (uint32_t shrinkMin = 0; shrinkMin < 4; ++shrinkMin)
+						{
+							if ((shrinkMax > 0 || shrinkMin > 0) && maxValue - minValue > (shrinkMax + shrinkMin) * step)
+								tryEndpoints(maxValue - shrinkMax * step, minValue + shrinkMin * step);
+						}
+					}
+
+					if (innerMin <= innerMax && (minValue == 0 || maxValue == 255))
+						tryEndpoints(innerMin, innerMax);
+				}
+
+				pDestination[0] = static_cast<uint8_t>(bestEndpoints[0]);
+				pDestination[1] = static_cast<uint8_t>(bestEndpoints[1]);
+				uint64_t indexBits{};
+				for (uint32_t texel = 0; texel < BlockTexels; ++texel)
+					indexBits |= uint64_t(bestIndices[texel]) << (texel * 3);
+				for (uint32_t byte = 0; byte < 6; ++byte)
+					pDestination[2 + byte] = static_cast<uint8_t>(indexBits >> (byte * 8));
+			}
+
+			void DecodeBc4(const uint8_t* pBlock, uint8_t values[BlockTexels])
+			{
+				uint32_t palette[8]{};
+				GetBc4Palette(pBlock[0], pBlock[1], palette);
+				uint64_t indexBits{};
+				for (uint32_t byte = 0; byte < 6; ++byte)
+					indexBits |= uint64_t(pBlock[2 + byte]) << (byte * 8);
+				for (uint32_t texel = 0; texel < BlockTexels; ++texel)
+					values[texel] = static_cast<uint8_t>(palette[(indexBits >> (texel * 3)) & 7]);
+			}
+
+			//---------------------
+			// Endpoints along a line: BC1 and BC7
+			//---------------------
+
+			enum class LineMode
+			{
+				//5:6:5 RGB, 4 levels
+				Bc1,
+				//Two subsets of 6 bit RGB and a p-bit each subset shares, 8 levels
+				Bc7Mode1,
+				//7 bit RGBA and a p-bit for each endpoint, 16 levels
+				Bc7Mode6
+			};
+
+			uint32_t GetChannelCount(LineMode mode)
+			{
+				return mode == LineMode::Bc7Mode6 ? 4 : 3;
+			}
+
+			uint32_t GetLevelCount(LineMode mode)
+			{
+				switch (mode)
+				{
+				case LineMode::Bc1:
+					return 4;
+				case LineMode::Bc7Mode1:
+					return 8;
+				default:
+					return 16;
+				}
+			}
+
+			//Levels run from endpoint 0 to endpoint 1, this is how far along a level is
+			float GetLevelWeight(LineMode mode, uint32_t level)
+			{
+				switch (mode)
+				{
+				case LineMode::Bc1:
+					return level / 3.f;
+				case LineMode::Bc7Mode1:
+					return Bc7Weights3[level] / 64.f;
+				default:
+					return Bc7Weights4[level] / 64.f;
+				}
+			}
+
+			uint8_t Interpolate(LineMode mode, uint32_t a, uint32_t b, uint32_t level)
+			{
+				if (mode == LineMode::Bc1)
+					return static_cast<uint8_t>(((3 - level) * a + level * b + 1) / 3);
+
+				const uint32_t weight{ mode == LineMode::Bc7Mode1 ? Bc7Weights3[level] : Bc7Weights4[level] };
+				return static_cast<uint8_t>(((64 - weight) * a + weight * b + 32) >> 6);
+			}
+
+			//Endpoints as a mode stores them and the colors they decode to
+			struct Endpoints
+			{
+				uint32_t values[2][4];
+				uint32_t pBits[2];
+				uint8_t colors[2][4];
+			};
+
+			void SwapEndpoints(Endpoints& endpoints)
+			{
+				std::swap(endpoints.values[0], endpoints.values[1]);
+				std::swap(endpoints.pBits[0], endpoints.pBits[1]);
+				std::swap(endpoints.colors[0], endpoints.colors[1]);
+			}
+
+			//The numBits value closest to value once expanded, pBit appended below it when numBits leaves room for one
+			uint32_t QuantizeChannel(float value, uint32_t numBits, int pBit, uint8_t& color)
+			{
+				const uint32_t numStoredBits{ pBit < 0 ? numBits : numBits + 1 };
+				const float scale{ float((1u << numStoredBits) - 1) / 255.f };
+				const int maxValue{ int(1u << numBits) - 1 };
+				const int guess{ static_cast<int>(pBit < 0 ? value * scale + 0.5f : (value * scale - pBit) / 2.f + 0.5f) };
+
+				uint32_t best{};
+				float bestError{ FLT_MAX };
+				for (int candidate = std::max(guess - 1, 0); candidate <= std::min(guess + 1, maxValue); ++candidate)
+				{
+					const uint32_t stored{ pBit < 0 ? uint32_t(candidate) : (uint32_t(candidate) << 1) | uint32_t(pBit) };
+					const uint8_t expanded{ ExpandBits(stored, numStoredBits) };
+					const float error{ std::abs(expanded - value) };
+					if (error < bestError)
+					{
+						bestError = error;
+						best = uint32_t(candidate);
+						color = expanded;
+					}
+				}
+				return best;
+			}
+
+			//Endpoints the mode can store closest to the ones given
+			void Quantize(LineMode mode, const float endpoints[2][4], Endpoints& quantized)
+			{
+				if (mode == LineMode::Bc1)
+				{
+					constexpr uint32_t numBits[3]{ 5, 6, 5 };
+					for (uint32_t endpoint = 0; endpoint < 2; ++endpoint)
+					{
+						for (uint32_t channel = 0; channel < 3; ++channel)
+							quantized.values[endpoint][channel] = QuantizeChannel(endpoints[endpoint][channel], numBits[channel], -1, quantized.colors[endpoint][channel]);
+						quantized.colors[endpoint][3] = 255;
+					}
+					return;
+				}
+
+				//Every endpoint, or for mode 1 both endpoints of the subset, with the p-bit that comes out closest
+				const uint32_t numChannels{ GetChannelCount(mode) };
+				const uint32_t numBits{ mode == LineMode::Bc7Mode1 ? 6u : 7u };
+				const uint32_t numGroups{ mode == LineMode::Bc7Mode1 ? 1u : 2u };
+				for (uint32_t group = 0; group < numGroups; ++group)
+				{
+					const uint32_t firstEndpoint{ numGroups == 1 ? 0 : group };
+					const uint32_t lastEndpoint{ numGroups == 1 ? 1 : group };
+					float bestError{ FLT_MAX };
+					for (int pBit = 0; pBit < 2; ++pBit)
+					{
+						Endpoints candidate{};
+						float error{};
+						for (uint32_t endpoint = firstEndpoint; endpoint <= lastEndpoint; ++endpoint)
+						{
+							for (uint32_t channel = 0; channel < numChannels; ++channel)
+							{
+								candidate.values[endpoint][channel] = QuantizeChannel(endpoints[endpoint][channel], numBits, pBit, candidate.colors[endpoint][channel]);
+								const float difference{ candidate.colors[endpoint][channel] - endpoints[endpoint][channel] };
+								error += difference * difference;
+							}
+						}
+
+						if (error < bestError)
+						{
+							bestError = error;
+							for (uint32_t endpoint = firstEndpoint; endpoint <= lastEndpoint; ++endpoint)
+							{
+								std::copy(candidate.values[endpoint], candidate.values[endpoint] + 4, quantized.values[endpoint]);
+								std::copy(candidate.colors[endpoint], candidate.colors[endpoint] + 4, quantized.colors[endpoint]);
+								quantized.pBits[endpoint] = uint32_t(pBit);
+							}
+						}
+					}
+				}
+
+				if (numChannels == 3)
+				{
+					quantized.colors[0][3] = 255;
+					quantized.colors[1][3] = 255;
+				}
+			}
+
+			//Squared error of the points against the nearest of the levels between the endpoints, which go to levels
+			uint32_t MatchLevels(const Points& points, LineMode mode, const Endpoints& endpoints, uint8_t levels[BlockTexels])
+			{
+				const uint32_t numChannels{ GetChannelCount(mode) };
+				const uint32_t numLevels{ GetLevelCount(mode) };
+				uint8_t palette[16][4]{};
+				for (uint32_t level = 0; level < numLevels; ++level)
+				{
+					for (uint32_t channel = 0; channel < numChannels; ++channel)
+						palette[level][channel] = Interpolate(mode, endpoints.colors[0][channel], endpoints.colors[1][channel], level);
+				}
+
+				uint32_t error{};
+				for (uint32_t point = 0; point < points.count; ++point)
+				{
+					uint32_t bestError{ UINT32_MAX };
+					for (uint32_t level = 0; level < numLevels; ++level)
+					{
+						uint32_t levelError{};
+						for (uint32_t channel = 0; channel < numChannels; ++channel)
+						{
+							const int difference{ int(points.texels[point][channel]) - int(palette[level][channel]) };
+							levelError += static_cast<uint32_t>(difference * difference);
+						}
+						if (levelError < bestError)
+						{
+							bestError = levelError;
+							levels[point] = static_cast<uint8_t>(level);
+						}
+					}
+					error += bestError;
+				}
+				return error;
+			}
+
+			//Mean of the points and the unit direction they spread along most, by power iteration on their covariance.
+			//Returns the spread off that line, how badly a line fits the points.
+			float GetPrincipalAxis(const Points& points, uint32_t numChannels, float mean[4], float axis[4])
+			{
+				for (uint32_t channel = 0; channel < 4; ++channel)
+				{
+					mean[channel] = 0.f;
+					axis[channel] = 0.f;
+				}
+				for (uint32_t point = 0; point < points.count; ++point)
+				{
+					for (uint32_t channel = 0; channel < numChannels; ++channel)
+						mean[channel] += points.texels[point][channel];
+				}
+				for (uint32_t channel = 0; channel < numChannels; ++channel)
+					mean[channel] /= static_cast<float>(points.count);
+
+				float covariance[4][4]{};
+				for (uint32_t point = 0; point < points.count; ++point)
+				{
+					float offset[4]{};
+					for (uint32_t channel = 0; channel < numChannels; ++channel)
+						offset[channel] = points.texels[point][channel] - mean[channel];
+					for (uint32_t row = 0; row < numChannels; ++row)
+					{
+						for (uint32_t column = 0; column < numChannels; ++column)
+							covariance[row][column] += offset[row] * offset[column];
+					}
+				}
+
+				//Starting from the covariance of the channel that varies most keeps the start off the orthogonal directions
+				float spread{};
+				uint32_t widest{};
+				for (uint32_t channel = 0; channel < numChannels; ++channel)
+				{
+					spread += covariance[channel][channel];
+					if (covariance[channel][channel] > covariance[widest][widest])
+						widest = channel;
+				}
+				if (spread <= 0.f)
+					return 0.f;
+
+				for (uint32_t channel = 0; channel < numChannels; ++channel)
+					axis[channel] = covariance[widest][channel];
+				for (int iteration = 0; iteration < 8; ++iteration)
+				{
+					float next[4]{};
+					float sqrLength{};
+					for (uint32_t row = 0; row < numChannels; ++row)
+					{
+						for (uint32_t column = 0; column < numChannels; ++column)
+							next[row] += covariance[row][column] * axis[column];
+						sqrLength += next[row] * next[row];
+					}
+					if (sqrLength <= FLT_MIN)
+						break;
+
+					const float invLength{ 1.f / sqrtf(sqrLength) };
+					for (uint32_t channel = 0; channel < numChannels; ++channel)
+						axis[channel] = next[channel] * invLength;
+				}
+
+				float alongAxis{};
+				for (uint32_t row = 0; row < numChannels; ++row)
+				{
+					for (uint32_t column = 0; column < numChannels; ++column)
+						alongAxis += axis[row] * covariance[row][column] * axis[column];
+				}
+				return std::max(spread - alongAxis, 0.f);
+			}
+
+			//Sums of texels' RGB and of the products of their channels, the covariance of any set of texels follows from them
+			struct Moments
+			{
+				float count;
+				float sums[3];
+				//rr, rg, rb, gg, gb, bb
+				float products[6];
+
+				void Add(const uint8_t texel[4])
+				{
+					const float r{ float(texel[0]) };
+					const float g{ float(texel[1]) };
+					const float b{ float(texel[2]) };
+					count += 1.f;
+					sums[0] += r;
+					sums[1] += g;
+					sums[2] += b;
+					products[0] += r * r;
+					products[1] += r * g;
+					products[2] += r * b;
+					products[3] += g * g;
+					products[4] += g * b;
+					products[5] += b * b;
+				}
+
+				Moments operator-(const Moments& other) const
+				{
+					Moments difference{};
+					difference.count = count - other.count;
+					for (uint32_t channel = 0; channel < 3; ++channel)
+						difference.sums[channel] = sums[channel] - other.sums[channel];
+					for (uint32_t product = 0; product < 6; ++product)
+						difference.products[product] = products[product] - other.products[product];
+					return difference;
+				}
+			};
+
+			//GetPrincipalAxis's spread off the line from moments instead of texels, cheap enough to rank every partition by
+			float GetLineSpread(const Moments& moments)
+			{
+				if (moments.count < 2.f)
+					return 0.f;
+
+				constexpr uint32_t productOf[3][3]{ { 0, 1, 2 }, { 1, 3, 4 }, { 2, 4, 5 } };
+				float covariance[3][3]{};
+				float spread{};
+				uint32_t widest{};
+				for (uint32_t row = 0; row < 3; ++row)
+				{
+					for (uint32_t column = 0; column < 3; ++column)
+						covariance[row][column] = moments.products[productOf[row][column]] - moments.sums[row] * moments.sums[column] / moments.count;
+					spread += covariance[row][row];
+					if (covariance[row][row] > covariance[widest][widest])
+						widest = row;
+				}
+				if (spread <= 0.f)
+					return 0.f;
+
+				float axis[3]{ covariance[widest][0], covariance[widest][1], covariance[widest][2] };
+				for (int iteration = 0; iteration < 2; ++iteration)
+				{
+					float next[3]{};
+					for (uint32_t row = 0; row < 3; ++row)
+						next[row] = covariance[row][0] * axis[0] + covariance[row][1] * axis[1] + covariance[row][2] * axis[2];
+					const float sqrLength{ next[0] * next[0] + next[1] * next[1] + next[2] * next[2] };
+					if (sqrLength <= FLT_MIN)
+						break;
+
+					const float invLength{ 1.f / sqrtf(sqrLength) };
+					for (uint32_t channel = 0; channel < 3; ++channel)
+						axis[channel] = next[channel] * invLength;
+				}
+
+				float alongAxis{};
+				for (uint32_t row = 0; row < 3; ++row)
+					alongAxis += axis[row] * (covariance[row][0] * axis[0] + covariance[row][1] * axis[1] + covariance[row][2] * axis[2]);
+				return std::max(spread - alongAxis, 0.f);
+			}
+
+			//Endpoints with the least squared error for the points at their levels, false when every point is on the same level
+			bool SolveEndpoints(const Points& points, LineMode mode, const uint8_t levels[BlockTexels], float endpoints[2][4])
+			{
+				const uint32_t numChannels{ GetChannelCount(mode) };
+				float sumAA{};
+				float sumAB{};
+				float sumBB{};
+				float sumAX[4]{};
+				float sumBX[4]{};
+				for (uint32_t point = 0; point < points.count; ++point)
+				{
+					const float b{ GetLevelWeight(mode, levels[point]) };
+					const float a{ 1.f - b };
+					sumAA += a * a;
+					sumAB += a * b;
+					sumBB += b * b;
+					for (uint32_t channel = 0; channel < numChannels; ++channel)
+					{
+						sumAX[channel] += a * points.texels[point][channel];
+						sumBX[channel] += b * points.texels[point][channel];
+					}
+				}
+
+				const float determinant{ sumAA * sumBB - sumAB * sumAB };
+				if (std::abs(determinant) < 1e-6f)
+					return false;
+
+				const float invDeterminant{ 1.f / determinant };
+				for (uint32_t channel = 0; channel < numChannels; ++channel)
+				{
+					endpoints[0][channel] = std::clamp((sumAX[channel] * sumBB - sumBX[channel] * sumAB) * invDeterminant, 0.f, 255.f);
+					endpoints[1][channel] = std::clamp((sumBX[channel] * sumAA - sumAX[channel] * sumAB) * invDeterminant, 0.f, 255.f);
+				}
+				return true;
+			}
+
+			struct LineFit
+			{
+				Endpoints endpoints;
+				//Of every point, in the order of the points
+				uint8_t levels[BlockTexels];
+				uint32_t error;
+			};
+
+			//Endpoints at the extremes of the points along their principal axis, then numRefinements rounds of least squares on the levels they got
+			LineFit FitLine(const Points& points, LineMode mode, uint32_t numRefinements)
+			{
+				const uint32_t numChannels{ GetChannelCount(mode) };
+				float mean[4]{};
+				float axis[4]{};
+				GetPrincipalAxis(points, numChannels, mean, axis);
+
+				float minProjection{ FLT_MAX };
+				float maxProjection{ -FLT_MAX };
+				for (uint32_t point = 0; point < points.count; ++point)
+				{
+					float projection{};
+					for (uint32_t channel = 0; channel < numChannels; ++channel)
+						projection += (points.texels[point][channel] - mean[channel]) * axis[channel];
+					minProjection = std::min(minProjection, projection);
+					maxProjection = std::max(maxProjection, projection);
+				}
+
+				float endpoints[2][4]{};
+				for (uint32_t channel = 0; channel < numChannels; ++channel)
+				{
+					endpoints[0][channel] = std::clamp(mean[channel] + minProjection * axis[channel], 0.f, 255.f);
+					endpoints[1][channel] = std::clamp(mean[channel] + maxProjection * axis[channel], 0.f, 255.f);
+				}
+
+				LineFit best{};
+				best.error = UINT32_MAX;
+				for (uint32_t refinement = 0; ; ++refinement)
+				{
+					LineFit fit{};
+					Quantize(mode, endpoints, fit.endpoints);
+					fit.error = MatchLevels(points, mode, fit.endpoints, fit.levels);
+					if (fit.error < best.error)
+						best = fit;
+
+					if (refinement == numRefinements || best.error == 0 || !SolveEndpoints(points, mode, fit.levels, endpoints))
+						break;
+				}
+				return best;
+			}
+
+			//---------------------
+			// BC1
+			//---------------------
+
+			uint16_t PackBc1Color(const uint32_t values[4])
+			{
+				return static_cast<uint16_t>((values[0] << 11) | (values[1] << 5) | values[2]);
+			}
+
+			void EncodeBc1(const Points& block, CompressionQuality quality, uint8_t* pDestination)
+			{
+				const LineFit fit{ FitLine(block, LineMode::Bc1, quality == CompressionQuality::High ? 2u : 0u) };
+
+				//The 4 color palette needs color 0 above color 1, levels run color 0, a third of the way, two thirds, color 1
+				constexpr uint32_t indexOfLevel[4]{ 0, 2, 3, 1 };
+				uint16_t colors[2]{ PackBc1Color(fit.endpoints.values[0]), PackBc1Color(fit.endpoints.values[1]) };
+				const bool isSwapped{ colors[0] < colors[1] };
+				if (isSwapped)
+					std::swap(colors[0], colors[1]);
+
+				uint32_t indices{};
+				if (colors[0] != colors[1])
+				{
+					for (uint32_t texel = 0; texel < BlockTexels; ++texel)
+						indices |= indexOfLevel[isSwapped ? 3 - fit.levels[texel] : fit.levels[texel]] << (texel * 2);
+				}
+
+				pDestination[0] = static_cast<uint8_t>(colors[0]);
+				pDestination[1] = static_cast<uint8_t>(colors[0] >> 8);
+				pDestination[2] = static_cast<uint8_t>(colors[1]);
+				pDestination[3] = static_cast<uint8_t>(colors[1] >> 8);
+				for (uint32_t byte = 0; byte < 4; ++byte)
+					pDestination[4 + byte] = static_cast<uint8_t>(indices >> (byte * 8));
+			}
+
+			void DecodeBc1(const uint8_t* pBlock, uint8_t texels[BlockTexels][4])
+			{
+				const uint32_t colors[2]{ uint32_t(pBlock[0]) | (uint32_t(pBlock[1]) << 8), uint32_t(pBlock[2]) | (uint32_t(pBlock[3]) << 8) };
+				uint8_t palette[4][4]{};
+				for (uint32_t endpoint = 0; endpoint < 2; ++endpoint)
+				{
+					palette[endpoint][0] = ExpandBits(colors[endpoint] >> 11, 5);
+					palette[endpoint][1] = ExpandBits((colors[endpoint] >> 5) & 63, 6);
+					palette[endpoint][2] = ExpandBits(colors[endpoint] & 31, 5);
+					palette[endpoint][3] = 255;
+				}
+
+				//Color 0 not above color 1 switches to 3 colors and transparent black
+				for (uint32_t channel = 0; channel < 3; ++channel)
+				{
+					const uint32_t a{ palette[0][channel] };
+					const uint32_t b{ palette[1][channel] };
+					palette[2][channel] = static_cast<uint8_t>(colors[0] > colors[1] ? (2 * a + b + 1) / 3 : (a + b + 1) / 2);
+					palette[3][channel] = static_cast<uint8_t>(colors[0] > colors[1] ? (a + 2 * b + 1) / 3 : 0);
+				}
+				palette[2][3] = 255;
+				palette[3][3] = colors[0] > colors[1] ? 255 : 0;
+
+				const uint32_t indices{ uint32_t(pBlock[4]) | (uint32_t(pBlock[5]) << 8) | (uint32_t(pBlock[6]) << 16) | (uint32_t(pBlock[7]) << 24) };
+				for (uint32_t texel = 0; texel < BlockTexels; ++texel)
+					std::memcpy(texels[texel], palette[(indices >> (texel * 2)) & 3], 4);
+			}
+
+			//---------------------
+			// BC7
+			//---------------------
+
+			uint32_t GetSubset(uint32_t partition, uint32_t texel)
+			{
+				return (Partitions2[partition] >> texel) & 1u;
+			}
+
+			void SplitPoints(const Points& block, uint32_t partition, Points subsets[2])
+			{
+				subsets[0].count = 0;
+				subsets[1].count = 0;
+				for (uint32_t texel = 0; texel < BlockTexels; ++texel)
+				{
+					Points& subset = subsets[GetSubset(partition, texel)];
+					std::memcpy(subset.texels[subset.count++], block.texels[texel], 4);
+				}
+			}
+
+			void WriteMode6(LineFit fit, uint8_t* pDestination)
+			{
+				//Texel 0's index drops its top bit, it has to be 0
+				if (fit.levels[0] >= 8)
+				{
+					SwapEndpoints(fit.endpoints);
+					for (uint32_t texel = 0; texel < BlockTexels; ++texel)
+						fit.levels[texel] = static_cast<uint8_t>(15 - fit.levels[texel]);
+				}
+
+				BitWriter writer{ pDestination };
+				writer.Write(1u << 6, 7);
+				for (uint32_t channel = 0; channel < 4; ++channel)
+				{
+					writer.Write(fit.endpoints.values[0][channel], 7);
+					writer.Write(fit.endpoints.values[1][channel], 7);
+				}
+				writer.Write(fit.endpoints.pBits[0], 1);
+				writer.Write(fit.endpoints.pBits[1], 1);
+				for (uint32_t texel = 0; texel < BlockTexels; ++texel)
+					writer.Write(fit.levels[texel], texel == 0 ? 3 : 4);
+			}
+
+			void WriteMode1(uint32_t partition, LineFit fits[2], uint8_t* pDestination)
+			{
+				uint8_t levels[BlockTexels]{};
+				uint32_t numPoints[2]{};
+				for (uint32_t texel = 0; texel < BlockTexels; ++texel)
+				{
+					const uint32_t subset{ GetSubset(partition, texel) };
+					levels[texel] = fits[subset].levels[numPoints[subset]++];
+				}
+
+				//Each subset's anchor texel drops the top bit of its index, it has to be 0
+				const uint32_t anchors[2]{ 0, Anchors2[partition] };
+				for (uint32_t subset = 0; subset < 2; ++subset)
+				{
+					if (levels[anchors[subset]] < 4)
+						continue;
+
+					SwapEndpoints(fits[subset].endpoints);
+					for (uint32_t texel = 0; texel < BlockTexels; ++texel)
+					{
+						if (GetSubset(partition, texel) == subset)
+							levels[texel] = static_cast<uint8_t>(7 - levels[texel]);
+					}
+				}
+
+				BitWriter writer{ pDestination };
+				writer.Write(1u << 1, 2);
+				writer.Write(partition, 6);
+				for (uint32_t channel = 0; channel < 3; ++channel)
+				{
+					for (uint32_t subset = 0; subset < 2; ++subset)
+					{
+						writer.Write(fits[subset].endpoints.values[0][channel], 6);
+						writer.Write(fits[subset].endpoints.values[1][channel], 6);
+					}
+				}
+				writer.Write(fits[0].endpoints.pBits[0], 1);
+				writer.Write(fits[1].endpoints.pBits[0], 1);
+				for (uint32_t texel = 0; texel < BlockTexels; ++texel)
+					writer.Write(levels[texel], texel == anchors[0] || texel == anchors[1] ? 2 : 3);
+			}
+
+			//Mode 6 for every block, High also tries mode 1 on opaque blocks: two subsets with a line each, on the partitions that suit the block best
+			void EncodeBc7(const Points& block, CompressionQuality quality, uint8_t* pDestination)
+			{
+				const uint32_t numRefinements{ quality == CompressionQuality::High ? 2u : 0u };
+				const LineFit singleFit{ FitLine(block, LineMode::Bc7Mode6, numRefinements) };
+
+				bool isOpaque{ true };
+				for (uint32_t texel = 0; texel < BlockTexels; ++texel)
+					isOpaque = isOpaque && block.texels[texel][3] == 255;
+
+				//Two subsets aren't worth the search once a single line is off by less than 1 a channel, root mean square
+				constexpr uint32_t GoodEnoughError{ BlockTexels * 3 };
+				if (quality == CompressionQuality::Fast || !isOpaque || singleFit.error <= GoodEnoughError)
+				{
+					WriteMode6(singleFit, pDestination);
+					return;
+				}
+
+				//Fitting a line costs too much to try every partition, the ones whose subsets lie closest to a line each get fitted for real
+				constexpr uint32_t NumCandidates{ 4 };
+				Moments total{};
+				for (uint32_t texel = 0; texel < BlockTexels; ++texel)
+					total.Add(block.texels[texel]);
+
+				float spreads[64]{};
+				uint32_t partitions[64]{};
+				for (uint32_t partition = 0; partition < 64; ++partition)
+				{
+					Moments second{};
+					for (uint32_t texel = 0; texel < BlockTexels; ++texel)
+					{
+						if (GetSubset(partition, texel) == 1)
+							second.Add(block.texels[texel]);
+					}
+					spreads[partition] = GetLineSpread(total - second) + GetLineSpread(second);
+					partitions[partition] = partition;
+				}
+				std::partial_sort(partitions, partitions + NumCandidates, partitions + 64, [&](uint32_t a, uint32_t b)
+					{
+						return spreads[a] < spreads[b] || (spreads[a] == spreads[b] && a < b);
+					});
+
+				uint32_t bestError{ singleFit.error };
+				uint32_t bestPartition{ UINT32_MAX };
+				LineFit bestFits[2]{};
+				for (uint32_t candidate = 0; candidate < NumCandidates; ++candidate)
+				{
+					Points subsets[2]{};
+					SplitPoints(block, partitions[candidate], subsets);
+					LineFit fits[2]{ FitLine(subsets[0], LineMode::Bc7Mode1, numRefinements), FitLine(subsets[1], LineMode::Bc7Mode1, numRefinements) };
+					if (fits[0].error + fits[1].error < bestError)
+					{
+						bestError = fits[0].error + fits[1].error;
+						bestPartition = partitions[candidate];
+						bestFits[0] = fits[0];
+						bestFits[1] = fits[1];
+					}
+				}
+
+				if (bestPartition == UINT32_MAX)
+					WriteMode6(singleFit, pDestination);
+				else
+					WriteMode1(bestPartition, bestFits, pDestination);
+			}
+
+			bool DecodeBc7(const uint8_t* pBlock, uint8_t texels[BlockTexels][4])
+			{
+				BitReader reader{ pBlock };
+				if ((pBlock[0] & 0x7F) == 0x40)
+				{
+					reader.Read(7);
+					uint32_t values[2][4]{};
+					for (uint32_t channel = 0; channel < 4; ++channel)
+					{
+						values[0][channel] = reader.Read(7);
+						values[1][channel] = reader.Read(7);
+					}
+
+					uint8_t colors[2][4]{};
+					for (uint32_t endpoint = 0; endpoint < 2; ++endpoint)
+					{
+						const uint32_t pBit{ reader.Read(1) };
+						for (uint32_t channel = 0; channel < 4; ++channel)
+							colors[endpoint][channel] = static_cast<uint8_t>((values[endpoint][channel] << 1) | pBit);
+					}
+
+					for (uint32_t texel = 0; texel < BlockTexels; ++texel)
+					{
+						const uint32_t level{ reader.Read(texel == 0 ? 3 : 4) };
+						for (uint32_t channel = 0; channel < 4; ++channel)
+							texels[texel][channel] = Interpolate(LineMode::Bc7Mode6, colors[0][channel], colors[1][channel], level);
+					}
+					return true;
+				}
+
+				if ((pBlock[0] & 0x03) == 0x02)
+				{
+					reader.Read(2);
+					const uint32_t partition{ reader.Read(6) };
+					uint32_t values[2][2][3]{};
+					for (uint32_t channel = 0; channel < 3; ++channel)
+					{
+						for (uint32_t subset = 0; subset < 2; ++subset)
+						{
+							values[subset][0][channel] = reader.Read(6);
+							values[subset][1][channel] = reader.Read(6);
+						}
+					}
+
+					uint8_t colors[2][2][3]{};
+					for (uint32_t subset = 0; subset < 2; ++subset)
+					{
+						const uint32_t pBit{ reader.Read(1) };
+						for (uint32_t endpoint = 0; endpoint < 2; ++endpoint)
+						{
+							for (uint32_t channel = 0; channel < 3; ++channel)
+								colors[subset][endpoint][channel] = ExpandBits((values[subset][endpoint][channel] << 1) | pBit, 7);
+						}
+					}
+
+					for (uint32_t texel = 0; texel < BlockTexels; ++texel)
+					{
+						const uint32_t subset{ GetSubset(partition, texel) };
+						const uint32_t level{ reader.Read(texel == 0 || texel == Anchors2[partition] ? 2 : 3) };
+						for (uint32_t channel = 0; channel < 3; ++channel)
+							texels[texel][channel] = Interpolate(LineMode::Bc7Mode1, colors[subset][0][channel], colors[subset][1][channel], level);
+						texels[texel][3] = 255;
+					}
+					return true;
+				}
+
+				return false;
+			}
+		}
+
+		TextureFormat ChooseFormat(const Image& image, MipContent content, CompressionQuality quality)
+		{
+			if (quality == CompressionQuality::None || image.IsEmpty() || image.width % 4 != 0 || image.height % 4 != 0)
+				return TextureFormat::R8G8B8A8;
+
+			switch (content)
+			{
+			case MipContent::Normal:
+				return TextureFormat::BC5;
+			case MipContent::Linear:
+				return TextureFormat::BC4;
+			default:
+				break;
+			}
+
+			if (quality == CompressionQuality::High)
+				return TextureFormat::BC7;
+
+			for (size_t texel = 3; texel < image.pixels.size(); texel += 4)
+			{
+				if (image.pixels[texel] != 255)
+					return TextureFormat::BC7;
+			}
+			return TextureFormat::BC1;
+		}
+
+		std::vector<uint8_t> Encode(const Image& image, TextureFormat format, CompressionQuality quality, size_t numThreads)
+		{
+			if (!IsBlockCompressed(format))
+				return image.pixels;
+			if (image.IsEmpty())
+				return {};
+
+			const uint32_t blockSize{ GetBlockSize(format) };
+			const uint32_t rowPitch{ GetRowPitch(format, image.width) };
+			const uint32_t numBlocksX{ rowPitch / blockSize };
+			const uint32_t numBlocksY{ GetRowCount(format, image.height) };
+			std::vector<uint8_t> blocks(size_t(rowPitch) * numBlocksY);
+			Utils::ParallelFor(numBlocksY, numThreads, [&](size_t begin, size_t end)
+				{
+					Points block{};
+					uint8_t values[BlockTexels]{};
+					for (size_t blockY = begin; blockY < end; ++blockY)
+					{
+						for (uint32_t blockX = 0; blockX < numBlocksX; ++blockX)
+						{
+							ReadBlock(image, blockX, static_cast<uint32_t>(blockY), block);
+							uint8_t* pDestination = blocks.data() + blockY * rowPitch + size_t(blockX) * blockSize;
+							switch (format)
+							{
+							case TextureFormat::BC1:
+								EncodeBc1(block, quality, pDestination);
+								break;
+							case TextureFormat::BC4:
+							case TextureFormat::BC5:
+								//BC5 is a BC4 block of red and one of green
+								for (uint32_t channel = 0; channel < blockSize / 8; ++channel)
+								{
+									for (uint32_t texel = 0; texel < BlockTexels; ++texel)
+										values[texel] = block.texels[texel][channel];
+									EncodeBc4(values, quality, pDestination + channel * 8);
+								}
+								break;
+							case TextureFormat::BC7:
+								EncodeBc7(block, quality, pDestination);
+								break;
+							default:
+								break;
+							}
+						}
+					}
+				});
+			return blocks;
+		}
+
+		bool Decode(const uint8_t* pBlocks, uint32_t width, uint32_t height, TextureFormat format, Image& image)
+		{
+			if (!IsBlockCompressed(format))
+				return false;
+
+			image.width = width;
+			image.height = height;
+			image.pixels.assign(size_t(width) * height * 4, 0);
+
+			const uint32_t blockSize{ GetBlockSize(format) };
+			const uint32_t rowPitch{ GetRowPitch(format, width) };
+			const uint32_t numBlocksX{ rowPitch / blockSize };
+			const uint32_t numBlocksY{ GetRowCount(format, height) };
+			bool isValid{ true };
+			for (uint32_t blockY = 0; blockY < numBlocksY; ++blockY)
+			{
+				for (uint32_t blockX = 0; blockX < numBlocksX; ++blockX)
+				{
+					const uint8_t* pBlock = pBlocks + size_t(blockY) * rowPitch + size_t(blockX) * blockSize;
+					uint8_t texels[BlockTexels][4]{};
+					uint8_t values[BlockTexels]{};
+					for (uint32_t texel = 0; texel < BlockTexels; ++texel)
+						texels[texel][3] = 255;
+
+					switch (format)
+					{
+					case TextureFormat::BC1:
+						DecodeBc1(pBlock, texels);
+						break;
+					case TextureFormat::BC4:
+					case TextureFormat::BC5:
+						for (uint32_t channel = 0; channel < blockSize / 8; ++channel)
+						{
+							DecodeBc4(pBlock + channel * 8, values);
+							for (uint32_t texel = 0; texel < BlockTexels; ++texel)
+								texels[texel][channel] = values[texel];
+						}
+						break;
+					case TextureFormat::BC7:
+						isValid = DecodeBc7(pBlock, texels) && isValid;
+						break;
+					default:
+						break;
+					}
+
+					//Padding past the edges of the image is dropped
+					for (uint32_t y = 0; y < 4 && blockY * 4 + y < height; ++y)
+					{
+						for (uint32_t x = 0; x < 4 && blockX * 4 + x < width; ++x)
+							std::memcpy(image.pixels.data() + (size_t(blockY * 4 + y) * width + blockX * 4 + x) * 4, texels[y * 4 + x], 4);
+					}
+				}
+			}
+			return isValid;
+		}
+	}
+}
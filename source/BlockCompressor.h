@@ -0,0 +1,36 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+#include "Image.h"
+#include "MipGenerator.h"
+#include "TextureFormat.h"
+
+namespace dae
+{
+	enum class CompressionQuality : uint32_t
+	{
+		//Textures stay R8G8B8A8
+		None,
+		//Endpoints along the texels' principal axis. BC7 only uses its single subset mode.
+		Fast,
+		//Endpoints refined by least squares and searched around. BC7 also tries the two subset mode on its most promising partitions.
+		High
+	};
+
+	//Encodes RGBA8 images into the block compressed formats the GPU samples as they are, 4x4 texels to a block
+	namespace BlockCompressor
+	{
+		//BC5 for normal maps, BC4 for linear maps of which only red is used, BC1 for opaque color maps and BC7 when they have alpha or quality is High.
+		//R8G8B8A8 without compression or when the image isn't a multiple of 4 texels, which block compressed textures have to be.
+		TextureFormat ChooseFormat(const Image& image, MipContent content, CompressionQuality quality);
+
+		//Blocks row by row, top to bottom. Images that aren't a multiple of 4 repeat their last row and column into the padding.
+		//BC1 keeps RGB, BC4 red, BC5 red and green, BC7 all of RGBA. R8G8B8A8 returns the pixels, None encodes like Fast.
+		//Rows of blocks are split over numThreads threads, the result doesn't depend on numThreads.
+		std::vector<uint8_t> Encode(const Image& image, TextureFormat format, CompressionQuality quality, size_t numThreads = 1);
+
+		//Back to RGBA8 the way the GPU decodes, channels the format doesn't store read 0 and alpha 255.
+		//False for R8G8B8A8 and for BC7 blocks in modes Encode doesn't write.
+		bool Decode(const uint8_t* pBlocks, uint32_t width, uint32_t height, TextureFormat format, Image& image);
+	}
+}
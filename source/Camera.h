@@ -42,6 +42,10 @@ namespace dae
 		float nearClippingPlane{ .1f };
 		float farClippingPlane{ 1000.f };
 
+		//Window coordinates of the mouse cursor, for picking
+		int cursorX{};
+		int cursorY{};
+
 		void Initialize(float aspect, float _fovAngle = 90.f, Vector3 _origin = {0.f,0.f,0.f})
 		{
 			aspectRatio = aspect;
@@ -70,6 +74,13 @@ namespace dae
 			//viewMatrix = Matrix::CreateLookAtLH(origin, forward, up);
 		}
 
+		//Unit world space direction through window coordinates (x, y) of a width by height viewport
+		Vector3 GetRayDirection(float x, float y, float width, float height) const
+		{
+			const Vector3 cameraDirection{ (2.f * x / width - 1.f) * aspectRatio * fov, (1.f - 2.f * y / height) * fov, 1.f };
+			return viewMatrix.TransformVector(cameraDirection).Normalized();
+		}
+
 		void CalculateProjectionMatrix()
 		{
 			projectionMatrix = Matrix::CreatePerspectiveFovLH(fov, aspectRatio, nearClippingPlane, farClippingPlane);
@@ -106,6 +117,7 @@ namespace dae
 			//Mouse Input
 			int mouseX{}, mouseY{};
 			const uint32_t mouseState = SDL_GetRelativeMouseState(&mouseX, &mouseY);
+			SDL_GetMouseState(&cursorX, &cursorY);
 			bool rightDown{ (mouseState & SDL_BUTTON(SDL_BUTTON_RIGHT)) != 0};
 			bool leftDown{ (mouseState & SDL_BUTTON(SDL_BUTTON_LEFT)) != 0};
 
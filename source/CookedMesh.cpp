@@ -0,0 +1,229 @@
+#include "pch.h"
+#include "CookedMesh.h"
+
+#include <cstddef>
+#include <filesystem>
+#include <fstream>
+#include "MeshCodec.h"
+#include "ParallelFor.h"
+
+namespace dae
+{
+	namespace
+	{
+		constexpr uint64_t BlockAlignment{ 16 };
+
+		uint64_t AlignUp(uint64_t offset)
+		{
+			return (offset + BlockAlignment - 1) & ~(BlockAlignment - 1);
+		}
+
+		//Compares without adding, a damaged offset close to 2^64 would wrap around past fileSize
+		bool IsInFile(uint64_t offset, uint64_t size, uint64_t fileSize)
+		{
+			return offset <= fileSize && size <= fileSize - offset;
+		}
+	}
+
+	CookedMesh::CookedMesh(const std::string& path)
+		: m_File{ path }
+		, m_Path{ path }
+	{
+		if (m_File.GetSize() < sizeof(Header))
+			return;
+
+		const Header* pHeader = reinterpret_cast<const Header*>(m_File.GetData());
+		if (pHeader->magic != Magic || pHeader->version != Version || pHeader->vertexLayout > VertexLayout::CompactQuantized ||
+			pHeader->vertexStride != VertexCodec::GetStride(pHeader->vertexLayout) ||
+			(pHeader->indexStride != sizeof(uint16_t) && pHeader->indexStride != sizeof(uint32_t)))
+			return;
+
+		//Reject truncated files before anyone reads the blocks
+		const uint64_t fileSize{ m_File.GetSize() };
+		if (!IsInFile(pHeader->vertexOffset, pHeader->vertexDataSize, fileSize) || !IsInFile(pHeader->indexOffset, pHeader->indexDataSize, fileSize) ||
+			!IsInFile(pHeader->rangeOffset, uint64_t(pHeader->rangeCount) * sizeof(DrawRange), fileSize) ||
+			!IsInFile(pHeader->lodOffset, uint64_t(pHeader->lodCount) * sizeof(MeshLod), fileSize) ||
+			!IsInFile(pHeader->meshletOffset, uint64_t(pHeader->meshletCount) * sizeof(Meshlet), fileSize) ||
+			!IsInFile(pHeader->rangeSubmeshOffset, uint64_t(pHeader->rangeCount) * sizeof(uint32_t), fileSize) ||
+			!IsInFile(pHeader->materialNamesOffset, pHeader->materialNamesSize, fileSize) ||
+			pHeader->vertexOffset % BlockAlignment != 0 || pHeader->indexOffset % BlockAlignment != 0 || pHeader->rangeOffset % BlockAlignment != 0 ||
+			pHeader->lodOffset % BlockAlignment != 0 || pHeader->meshletOffset % BlockAlignment != 0 || pHeader->rangeSubmeshOffset % BlockAlignment != 0 ||
+			pHeader->lodCount == 0 || pHeader->submeshCount == 0)
+			return;
+
+		//Every submesh needs its name, and every range a submesh that exists
+		const char* pNames = m_File.GetData() + pHeader->materialNamesOffset;
+		if (uint32_t(std::count(pNames, pNames + pHeader->materialNamesSize, '\0')) != pHeader->submeshCount ||
+			pNames[pHeader->materialNamesSize - 1] != '\0')
+			return;
+
+		const uint32_t* pRangeSubmeshes = reinterpret_cast<const uint32_t*>(m_File.GetData() + pHeader->rangeSubmeshOffset);
+		for (uint32_t i = 0; i < pHeader->rangeCount; ++i)
+		{
+			if (pRangeSubmeshes[i] >= pHeader->submeshCount)
+				return;
+		}
+
+		//Ranges have to stay inside the blocks they draw from
+		const DrawRange* pRanges = reinterpret_cast<const DrawRange*>(m_File.GetData() + pHeader->rangeOffset);
+		for (uint32_t i = 0; i < pHeader->rangeCount; ++i)
+		{
+			if (uint64_t(pRanges[i].indexStart) + pRanges[i].indexCount > pHeader->indexCount ||
+				uint64_t(pRanges[i].baseVertex) + pRanges[i].vertexCount > pHeader->vertexCount)
+				return;
+		}
+
+		const MeshLod* pLods = reinterpret_cast<const MeshLod*>(m_File.GetData() + pHeader->lodOffset);
+		for (uint32_t i = 0; i < pHeader->lodCount; ++i)
+		{
+			if (uint64_t(pLods[i].firstRange) + pLods[i].rangeCount > pHeader->rangeCount ||
+				uint64_t(pLods[i].firstMeshlet) + pLods[i].meshletCount > pHeader->meshletCount)
+				return;
+		}
+
+		const Meshlet* pMeshlets = reinterpret_cast<const Meshlet*>(m_File.GetData() + pHeader->meshletOffset);
+		for (uint32_t i = 0; i < pHeader->meshletCount; ++i)
+		{
+			if (uint64_t(pMeshlets[i].indexStart) + pMeshlets[i].indexCount > pHeader->indexCount)
+				return;
+		}
+
+		//The codec checks every read, a corrupt block fails here instead of feeding garbage to the GPU
+		const size_t numThreads{ Utils::GetWorkerCount() };
+		m_Vertices.resize(uint64_t(pHeader->vertexCount) * pHeader->vertexStride);
+		m_Indices.resize(uint64_t(pHeader->indexCount) * pHeader->indexStride);
+		if (!MeshCodec::DecodeVertices(m_Vertices.data(), pHeader->vertexCount, pHeader->vertexStride,
+				reinterpret_cast<const uint8_t*>(m_File.GetData() + pHeader->vertexOffset), pHeader->vertexDataSize, numThreads) ||
+			!MeshCodec::DecodeIndices(m_Indices.data(), pHeader->indexCount, pHeader->indexStride,
+				reinterpret_cast<const uint8_t*>(m_File.GetData() + pHeader->indexOffset), pHeader->indexDataSize, numThreads))
+		{
+			m_Vertices.clear();
+			m_Indices.clear();
+			return;
+		}
+
+		m_pHeader = pHeader;
+	}
+
+	std::string CookedMesh::GetCookedPath(const std::string& sourcePath)
+	{
+		return std::filesystem::path{ sourcePath }.replace_extension(".mesh").string();
+	}
+
+	bool CookedMesh::Write(const std::string& path, const EncodedVertices& vertices, const EncodedIndices& indices, const std::vector<MeshLod>& lods,
+		const std::vector<Meshlet>& meshlets, const std::vector<uint32_t>& rangeSubmeshes, const std::vector<std::string>& submeshMaterials,
+		bool isOpaque, const Vector3& lightDirection, uint32_t lightSampleCount, const std::string& sourcePath)
+	{
+		if (rangeSubmeshes.size() != indices.ranges.size())
+			return false;
+
+		const std::vector<uint8_t> vertexData{ MeshCodec::EncodeVertices(vertices.data.data(), vertices.count, vertices.stride) };
+		const std::vector<uint8_t> indexData{ MeshCodec::EncodeIndices(indices.data.data(), indices.count, indices.stride) };
+
+		std::string materialNames{};
+		for (const std::string& material : submeshMaterials)
+			materialNames.append(material.c_str(), material.size() + 1);
+
+		Header header{};
+		header.magic = Magic;
+		header.version = Version;
+		header.vertexLayout = vertices.layout;
+		header.isOpaque = isOpaque ? 1u : 0u;
+		header.vertexStride = vertices.stride;
+		header.vertexCount = vertices.count;
+		header.indexStride = indices.stride;
+		header.indexCount = indices.count;
+		header.rangeCount = static_cast<uint32_t>(indices.ranges.size());
+		header.lodCount = static_cast<uint32_t>(lods.size());
+		header.meshletCount = static_cast<uint32_t>(meshlets.size());
+		header.submeshCount = static_cast<uint32_t>(submeshMaterials.size());
+		header.materialNamesSize = static_cast<uint32_t>(materialNames.size());
+		header.vertexOffset = AlignUp(sizeof(Header));
+		header.vertexDataSize = vertexData.size();
+		header.indexOffset = AlignUp(header.vertexOffset + vertexData.size());
+		header.indexDataSize = indexData.size();
+		header.rangeOffset = AlignUp(header.indexOffset + indexData.size());
+		header.lodOffset = AlignUp(header.rangeOffset + indices.ranges.size() * sizeof(DrawRange));
+		header.meshletOffset = AlignUp(header.lodOffset + lods.size() * sizeof(MeshLod));
+		header.rangeSubmeshOffset = AlignUp(header.meshletOffset + meshlets.size() * sizeof(Meshlet));
+		header.materialNamesOffset = AlignUp(header.rangeSubmeshOffset + rangeSubmeshes.size() * sizeof(uint32_t));
+
+		for (int axis = 0; axis < 3; ++axis)
+		{
+			header.boundsMin[axis] = vertices.boundsMin[axis];
+			header.boundsMax[axis] = vertices.boundsMax[axis];
+			header.lightDirection[axis] = lightDirection[axis];
+		}
+		header.lightSampleCount = lightSampleCount;
+
+		if (!SourceStamp::Create(sourcePath, header.source))
+			return false;
+
+		std::ofstream file{ path, std::ios::binary | std::ios::trunc };
+		if (!file)
+			return false;
+
+		constexpr char padding[BlockAlignment]{};
+		file.write(reinterpret_cast<const char*>(&header), sizeof(Header));
+		file.write(padding, static_cast<std::streamsize>(header.vertexOffset - sizeof(Header)));
+		file.write(reinterpret_cast<const char*>(vertexData.data()), static_cast<std::streamsize>(vertexData.size()));
+		file.write(padding, static_cast<std::streamsize>(header.indexOffset - header.vertexOffset - vertexData.size()));
+		file.write(reinterpret_cast<const char*>(indexData.data()), static_cast<std::streamsize>(indexData.size()));
+		file.write(padding, static_cast<std::streamsize>(header.rangeOffset - header.indexOffset - indexData.size()));
+		file.write(reinterpret_cast<const char*>(indices.ranges.data()), static_cast<std::streamsize>(indices.ranges.size() * sizeof(DrawRange)));
+		file.write(padding, static_cast<std::streamsize>(header.lodOffset - header.rangeOffset - indices.ranges.size() * sizeof(DrawRange)));
+		file.write(reinterpret_cast<const char*>(lods.data()), static_cast<std::streamsize>(lods.size() * sizeof(MeshLod)));
+		file.write(padding, static_cast<std::streamsize>(header.meshletOffset - header.lodOffset - lods.size() * sizeof(MeshLod)));
+		file.write(reinterpret_cast<const char*>(meshlets.data()), static_cast<std::streamsize>(meshlets.size() * sizeof(Meshlet)));
+		file.write(padding, static_cast<std::streamsize>(header.rangeSubmeshOffset - header.meshletOffset - meshlets.size() * sizeof(Meshlet)));
+		file.write(reinterpret_cast<const char*>(rangeSubmeshes.data()), static_cast<std::streamsize>(rangeSubmeshes.size() * sizeof(uint32_t)));
+		file.write(padding, static_cast<std::streamsize>(header.materialNamesOffset - header.rangeSubmeshOffset - rangeSubmeshes.size() * sizeof(uint32_t)));
+		file.write(materialNames.data(), static_cast<std::streamsize>(materialNames.size()));
+
+		return static_cast<bool>(file);
+	}
+
+	bool CookedMesh::IsUpToDate(const std::string& sourcePath) const
+	{
+		return IsValid() && m_pHeader->source.Matches(sourcePath, m_Path, offsetof(Header, source));
+	}
+
+	bool CookedMesh::IsBakedWith(const Vector3& lightDirection, uint32_t lightSampleCount) const
+	{
+		return m_pHeader->lightSampleCount == lightSampleCount && m_pHeader->lightDirection[0] == lightDirection.x &&
+			m_pHeader->lightDirection[1] == lightDirection.y && m_pHeader->lightDirection[2] == lightDirection.z;
+	}
+
+	const DrawRange* CookedMesh::GetRanges() const
+	{
+		return reinterpret_cast<const DrawRange*>(m_File.GetData() + m_pHeader->rangeOffset);
+	}
+
+	const MeshLod* CookedMesh::GetLods() const
+	{
+		return reinterpret_cast<const MeshLod*>(m_File.GetData() + m_pHeader->lodOffset);
+	}
+
+	const Meshlet* CookedMesh::GetMeshlets() const
+	{
+		return reinterpret_cast<const Meshlet*>(m_File.GetData() + m_pHeader->meshletOffset);
+	}
+
+	const uint32_t* CookedMesh::GetRangeSubmeshes() const
+	{
+		return reinterpret_cast<const uint32_t*>(m_File.GetData() + m_pHeader->rangeSubmeshOffset);
+	}
+
+	std::vector<std::string> CookedMesh::GetSubmeshMaterials() const
+	{
+		std::vector<std::string> materials{};
+		const char* pName = m_File.GetData() + m_pHeader->materialNamesOffset;
+		for (uint32_t i = 0; i < m_pHeader->submeshCount; ++i)
+		{
+			materials.emplace_back(pName);
+			pName += materials.back().size() + 1;
+		}
+
+		return materials;
+	}
+}
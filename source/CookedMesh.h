@@ -0,0 +1,105 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "MappedFile.h"
+#include "Meshlet.h"
+#include "MeshSimplifier.h"
+#include "MeshSplitter.h"
+#include "SourceStamp.h"
+#include "VertexLayout.h"
+
+namespace dae
+{
+	//Binary mesh container: header, vertex block, index block, draw range block, level of detail block, meshlet block,
+	//the submesh of every draw range, the material names of the submeshes and bounds.
+	//The vertex and index blocks are stored compressed with MeshCodec and decoded on load, the other blocks are used straight from the mapping.
+	class CookedMesh final
+	{
+	public:
+		static constexpr uint32_t Magic{ 0x4D454144 }; //"DAEM"
+		static constexpr uint32_t Version{ 13 };
+
+		struct Header
+		{
+			uint32_t magic;
+			uint32_t version;
+			VertexLayout vertexLayout;
+			//Cooked for an opaque effect: triangles sorted against overdraw, meshlets free to reorder them
+			uint32_t isOpaque;
+			uint32_t vertexStride;
+			uint32_t vertexCount;
+			uint32_t indexStride;
+			uint32_t indexCount;
+			uint32_t rangeCount;
+			uint32_t lodCount;
+			uint32_t meshletCount;
+			uint32_t submeshCount;
+			uint32_t materialNamesSize;
+			uint64_t vertexOffset;
+			//Compressed sizes of the vertex and index blocks
+			uint64_t vertexDataSize;
+			uint64_t indexDataSize;
+			uint64_t indexOffset;
+			uint64_t rangeOffset;
+			uint64_t lodOffset;
+			uint64_t meshletOffset;
+			uint64_t rangeSubmeshOffset;
+			//Null-terminated material names, one per submesh
+			uint64_t materialNamesOffset;
+			//Also the range quantized positions are stored in
+			float boundsMin[3];
+			float boundsMax[3];
+			//Vertex lighting baked into the full layout's color: the light's direction, zero without one,
+			//and the occlusion rays per vertex, zero when nothing was baked
+			float lightDirection[3];
+			uint32_t lightSampleCount;
+
+			SourceStamp source;
+		};
+
+		explicit CookedMesh(const std::string& path);
+		~CookedMesh() = default;
+
+		CookedMesh(const CookedMesh&) = delete;
+		CookedMesh(CookedMesh&&) noexcept = delete;
+		CookedMesh& operator=(const CookedMesh&) = delete;
+		CookedMesh& operator=(CookedMesh&&) noexcept = delete;
+
+		static std::string GetCookedPath(const std::string& sourcePath);
+		static bool Write(const std::string& path, const EncodedVertices& vertices, const EncodedIndices& indices, const std::vector<MeshLod>& lods,
+			const std::vector<Meshlet>& meshlets, const std::vector<uint32_t>& rangeSubmeshes, const std::vector<std::string>& submeshMaterials,
+			bool isOpaque, const Vector3& lightDirection, uint32_t lightSampleCount, const std::string& sourcePath);
+
+		bool IsValid() const { return m_pHeader != nullptr; }
+		bool IsUpToDate(const std::string& sourcePath) const;
+
+		const Header& GetHeader() const { return *m_pHeader; }
+		VertexLayout GetVertexLayout() const { return m_pHeader->vertexLayout; }
+		bool IsOpaque() const { return m_pHeader->isOpaque != 0; }
+		bool IsBaked() const { return m_pHeader->lightSampleCount > 0; }
+		bool IsBakedWith(const Vector3& lightDirection, uint32_t lightSampleCount) const;
+		uint32_t GetVertexStride() const { return m_pHeader->vertexStride; }
+		const void* GetVertices() const { return m_Vertices.data(); }
+		uint32_t GetIndexStride() const { return m_pHeader->indexStride; }
+		const void* GetIndices() const { return m_Indices.data(); }
+		const DrawRange* GetRanges() const;
+		const MeshLod* GetLods() const;
+		const Meshlet* GetMeshlets() const;
+		const uint32_t* GetRangeSubmeshes() const;
+		std::vector<std::string> GetSubmeshMaterials() const;
+		uint32_t GetVertexCount() const { return m_pHeader->vertexCount; }
+		uint32_t GetIndexCount() const { return m_pHeader->indexCount; }
+		uint32_t GetRangeCount() const { return m_pHeader->rangeCount; }
+		uint32_t GetLodCount() const { return m_pHeader->lodCount; }
+		uint32_t GetMeshletCount() const { return m_pHeader->meshletCount; }
+		uint32_t GetSubmeshCount() const { return m_pHeader->submeshCount; }
+
+	private:
+		MappedFile m_File;
+		std::string m_Path;
+		const Header* m_pHeader{ nullptr };
+		std::vector<uint8_t> m_Vertices{};
+		std::vector<uint8_t> m_Indices{};
+	};
+}
@@ -0,0 +1,85 @@
+#include "pch.h"
+#include "CookedSdf.h"
+
+#include <cstddef>
+#include <filesystem>
+#include <fstream>
+
+namespace dae
+{
+	CookedSdf::CookedSdf(const std::string& path)
+		: m_File{ path }
+		, m_Path{ path }
+	{
+		if (m_File.GetSize() < sizeof(Header))
+			return;
+
+		const Header* pHeader = reinterpret_cast<const Header*>(m_File.GetData());
+		if (pHeader->magic != Magic || pHeader->version != Version || pHeader->distanceOffset % sizeof(float) != 0 || !(pHeader->voxelSize > 0.f))
+			return;
+
+		//Reject truncated files before anyone reads the distances, dividing instead of multiplying so damaged dimensions can't wrap around
+		const uint64_t sliceCount{ uint64_t(pHeader->dimensions[0]) * pHeader->dimensions[1] };
+		if (sliceCount == 0 || pHeader->dimensions[2] == 0 || pHeader->distanceOffset > m_File.GetSize() ||
+			(m_File.GetSize() - pHeader->distanceOffset) / sizeof(float) / sliceCount < pHeader->dimensions[2])
+			return;
+
+		m_pHeader = pHeader;
+	}
+
+	std::string CookedSdf::GetCookedPath(const std::string& sourcePath)
+	{
+		return std::filesystem::path{ sourcePath }.replace_extension(".sdf").string();
+	}
+
+	bool CookedSdf::Write(const std::string& path, const SignedDistanceField& field, uint32_t resolution, const std::string& sourcePath)
+	{
+		if (field.IsEmpty())
+			return false;
+
+		Header header{};
+		header.magic = Magic;
+		header.version = Version;
+		std::copy(field.dimensions, field.dimensions + 3, header.dimensions);
+		header.resolution = resolution;
+		header.origin[0] = field.origin.x;
+		header.origin[1] = field.origin.y;
+		header.origin[2] = field.origin.z;
+		header.voxelSize = field.voxelSize;
+		header.distanceOffset = sizeof(Header);
+
+		if (!SourceStamp::Create(sourcePath, header.source))
+			return false;
+
+		std::ofstream file{ path, std::ios::binary | std::ios::trunc };
+		if (!file)
+			return false;
+
+		file.write(reinterpret_cast<const char*>(&header), sizeof(Header));
+		file.write(reinterpret_cast<const char*>(field.distances.data()), static_cast<std::streamsize>(field.distances.size() * sizeof(float)));
+
+		return static_cast<bool>(file);
+	}
+
+	bool CookedSdf::IsUpToDate(const std::string& sourcePath) const
+	{
+		return IsValid() && m_pHeader->source.Matches(sourcePath, m_Path, offsetof(Header, source));
+	}
+
+	const float* CookedSdf::GetDistances() const
+	{
+		return reinterpret_cast<const float*>(m_File.GetData() + m_pHeader->distanceOffset);
+	}
+
+	SignedDistanceField CookedSdf::GetField() const
+	{
+		SignedDistanceField field{};
+		std::copy(m_pHeader->dimensions, m_pHeader->dimensions + 3, field.dimensions);
+		field.origin = Vector3{ m_pHeader->origin[0], m_pHeader->origin[1], m_pHeader->origin[2] };
+		field.voxelSize = m_pHeader->voxelSize;
+
+		const float* pDistances = GetDistances();
+		field.distances.assign(pDistances, pDistances + size_t(m_pHeader->dimensions[0]) * m_pHeader->dimensions[1] * m_pHeader->dimensions[2]);
+		return field;
+	}
+}
@@ -0,0 +1,53 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include "MappedFile.h"
+#include "SignedDistanceField.h"
+#include "SourceStamp.h"
+
+namespace dae
+{
+	//Binary signed distance field container: header and the 32 bit float distances, laid out like an R32_FLOAT 3D texture
+	class CookedSdf final
+	{
+	public:
+		static constexpr uint32_t Magic{ 0x53454144 }; //"DAES"
+		static constexpr uint32_t Version{ 1 };
+
+		struct Header
+		{
+			uint32_t magic;
+			uint32_t version;
+			uint32_t dimensions[3];
+			//Longest grid axis the field was baked for
+			uint32_t resolution;
+			float origin[3];
+			float voxelSize;
+			uint64_t distanceOffset;
+			SourceStamp source;
+		};
+
+		explicit CookedSdf(const std::string& path);
+		~CookedSdf() = default;
+
+		CookedSdf(const CookedSdf&) = delete;
+		CookedSdf(CookedSdf&&) noexcept = delete;
+		CookedSdf& operator=(const CookedSdf&) = delete;
+		CookedSdf& operator=(CookedSdf&&) noexcept = delete;
+
+		static std::string GetCookedPath(const std::string& sourcePath);
+		static bool Write(const std::string& path, const SignedDistanceField& field, uint32_t resolution, const std::string& sourcePath);
+
+		bool IsValid() const { return m_pHeader != nullptr; }
+		bool IsUpToDate(const std::string& sourcePath) const;
+
+		const Header& GetHeader() const { return *m_pHeader; }
+		const float* GetDistances() const;
+		SignedDistanceField GetField() const;
+
+	private:
+		MappedFile m_File;
+		std::string m_Path;
+		const Header* m_pHeader{ nullptr };
+	};
+}
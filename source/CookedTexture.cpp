@@ -0,0 +1,142 @@
+#include "pch.h"
+#include "CookedTexture.h"
+
+#include <cstddef>
+#include <filesystem>
+#include <fstream>
+
+namespace dae
+{
+	namespace
+	{
+		constexpr uint64_t MipAlignment{ 16 };
+
+		uint64_t AlignUp(uint64_t offset)
+		{
+			return (offset + MipAlignment - 1) & ~(MipAlignment - 1);
+		}
+
+		uint32_t GetMipExtent(uint32_t extent, uint32_t level)
+		{
+			return std::max(extent >> level, 1u);
+		}
+
+		uint64_t GetLevelSize(TextureFormat format, uint32_t width, uint32_t height, uint32_t level)
+		{
+			return uint64_t(GetRowPitch(format, GetMipExtent(width, level))) * GetRowCount(format, GetMipExtent(height, level));
+		}
+
+		//Compares without adding, a damaged offset close to 2^64 would wrap around past fileSize
+		bool IsInFile(uint64_t offset, uint64_t size, uint64_t fileSize)
+		{
+			return offset <= fileSize && size <= fileSize - offset;
+		}
+	}
+
+	CookedTexture::CookedTexture(const std::string& path)
+		: m_File{ path }
+		, m_Path{ path }
+	{
+		if (m_File.GetSize() < sizeof(Header))
+			return;
+
+		const Header* pHeader = reinterpret_cast<const Header*>(m_File.GetData());
+		if (pHeader->magic != Magic || pHeader->version != Version || pHeader->format > TextureFormat::BC7 ||
+			pHeader->content > MipContent::Normal || pHeader->filter > MipFilter::Kaiser || pHeader->quality > CompressionQuality::High ||
+			pHeader->width == 0 || pHeader->height == 0 || pHeader->mipCount == 0 || pHeader->mipCount > MaxMipCount ||
+			pHeader->mipCount > MipGenerator::GetMipCount(pHeader->width, pHeader->height))
+			return;
+
+		//Reject truncated files before anyone uploads the levels
+		for (uint32_t level = 0; level < pHeader->mipCount; ++level)
+		{
+			const uint64_t mipSize{ GetLevelSize(pHeader->format, pHeader->width, pHeader->height, level) };
+			if (pHeader->mipOffsets[level] % MipAlignment != 0 || !IsInFile(pHeader->mipOffsets[level], mipSize, m_File.GetSize()))
+				return;
+		}
+
+		m_pHeader = pHeader;
+	}
+
+	std::string CookedTexture::GetCookedPath(const std::string& sourcePath)
+	{
+		return std::filesystem::path{ sourcePath }.replace_extension(".tex").string();
+	}
+
+	bool CookedTexture::Write(const std::string& path, TextureFormat format, uint32_t width, uint32_t height, const std::vector<std::vector<uint8_t>>& levels,
+		MipContent content, MipFilter filter, CompressionQuality quality, const std::string& sourcePath)
+	{
+		if (levels.empty() || levels.size() > MaxMipCount || width == 0 || height == 0 || levels.size() > MipGenerator::GetMipCount(width, height))
+			return false;
+
+		Header header{};
+		header.magic = Magic;
+		header.version = Version;
+		header.format = format;
+		header.content = content;
+		header.filter = filter;
+		header.quality = quality;
+		header.width = width;
+		header.height = height;
+		header.mipCount = static_cast<uint32_t>(levels.size());
+
+		uint64_t offset{ AlignUp(sizeof(Header)) };
+		for (uint32_t level = 0; level < header.mipCount; ++level)
+		{
+			if (levels[level].size() != GetLevelSize(format, width, height, level))
+				return false;
+
+			header.mipOffsets[level] = offset;
+			offset = AlignUp(offset + levels[level].size());
+		}
+
+		if (!SourceStamp::Create(sourcePath, header.source))
+			return false;
+
+		std::ofstream file{ path, std::ios::binary | std::ios::trunc };
+		if (!file)
+			return false;
+
+		constexpr char padding[MipAlignment]{};
+		file.write(reinterpret_cast<const char*>(&header), sizeof(Header));
+		uint64_t position{ sizeof(Header) };
+		for (uint32_t level = 0; level < header.mipCount; ++level)
+		{
+			file.write(padding, static_cast<std::streamsize>(header.mipOffsets[level] - position));
+			file.write(reinterpret_cast<const char*>(levels[level].data()), static_cast<std::streamsize>(levels[level].size()));
+			position = header.mipOffsets[level] + levels[level].size();
+		}
+
+		return static_cast<bool>(file);
+	}
+
+	bool CookedTexture::IsUpToDate(const std::string& sourcePath) const
+	{
+		return IsValid() && m_pHeader->source.Matches(sourcePath, m_Path, offsetof(Header, source));
+	}
+
+	uint32_t CookedTexture::GetWidth(uint32_t level) const
+	{
+		return GetMipExtent(m_pHeader->width, level);
+	}
+
+	uint32_t CookedTexture::GetHeight(uint32_t level) const
+	{
+		return GetMipExtent(m_pHeader->height, level);
+	}
+
+	uint32_t CookedTexture::GetRowPitch(uint32_t level) const
+	{
+		return dae::GetRowPitch(m_pHeader->format, GetWidth(level));
+	}
+
+	uint64_t CookedTexture::GetMipSize(uint32_t level) const
+	{
+		return GetLevelSize(m_pHeader->format, m_pHeader->width, m_pHeader->height, level);
+	}
+
+	const uint8_t* CookedTexture::GetMipData(uint32_t level) const
+	{
+		return reinterpret_cast<const uint8_t*>(m_File.GetData() + m_pHeader->mipOffsets[level]);
+	}
+}
@@ -0,0 +1,72 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "BlockCompressor.h"
+#include "MappedFile.h"
+#include "MipGenerator.h"
+#include "SourceStamp.h"
+#include "TextureFormat.h"
+
+namespace dae
+{
+	//Binary texture container: header and the full mip chain, every level laid out the way the GPU takes it
+	class CookedTexture final
+	{
+	public:
+		static constexpr uint32_t Magic{ 0x54454144 }; //"DAET"
+		static constexpr uint32_t Version{ 3 };
+		//Enough for 32768x32768
+		static constexpr uint32_t MaxMipCount{ 16 };
+
+		struct Header
+		{
+			uint32_t magic;
+			uint32_t version;
+			TextureFormat format;
+			//How the mips were filtered and compressed
+			MipContent content;
+			MipFilter filter;
+			CompressionQuality quality;
+			uint32_t width;
+			uint32_t height;
+			uint32_t mipCount;
+			uint64_t mipOffsets[MaxMipCount];
+			SourceStamp source;
+		};
+
+		explicit CookedTexture(const std::string& path);
+		~CookedTexture() = default;
+
+		CookedTexture(const CookedTexture&) = delete;
+		CookedTexture(CookedTexture&&) noexcept = delete;
+		CookedTexture& operator=(const CookedTexture&) = delete;
+		CookedTexture& operator=(CookedTexture&&) noexcept = delete;
+
+		static std::string GetCookedPath(const std::string& sourcePath);
+		//levels holds the data of every level of a width x height mip chain in format, level 0 first, like BlockCompressor::Encode makes them
+		static bool Write(const std::string& path, TextureFormat format, uint32_t width, uint32_t height, const std::vector<std::vector<uint8_t>>& levels,
+			MipContent content, MipFilter filter, CompressionQuality quality, const std::string& sourcePath);
+
+		bool IsValid() const { return m_pHeader != nullptr; }
+		bool IsUpToDate(const std::string& sourcePath) const;
+
+		const Header& GetHeader() const { return *m_pHeader; }
+		TextureFormat GetFormat() const { return m_pHeader->format; }
+		MipContent GetContent() const { return m_pHeader->content; }
+		MipFilter GetFilter() const { return m_pHeader->filter; }
+		CompressionQuality GetQuality() const { return m_pHeader->quality; }
+		uint32_t GetMipCount() const { return m_pHeader->mipCount; }
+		uint32_t GetWidth(uint32_t level = 0) const;
+		uint32_t GetHeight(uint32_t level = 0) const;
+		//Bytes from one row of texels to the next, of blocks for block compressed formats
+		uint32_t GetRowPitch(uint32_t level) const;
+		uint64_t GetMipSize(uint32_t level) const;
+		const uint8_t* GetMipData(uint32_t level) const;
+
+	private:
+		MappedFile m_File;
+		std::string m_Path;
+		const Header* m_pHeader{ nullptr };
+	};
+}
@@ -11,6 +11,11 @@ Effect::Effect(ID3D11Device* pDevice, const std::wstring& assetFile)
 	if (!m_pTechnique->IsValid())
 		std::wcout << L"Technique not valid\n";
 
+	//Optional
+	m_pCompactTechnique = m_pEffect->GetTechniqueByName("CompactTechnique");
+	if (!m_pCompactTechnique->IsValid())
+		m_pCompactTechnique = nullptr;
+
 	//World
 	m_pMatWorldViewProjVariable = m_pEffect->GetVariableByName("gWorldViewProj")->AsMatrix();
 	if (!m_pMatWorldViewProjVariable->IsValid())
@@ -81,6 +86,37 @@ ID3DX11EffectTechnique* Effect::GetTechnique() const
 	return m_pTechnique;
 }
 
+ID3DX11EffectTechnique* Effect::GetCompactTechnique() const
+{
+	return m_pCompactTechnique;
+}
+
+bool Effect::IsOpaque() const
+{
+	ID3DX11EffectBlendVariable* pBlendVariable = m_pEffect->GetVariableByName("gBlendState")->AsBlend();
+	if (!pBlendVariable->IsValid())
+		return true;
+
+	D3D11_BLEND_DESC blendDesc{};
+	if (FAILED(pBlendVariable->GetBackingStore(0, &blendDesc)))
+		return true;
+
+	return !blendDesc.RenderTarget[0].BlendEnable;
+}
+
+bool Effect::IsBackfaceCulled() const
+{
+	ID3DX11EffectRasterizerVariable* pRasterizerVariable = m_pEffect->GetVariableByName("gRasterizerState")->AsRasterizer();
+	if (!pRasterizerVariable->IsValid())
+		return false;
+
+	D3D11_RASTERIZER_DESC rasterizerDesc{};
+	if (FAILED(pRasterizerVariable->GetBackingStore(0, &rasterizerDesc)))
+		return false;
+
+	return rasterizerDesc.CullMode == D3D11_CULL_BACK && !rasterizerDesc.FrontCounterClockwise;
+}
+
 //World
 void Effect::SetMatWorldViewProj(const Matrix& matrix) const
 {
@@ -101,7 +137,17 @@ void Effect::SetViewInverseVariable(const Matrix& matrix) const
 void Effect::SetDiffuseMap(const Texture* pDiffuseTexture)
 {
 	if (pDiffuseTexture)
+	{
+		m_pDiffuseMap = pDiffuseTexture;
 		m_pDiffuseMapVariable->SetResource(pDiffuseTexture->GetSRV());
+	}
+}
+
+void Effect::SetMaterial(const Material* pMaterial) const
+{
+	const Texture* pDiffuseMap = pMaterial && pMaterial->pDiffuseMap ? pMaterial->pDiffuseMap : m_pDiffuseMap;
+	if (pDiffuseMap)
+		m_pDiffuseMapVariable->SetResource(pDiffuseMap->GetSRV());
 }
 
 void Effect::SetUseNormalMap(const bool useNormalMap) const
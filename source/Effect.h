@@ -1,4 +1,5 @@
 #pragma once
+#include "Material.h"
 #include "Texture.h"
 
 class Effect
@@ -13,6 +14,12 @@ public:
 	Effect& operator=(Effect&& other) = delete;
 
 	ID3DX11EffectTechnique* GetTechnique() const;
+	//Technique reading the compact vertex layouts, nullptr when the effect has none
+	ID3DX11EffectTechnique* GetCompactTechnique() const;
+	//False when the effect blends, the triangle order of its meshes then changes the result
+	bool IsOpaque() const;
+	//True when the rasterizer drops back faces of clockwise front faces, so their triangles can be culled on the CPU as well
+	bool IsBackfaceCulled() const;
 
 	//World
 	void SetMatWorldViewProj(const dae::Matrix& matrix) const;
@@ -21,17 +28,21 @@ public:
 
 	//Texture
 	void SetDiffuseMap(const dae::Texture* pDiffuseTexture);
+	//Binds the maps of a material, maps it leaves null (or a null material) bind the ones set on the effect
+	virtual void SetMaterial(const dae::Material* pMaterial) const;
 
 	virtual void SetUseNormalMap(const bool useNormalMap) const;
 protected:
 	ID3DX11Effect* m_pEffect{ nullptr };
 	ID3DX11EffectTechnique* m_pTechnique{ nullptr };
+	ID3DX11EffectTechnique* m_pCompactTechnique{ nullptr };
 
 	//World
 	ID3DX11EffectMatrixVariable* m_pMatWorldViewProjVariable{ nullptr };
 
 	//Texture
 	ID3DX11EffectShaderResourceVariable* m_pDiffuseMapVariable{ nullptr };
+	const dae::Texture* m_pDiffuseMap{ nullptr };
 
 	static ID3DX11Effect* LoadEffect(ID3D11Device* pDevice, const std::wstring& assetFile);
 };
\ No newline at end of file
@@ -0,0 +1,254 @@
+#include "pch.h"
+#include "HalfEdgeMesh.h"
+
+#include <cstring>
+#include "ParallelFor.h"
+
+namespace dae
+{
+	namespace
+	{
+		constexpr uint32_t RadixBits{ 12 };
+		constexpr uint32_t RadixSize{ 1u << RadixBits };
+		//Runs of equal keys up to this long are sorted by insertion
+		constexpr uint32_t MaxInsertionRun{ 16 };
+
+		bool IsSamePosition(const Vector3& a, const Vector3& b)
+		{
+			return a.x == b.x && a.y == b.y && a.z == b.z;
+		}
+
+		uint32_t HashPosition(const Vector3& position)
+		{
+			//Adding zero turns -0 into +0, they compare equal so they have to hash the same
+			const float components[3]{ position.x + 0.f, position.y + 0.f, position.z + 0.f };
+			uint32_t bits[3]{};
+			std::memcpy(bits, components, sizeof(bits));
+
+			uint32_t hash{ bits[0] * 0x9E3779B1u };
+			hash = (hash ^ (hash >> 15) ^ bits[1]) * 0x85EBCA77u;
+			hash = (hash ^ (hash >> 13) ^ bits[2]) * 0xC2B2AE3Du;
+			return hash ^ (hash >> 16);
+		}
+
+		//Stable least significant digit radix sort of values by keys, one contiguous chunk per thread.
+		//Every pass counts digits per chunk, then scatters each chunk to its slots in digit, chunk order.
+		void RadixSort(std::vector<uint32_t>& keys, std::vector<uint32_t>& values, uint32_t maxKey, size_t numThreads)
+		{
+			const size_t count{ keys.size() };
+			const size_t numJobs{ std::max(std::min(numThreads, count / RadixSize), size_t{ 1 }) };
+			std::vector<uint32_t> sortedKeys(count);
+			std::vector<uint32_t> sortedValues(count);
+			std::vector<size_t> offsets(numJobs * RadixSize);
+
+			for (uint32_t shift = 0; shift < 32 && (maxKey >> shift) > 0; shift += RadixBits)
+			{
+				Utils::ParallelFor(numJobs, numJobs, [&](size_t begin, size_t end)
+					{
+						for (size_t job = begin; job < end; ++job)
+						{
+							size_t* pCounts = offsets.data() + job * RadixSize;
+							std::fill(pCounts, pCounts + RadixSize, size_t{ 0 });
+							for (size_t i = count * job / numJobs; i < count * (job + 1) / numJobs; ++i)
+								++pCounts[(keys[i] >> shift) & (RadixSize - 1)];
+						}
+					});
+
+				size_t total{};
+				for (uint32_t digit = 0; digit < RadixSize; ++digit)
+				{
+					for (size_t job = 0; job < numJobs; ++job)
+					{
+						const size_t digitCount{ offsets[job * RadixSize + digit] };
+						offsets[job * RadixSize + digit] = total;
+						total += digitCount;
+					}
+				}
+
+				Utils::ParallelFor(numJobs, numJobs, [&](size_t begin, size_t end)
+					{
+						for (size_t job = begin; job < end; ++job)
+						{
+							size_t* pOffsets = offsets.data() + job * RadixSize;
+							for (size_t i = count * job / numJobs; i < count * (job + 1) / numJobs; ++i)
+							{
+								const size_t slot{ pOffsets[(keys[i] >> shift) & (RadixSize - 1)]++ };
+								sortedKeys[slot] = keys[i];
+								sortedValues[slot] = values[i];
+							}
+						}
+					});
+
+				keys.swap(sortedKeys);
+				values.swap(sortedValues);
+			}
+		}
+	}
+
+	HalfEdgeMesh::HalfEdgeMesh(const std::vector<Vertex>& vertices, const std::vector<uint32_t>& indices, size_t numThreads)
+	{
+		const size_t numHalfEdges{ indices.size() / 3 * 3 };
+		const uint32_t numPositions{ WeldPositions(vertices, m_PositionIds, numThreads) };
+
+		m_Vertices.assign(indices.begin(), indices.begin() + numHalfEdges);
+		m_Origins.resize(numHalfEdges);
+		m_Twins.assign(numHalfEdges, Invalid);
+
+		//Every half-edge is keyed by the lower of its two positions, so both halves of an edge land in the same run
+		std::vector<uint32_t> keys(numHalfEdges);
+		std::vector<uint32_t> halfEdges(numHalfEdges);
+		Utils::ParallelFor(numHalfEdges, numThreads, [&](size_t begin, size_t end)
+			{
+				for (size_t halfEdge = begin; halfEdge < end; ++halfEdge)
+				{
+					m_Origins[halfEdge] = m_PositionIds[indices[halfEdge]];
+					const uint32_t target{ m_PositionIds[indices[GetNext(static_cast<uint32_t>(halfEdge))]] };
+					keys[halfEdge] = std::min(m_Origins[halfEdge], target);
+					halfEdges[halfEdge] = static_cast<uint32_t>(halfEdge);
+				}
+			});
+
+		RadixSort(keys, halfEdges, numPositions > 0 ? numPositions - 1 : 0, numThreads);
+
+		//Within a run the half-edges are ordered by their other position, an edge's halves end up next to each other.
+		//Jobs move their bounds to the start of a run so no run is split.
+		const size_t numJobs{ std::max(std::min(numThreads, numHalfEdges), size_t{ 1 }) };
+		std::vector<uint32_t> borderCounts(numJobs);
+		std::vector<uint32_t> nonManifoldCounts(numJobs);
+		Utils::ParallelFor(numJobs, numJobs, [&](size_t beginJob, size_t endJob)
+			{
+				for (size_t job = beginJob; job < endJob; ++job)
+				{
+					const auto alignToRun = [&](size_t i)
+						{
+							while (i > 0 && i < numHalfEdges && keys[i] == keys[i - 1])
+								++i;
+							return i;
+						};
+
+					const size_t end{ alignToRun(numHalfEdges * (job + 1) / numJobs) };
+					for (size_t runStart = alignToRun(numHalfEdges * job / numJobs); runStart < end; )
+					{
+						size_t runEnd{ runStart + 1 };
+						while (runEnd < numHalfEdges && keys[runEnd] == keys[runStart])
+							++runEnd;
+
+						//Sorting by the sum of both positions orders by the other one, the lower one is the run's key
+						uint32_t* pRun = halfEdges.data() + runStart;
+						const auto isBefore = [&](uint32_t lhs, uint32_t rhs)
+							{
+								const uint64_t lhsKey{ (uint64_t(m_Origins[lhs]) + m_Origins[GetNext(lhs)]) << 32 | lhs };
+								const uint64_t rhsKey{ (uint64_t(m_Origins[rhs]) + m_Origins[GetNext(rhs)]) << 32 | rhs };
+								return lhsKey < rhsKey;
+							};
+
+						const size_t runLength{ runEnd - runStart };
+						if (runLength <= MaxInsertionRun)
+						{
+							for (size_t i = 1; i < runLength; ++i)
+							{
+								const uint32_t halfEdge{ pRun[i] };
+								size_t j{ i };
+								for (; j > 0 && isBefore(halfEdge, pRun[j - 1]); --j)
+									pRun[j] = pRun[j - 1];
+								pRun[j] = halfEdge;
+							}
+						}
+						else
+						{
+							std::sort(pRun, pRun + runLength, isBefore);
+						}
+
+						//Pair the halves of every edge, anything but two opposite halves is left without twins
+						for (size_t edgeStart = 0; edgeStart < runLength; )
+						{
+							const uint32_t target{ m_Origins[pRun[edgeStart]] + m_Origins[GetNext(pRun[edgeStart])] };
+							size_t edgeEnd{ edgeStart + 1 };
+							while (edgeEnd < runLength && m_Origins[pRun[edgeEnd]] + m_Origins[GetNext(pRun[edgeEnd])] == target)
+								++edgeEnd;
+
+							const size_t numShared{ edgeEnd - edgeStart };
+							if (numShared == 2 && m_Origins[pRun[edgeStart]] != m_Origins[pRun[edgeStart + 1]])
+							{
+								m_Twins[pRun[edgeStart]] = pRun[edgeStart + 1];
+								m_Twins[pRun[edgeStart + 1]] = pRun[edgeStart];
+							}
+							else if (numShared == 1)
+							{
+								++borderCounts[job];
+							}
+							else
+							{
+								nonManifoldCounts[job] += static_cast<uint32_t>(numShared);
+							}
+
+							edgeStart = edgeEnd;
+						}
+
+						runStart = runEnd;
+					}
+				}
+			});
+
+		for (size_t job = 0; job < numJobs; ++job)
+		{
+			m_NumBorders += borderCounts[job];
+			m_NumNonManifold += nonManifoldCounts[job];
+		}
+
+		//The lowest half-edge leaving every position, a border one wins so fan walks start at the border
+		m_Outgoing.assign(numPositions, Invalid);
+		for (uint32_t halfEdge = 0; halfEdge < numHalfEdges; ++halfEdge)
+		{
+			uint32_t& outgoing = m_Outgoing[m_Origins[halfEdge]];
+			if (outgoing == Invalid || (m_Twins[halfEdge] == Invalid && m_Twins[outgoing] != Invalid))
+				outgoing = halfEdge;
+		}
+	}
+
+	uint32_t HalfEdgeMesh::WeldPositions(const std::vector<Vertex>& vertices, std::vector<uint32_t>& positionIds, size_t numThreads)
+	{
+		std::vector<uint32_t> hashes(vertices.size());
+		Utils::ParallelFor(vertices.size(), numThreads, [&](size_t begin, size_t end)
+			{
+				for (size_t vertexIdx = begin; vertexIdx < end; ++vertexIdx)
+					hashes[vertexIdx] = HashPosition(vertices[vertexIdx].position);
+			});
+
+		size_t capacity{ 16 };
+		while (capacity < vertices.size() * 2)
+			capacity <<= 1;
+
+		//Slots hold the first vertex seen at a position
+		std::vector<uint32_t> slots(capacity, Invalid);
+		const size_t mask{ capacity - 1 };
+		uint32_t numPositions{};
+		positionIds.resize(vertices.size());
+		for (size_t vertexIdx = 0; vertexIdx < vertices.size(); ++vertexIdx)
+		{
+			for (size_t slotIdx = hashes[vertexIdx] & mask; ; slotIdx = (slotIdx + 1) & mask)
+			{
+				if (slots[slotIdx] == Invalid)
+				{
+					slots[slotIdx] = static_cast<uint32_t>(vertexIdx);
+					positionIds[vertexIdx] = numPositions++;
+					break;
+				}
+
+				if (IsSamePosition(vertices[slots[slotIdx]].position, vertices[vertexIdx].position))
+				{
+					positionIds[vertexIdx] = positionIds[slots[slotIdx]];
+					break;
+				}
+			}
+		}
+
+		return numPositions;
+	}
+
+	bool HalfEdgeMesh::IsSeam(uint32_t halfEdge) const
+	{
+		const uint32_t twin{ m_Twins[halfEdge] };
+		return twin != Invalid && (m_Vertices[halfEdge] != m_Vertices[GetNext(twin)] || m_Vertices[GetNext(halfEdge)] != m_Vertices[twin]);
+	}
+}
@@ -0,0 +1,71 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+#include "Vertex.h"
+
+namespace dae
+{
+	//Edge adjacency of an indexed triangle list, in flat arrays with one entry per corner and no per-element allocations.
+	//Half-edge h runs from corner h to the next corner of triangle h / 3, so next, previous and face need no storage.
+	//Vertices are matched by exact position, so uv and normal seams don't cut the connectivity.
+	class HalfEdgeMesh final
+	{
+	public:
+		static constexpr uint32_t Invalid{ UINT32_MAX };
+
+		//Time linear in the triangle count, the edge keys are radix sorted on numThreads threads.
+		//Edges shared by more than two triangles or by two with opposite windings get no twins, like borders.
+		//The result doesn't depend on numThreads.
+		HalfEdgeMesh(const std::vector<Vertex>& vertices, const std::vector<uint32_t>& indices, size_t numThreads = 1);
+
+		//Gives every vertex a dense id shared by all vertices at exactly the same position, ids follow first use
+		static uint32_t WeldPositions(const std::vector<Vertex>& vertices, std::vector<uint32_t>& positionIds, size_t numThreads = 1);
+
+		static uint32_t GetNext(uint32_t halfEdge) { return halfEdge % 3 == 2 ? halfEdge - 2 : halfEdge + 1; }
+		static uint32_t GetPrevious(uint32_t halfEdge) { return halfEdge % 3 == 0 ? halfEdge + 2 : halfEdge - 1; }
+		static uint32_t GetFace(uint32_t halfEdge) { return halfEdge / 3; }
+
+		uint32_t GetTwin(uint32_t halfEdge) const { return m_Twins[halfEdge]; }
+		bool IsBorder(uint32_t halfEdge) const { return m_Twins[halfEdge] == Invalid; }
+		//Welded positions the half-edge leaves and reaches
+		uint32_t GetOrigin(uint32_t halfEdge) const { return m_Origins[halfEdge]; }
+		uint32_t GetTarget(uint32_t halfEdge) const { return m_Origins[GetNext(halfEdge)]; }
+		//True when both sides of the edge meet at the same positions but not at the same vertices, a uv or normal seam
+		bool IsSeam(uint32_t halfEdge) const;
+
+		uint32_t GetPositionId(uint32_t vertex) const { return m_PositionIds[vertex]; }
+		//A half-edge leaving the position, the border one if the position has one
+		uint32_t GetOutgoing(uint32_t position) const { return m_Outgoing[position]; }
+
+		//Calls visitor(halfEdge) for the half-edges leaving position, walking the fan of triangles around it.
+		//The fan of a non-manifold position is only walked as far as the first one the outgoing half-edge belongs to.
+		template<typename Visitor>
+		void ForEachOutgoing(uint32_t position, const Visitor& visitor) const
+		{
+			const uint32_t first{ m_Outgoing[position] };
+			uint32_t halfEdge{ first };
+			while (halfEdge != Invalid)
+			{
+				visitor(halfEdge);
+				halfEdge = m_Twins[GetPrevious(halfEdge)];
+				if (halfEdge == first)
+					break;
+			}
+		}
+
+		uint32_t GetHalfEdgeCount() const { return static_cast<uint32_t>(m_Origins.size()); }
+		uint32_t GetPositionCount() const { return static_cast<uint32_t>(m_Outgoing.size()); }
+		uint32_t GetBorderCount() const { return m_NumBorders; }
+		uint32_t GetNonManifoldCount() const { return m_NumNonManifold; }
+
+	private:
+		std::vector<uint32_t> m_Origins{};
+		std::vector<uint32_t> m_Vertices{};
+		std::vector<uint32_t> m_Twins{};
+		std::vector<uint32_t> m_PositionIds{};
+		std::vector<uint32_t> m_Outgoing{};
+		uint32_t m_NumBorders{};
+		//Half-edges left without a twin because their edge isn't shared by exactly two consistently wound triangles
+		uint32_t m_NumNonManifold{};
+	};
+}
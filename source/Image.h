@@ -0,0 +1,16 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+
+namespace dae
+{
+	//8 bit RGBA pixels, rows top to bottom without padding
+	struct Image
+	{
+		uint32_t width{};
+		uint32_t height{};
+		std::vector<uint8_t> pixels{};
+
+		bool IsEmpty() const { return pixels.empty(); }
+	};
+}
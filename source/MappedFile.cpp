@@ -0,0 +1,104 @@
+#include "pch.h"
+#include "MappedFile.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace dae
+{
+	MappedFile::MappedFile(const std::string& path)
+	{
+#ifdef _WIN32
+		//Shared for writing so a cooked file's source stamp can be refreshed while the file is mapped
+		HANDLE fileHandle = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE, nullptr, OPEN_EXISTING,
+			FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+		if (fileHandle == INVALID_HANDLE_VALUE)
+			return;
+
+		m_FileHandle = fileHandle;
+
+		LARGE_INTEGER fileSize{};
+		if (!GetFileSizeEx(fileHandle, &fileSize))
+		{
+			Close();
+			return;
+		}
+
+		m_Size = static_cast<size_t>(fileSize.QuadPart);
+		m_IsOpen = true;
+
+		//Mapping an empty file fails, there is nothing to read anyway
+		if (m_Size == 0)
+			return;
+
+		m_MappingHandle = CreateFileMappingA(fileHandle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+		if (!m_MappingHandle)
+		{
+			Close();
+			return;
+		}
+
+		m_pData = static_cast<const char*>(MapViewOfFile(m_MappingHandle, FILE_MAP_READ, 0, 0, 0));
+		if (!m_pData)
+			Close();
+#else
+		m_FileDescriptor = open(path.c_str(), O_RDONLY);
+		if (m_FileDescriptor < 0)
+			return;
+
+		struct stat fileStat{};
+		if (fstat(m_FileDescriptor, &fileStat) != 0)
+		{
+			Close();
+			return;
+		}
+
+		m_Size = static_cast<size_t>(fileStat.st_size);
+		m_IsOpen = true;
+
+		if (m_Size == 0)
+			return;
+
+		void* pMapped = mmap(nullptr, m_Size, PROT_READ, MAP_PRIVATE, m_FileDescriptor, 0);
+		if (pMapped == MAP_FAILED)
+		{
+			Close();
+			return;
+		}
+
+		madvise(pMapped, m_Size, MADV_SEQUENTIAL);
+		m_pData = static_cast<const char*>(pMapped);
+#endif
+	}
+
+	MappedFile::~MappedFile()
+	{
+		Close();
+	}
+
+	void MappedFile::Close()
+	{
+#ifdef _WIN32
+		if (m_pData) UnmapViewOfFile(m_pData);
+		if (m_MappingHandle) CloseHandle(m_MappingHandle);
+		if (m_FileHandle) CloseHandle(m_FileHandle);
+
+		m_MappingHandle = nullptr;
+		m_FileHandle = nullptr;
+#else
+		if (m_pData) munmap(const_cast<char*>(m_pData), m_Size);
+		if (m_FileDescriptor >= 0) close(m_FileDescriptor);
+
+		m_FileDescriptor = -1;
+#endif
+		m_pData = nullptr;
+		m_Size = 0;
+		m_IsOpen = false;
+	}
+}
@@ -0,0 +1,15 @@
+#pragma once
+
+namespace dae
+{
+	class Texture;
+
+	//Maps of one OBJ material, a null map falls back to the one set on the effect
+	struct Material
+	{
+		const Texture* pDiffuseMap{ nullptr };
+		const Texture* pNormalMap{ nullptr };
+		const Texture* pSpecularMap{ nullptr };
+		const Texture* pGlossinessMap{ nullptr };
+	};
+}
@@ -1,4 +1,5 @@
 #pragma once
+#include <cfloat>
 #include <cmath>
 
 namespace dae
@@ -56,4 +57,13 @@ namespace dae
 		if (v > 1.f) return 1.f;
 		return v;
 	}
+
+	//Abramowitz and Stegun 4.4.45, within 7e-5 radians of acos
+	inline float AcosApprox(float x)
+	{
+		const float absX{ fabsf(x) };
+		const float polynomial{ 1.5707288f + absX * (-.2121144f + absX * (.0742610f + absX * -.0187293f)) };
+		const float angle{ sqrtf(1.f - absX) * polynomial };
+		return x < 0.f ? 3.14159265f - angle : angle;
+	}
 }
\ No newline at end of file
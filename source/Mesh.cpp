@@ -1,55 +1,147 @@
 #include "pch.h"
 #include "Mesh.h"
 #include "Effect.h"
+#include "Camera.h"
 #include <cassert>
 #include "Utils.h"
+#include "CookedMesh.h"
+#include "MeshCooker.h"
+#include "StaticBatcher.h"
+#include <cstring>
 
-Mesh::Mesh(ID3D11Device* pDevice, const std::string& filename, Effect* pEffect)
+Mesh::Mesh(ID3D11Device* pDevice, Effect* pEffect, dae::VertexLayout layout)
 	:m_pEffect{pEffect}
 {
-	std::vector<Vertex> vertices;
-	std::vector<uint32_t> indices;
+	m_pTechnique = m_pEffect->GetTechnique();
+	if (layout != dae::VertexLayout::Full)
+	{
+		if (ID3DX11EffectTechnique* pCompactTechnique = m_pEffect->GetCompactTechnique())
+			m_pTechnique = pCompactTechnique;
+		else
+			layout = dae::VertexLayout::Full;
+	}
+
+	m_VertexLayout = layout;
+	m_VertexStride = dae::VertexCodec::GetStride(layout);
+	m_IsBackfaceCulled = m_pEffect->IsBackfaceCulled();
+	CreateInputLayout(pDevice);
+}
+
+namespace
+{
+	//Only the full layout keeps the vertex color, the asset cooker bakes light into meshes in it.
+	//Such a mesh loads in the full layout, cooking it again in the one asked for would drop the light.
+	dae::VertexLayout GetLoadLayout(const std::string& filename, bool isOpaque, dae::VertexLayout layout)
+	{
+		const dae::CookedMesh cookedMesh{ dae::CookedMesh::GetCookedPath(filename) };
+		if (cookedMesh.IsUpToDate(filename) && cookedMesh.GetVertexLayout() == dae::VertexLayout::Full && cookedMesh.IsOpaque() == isOpaque && cookedMesh.IsBaked())
+			return dae::VertexLayout::Full;
+		return layout;
+	}
+}
+
+Mesh::Mesh(ID3D11Device* pDevice, const std::string& filename, Effect* pEffect, dae::VertexLayout layout)
+	:Mesh(pDevice, pEffect, GetLoadLayout(filename, pEffect->IsOpaque(), layout))
+{
+	//Cooked meshes skip parsing and processing, only their vertex and index blocks need decoding
+	const bool isOpaque{ m_pEffect->IsOpaque() };
+	{
+		const dae::CookedMesh cookedMesh{ dae::CookedMesh::GetCookedPath(filename) };
+		if (cookedMesh.IsUpToDate(filename) && cookedMesh.GetVertexLayout() == m_VertexLayout && cookedMesh.IsOpaque() == isOpaque)
+		{
+			const dae::CookedMesh::Header& header = cookedMesh.GetHeader();
+			SetBounds({ header.boundsMin[0], header.boundsMin[1], header.boundsMin[2] }, { header.boundsMax[0], header.boundsMax[1], header.boundsMax[2] });
+			m_DrawRanges.assign(cookedMesh.GetRanges(), cookedMesh.GetRanges() + cookedMesh.GetRangeCount());
+			m_Lods.assign(cookedMesh.GetLods(), cookedMesh.GetLods() + cookedMesh.GetLodCount());
+			m_RangeSubmeshes.assign(cookedMesh.GetRangeSubmeshes(), cookedMesh.GetRangeSubmeshes() + cookedMesh.GetRangeCount());
+			m_SubmeshMaterials = cookedMesh.GetSubmeshMaterials();
+			m_Materials.resize(m_SubmeshMaterials.size());
+			SetMeshlets(cookedMesh.GetMeshlets(), cookedMesh.GetMeshletCount());
+			CreateBuffers(pDevice, cookedMesh.GetVertices(), cookedMesh.GetVertexCount(), cookedMesh.GetIndices(), cookedMesh.GetIndexStride(), cookedMesh.GetIndexCount());
+			CreatePickingData(cookedMesh.GetVertices(), cookedMesh.GetVertexCount(), cookedMesh.GetIndices(), { header.boundsMin[0], header.boundsMin[1], header.boundsMin[2] },
+				{ header.boundsMax[0], header.boundsMax[1], header.boundsMax[2] });
+			return;
+		}
+	}
 
-	if (!dae::Utils::ParseOBJ(filename, vertices, indices))
+	//The same cook the asset cooker runs ahead of time, with this effect's blend state.
+	//Loading never spends time ray tracing a vertex color, only the asset cooker's --bake-light does.
+	dae::CookedMeshData data{};
+	if (!dae::MeshCooker::CookObj(filename, m_VertexLayout, isOpaque, nullptr, 0, dae::Utils::GetWorkerCount(), data, std::cout))
+	{
 		std::cout << "Couldn't find file to parse\n";
+		return;
+	}
 
-	m_pTechnique = m_pEffect->GetTechnique();
-	
+	Upload(pDevice, data);
+}
+
+Mesh::Mesh(ID3D11Device* pDevice, dae::StaticBatch batch, Effect* pEffect, dae::VertexLayout layout)
+	:Mesh(pDevice, pEffect, layout)
+{
+	if (batch.indices.empty())
+	{
+		std::cout << "Static batch is empty\n";
+		return;
+	}
+
+	//Batches are assembled at load time from meshes that may be cooked themselves, there's no source file to cook them against
+	Upload(pDevice, dae::MeshCooker::Cook(batch.vertices, batch.indices, batch.materialRanges, m_VertexLayout, m_pEffect->IsOpaque(), "Static batch", std::cout));
+}
+
+void Mesh::Upload(ID3D11Device* pDevice, const dae::CookedMeshData& data)
+{
+	m_SubmeshMaterials = data.submeshMaterials;
+	m_Materials.resize(m_SubmeshMaterials.size());
+	m_Lods = data.lods;
+	m_RangeSubmeshes = data.rangeSubmeshes;
+	m_DrawRanges = data.indices.ranges;
+
+	SetBounds(data.vertices.boundsMin, data.vertices.boundsMax);
+	SetMeshlets(data.meshlets.data(), static_cast<uint32_t>(data.meshlets.size()));
+	CreateBuffers(pDevice, data.vertices.data.data(), data.vertices.count, data.indices.data.data(), data.indices.stride, data.indices.count);
+	CreatePickingData(data.vertices.data.data(), data.vertices.count, data.indices.data.data(), data.vertices.boundsMin, data.vertices.boundsMax);
+}
+
+Mesh::~Mesh()
+{
+	delete m_pEffect;
+
+	if (m_pVertexBuffer) m_pVertexBuffer->Release();
+	if (m_pIndexBuffer) m_pIndexBuffer->Release();
+	if (m_pInputLayout) m_pInputLayout->Release();
+}
+
+void Mesh::CreateInputLayout(ID3D11Device* pDevice)
+{
 	//Create Vertex Layout
-	static constexpr uint32_t numElements{ 5 };
-	D3D11_INPUT_ELEMENT_DESC vertexDesc[numElements]{};
-
-	vertexDesc[0].SemanticName = "POSITION";
-	vertexDesc[0].Format = DXGI_FORMAT_R32G32B32_FLOAT;
-	vertexDesc[0].AlignedByteOffset = 0;
-	vertexDesc[0].InputSlotClass = D3D11_INPUT_PER_VERTEX_DATA;
-
-	vertexDesc[1].SemanticName = "COLOR";
-	vertexDesc[1].Format = DXGI_FORMAT_R32G32B32_FLOAT;
-	vertexDesc[1].AlignedByteOffset = 12;
-	vertexDesc[1].InputSlotClass = D3D11_INPUT_PER_VERTEX_DATA;
-
-	vertexDesc[2].SemanticName = "TEXCOORD";
-	vertexDesc[2].Format = DXGI_FORMAT_R32G32_FLOAT;
-	vertexDesc[2].AlignedByteOffset = 24;
-	vertexDesc[2].InputSlotClass = D3D11_INPUT_PER_VERTEX_DATA;
-
-	vertexDesc[3].SemanticName = "NORMAL";
-	vertexDesc[3].Format = DXGI_FORMAT_R32G32B32_FLOAT;
-	vertexDesc[3].AlignedByteOffset = 32;
-	vertexDesc[3].InputSlotClass = D3D11_INPUT_PER_VERTEX_DATA;
-
-	vertexDesc[4].SemanticName = "TANGENT";
-	vertexDesc[4].Format = DXGI_FORMAT_R32G32B32_FLOAT;
-	vertexDesc[4].AlignedByteOffset = 44;
-	vertexDesc[4].InputSlotClass = D3D11_INPUT_PER_VERTEX_DATA;
+	const std::vector<dae::VertexAttribute> attributes = dae::VertexCodec::GetAttributes(m_VertexLayout);
+	const uint32_t numElements{ static_cast<uint32_t>(attributes.size()) };
+	std::vector<D3D11_INPUT_ELEMENT_DESC> vertexDesc(numElements);
+
+	for (uint32_t i = 0; i < numElements; ++i)
+	{
+		vertexDesc[i].SemanticName = attributes[i].semantic;
+		vertexDesc[i].AlignedByteOffset = attributes[i].offset;
+		vertexDesc[i].InputSlotClass = D3D11_INPUT_PER_VERTEX_DATA;
+
+		switch (attributes[i].format)
+		{
+		case dae::AttributeFormat::Float32x2: vertexDesc[i].Format = DXGI_FORMAT_R32G32_FLOAT; break;
+		case dae::AttributeFormat::Float32x3: vertexDesc[i].Format = DXGI_FORMAT_R32G32B32_FLOAT; break;
+		case dae::AttributeFormat::Float32x4: vertexDesc[i].Format = DXGI_FORMAT_R32G32B32A32_FLOAT; break;
+		case dae::AttributeFormat::Float16x2: vertexDesc[i].Format = DXGI_FORMAT_R16G16_FLOAT; break;
+		case dae::AttributeFormat::Unorm16x4: vertexDesc[i].Format = DXGI_FORMAT_R16G16B16A16_UNORM; break;
+		case dae::AttributeFormat::Snorm16x2: vertexDesc[i].Format = DXGI_FORMAT_R16G16_SNORM; break;
+		}
+	}
 
 	//Create Input Layout
 	D3DX11_PASS_DESC passDesc{};
 	m_pTechnique->GetPassByIndex(0)->GetDesc(&passDesc);
 
 	HRESULT result = pDevice->CreateInputLayout(
-		vertexDesc,
+		vertexDesc.data(),
 		numElements,
 		passDesc.pIAInputSignature,
 		passDesc.IAInputSignatureSize,
@@ -57,42 +149,139 @@ Mesh::Mesh(ID3D11Device* pDevice, const std::string& filename, Effect* pEffect)
 
 	if (FAILED(result))
 		assert(false);
+}
 
+void Mesh::CreateBuffers(ID3D11Device* pDevice, const void* pVertices, uint32_t numVertices, const void* pIndices, uint32_t indexStride, uint32_t numIndices)
+{
 	//Create Vertex Buffer
 	D3D11_BUFFER_DESC bd = {};
 	bd.Usage = D3D11_USAGE_IMMUTABLE;
-	bd.ByteWidth = sizeof(Vertex) * static_cast<uint32_t>(vertices.size());
+	bd.ByteWidth = m_VertexStride * numVertices;
 	bd.BindFlags = D3D11_BIND_VERTEX_BUFFER;
 	bd.CPUAccessFlags = 0;
 	bd.MiscFlags = 0;
 
 	D3D11_SUBRESOURCE_DATA initData = {};
-	initData.pSysMem = vertices.data();
+	initData.pSysMem = pVertices;
 
-	result = pDevice->CreateBuffer(&bd, &initData, &m_pVertexBuffer);
+	HRESULT result = pDevice->CreateBuffer(&bd, &initData, &m_pVertexBuffer);
 	if (FAILED(result))
 		return;
 
-	//Create Index Buffer
-	m_NumIndices = static_cast<uint32_t>(indices.size());
+	//Create Index Buffer, culling only picks which parts of it get drawn
+	m_NumIndices = numIndices;
+	m_IndexStride = indexStride;
+	m_IndexFormat = indexStride == sizeof(uint16_t) ? DXGI_FORMAT_R16_UINT : DXGI_FORMAT_R32_UINT;
+
 	bd.Usage = D3D11_USAGE_IMMUTABLE;
-	bd.ByteWidth = sizeof(uint32_t) * m_NumIndices;
+	bd.ByteWidth = indexStride * m_NumIndices;
 	bd.BindFlags = D3D11_BIND_INDEX_BUFFER;
 	bd.CPUAccessFlags = 0;
 	bd.MiscFlags = 0;
-	initData.pSysMem = indices.data();
+	initData.pSysMem = pIndices;
 	result = pDevice->CreateBuffer(&bd, &initData, &m_pIndexBuffer);
 	if (FAILED(result))
 		return;
 }
 
-Mesh::~Mesh()
+void Mesh::CreatePickingData(const void* pVertices, uint32_t numVertices, const void* pIndices, const dae::Vector3& boundsMin, const dae::Vector3& boundsMax)
 {
-	delete m_pEffect;
+	if (m_Lods.empty())
+		return;
 
-	if (m_pVertexBuffer) m_pVertexBuffer->Release();
-	if (m_pIndexBuffer) m_pIndexBuffer->Release();
-	if (m_pInputLayout) m_pInputLayout->Release();
+	//Indices of the first level's ranges, made absolute so they address the whole vertex buffer
+	const dae::MeshLod& lod = m_Lods[0];
+	m_PickingIndices.clear();
+	for (uint32_t rangeIdx = lod.firstRange; rangeIdx < lod.firstRange + lod.rangeCount; ++rangeIdx)
+	{
+		const dae::DrawRange& range = m_DrawRanges[rangeIdx];
+		for (uint32_t i = range.indexStart; i < range.indexStart + range.indexCount; ++i)
+		{
+			const uint8_t* pIndexBytes = static_cast<const uint8_t*>(pIndices);
+			uint32_t index{};
+			if (m_IndexStride == sizeof(uint16_t))
+			{
+				uint16_t shortIndex{};
+				std::memcpy(&shortIndex, pIndexBytes + size_t(i) * sizeof(uint16_t), sizeof(uint16_t));
+				index = shortIndex;
+			}
+			else
+			{
+				std::memcpy(&index, pIndexBytes + size_t(i) * sizeof(uint32_t), sizeof(uint32_t));
+			}
+			m_PickingIndices.push_back(index + range.baseVertex);
+		}
+	}
+
+	const std::vector<Vertex> vertices{ dae::VertexCodec::Decode(m_VertexLayout, pVertices, numVertices, boundsMin, boundsMax) };
+	m_PickingUvs.resize(vertices.size());
+	for (size_t vertexIdx = 0; vertexIdx < vertices.size(); ++vertexIdx)
+		m_PickingUvs[vertexIdx] = vertices[vertexIdx].uv;
+
+	//Ratio of the total areas, so slivers and degenerate triangles barely count
+	double area{};
+	double uvArea{};
+	for (size_t i = 0; i + 2 < m_PickingIndices.size(); i += 3)
+	{
+		const Vertex& v0 = vertices[m_PickingIndices[i]];
+		const Vertex& v1 = vertices[m_PickingIndices[i + 1]];
+		const Vertex& v2 = vertices[m_PickingIndices[i + 2]];
+		area += dae::Vector3::Cross(v1.position - v0.position, v2.position - v0.position).Magnitude();
+		uvArea += std::abs(dae::Vector2::Cross(v1.uv - v0.uv, v2.uv - v0.uv));
+	}
+	m_UvPerUnit = area > 0.0 ? static_cast<float>(std::sqrt(uvArea / area)) : 0.f;
+
+	m_PickingBvh = dae::TriangleBvh{ vertices, m_PickingIndices, dae::Utils::GetWorkerCount() };
+}
+
+void Mesh::SetMeshlets(const dae::Meshlet* pMeshlets, uint32_t numMeshlets)
+{
+	m_Meshlets.assign(pMeshlets, pMeshlets + numMeshlets);
+	m_MeshletCuller.SetMeshlets(m_Meshlets);
+	m_VisibleMeshlets.reserve(m_Meshlets.size());
+}
+
+void Mesh::SetBounds(const dae::Vector3& boundsMin, const dae::Vector3& boundsMax)
+{
+	m_BoundsCenter = (boundsMin + boundsMax) * .5f;
+	m_BoundsRadius = (boundsMax - boundsMin).Magnitude() * .5f;
+
+	if (m_VertexLayout != dae::VertexLayout::CompactQuantized)
+		return;
+
+	//Unorm positions arrive in [0, 1], scale them to the bounds and move them to the minimum
+	const dae::Vector3 extent{ boundsMax - boundsMin };
+	m_DequantizeMatrix = dae::Matrix{ dae::Vector3::UnitX * extent.x, dae::Vector3::UnitY * extent.y, dae::Vector3::UnitZ * extent.z, boundsMin };
+}
+
+bool Mesh::Pick(const dae::Vector3& origin, const dae::Vector3& direction, float maxDistance, MeshHit& hit) const
+{
+	//The direction isn't renormalized in object space, so distances along the ray stay in world units
+	const dae::Matrix worldToObject{ dae::Matrix::Inverse(m_ScaleMatrix * m_RotationMatrix * m_TranslationMatrix) };
+	dae::TriangleBvh::RayHit rayHit{};
+	if (!m_PickingBvh.Intersect(worldToObject.TransformPoint(origin), worldToObject.TransformVector(direction), maxDistance, rayHit))
+		return false;
+
+	const uint32_t* pCorners = m_PickingIndices.data() + size_t(rayHit.triangle) * 3;
+	const float firstWeight{ 1.f - rayHit.u - rayHit.v };
+	const dae::Vector2 uv{ m_PickingUvs[pCorners[0]] * firstWeight + m_PickingUvs[pCorners[1]] * rayHit.u + m_PickingUvs[pCorners[2]] * rayHit.v };
+
+	//The first level's ranges in order make up the picking triangles
+	const dae::MeshLod& lod = m_Lods[0];
+	uint32_t submesh{};
+	uint32_t rangeStart{};
+	for (uint32_t rangeIdx = lod.firstRange; rangeIdx < lod.firstRange + lod.rangeCount; ++rangeIdx)
+	{
+		rangeStart += m_DrawRanges[rangeIdx].indexCount;
+		if (rayHit.triangle * 3 < rangeStart)
+		{
+			submesh = m_RangeSubmeshes[rangeIdx];
+			break;
+		}
+	}
+
+	hit = MeshHit{ rayHit.distance, rayHit.triangle, submesh, dae::Vector2{ rayHit.u, rayHit.v }, uv };
+	return true;
 }
 
 void Mesh::Render(ID3D11DeviceContext* pDeviceContext) const
@@ -104,31 +293,141 @@ void Mesh::Render(ID3D11DeviceContext* pDeviceContext) const
 	pDeviceContext->IASetInputLayout(m_pInputLayout);
 
 	//3. Set VertexBuffer
-	constexpr UINT stride = sizeof(Vertex);
+	const UINT stride = m_VertexStride;
 	constexpr UINT offset = 0;
 	pDeviceContext->IASetVertexBuffers(0, 1, &m_pVertexBuffer, &stride, &offset);
 
 	//4. Set IndexBUffer
-	pDeviceContext->IASetIndexBuffer(m_pIndexBuffer, DXGI_FORMAT_R32_UINT, 0);
+	pDeviceContext->IASetIndexBuffer(m_pIndexBuffer, m_IndexFormat, 0);
+
+	//5. Draw the visible meshlets, or the whole level of detail when they weren't culled,
+	//binding the maps of every submesh once before its ranges
+	const dae::DrawRange* pRanges{ m_VisibleRanges.data() };
+	const uint32_t* pSubmeshes{ m_VisibleSubmeshes.data() };
+	size_t numRanges{ m_VisibleRanges.size() };
+	if (!m_IsCulled)
+	{
+		if (m_Lods.empty())
+			return;
+
+		const dae::MeshLod& lod = m_Lods[m_LodIdx];
+		pRanges = m_DrawRanges.data() + lod.firstRange;
+		pSubmeshes = m_RangeSubmeshes.data() + lod.firstRange;
+		numRanges = lod.rangeCount;
+	}
 
-	//5. Draw
 	D3DX11_TECHNIQUE_DESC techDesc{};
 	m_pTechnique->GetDesc(&techDesc);
 	if (m_Pass < techDesc.Passes)
 	{
-		m_pTechnique->GetPassByIndex(m_Pass)->Apply(0, pDeviceContext);
-		pDeviceContext->DrawIndexed(m_NumIndices, 0, 0);
+		ID3DX11EffectPass* pPass = m_pTechnique->GetPassByIndex(m_Pass);
+		uint32_t boundSubmesh{ UINT32_MAX };
+		for (size_t rangeIdx = 0; rangeIdx < numRanges; ++rangeIdx)
+		{
+			if (pSubmeshes[rangeIdx] != boundSubmesh)
+			{
+				boundSubmesh = pSubmeshes[rangeIdx];
+				m_pEffect->SetMaterial(&m_Materials[boundSubmesh]);
+				pPass->Apply(0, pDeviceContext);
+			}
+
+			const dae::DrawRange& range = pRanges[rangeIdx];
+			pDeviceContext->DrawIndexed(range.indexCount, range.indexStart, static_cast<INT>(range.baseVertex));
+		}
 	}
 }
 
 void Mesh::Update(const dae::Matrix projectionMatrix, const dae::Matrix& inverseViewMatrix)
 {
 	dae::Matrix worldMatrix = m_ScaleMatrix * m_RotationMatrix * m_TranslationMatrix;
-	m_pEffect->SetMatWorldViewProj(worldMatrix * inverseViewMatrix * projectionMatrix);
+	m_pEffect->SetMatWorldViewProj(m_DequantizeMatrix * worldMatrix * inverseViewMatrix * projectionMatrix);
 	m_pEffect->SetWorldMatrixVariable(worldMatrix);
 	m_pEffect->SetViewInverseVariable(inverseViewMatrix);
 }
 
+float Mesh::GetPixelsPerUnit(const dae::Camera& camera, float viewportHeight, float& scale) const
+{
+	const dae::Matrix worldMatrix = m_ScaleMatrix * m_RotationMatrix * m_TranslationMatrix;
+	scale = std::max(std::max(worldMatrix.TransformVector(dae::Vector3::UnitX).Magnitude(), worldMatrix.TransformVector(dae::Vector3::UnitY).Magnitude()),
+		worldMatrix.TransformVector(dae::Vector3::UnitZ).Magnitude());
+
+	//Distance to the nearest point of the bounding sphere, camera.fov holds tan(fov / 2)
+	const dae::Vector3 center{ worldMatrix.TransformPoint(m_BoundsCenter) };
+	const float distance{ std::max((center - camera.origin).Magnitude() - m_BoundsRadius * scale, camera.nearClippingPlane) };
+	return viewportHeight / (2.f * camera.fov * distance);
+}
+
+void Mesh::SelectLod(const dae::Camera& camera, float viewportHeight, float maxPixelError)
+{
+	float scale{};
+	const float pixelsPerUnit{ GetPixelsPerUnit(camera, viewportHeight, scale) };
+
+	//Coarsest level whose error still projects below the limit, visible meshlets of the previous level no longer apply
+	m_IsCulled = false;
+	m_LodIdx = dae::MeshSimplifier::SelectLod(m_Lods, scale * pixelsPerUnit, maxPixelError);
+}
+
+float Mesh::GetPixelsPerUv(const dae::Camera& camera, float viewportHeight) const
+{
+	if ((m_IsCulled && m_VisibleRanges.empty()) || m_UvPerUnit <= 0.f)
+		return 0.f;
+
+	//A world space unit is scale object space units, which span m_UvPerUnit * scale of UV
+	float scale{};
+	const float pixelsPerUnit{ GetPixelsPerUnit(camera, viewportHeight, scale) };
+	return pixelsPerUnit / (m_UvPerUnit * scale);
+}
+
+void Mesh::CullMeshlets(const dae::Camera& camera)
+{
+	m_VisibleRanges.clear();
+	m_VisibleSubmeshes.clear();
+	m_VisibleMeshlets.clear();
+	m_IsCulled = !m_Lods.empty();
+	if (m_Lods.empty())
+		return;
+
+	//Cull in object space, against the frustum of the full transform and the camera moved into the mesh
+	const dae::Matrix worldMatrix = m_ScaleMatrix * m_RotationMatrix * m_TranslationMatrix;
+	const dae::Vector3 cameraPosition{ dae::Matrix::Inverse(worldMatrix).TransformPoint(camera.origin) };
+	const dae::MeshLod& lod = m_Lods[m_LodIdx];
+	m_MeshletCuller.Cull(worldMatrix * camera.GetViewMatrix() * camera.projectionMatrix, cameraPosition, m_IsBackfaceCulled,
+		lod.firstMeshlet, lod.meshletCount, m_VisibleMeshlets);
+
+	//Meshlets are in index order, visible neighbours in the same draw range merge into one draw.
+	//A meshlet crossing into the next draw range is drawn in two parts with each range's base vertex.
+	size_t visibleIdx{};
+	for (uint32_t rangeIdx = lod.firstRange; rangeIdx < lod.firstRange + lod.rangeCount; ++rangeIdx)
+	{
+		const dae::DrawRange& range = m_DrawRanges[rangeIdx];
+		const uint32_t rangeEnd{ range.indexStart + range.indexCount };
+		const size_t firstVisibleRange{ m_VisibleRanges.size() };
+
+		for (; visibleIdx < m_VisibleMeshlets.size(); ++visibleIdx)
+		{
+			const dae::Meshlet& meshlet = m_Meshlets[m_VisibleMeshlets[visibleIdx]];
+			const uint32_t start{ std::max(meshlet.indexStart, range.indexStart) };
+			const uint32_t end{ std::min(meshlet.indexStart + meshlet.indexCount, rangeEnd) };
+			if (start < end)
+			{
+				dae::DrawRange* pLast{ m_VisibleRanges.size() > firstVisibleRange ? &m_VisibleRanges.back() : nullptr };
+				if (pLast && pLast->indexStart + pLast->indexCount == start)
+				{
+					pLast->indexCount += end - start;
+				}
+				else
+				{
+					m_VisibleRanges.push_back(dae::DrawRange{ start, end - start, range.baseVertex, range.vertexCount });
+					m_VisibleSubmeshes.push_back(m_RangeSubmeshes[rangeIdx]);
+				}
+			}
+
+			if (meshlet.indexStart + meshlet.indexCount > rangeEnd)
+				break;
+		}
+	}
+}
+
 void Mesh::RotateX(const float angle)
 {
 	m_RotationMatrix = dae::Matrix::CreateRotationX(angle) * m_RotationMatrix;
@@ -147,4 +446,14 @@ void Mesh::RotateZ(const float angle)
 void Mesh::SetUseNormalMap(const bool useNormalMap)
 {
 	m_pEffect->SetUseNormalMap(useNormalMap);
+}
+
+bool Mesh::SetMaterial(const std::string& materialName, const dae::Material& material)
+{
+	const auto it = std::find(m_SubmeshMaterials.begin(), m_SubmeshMaterials.end(), materialName);
+	if (it == m_SubmeshMaterials.end())
+		return false;
+
+	m_Materials[it - m_SubmeshMaterials.begin()] = material;
+	return true;
 }
\ No newline at end of file
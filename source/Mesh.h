@@ -1,27 +1,53 @@
 #pragma once
 
+#include "Material.h"
 #include "Texture.h"
+#include "MeshSimplifier.h"
+#include "MeshSplitter.h"
+#include "Meshlet.h"
+#include "TriangleBvh.h"
+#include "VertexLayout.h"
 
 class Effect;
 
-struct Vertex
+namespace dae
 {
-	dae::Vector3 position;
-	dae::ColorRGB color;
+	struct Camera;
+	struct CookedMeshData;
+	struct StaticBatch;
+}
+
+//Closest triangle of a mesh under a ray
+struct MeshHit
+{
+	float distance;
+	//Triangle of the finest level of detail, in draw order
+	uint32_t triangle;
+	uint32_t submesh;
+	//Weights of the triangle's second and third corner, the first one gets the rest
+	dae::Vector2 barycentrics;
 	dae::Vector2 uv;
-	dae::Vector3 normal;
-	dae::Vector3 tangent;
 };
 
 class Mesh
 {
 public:
-	Mesh(ID3D11Device* pDevice, const std::string& filename, Effect* pEffect);
+	//Falls back to the full layout when the effect has no compact technique, or when the cooked mesh has light baked into it
+	Mesh(ID3D11Device* pDevice, const std::string& filename, Effect* pEffect, dae::VertexLayout layout = dae::VertexLayout::CompactQuantized);
+	//Draws a merged batch of static meshes, its vertices are already in world space so the mesh keeps an identity world matrix
+	Mesh(ID3D11Device* pDevice, dae::StaticBatch batch, Effect* pEffect, dae::VertexLayout layout = dae::VertexLayout::CompactQuantized);
 	~Mesh();
 
 	void Render(ID3D11DeviceContext* pDeviceContext) const;
 
 	void Update(const dae::Matrix projectionMatrix, const dae::Matrix& inverseViewMatrix);
+	//Picks the coarsest level of detail whose error projects to at most maxPixelError pixels
+	void SelectLod(const dae::Camera& camera, float viewportHeight, float maxPixelError = 1.f);
+	//Culls the meshlets of the selected level of detail, the next Render only draws the visible ones.
+	//Without culling since the last SelectLod, Render draws the whole level.
+	void CullMeshlets(const dae::Camera& camera);
+	//Screen pixels one unit of UV covers at the point of the bounds nearest the camera, 0 when the last CullMeshlets left nothing visible
+	float GetPixelsPerUv(const dae::Camera& camera, float viewportHeight) const;
 
 	void RotateX(const float angle);
 	void RotateY(const float angle);
@@ -29,13 +55,65 @@ public:
 
 	void SetPass(const int passIdx) {m_Pass = passIdx;};
 	void SetUseNormalMap(const bool useNormalMap);
+	//Draws the submesh of an OBJ material with these maps, returns false when the mesh has no such material
+	bool SetMaterial(const std::string& materialName, const dae::Material& material);
+	size_t GetSubmeshCount() const { return m_SubmeshMaterials.size(); }
+	const std::string& GetSubmeshMaterial(uint32_t submesh) const { return m_SubmeshMaterials[submesh]; }
+
+	//Closest hit of a world space ray with a unit direction on the finest level of detail, within maxDistance
+	bool Pick(const dae::Vector3& origin, const dae::Vector3& direction, float maxDistance, MeshHit& hit) const;
 private:
+	Mesh(ID3D11Device* pDevice, Effect* pEffect, dae::VertexLayout layout);
+	//Buffers, draw ranges and meshlets of a mesh MeshCooker cooked
+	void Upload(ID3D11Device* pDevice, const dae::CookedMeshData& data);
+	void CreateInputLayout(ID3D11Device* pDevice);
+	void CreateBuffers(ID3D11Device* pDevice, const void* pVertices, uint32_t numVertices, const void* pIndices, uint32_t indexStride, uint32_t numIndices);
+	void SetMeshlets(const dae::Meshlet* pMeshlets, uint32_t numMeshlets);
+	void SetBounds(const dae::Vector3& boundsMin, const dae::Vector3& boundsMax);
+	//Screen pixels one world space unit covers at the point of the bounds nearest the camera, scale is the largest scale of the world matrix
+	float GetPixelsPerUnit(const dae::Camera& camera, float viewportHeight, float& scale) const;
+	//Decodes the finest level of detail of the uploaded buffers for picking, after CreateBuffers
+	void CreatePickingData(const void* pVertices, uint32_t numVertices, const void* pIndices, const dae::Vector3& boundsMin, const dae::Vector3& boundsMax);
+
 	//Effect
 	Effect* m_pEffect{ nullptr };
 	ID3DX11EffectTechnique* m_pTechnique{ nullptr };
 
 	//Render
+	dae::VertexLayout m_VertexLayout{ dae::VertexLayout::Full };
+	uint32_t m_VertexStride{ sizeof(Vertex) };
 	uint32_t m_NumIndices{};
+	uint32_t m_IndexStride{ sizeof(uint32_t) };
+	DXGI_FORMAT m_IndexFormat{ DXGI_FORMAT_R32_UINT };
+	std::vector<dae::DrawRange> m_DrawRanges{};
+	std::vector<dae::MeshLod> m_Lods{};
+	size_t m_LodIdx{ 0 };
+
+	//One submesh per OBJ material, the ranges of a submesh are drawn after binding its maps
+	std::vector<std::string> m_SubmeshMaterials{};
+	std::vector<dae::Material> m_Materials{};
+	std::vector<uint32_t> m_RangeSubmeshes{};
+
+	//Meshlet culling, visible meshlets are drawn as ranges of the immutable index buffer
+	std::vector<dae::Meshlet> m_Meshlets{};
+	dae::MeshletCuller m_MeshletCuller{};
+	bool m_IsBackfaceCulled{ false };
+	bool m_IsCulled{ false };
+	std::vector<dae::DrawRange> m_VisibleRanges{};
+	std::vector<uint32_t> m_VisibleSubmeshes{};
+	std::vector<uint32_t> m_VisibleMeshlets{};
+
+	//Picking, in object space with positions as the GPU expands them
+	dae::TriangleBvh m_PickingBvh{};
+	std::vector<uint32_t> m_PickingIndices{};
+	std::vector<dae::Vector2> m_PickingUvs{};
+
+	//Average UV units per object space unit over the finest level's triangles
+	float m_UvPerUnit{};
+
+	//Object space bounding sphere
+	dae::Vector3 m_BoundsCenter{};
+	float m_BoundsRadius{};
 
 	ID3D11Buffer* m_pVertexBuffer{ nullptr };
 	ID3D11Buffer* m_pIndexBuffer{ nullptr };
@@ -45,6 +123,8 @@ private:
 	dae::Matrix m_TranslationMatrix{ dae::Vector3::UnitX,dae::Vector3::UnitY, dae::Vector3::UnitZ, dae::Vector3::Zero };
 	dae::Matrix m_RotationMatrix{ dae::Vector3::UnitX,dae::Vector3::UnitY, dae::Vector3::UnitZ, dae::Vector3::Zero };
 	dae::Matrix m_ScaleMatrix{ dae::Vector3::UnitX,dae::Vector3::UnitY, dae::Vector3::UnitZ, dae::Vector3::Zero };
+	//Expands quantized positions to object space, identity for the float layouts
+	dae::Matrix m_DequantizeMatrix{ dae::Vector3::UnitX,dae::Vector3::UnitY, dae::Vector3::UnitZ, dae::Vector3::Zero };
 
 	UINT m_Pass{ 0 };
 };
@@ -0,0 +1,536 @@
+#include "pch.h"
+#include "MeshCodec.h"
+
+#include <cstring>
+#include "ParallelFor.h"
+
+namespace dae
+{
+	namespace MeshCodec
+	{
+		namespace
+		{
+			constexpr uint32_t GroupSize{ 16 };
+			constexpr uint32_t FifoSize{ 16 };
+			//Edge slot that marks a triangle without a recent edge
+			constexpr uint32_t NoEdge{ FifoSize - 1 };
+
+			enum class ThirdVertex : uint8_t
+			{
+				Next,
+				Recent,
+				Explicit
+			};
+
+			uint32_t ReadUint32(const uint8_t* pData)
+			{
+				uint32_t value{};
+				std::memcpy(&value, pData, sizeof(value));
+				return value;
+			}
+
+			//Block count, the end of every block relative to the first one, then the blocks.
+			//Sized once and filled with memcpy, the table and blocks go straight to their offsets.
+			std::vector<uint8_t> JoinBlocks(const std::vector<std::vector<uint8_t>>& blocks)
+			{
+				const size_t tableSize{ (blocks.size() + 1) * sizeof(uint32_t) };
+				size_t totalSize{ tableSize };
+				for (const std::vector<uint8_t>& block : blocks)
+					totalSize += block.size();
+
+				std::vector<uint8_t> data(totalSize);
+				const uint32_t numBlocks{ static_cast<uint32_t>(blocks.size()) };
+				std::memcpy(data.data(), &numBlocks, sizeof(numBlocks));
+
+				uint32_t end{};
+				size_t cursor{ tableSize };
+				for (size_t blockIdx = 0; blockIdx < blocks.size(); ++blockIdx)
+				{
+					const std::vector<uint8_t>& block = blocks[blockIdx];
+					end += static_cast<uint32_t>(block.size());
+					std::memcpy(data.data() + (blockIdx + 1) * sizeof(uint32_t), &end, sizeof(end));
+					if (!block.empty())
+						std::memcpy(data.data() + cursor, block.data(), block.size());
+					cursor += block.size();
+				}
+
+				return data;
+			}
+
+			//Checks the block table against the size and returns where the blocks start, nullptr when it doesn't fit
+			const uint8_t* ReadBlockTable(const uint8_t* pData, size_t size, size_t numBlocks)
+			{
+				const size_t tableSize{ (numBlocks + 1) * sizeof(uint32_t) };
+				if (size < tableSize || ReadUint32(pData) != numBlocks)
+					return nullptr;
+
+				uint32_t previousEnd{};
+				for (size_t block = 0; block < numBlocks; ++block)
+				{
+					const uint32_t end{ ReadUint32(pData + (block + 1) * sizeof(uint32_t)) };
+					if (end < previousEnd)
+						return nullptr;
+					previousEnd = end;
+				}
+
+				return previousEnd == size - tableSize ? pData + tableSize : nullptr;
+			}
+
+			void GetBlockBounds(const uint8_t* pData, size_t block, uint32_t& begin, uint32_t& end)
+			{
+				begin = block > 0 ? ReadUint32(pData + block * sizeof(uint32_t)) : 0;
+				end = ReadUint32(pData + (block + 1) * sizeof(uint32_t));
+			}
+
+			/* --- VERTICES --- */
+			void EncodeVertexBlock(const uint8_t* pVertices, size_t count, size_t stride, std::vector<uint8_t>& data)
+			{
+				const size_t numGroups{ (count + GroupSize - 1) / GroupSize };
+				uint8_t deltas[VertexBlockSize]{};
+
+				for (size_t byteIdx = 0; byteIdx < stride; ++byteIdx)
+				{
+					//Zigzag keeps small negative deltas small
+					uint8_t previous{};
+					for (size_t vertexIdx = 0; vertexIdx < count; ++vertexIdx)
+					{
+						const uint8_t value{ pVertices[vertexIdx * stride + byteIdx] };
+						const uint8_t delta{ static_cast<uint8_t>(value - previous) };
+						deltas[vertexIdx] = static_cast<uint8_t>((delta << 1) ^ static_cast<uint8_t>(static_cast<int8_t>(delta) >> 7));
+						previous = value;
+					}
+					std::fill(deltas + count, deltas + numGroups * GroupSize, uint8_t{ 0 });
+
+					//Two bits per group select 0, 2, 4 or 8 bit deltas
+					const size_t headerStart{ data.size() };
+					data.resize(data.size() + (numGroups + 3) / 4, 0);
+					for (size_t group = 0; group < numGroups; ++group)
+					{
+						const uint8_t* pGroup = deltas + group * GroupSize;
+						const uint8_t largest{ *std::max_element(pGroup, pGroup + GroupSize) };
+						const uint32_t mode{ largest == 0 ? 0u : largest < 4 ? 1u : largest < 16 ? 2u : 3u };
+						data[headerStart + group / 4] |= static_cast<uint8_t>(mode << (group % 4 * 2));
+
+						if (mode == 3)
+						{
+							data.insert(data.end(), pGroup, pGroup + GroupSize);
+						}
+						else if (mode > 0)
+						{
+							const uint32_t bits{ mode * 2 };
+							const uint32_t perByte{ 8 / bits };
+							for (uint32_t i = 0; i < GroupSize; i += perByte)
+							{
+								uint8_t packed{};
+								for (uint32_t j = 0; j < perByte; ++j)
+									packed |= static_cast<uint8_t>(pGroup[i + j] << (j * bits));
+								data.push_back(packed);
+							}
+						}
+					}
+				}
+			}
+
+			bool DecodeVertexBlock(uint8_t* pVertices, size_t count, size_t stride, const uint8_t* pData, const uint8_t* pEnd)
+			{
+				const size_t numGroups{ (count + GroupSize - 1) / GroupSize };
+				uint8_t deltas[VertexBlockSize];
+
+				for (size_t byteIdx = 0; byteIdx < stride; ++byteIdx)
+				{
+					const uint8_t* pHeader = pData;
+					pData += (numGroups + 3) / 4;
+					if (pData > pEnd)
+						return false;
+
+					for (size_t group = 0; group < numGroups; ++group)
+					{
+						uint8_t* pGroup = deltas + group * GroupSize;
+						const uint32_t mode{ (pHeader[group / 4] >> (group % 4 * 2)) & 3u };
+						switch (mode)
+						{
+						case 0:
+							std::memset(pGroup, 0, GroupSize);
+							break;
+						case 1:
+							if (pEnd - pData < 4)
+								return false;
+							for (uint32_t i = 0; i < GroupSize; ++i)
+								pGroup[i] = (pData[i / 4] >> (i % 4 * 2)) & 3u;
+							pData += 4;
+							break;
+						case 2:
+							if (pEnd - pData < 8)
+								return false;
+							for (uint32_t i = 0; i < GroupSize; ++i)
+								pGroup[i] = (pData[i / 2] >> (i % 2 * 4)) & 15u;
+							pData += 8;
+							break;
+						default:
+							if (pEnd - pData < static_cast<ptrdiff_t>(GroupSize))
+								return false;
+							std::memcpy(pGroup, pData, GroupSize);
+							pData += GroupSize;
+							break;
+						}
+					}
+
+					uint8_t value{};
+					for (size_t vertexIdx = 0; vertexIdx < count; ++vertexIdx)
+					{
+						const uint8_t zigzag{ deltas[vertexIdx] };
+						value = static_cast<uint8_t>(value + ((zigzag >> 1) ^ static_cast<uint8_t>(-(zigzag & 1))));
+						pVertices[vertexIdx * stride + byteIdx] = value;
+					}
+				}
+
+				return pData == pEnd;
+			}
+
+			/* --- INDICES --- */
+			void WriteVarint(std::vector<uint8_t>& data, int32_t delta)
+			{
+				uint32_t value{ (static_cast<uint32_t>(delta) << 1) ^ static_cast<uint32_t>(delta >> 31) };
+				while (value >= 0x80)
+				{
+					data.push_back(static_cast<uint8_t>(value | 0x80));
+					value >>= 7;
+				}
+				data.push_back(static_cast<uint8_t>(value));
+			}
+
+			bool ReadVarint(const uint8_t*& pData, const uint8_t* pEnd, int32_t& delta)
+			{
+				uint32_t value{};
+				for (uint32_t shift = 0; shift < 35; shift += 7)
+				{
+					if (pData == pEnd)
+						return false;
+
+					const uint8_t byte{ *pData++ };
+					value |= static_cast<uint32_t>(byte & 0x7F) << shift;
+					if (byte < 0x80)
+					{
+						delta = static_cast<int32_t>((value >> 1) ^ (0u - (value & 1)));
+						return true;
+					}
+				}
+
+				return false;
+			}
+
+			//Recent edges and vertices, the most recent one is at distance 0
+			struct IndexState
+			{
+				uint32_t edges[FifoSize][2]{};
+				uint32_t edgeHead{};
+				uint32_t vertices[FifoSize]{};
+				uint32_t vertexHead{};
+				//Highest index so far plus one, the guess for a vertex not seen before
+				uint32_t next{};
+				uint32_t last{};
+
+				void PushEdge(uint32_t a, uint32_t b)
+				{
+					edgeHead = (edgeHead + 1) % FifoSize;
+					edges[edgeHead][0] = a;
+					edges[edgeHead][1] = b;
+				}
+
+				const uint32_t* GetEdge(uint32_t distance) const
+				{
+					return edges[(edgeHead + FifoSize - distance) % FifoSize];
+				}
+
+				void PushVertex(uint32_t vertex)
+				{
+					vertexHead = (vertexHead + 1) % FifoSize;
+					vertices[vertexHead] = vertex;
+				}
+
+				uint32_t GetVertex(uint32_t distance) const
+				{
+					return vertices[(vertexHead + FifoSize - distance) % FifoSize];
+				}
+
+				//A neighbour walks a shared edge the other way, so edges go in reversed
+				void PushTriangle(uint32_t a, uint32_t b, uint32_t c)
+				{
+					PushEdge(b, a);
+					PushEdge(c, b);
+					PushEdge(a, c);
+					next = std::max(next, std::max(std::max(a, b), c) + 1);
+				}
+			};
+
+			//The triangle starting at its corner rotation: 0 is abc, 1 is bca, 2 is cab
+			void Rotate(const uint32_t* pTriangle, uint32_t rotation, uint32_t* pRotated)
+			{
+				for (uint32_t corner = 0; corner < 3; ++corner)
+					pRotated[corner] = pTriangle[(corner + rotation) % 3];
+			}
+
+			template<typename Index>
+			void EncodeIndexBlock(const Index* pIndices, size_t count, std::vector<uint8_t>& data)
+			{
+				//One code per triangle up front, vertex data after them
+				const size_t numTriangles{ count / 3 };
+				std::vector<uint8_t> codes(numTriangles);
+				std::vector<uint8_t> payload{};
+				IndexState state{};
+
+				for (size_t triangleIdx = 0; triangleIdx < numTriangles; ++triangleIdx)
+				{
+					const uint32_t triangle[3]{ pIndices[triangleIdx * 3], pIndices[triangleIdx * 3 + 1], pIndices[triangleIdx * 3 + 2] };
+
+					//The most recent edge any rotation of the triangle starts with
+					uint32_t bestDistance{ NoEdge };
+					uint32_t bestRotation{};
+					for (uint32_t rotation = 0; rotation < 3; ++rotation)
+					{
+						uint32_t rotated[3];
+						Rotate(triangle, rotation, rotated);
+						for (uint32_t distance = 0; distance < bestDistance; ++distance)
+						{
+							const uint32_t* pEdge = state.GetEdge(distance);
+							if (pEdge[0] == rotated[0] && pEdge[1] == rotated[1])
+							{
+								bestDistance = distance;
+								bestRotation = rotation;
+								break;
+							}
+						}
+					}
+
+					if (bestDistance == NoEdge)
+					{
+						codes[triangleIdx] = static_cast<uint8_t>(NoEdge << 4);
+						for (const uint32_t vertex : triangle)
+						{
+							WriteVarint(payload, static_cast<int32_t>(vertex - state.last));
+							state.last = vertex;
+							state.PushVertex(vertex);
+						}
+						state.PushTriangle(triangle[0], triangle[1], triangle[2]);
+						continue;
+					}
+
+					uint32_t rotated[3];
+					Rotate(triangle, bestRotation, rotated);
+					const uint32_t third{ rotated[2] };
+
+					ThirdVertex kind{ ThirdVertex::Explicit };
+					uint32_t recentDistance{};
+					if (third == state.next)
+					{
+						kind = ThirdVertex::Next;
+					}
+					else
+					{
+						for (uint32_t distance = 0; distance < FifoSize; ++distance)
+						{
+							if (state.GetVertex(distance) == third)
+							{
+								kind = ThirdVertex::Recent;
+								recentDistance = distance;
+								break;
+							}
+						}
+					}
+
+					codes[triangleIdx] = static_cast<uint8_t>(bestDistance << 4 | bestRotation << 2 | static_cast<uint32_t>(kind));
+					if (kind == ThirdVertex::Recent)
+					{
+						payload.push_back(static_cast<uint8_t>(recentDistance));
+					}
+					else
+					{
+						if (kind == ThirdVertex::Explicit)
+							WriteVarint(payload, static_cast<int32_t>(third - state.last));
+						state.PushVertex(third);
+					}
+
+					state.last = third;
+					state.PushTriangle(triangle[0], triangle[1], triangle[2]);
+				}
+
+				//Leftover indices that don't make a triangle
+				for (size_t i = numTriangles * 3; i < count; ++i)
+				{
+					WriteVarint(payload, static_cast<int32_t>(pIndices[i] - state.last));
+					state.last = pIndices[i];
+				}
+
+				data.insert(data.end(), codes.begin(), codes.end());
+				data.insert(data.end(), payload.begin(), payload.end());
+			}
+
+			template<typename Index>
+			bool DecodeIndexBlock(Index* pIndices, size_t count, const uint8_t* pData, const uint8_t* pEnd)
+			{
+				const size_t numTriangles{ count / 3 };
+				if (static_cast<size_t>(pEnd - pData) < numTriangles)
+					return false;
+
+				const uint8_t* pCodes = pData;
+				pData += numTriangles;
+				IndexState state{};
+
+				const auto readExplicit = [&](uint32_t& vertex)
+					{
+						int32_t delta{};
+						if (!ReadVarint(pData, pEnd, delta))
+							return false;
+
+						vertex = state.last + static_cast<uint32_t>(delta);
+						state.last = vertex;
+						return sizeof(Index) == sizeof(uint32_t) || vertex <= UINT16_MAX;
+					};
+
+				for (size_t triangleIdx = 0; triangleIdx < numTriangles; ++triangleIdx)
+				{
+					const uint8_t code{ pCodes[triangleIdx] };
+					const uint32_t distance{ static_cast<uint32_t>(code >> 4) };
+					uint32_t triangle[3];
+
+					if (distance == NoEdge)
+					{
+						for (uint32_t& vertex : triangle)
+						{
+							if (!readExplicit(vertex))
+								return false;
+							state.PushVertex(vertex);
+						}
+					}
+					else
+					{
+						const uint32_t* pEdge = state.GetEdge(distance);
+						uint32_t third{};
+						switch (static_cast<ThirdVertex>(code & 3u))
+						{
+						case ThirdVertex::Next:
+							third = state.next;
+							if (sizeof(Index) == sizeof(uint16_t) && third > UINT16_MAX)
+								return false;
+							state.PushVertex(third);
+							break;
+						case ThirdVertex::Recent:
+							if (pData == pEnd || *pData >= FifoSize)
+								return false;
+							third = state.GetVertex(*pData++);
+							break;
+						case ThirdVertex::Explicit:
+							if (!readExplicit(third))
+								return false;
+							state.PushVertex(third);
+							break;
+						default:
+							return false;
+						}
+
+						state.last = third;
+						const uint32_t rotated[3]{ pEdge[0], pEdge[1], third };
+						//Undo the rotation, rotating by the remaining steps
+						Rotate(rotated, (3 - ((code >> 2) & 3u)) % 3, triangle);
+					}
+
+					pIndices[triangleIdx * 3] = static_cast<Index>(triangle[0]);
+					pIndices[triangleIdx * 3 + 1] = static_cast<Index>(triangle[1]);
+					pIndices[triangleIdx * 3 + 2] = static_cast<Index>(triangle[2]);
+					state.PushTriangle(triangle[0], triangle[1], triangle[2]);
+				}
+
+				for (size_t i = numTriangles * 3; i < count; ++i)
+				{
+					uint32_t vertex{};
+					if (!readExplicit(vertex))
+						return false;
+					pIndices[i] = static_cast<Index>(vertex);
+				}
+
+				return pData == pEnd;
+			}
+
+			template<typename Index>
+			std::vector<uint8_t> EncodeIndicesAs(const Index* pIndices, size_t count)
+			{
+				std::vector<std::vector<uint8_t>> blocks((count + IndexBlockSize - 1) / IndexBlockSize);
+				for (size_t block = 0; block < blocks.size(); ++block)
+					EncodeIndexBlock(pIndices + block * IndexBlockSize, std::min(size_t{ IndexBlockSize }, count - block * IndexBlockSize), blocks[block]);
+
+				return JoinBlocks(blocks);
+			}
+
+			template<typename Index>
+			bool DecodeIndicesAs(Index* pIndices, size_t count, const uint8_t* pData, size_t size, size_t numThreads)
+			{
+				const size_t numBlocks{ (count + IndexBlockSize - 1) / IndexBlockSize };
+				const uint8_t* pBlocks = ReadBlockTable(pData, size, numBlocks);
+				if (!pBlocks)
+					return false;
+
+				std::vector<uint8_t> isDecoded(numBlocks, 0);
+				Utils::ParallelFor(numBlocks, numThreads, [&](size_t begin, size_t end)
+					{
+						for (size_t block = begin; block < end; ++block)
+						{
+							uint32_t blockBegin{}, blockEnd{};
+							GetBlockBounds(pData, block, blockBegin, blockEnd);
+							isDecoded[block] = DecodeIndexBlock(pIndices + block * IndexBlockSize, std::min(size_t{ IndexBlockSize }, count - block * IndexBlockSize),
+								pBlocks + blockBegin, pBlocks + blockEnd);
+						}
+					});
+
+				return std::find(isDecoded.begin(), isDecoded.end(), uint8_t{ 0 }) == isDecoded.end();
+			}
+		}
+
+		std::vector<uint8_t> EncodeVertices(const void* pVertices, size_t count, size_t stride)
+		{
+			const uint8_t* pBytes = static_cast<const uint8_t*>(pVertices);
+			std::vector<std::vector<uint8_t>> blocks((count + VertexBlockSize - 1) / VertexBlockSize);
+			for (size_t block = 0; block < blocks.size(); ++block)
+				EncodeVertexBlock(pBytes + block * VertexBlockSize * stride, std::min(size_t{ VertexBlockSize }, count - block * VertexBlockSize), stride, blocks[block]);
+
+			return JoinBlocks(blocks);
+		}
+
+		bool DecodeVertices(void* pDestination, size_t count, size_t stride, const uint8_t* pData, size_t size, size_t numThreads)
+		{
+			const size_t numBlocks{ (count + VertexBlockSize - 1) / VertexBlockSize };
+			const uint8_t* pBlocks = ReadBlockTable(pData, size, numBlocks);
+			if (!pBlocks)
+				return false;
+
+			uint8_t* pBytes = static_cast<uint8_t*>(pDestination);
+			std::vector<uint8_t> isDecoded(numBlocks, 0);
+			Utils::ParallelFor(numBlocks, numThreads, [&](size_t begin, size_t end)
+				{
+					for (size_t block = begin; block < end; ++block)
+					{
+						uint32_t blockBegin{}, blockEnd{};
+						GetBlockBounds(pData, block, blockBegin, blockEnd);
+						isDecoded[block] = DecodeVertexBlock(pBytes + block * VertexBlockSize * stride, std::min(size_t{ VertexBlockSize }, count - block * VertexBlockSize),
+							stride, pBlocks + blockBegin, pBlocks + blockEnd);
+					}
+				});
+
+			return std::find(isDecoded.begin(), isDecoded.end(), uint8_t{ 0 }) == isDecoded.end();
+		}
+
+		std::vector<uint8_t> EncodeIndices(const void* pIndices, size_t count, uint32_t indexStride)
+		{
+			return indexStride == sizeof(uint16_t) ? EncodeIndicesAs(static_cast<const uint16_t*>(pIndices), count)
+				: EncodeIndicesAs(static_cast<const uint32_t*>(pIndices), count);
+		}
+
+		bool DecodeIndices(void* pDestination, size_t count, uint32_t indexStride, const uint8_t* pData, size_t size, size_t numThreads)
+		{
+			if (indexStride == sizeof(uint16_t))
+				return DecodeIndicesAs(static_cast<uint16_t*>(pDestination), count, pData, size, numThreads);
+			if (indexStride == sizeof(uint32_t))
+				return DecodeIndicesAs(static_cast<uint32_t*>(pDestination), count, pData, size, numThreads);
+			return false;
+		}
+	}
+}
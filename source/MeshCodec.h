@@ -0,0 +1,28 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace dae
+{
+	//Lossless compression of vertex and index buffers for cooked meshes.
+	//Streams are cut into independent blocks behind an offset table, so blocks decode in parallel.
+	namespace MeshCodec
+	{
+		constexpr uint32_t VertexBlockSize{ 256 };
+		constexpr uint32_t IndexBlockSize{ 4096 * 3 };
+
+		//Every byte of a vertex is delta coded against the same byte of the previous vertex, byte by byte across the block.
+		//The zigzagged deltas are packed in groups of 16 at 0, 2, 4 or 8 bits, so runs of equal bytes cost nothing.
+		std::vector<uint8_t> EncodeVertices(const void* pVertices, size_t count, size_t stride);
+		//Returns false on malformed data
+		bool DecodeVertices(void* pDestination, size_t count, size_t stride, const uint8_t* pData, size_t size, size_t numThreads = 1);
+
+		//Triangles are coded as an edge shared with a recent triangle and the third vertex, predicted to be the next unseen one
+		//or else looked up among recent vertices (after Kapoulkine's meshoptimizer index codec). Triangles and their corners
+		//keep their order, so draw ranges and meshlets stay valid. Indices are 2 or 4 bytes wide.
+		std::vector<uint8_t> EncodeIndices(const void* pIndices, size_t count, uint32_t indexStride);
+		//Returns false on malformed data or values that don't fit indexStride
+		bool DecodeIndices(void* pDestination, size_t count, uint32_t indexStride, const uint8_t* pData, size_t size, size_t numThreads = 1);
+	}
+}
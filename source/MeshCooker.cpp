@@ -0,0 +1,176 @@
+#include "pch.h"
+#include "MeshCooker.h"
+
+#include <cstddef>
+#include "CookedMesh.h"
+#include "MappedFile.h"
+#include "MeshOptimizer.h"
+#include "VertexLightBaker.h"
+
+namespace dae
+{
+	namespace MeshCooker
+	{
+		namespace
+		{
+			//The light a cook bakes, nothing when the layout drops the color or no samples are asked for
+			uint32_t GetBakedLight(VertexLayout layout, const Vector3* pLightDirection, uint32_t numLightSamples, Vector3& lightDirection)
+			{
+				const bool isBaked{ layout == VertexLayout::Full && numLightSamples > 0 };
+				lightDirection = isBaked && pLightDirection ? *pLightDirection : Vector3{};
+				return isBaked ? numLightSamples : 0;
+			}
+		}
+
+		CookedMeshData Cook(std::vector<Vertex>& vertices, std::vector<uint32_t>& indices, const std::vector<Utils::ObjMaterialRange>& materialRanges,
+			VertexLayout layout, bool isOpaque, const std::string& name, std::ostream& log, bool analyzeOverdraw)
+		{
+			CookedMeshData data{};
+
+			//Every material is a submesh, levels of detail and meshlets are built per submesh so none of them mixes materials
+			std::vector<uint32_t> submeshStarts{};
+			for (const Utils::ObjMaterialRange& materialRange : materialRanges)
+			{
+				submeshStarts.push_back(materialRange.indexStart);
+				data.submeshMaterials.push_back(materialRange.material);
+			}
+
+			if (submeshStarts.empty())
+			{
+				submeshStarts.push_back(0);
+				data.submeshMaterials.emplace_back();
+			}
+
+			const size_t numSubmeshes{ submeshStarts.size() };
+
+			//Levels of detail share the vertex buffer, each submesh of each level gets its own index group
+			const MeshOptimizer::CacheStats statsBefore = MeshOptimizer::AnalyzeVertexCache(indices, vertices.size());
+			std::vector<MeshSimplifier::LodLevel> lodLevels = MeshSimplifier::GenerateLodChain(indices, vertices, submeshStarts);
+
+			//Optimize the triangle and vertex order before it gets baked into buffers, meshlets keep it
+			//Blended meshes depend on their triangle order, only opaque ones get sorted for overdraw
+			MeshOptimizer::OverdrawStats overdrawBefore{};
+			if (isOpaque && analyzeOverdraw)
+				overdrawBefore = MeshOptimizer::AnalyzeOverdraw(lodLevels[0].indices, vertices);
+
+			std::vector<uint32_t> groupStarts{};
+			indices.clear();
+			for (size_t lodIdx = 0; lodIdx < lodLevels.size(); ++lodIdx)
+			{
+				const MeshSimplifier::LodLevel& lodLevel = lodLevels[lodIdx];
+				for (size_t submeshIdx = 0; submeshIdx < numSubmeshes; ++submeshIdx)
+				{
+					const uint32_t submeshEnd{ submeshIdx + 1 < numSubmeshes ? lodLevel.groupStarts[submeshIdx + 1] : static_cast<uint32_t>(lodLevel.indices.size()) };
+					std::vector<uint32_t> submeshIndices(lodLevel.indices.begin() + lodLevel.groupStarts[submeshIdx], lodLevel.indices.begin() + submeshEnd);
+
+					MeshOptimizer::OptimizeVertexCache(submeshIndices, vertices.size());
+					if (isOpaque)
+						MeshOptimizer::OptimizeOverdraw(submeshIndices, vertices);
+
+					groupStarts.push_back(static_cast<uint32_t>(indices.size()));
+					indices.insert(indices.end(), submeshIndices.begin(), submeshIndices.end());
+				}
+			}
+
+			//The first level references every vertex, so its first-use order decides the vertex order
+			MeshOptimizer::OptimizeVertexFetch(vertices, indices);
+			const std::vector<uint32_t> firstLodIndices(indices.begin(), indices.begin() + lodLevels[0].indices.size());
+			const MeshOptimizer::CacheStats statsAfter = MeshOptimizer::AnalyzeVertexCache(firstLodIndices, vertices.size());
+			log << name << " vertex cache ACMR: " << statsBefore.acmr << " -> " << statsAfter.acmr
+				<< ", ATVR: " << statsBefore.atvr << " -> " << statsAfter.atvr << "\n";
+			if (isOpaque && analyzeOverdraw)
+				log << name << " overdraw: " << overdrawBefore.overdraw << " -> " << MeshOptimizer::AnalyzeOverdraw(firstLodIndices, vertices).overdraw << "\n";
+
+			//16 bit indices, meshes with too many vertices for them are drawn in several ranges.
+			//The levels of a submesh share its vertex blocks, they only use vertices of the first level.
+			std::vector<uint32_t> groupSets(groupStarts.size());
+			for (size_t group = 0; group < groupSets.size(); ++group)
+				groupSets[group] = static_cast<uint32_t>(group % numSubmeshes);
+			data.indices = MeshSplitter::EncodeShortIndices(vertices, indices, groupStarts, groupSets);
+			if (data.indices.ranges.size() > data.indices.groups.size())
+				log << name << " split into " << data.indices.ranges.size() << " draw ranges, " << vertices.size() << " vertices\n";
+
+			//Meshlets are cut from the final order and never cross a range, the split may have moved triangles between its ranges
+			const uint16_t* pShortIndices = reinterpret_cast<const uint16_t*>(data.indices.data.data());
+			std::vector<uint32_t> rangeMeshletStarts{};
+			for (const DrawRange& range : data.indices.ranges)
+			{
+				rangeMeshletStarts.push_back(static_cast<uint32_t>(data.meshlets.size()));
+				std::vector<uint32_t> rangeIndices(pShortIndices + range.indexStart, pShortIndices + range.indexStart + range.indexCount);
+				for (uint32_t& index : rangeIndices)
+					index += range.baseVertex;
+
+				for (Meshlet& meshlet : MeshletBuilder::Build(rangeIndices, vertices))
+				{
+					meshlet.indexStart += range.indexStart;
+					data.meshlets.push_back(meshlet);
+				}
+			}
+			rangeMeshletStarts.push_back(static_cast<uint32_t>(data.meshlets.size()));
+
+			for (size_t lodIdx = 0; lodIdx < lodLevels.size(); ++lodIdx)
+			{
+				const uint32_t firstRange{ data.indices.groups[lodIdx * numSubmeshes] };
+				const uint32_t endRange{ lodIdx + 1 < lodLevels.size() ? data.indices.groups[(lodIdx + 1) * numSubmeshes] : static_cast<uint32_t>(data.indices.ranges.size()) };
+				const uint32_t firstMeshlet{ rangeMeshletStarts[firstRange] };
+				data.lods.push_back(MeshLod{ firstRange, endRange - firstRange, firstMeshlet, rangeMeshletStarts[endRange] - firstMeshlet, lodLevels[lodIdx].error });
+
+				log << name << " LOD " << lodIdx << ": " << lodLevels[lodIdx].indices.size() / 3 << " triangles in " << numSubmeshes << " submeshes, "
+					<< data.lods.back().meshletCount << " meshlets, error " << lodLevels[lodIdx].error << "\n";
+			}
+
+			//Groups go level by level and submesh by submesh, a split group's ranges all belong to its submesh
+			data.rangeSubmeshes.resize(data.indices.ranges.size());
+			for (size_t group = 0; group < data.indices.groups.size(); ++group)
+			{
+				const uint32_t endRange{ group + 1 < data.indices.groups.size() ? data.indices.groups[group + 1] : static_cast<uint32_t>(data.indices.ranges.size()) };
+				std::fill(data.rangeSubmeshes.begin() + data.indices.groups[group], data.rangeSubmeshes.begin() + endRange, static_cast<uint32_t>(group % numSubmeshes));
+			}
+
+			data.vertices = VertexCodec::Encode(vertices, layout);
+			return data;
+		}
+
+		bool CookObj(const std::string& objPath, VertexLayout layout, bool isOpaque, const Vector3* pLightDirection, uint32_t numLightSamples,
+			size_t numThreads, CookedMeshData& data, std::ostream& log, bool analyzeOverdraw)
+		{
+			data = CookedMeshData{};
+			std::vector<Vertex> vertices{};
+			std::vector<uint32_t> indices{};
+			std::vector<Utils::ObjMaterialRange> materialRanges{};
+			if (!Utils::ParseOBJ(objPath, vertices, indices, true, true, numThreads, &materialRanges))
+				return false;
+
+			Vector3 lightDirection{};
+			const uint32_t lightSampleCount{ GetBakedLight(layout, pLightDirection, numLightSamples, lightDirection) };
+			if (lightSampleCount > 0)
+				VertexLightBaker::Bake(vertices, indices, pLightDirection ? &lightDirection : nullptr, lightSampleCount, 0, numThreads);
+
+			data = Cook(vertices, indices, materialRanges, layout, isOpaque, objPath, log, analyzeOverdraw);
+
+			const std::string cookedPath{ CookedMesh::GetCookedPath(objPath) };
+			if (!CookedMesh::Write(cookedPath, data.vertices, data.indices, data.lods, data.meshlets, data.rangeSubmeshes, data.submeshMaterials, isOpaque,
+				lightDirection, lightSampleCount, objPath))
+				log << "Couldn't write cooked mesh " << cookedPath << "\n";
+
+			return true;
+		}
+
+		bool IsUpToDate(const std::string& objPath, VertexLayout layout, bool isOpaque, const Vector3* pLightDirection, uint32_t numLightSamples)
+		{
+			//The header is enough to tell, the blocks are only checked when they get loaded
+			const std::string cookedPath{ CookedMesh::GetCookedPath(objPath) };
+			const MappedFile file{ cookedPath };
+			if (file.GetSize() < sizeof(CookedMesh::Header))
+				return false;
+
+			Vector3 lightDirection{};
+			const uint32_t lightSampleCount{ GetBakedLight(layout, pLightDirection, numLightSamples, lightDirection) };
+			const CookedMesh::Header* pHeader = reinterpret_cast<const CookedMesh::Header*>(file.GetData());
+			return pHeader->magic == CookedMesh::Magic && pHeader->version == CookedMesh::Version && pHeader->vertexLayout == layout &&
+				(pHeader->isOpaque != 0) == isOpaque && pHeader->lightSampleCount == lightSampleCount && pHeader->lightDirection[0] == lightDirection.x &&
+				pHeader->lightDirection[1] == lightDirection.y && pHeader->lightDirection[2] == lightDirection.z &&
+				pHeader->source.Matches(objPath, cookedPath, offsetof(CookedMesh::Header, source));
+		}
+	}
+}
@@ -0,0 +1,45 @@
+#pragma once
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <vector>
+#include "Meshlet.h"
+#include "MeshSimplifier.h"
+#include "MeshSplitter.h"
+#include "Utils.h"
+#include "VertexLayout.h"
+
+namespace dae
+{
+	//Everything a Mesh uploads and a cooked mesh stores
+	struct CookedMeshData
+	{
+		EncodedVertices vertices{};
+		EncodedIndices indices{};
+		std::vector<MeshLod> lods{};
+		std::vector<Meshlet> meshlets{};
+		//Submesh of every draw range
+		std::vector<uint32_t> rangeSubmeshes{};
+		std::vector<std::string> submeshMaterials{};
+	};
+
+	//The processing a Mesh does before it can upload, without a device, so the asset cooker runs it ahead of time:
+	//levels of detail, vertex and triangle order, meshlets and the vertex layout.
+	//Only the effect's blend state and the baked light change the result, the caller passes them in.
+	namespace MeshCooker
+	{
+		//Every material of materialRanges is a submesh. vertices and indices are reordered in place.
+		//Statistics of every step are written to log. analyzeOverdraw adds the overdraw of opaque meshes before and after sorting,
+		//which rasterizes the mesh from 16 views, so only the asset cooker's --stats asks for it.
+		CookedMeshData Cook(std::vector<Vertex>& vertices, std::vector<uint32_t>& indices, const std::vector<Utils::ObjMaterialRange>& materialRanges,
+			VertexLayout layout, bool isOpaque, const std::string& name, std::ostream& log, bool analyzeOverdraw = false);
+
+		//Parses and cooks the OBJ at objPath and writes the cooked mesh next to it. False when the OBJ can't be parsed, data is left empty then.
+		//With numLightSamples the full layout, the only one keeping the vertex color, gets ambient occlusion and the light at pLightDirection
+		//baked in offline, by the asset cooker's --bake-light. The renderer never bakes, it loads baked meshes in the full layout.
+		bool CookObj(const std::string& objPath, VertexLayout layout, bool isOpaque, const Vector3* pLightDirection, uint32_t numLightSamples,
+			size_t numThreads, CookedMeshData& data, std::ostream& log, bool analyzeOverdraw = false);
+		//True when the cooked mesh of objPath was made from it as it is now, with these settings
+		bool IsUpToDate(const std::string& objPath, VertexLayout layout, bool isOpaque, const Vector3* pLightDirection = nullptr, uint32_t numLightSamples = 0);
+	}
+}
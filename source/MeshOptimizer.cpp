@@ -0,0 +1,419 @@
+#include "pch.h"
+#include "MeshOptimizer.h"
+
+namespace dae
+{
+	namespace MeshOptimizer
+	{
+		namespace
+		{
+			//Timestamped FIFO cache, bumping the timestamp past the cache size flushes it
+			class FifoCache final
+			{
+			public:
+				FifoCache(size_t numVertices, uint32_t cacheSize)
+					: m_CacheTime(numVertices)
+					, m_TimeStamp{ cacheSize + 1 }
+					, m_CacheSize{ cacheSize }
+				{
+				}
+
+				uint32_t AddTriangle(const uint32_t* pTriangle)
+				{
+					uint32_t numMisses{};
+					for (size_t corner = 0; corner < 3; ++corner)
+					{
+						uint32_t& cacheTime = m_CacheTime[pTriangle[corner]];
+						if (m_TimeStamp - cacheTime > m_CacheSize)
+						{
+							cacheTime = m_TimeStamp++;
+							++numMisses;
+						}
+					}
+
+					return numMisses;
+				}
+
+				void Flush()
+				{
+					m_TimeStamp += m_CacheSize + 1;
+				}
+
+			private:
+				std::vector<uint32_t> m_CacheTime;
+				uint32_t m_TimeStamp;
+				uint32_t m_CacheSize;
+			};
+
+			//Area weighted, facing out of the mesh for the clockwise front faces the effects use
+			Vector3 TriangleNormal(const std::vector<Vertex>& vertices, const uint32_t* pTriangle)
+			{
+				const Vector3& p0 = vertices[pTriangle[0]].position;
+				return Vector3::Cross(vertices[pTriangle[1]].position - p0, vertices[pTriangle[2]].position - p0);
+			}
+		}
+
+		CacheStats AnalyzeVertexCache(const std::vector<uint32_t>& indices, size_t numVertices, uint32_t cacheSize, CacheModel model)
+		{
+			CacheStats stats{};
+			if (indices.empty() || numVertices == 0 || cacheSize == 0)
+				return stats;
+
+			//Cache entries in eviction order, the front is evicted first
+			std::vector<uint32_t> cache{};
+			cache.reserve(cacheSize);
+
+			size_t numMisses{};
+			for (const uint32_t index : indices)
+			{
+				const auto it = std::find(cache.begin(), cache.end(), index);
+				if (it != cache.end())
+				{
+					//A hit refreshes the entry in an LRU cache, a FIFO cache doesn't care
+					if (model == CacheModel::Lru)
+					{
+						cache.erase(it);
+						cache.push_back(index);
+					}
+					continue;
+				}
+
+				++numMisses;
+				if (cache.size() == cacheSize)
+					cache.erase(cache.begin());
+
+				cache.push_back(index);
+			}
+
+			stats.acmr = static_cast<float>(numMisses) / static_cast<float>(indices.size() / 3);
+			stats.atvr = static_cast<float>(numMisses) / static_cast<float>(numVertices);
+			return stats;
+		}
+
+		void OptimizeVertexCache(std::vector<uint32_t>& indices, size_t numVertices, uint32_t cacheSize)
+		{
+			const size_t numTriangles{ indices.size() / 3 };
+			if (numTriangles == 0 || numVertices == 0)
+				return;
+
+			//Vertex -> triangle adjacency
+			std::vector<uint32_t> liveTriangles(numVertices);
+			for (size_t i = 0; i < numTriangles * 3; ++i)
+				++liveTriangles[indices[i]];
+
+			std::vector<uint32_t> firstTriangle(numVertices + 1);
+			for (size_t vertexIdx = 0; vertexIdx < numVertices; ++vertexIdx)
+				firstTriangle[vertexIdx + 1] = firstTriangle[vertexIdx] + liveTriangles[vertexIdx];
+
+			std::vector<uint32_t> adjacency(numTriangles * 3);
+			std::vector<uint32_t> fillCursor(firstTriangle.begin(), firstTriangle.end() - 1);
+			for (size_t i = 0; i < numTriangles * 3; ++i)
+				adjacency[fillCursor[indices[i]]++] = static_cast<uint32_t>(i / 3);
+
+			std::vector<uint32_t> cacheTime(numVertices);
+			std::vector<char> isEmitted(numTriangles);
+			std::vector<uint32_t> deadEnds{};
+			std::vector<uint32_t> candidates{};
+			std::vector<uint32_t> output{};
+			output.reserve(numTriangles * 3);
+
+			uint32_t timeStamp{ cacheSize + 1 };
+			size_t scanCursor{ 1 };
+			int64_t fanningVertex{ 0 };
+
+			while (fanningVertex >= 0)
+			{
+				candidates.clear();
+
+				//Emit every remaining triangle around the fanning vertex
+				for (uint32_t i = firstTriangle[fanningVertex]; i < firstTriangle[fanningVertex + 1]; ++i)
+				{
+					const uint32_t triangleIdx = adjacency[i];
+					if (isEmitted[triangleIdx])
+						continue;
+
+					for (size_t corner = 0; corner < 3; ++corner)
+					{
+						const uint32_t vertexIdx = indices[triangleIdx * 3 + corner];
+						output.push_back(vertexIdx);
+						deadEnds.push_back(vertexIdx);
+						candidates.push_back(vertexIdx);
+						--liveTriangles[vertexIdx];
+
+						if (timeStamp - cacheTime[vertexIdx] > cacheSize)
+							cacheTime[vertexIdx] = timeStamp++;
+					}
+
+					isEmitted[triangleIdx] = true;
+				}
+
+				//Next fanning vertex: the candidate that stays in cache the longest while we fan around it
+				fanningVertex = -1;
+				uint32_t bestPriority{};
+				for (const uint32_t vertexIdx : candidates)
+				{
+					if (liveTriangles[vertexIdx] == 0)
+						continue;
+
+					uint32_t priority{};
+					if (timeStamp - cacheTime[vertexIdx] + 2 * liveTriangles[vertexIdx] <= cacheSize)
+						priority = timeStamp - cacheTime[vertexIdx];
+
+					if (priority > bestPriority)
+					{
+						bestPriority = priority;
+						fanningVertex = vertexIdx;
+					}
+				}
+
+				if (fanningVertex >= 0)
+					continue;
+
+				//Dead end: go back to recently used vertices first, then scan for any vertex with work left
+				while (!deadEnds.empty())
+				{
+					const uint32_t vertexIdx = deadEnds.back();
+					deadEnds.pop_back();
+					if (liveTriangles[vertexIdx] > 0)
+					{
+						fanningVertex = vertexIdx;
+						break;
+					}
+				}
+
+				while (fanningVertex < 0 && scanCursor < numVertices)
+				{
+					if (liveTriangles[scanCursor] > 0)
+						fanningVertex = static_cast<int64_t>(scanCursor);
+
+					++scanCursor;
+				}
+			}
+
+			indices.swap(output);
+		}
+
+		OverdrawStats AnalyzeOverdraw(const std::vector<uint32_t>& indices, const std::vector<Vertex>& vertices, uint32_t numViews, uint32_t resolution)
+		{
+			OverdrawStats stats{};
+			const size_t numTriangles{ indices.size() / 3 };
+			if (numTriangles == 0 || vertices.empty() || numViews == 0 || resolution == 0)
+				return stats;
+
+			//Fit a bounding sphere of the mesh to the viewport from every direction
+			Vector3 boundsMin{ vertices[0].position };
+			Vector3 boundsMax{ vertices[0].position };
+			for (const Vertex& vertex : vertices)
+			{
+				for (int axis = 0; axis < 3; ++axis)
+				{
+					boundsMin[axis] = std::min(boundsMin[axis], vertex.position[axis]);
+					boundsMax[axis] = std::max(boundsMax[axis], vertex.position[axis]);
+				}
+			}
+
+			const Vector3 center{ (boundsMin + boundsMax) * 0.5f };
+			const float radius{ std::max((boundsMax - boundsMin).Magnitude() * 0.5f, FLT_EPSILON) };
+			const float toPixels{ static_cast<float>(resolution) / (2.f * radius) };
+
+			std::vector<float> depthBuffer(size_t(resolution) * resolution);
+			std::vector<Vector3> projected(vertices.size());
+
+			for (uint32_t viewIdx = 0; viewIdx < numViews; ++viewIdx)
+			{
+				//Fibonacci sphere directions, the camera looks along viewDir
+				const float y{ 1.f - 2.f * (viewIdx + 0.5f) / numViews };
+				const float ringRadius{ sqrtf(std::max(0.f, 1.f - y * y)) };
+				const float angle{ PI * (3.f - sqrtf(5.f)) * viewIdx };
+				const Vector3 viewDir{ cosf(angle) * ringRadius, y, sinf(angle) * ringRadius };
+				const Vector3 helperUp{ fabsf(viewDir.y) < 0.99f ? Vector3::UnitY : Vector3::UnitX };
+				const Vector3 right{ Vector3::Cross(helperUp, viewDir).Normalized() };
+				const Vector3 up{ Vector3::Cross(viewDir, right) };
+
+				for (size_t vertexIdx = 0; vertexIdx < vertices.size(); ++vertexIdx)
+				{
+					const Vector3 offset{ vertices[vertexIdx].position - center };
+					projected[vertexIdx] = { (Vector3::Dot(offset, right) + radius) * toPixels,
+						(Vector3::Dot(offset, up) + radius) * toPixels,
+						Vector3::Dot(offset, viewDir) };
+				}
+
+				std::fill(depthBuffer.begin(), depthBuffer.end(), FLT_MAX);
+
+				for (size_t triangleIdx = 0; triangleIdx < numTriangles; ++triangleIdx)
+				{
+					const uint32_t* pTriangle = &indices[triangleIdx * 3];
+					if (Vector3::Dot(TriangleNormal(vertices, pTriangle), viewDir) >= 0.f)
+						continue;
+
+					const Vector3& p0 = projected[pTriangle[0]];
+					const Vector3& p1 = projected[pTriangle[1]];
+					const Vector3& p2 = projected[pTriangle[2]];
+
+					const float area{ (p1.x - p0.x) * (p2.y - p0.y) - (p1.y - p0.y) * (p2.x - p0.x) };
+					if (fabsf(area) < FLT_EPSILON)
+						continue;
+
+					const int minX{ std::max(0, static_cast<int>(std::min({ p0.x, p1.x, p2.x }))) };
+					const int maxX{ std::min(static_cast<int>(resolution) - 1, static_cast<int>(std::max({ p0.x, p1.x, p2.x }))) };
+					const int minY{ std::max(0, static_cast<int>(std::min({ p0.y, p1.y, p2.y }))) };
+					const int maxY{ std::min(static_cast<int>(resolution) - 1, static_cast<int>(std::max({ p0.y, p1.y, p2.y }))) };
+
+					//Sample pixel centers with barycentric edge functions
+					for (int py = minY; py <= maxY; ++py)
+					{
+						for (int px = minX; px <= maxX; ++px)
+						{
+							const float sx{ px + 0.5f };
+							const float sy{ py + 0.5f };
+							const float w0{ ((p1.x - sx) * (p2.y - sy) - (p1.y - sy) * (p2.x - sx)) / area };
+							const float w1{ ((p2.x - sx) * (p0.y - sy) - (p2.y - sy) * (p0.x - sx)) / area };
+							const float w2{ 1.f - w0 - w1 };
+							if (w0 < 0.f || w1 < 0.f || w2 < 0.f)
+								continue;
+
+							const float depth{ w0 * p0.z + w1 * p1.z + w2 * p2.z };
+							float& storedDepth = depthBuffer[size_t(py) * resolution + px];
+							if (depth < storedDepth)
+							{
+								storedDepth = depth;
+								++stats.pixelsShaded;
+							}
+						}
+					}
+				}
+
+				stats.pixelsCovered += std::count_if(depthBuffer.begin(), depthBuffer.end(), [](float depth) { return depth != FLT_MAX; });
+			}
+
+			stats.overdraw = stats.pixelsCovered > 0 ? static_cast<float>(stats.pixelsShaded) / static_cast<float>(stats.pixelsCovered) : 0.f;
+			return stats;
+		}
+
+		void OptimizeOverdraw(std::vector<uint32_t>& indices, const std::vector<Vertex>& vertices, float threshold, uint32_t cacheSize)
+		{
+			const size_t numTriangles{ indices.size() / 3 };
+			if (numTriangles == 0)
+				return;
+
+			//Hard boundaries: triangles that miss all three vertices start a disconnected patch
+			std::vector<size_t> hardBoundaries{};
+			{
+				FifoCache cache{ vertices.size(), cacheSize };
+				for (size_t triangleIdx = 0; triangleIdx < numTriangles; ++triangleIdx)
+				{
+					if (cache.AddTriangle(&indices[triangleIdx * 3]) == 3 || triangleIdx == 0)
+						hardBoundaries.push_back(triangleIdx);
+				}
+				hardBoundaries.push_back(numTriangles);
+			}
+
+			//Soft boundaries: split each patch wherever the running ACMR is within threshold of the patch's ACMR
+			std::vector<size_t> clusterStarts{};
+			{
+				FifoCache cache{ vertices.size(), cacheSize };
+				for (size_t patchIdx = 0; patchIdx + 1 < hardBoundaries.size(); ++patchIdx)
+				{
+					const size_t begin{ hardBoundaries[patchIdx] };
+					const size_t end{ hardBoundaries[patchIdx + 1] };
+
+					cache.Flush();
+					uint32_t patchMisses{};
+					for (size_t triangleIdx = begin; triangleIdx < end; ++triangleIdx)
+						patchMisses += cache.AddTriangle(&indices[triangleIdx * 3]);
+
+					const float patchThreshold{ threshold * static_cast<float>(patchMisses) / static_cast<float>(end - begin) };
+
+					clusterStarts.push_back(begin);
+					cache.Flush();
+
+					uint32_t runningMisses{}, runningTriangles{};
+					for (size_t triangleIdx = begin; triangleIdx < end; ++triangleIdx)
+					{
+						runningMisses += cache.AddTriangle(&indices[triangleIdx * 3]);
+						++runningTriangles;
+
+						if (static_cast<float>(runningMisses) / static_cast<float>(runningTriangles) <= patchThreshold && triangleIdx + 1 < end)
+						{
+							clusterStarts.push_back(triangleIdx + 1);
+							cache.Flush();
+							runningMisses = 0;
+							runningTriangles = 0;
+						}
+					}
+				}
+				clusterStarts.push_back(numTriangles);
+			}
+
+			//Occlusion potential: how far the cluster sits out of the mesh along its own normal
+			Vector3 meshCenter{};
+			float meshArea{};
+			std::vector<Vector3> clusterCenters(clusterStarts.size() - 1);
+			std::vector<Vector3> clusterNormals(clusterStarts.size() - 1);
+			for (size_t clusterIdx = 0; clusterIdx + 1 < clusterStarts.size(); ++clusterIdx)
+			{
+				float clusterArea{};
+				for (size_t triangleIdx = clusterStarts[clusterIdx]; triangleIdx < clusterStarts[clusterIdx + 1]; ++triangleIdx)
+				{
+					const uint32_t* pTriangle = &indices[triangleIdx * 3];
+					const Vector3 normal{ TriangleNormal(vertices, pTriangle) };
+					const float area{ normal.Magnitude() };
+					const Vector3 triangleCenter{ (vertices[pTriangle[0]].position + vertices[pTriangle[1]].position + vertices[pTriangle[2]].position) / 3.f };
+
+					clusterCenters[clusterIdx] += triangleCenter * area;
+					clusterNormals[clusterIdx] += normal;
+					clusterArea += area;
+				}
+
+				meshCenter += clusterCenters[clusterIdx];
+				meshArea += clusterArea;
+				clusterCenters[clusterIdx] = clusterArea > 0.f ? clusterCenters[clusterIdx] / clusterArea : vertices[indices[clusterStarts[clusterIdx] * 3]].position;
+			}
+
+			if (meshArea > 0.f)
+				meshCenter /= meshArea;
+
+			std::vector<float> occlusionPotential(clusterCenters.size());
+			std::vector<uint32_t> clusterOrder(clusterCenters.size());
+			for (size_t clusterIdx = 0; clusterIdx < clusterCenters.size(); ++clusterIdx)
+			{
+				const float normalLength{ clusterNormals[clusterIdx].Magnitude() };
+				occlusionPotential[clusterIdx] = normalLength > 0.f ? Vector3::Dot(clusterCenters[clusterIdx] - meshCenter, clusterNormals[clusterIdx] / normalLength) : 0.f;
+				clusterOrder[clusterIdx] = static_cast<uint32_t>(clusterIdx);
+			}
+
+			std::stable_sort(clusterOrder.begin(), clusterOrder.end(), [&occlusionPotential](uint32_t a, uint32_t b)
+				{
+					return occlusionPotential[a] > occlusionPotential[b];
+				});
+
+			std::vector<uint32_t> output{};
+			output.reserve(numTriangles * 3);
+			for (const uint32_t clusterIdx : clusterOrder)
+				output.insert(output.end(), indices.begin() + clusterStarts[clusterIdx] * 3, indices.begin() + clusterStarts[clusterIdx + 1] * 3);
+
+			indices.swap(output);
+		}
+
+		void OptimizeVertexFetch(std::vector<Vertex>& vertices, std::vector<uint32_t>& indices)
+		{
+			constexpr uint32_t unused{ UINT32_MAX };
+			std::vector<uint32_t> remap(vertices.size(), unused);
+			std::vector<Vertex> reordered{};
+			reordered.reserve(vertices.size());
+
+			for (uint32_t& index : indices)
+			{
+				if (remap[index] == unused)
+				{
+					remap[index] = static_cast<uint32_t>(reordered.size());
+					reordered.push_back(vertices[index]);
+				}
+
+				index = remap[index];
+			}
+
+			vertices.swap(reordered);
+		}
+	}
+}
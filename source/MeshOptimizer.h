@@ -0,0 +1,48 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+#include "Vertex.h"
+
+namespace dae
+{
+	//CPU passes that reorder an indexed triangle list before it's uploaded
+	namespace MeshOptimizer
+	{
+		constexpr uint32_t DefaultCacheSize{ 16 };
+
+		enum class CacheModel
+		{
+			Fifo,
+			Lru
+		};
+
+		struct CacheStats
+		{
+			float acmr{}; //Average cache miss ratio: transformed vertices per triangle
+			float atvr{}; //Average transform to vertex ratio: transformed vertices per unique vertex
+		};
+
+		//Simulates a post-transform vertex cache over the triangle list
+		CacheStats AnalyzeVertexCache(const std::vector<uint32_t>& indices, size_t numVertices, uint32_t cacheSize = DefaultCacheSize, CacheModel model = CacheModel::Fifo);
+
+		//Reorders triangles for post-transform cache locality (Tipsify, Sander et al. 2007), winding is kept
+		void OptimizeVertexCache(std::vector<uint32_t>& indices, size_t numVertices, uint32_t cacheSize = DefaultCacheSize);
+
+		struct OverdrawStats
+		{
+			float overdraw{}; //Shaded pixels per covered pixel, 1 is optimal
+			uint64_t pixelsCovered{};
+			uint64_t pixelsShaded{};
+		};
+
+		//Estimates overdraw by rasterizing the opaque, back-face culled mesh in draw order from numViews directions around it
+		OverdrawStats AnalyzeOverdraw(const std::vector<uint32_t>& indices, const std::vector<Vertex>& vertices, uint32_t numViews = 16, uint32_t resolution = 256);
+
+		//Splits the cache optimized triangle list into clusters and draws the clusters most likely to occlude the rest first (Sander et al. 2007).
+		//threshold >= 1 trades vertex cache efficiency (low) for less overdraw (high), run it after OptimizeVertexCache
+		void OptimizeOverdraw(std::vector<uint32_t>& indices, const std::vector<Vertex>& vertices, float threshold = 1.05f, uint32_t cacheSize = DefaultCacheSize);
+
+		//Reorders vertices into first-use order so fetches stay sequential, unreferenced vertices are dropped
+		void OptimizeVertexFetch(std::vector<Vertex>& vertices, std::vector<uint32_t>& indices);
+	}
+}
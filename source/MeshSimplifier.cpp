@@ -0,0 +1,511 @@
+#include "pch.h"
+#include "MeshSimplifier.h"
+
+#include <cfloat>
+#include <numeric>
+#include <tuple>
+
+namespace dae
+{
+	namespace MeshSimplifier
+	{
+		namespace
+		{
+			enum class VertexKind : uint8_t
+			{
+				Manifold,	//Interior of a single attribute chart
+				Border,		//On an open edge of the mesh
+				Seam,		//On a UV or normal seam, shares its position with exactly one other vertex
+				Locked		//Where borders and seams meet, never moves
+			};
+
+			//Which kinds a vertex of the row kind may collapse onto
+			constexpr bool CanCollapse[4][4]{
+				{ true, true, true, true },
+				{ false, true, false, false },
+				{ false, false, true, false },
+				{ false, false, false, false } };
+
+			//Border edges resist collapses across them more than faces do
+			constexpr float BorderWeight{ 10.f };
+			//Squared normal and uv differences add to the squared distance error with these weights
+			constexpr float NormalWeight{ .01f };
+			constexpr float UvWeight{ .01f };
+			//Collapses that turn a remaining triangle's normal further than this cosine are rejected
+			constexpr float MinNormalCosine{ .25f };
+
+			constexpr float InvalidError{ FLT_MAX };
+
+			struct Quadric
+			{
+				float a00{}, a11{}, a22{};
+				float a10{}, a20{}, a21{};
+				float b0{}, b1{}, b2{};
+				float c{};
+				float weight{};
+
+				void AddPlane(const Vector3& normal, float distance, float planeWeight)
+				{
+					a00 += planeWeight * normal.x * normal.x;
+					a11 += planeWeight * normal.y * normal.y;
+					a22 += planeWeight * normal.z * normal.z;
+					a10 += planeWeight * normal.y * normal.x;
+					a20 += planeWeight * normal.z * normal.x;
+					a21 += planeWeight * normal.z * normal.y;
+					b0 += planeWeight * normal.x * distance;
+					b1 += planeWeight * normal.y * distance;
+					b2 += planeWeight * normal.z * distance;
+					c += planeWeight * distance * distance;
+					weight += planeWeight;
+				}
+
+				void Add(const Quadric& other)
+				{
+					a00 += other.a00; a11 += other.a11; a22 += other.a22;
+					a10 += other.a10; a20 += other.a20; a21 += other.a21;
+					b0 += other.b0; b1 += other.b1; b2 += other.b2;
+					c += other.c;
+					weight += other.weight;
+				}
+
+				//Weighted mean of the squared distances to the planes
+				float Evaluate(const Vector3& p) const
+				{
+					const float rx{ b0 + p.x * a00 + p.y * a10 + p.z * a20 };
+					const float ry{ b1 + p.x * a10 + p.y * a11 + p.z * a21 };
+					const float rz{ b2 + p.x * a20 + p.y * a21 + p.z * a22 };
+					const float error{ p.x * rx + p.y * ry + p.z * rz + b0 * p.x + b1 * p.y + b2 * p.z + c };
+					return weight > 0.f ? fabsf(error) / weight : 0.f;
+				}
+			};
+
+			//Items grouped by vertex: half-edge targets by start vertex, or triangles by corner
+			struct VertexTable
+			{
+				std::vector<uint32_t> offsets{};
+				std::vector<uint32_t> items{};
+
+				const uint32_t* begin(uint32_t vertex) const { return items.data() + offsets[vertex]; }
+				const uint32_t* end(uint32_t vertex) const { return items.data() + offsets[vertex + 1]; }
+			};
+
+			//Half-edges of the triangle list, vertices are looked up through remap when it's given
+			VertexTable BuildEdges(const std::vector<uint32_t>& indices, size_t numVertices, const std::vector<uint32_t>* pRemap = nullptr)
+			{
+				const auto vertexOf = [pRemap](uint32_t index) { return pRemap ? (*pRemap)[index] : index; };
+
+				VertexTable edges{};
+				edges.offsets.assign(numVertices + 1, 0);
+				for (size_t i = 0; i < indices.size(); ++i)
+					++edges.offsets[vertexOf(indices[i]) + 1];
+				std::partial_sum(edges.offsets.begin(), edges.offsets.end(), edges.offsets.begin());
+
+				std::vector<uint32_t> cursor(edges.offsets.begin(), edges.offsets.end() - 1);
+				edges.items.resize(indices.size());
+				for (size_t i = 0; i < indices.size(); i += 3)
+				{
+					for (size_t corner = 0; corner < 3; ++corner)
+					{
+						const uint32_t from{ vertexOf(indices[i + corner]) };
+						edges.items[cursor[from]++] = vertexOf(indices[i + (corner + 1) % 3]);
+					}
+				}
+
+				return edges;
+			}
+
+			VertexTable BuildTriangles(const std::vector<uint32_t>& indices, size_t numVertices)
+			{
+				VertexTable triangles{};
+				triangles.offsets.assign(numVertices + 1, 0);
+				for (const uint32_t index : indices)
+					++triangles.offsets[index + 1];
+				std::partial_sum(triangles.offsets.begin(), triangles.offsets.end(), triangles.offsets.begin());
+
+				std::vector<uint32_t> cursor(triangles.offsets.begin(), triangles.offsets.end() - 1);
+				triangles.items.resize(indices.size());
+				for (size_t i = 0; i < indices.size(); ++i)
+					triangles.items[cursor[indices[i]]++] = static_cast<uint32_t>(i / 3);
+
+				return triangles;
+			}
+
+			bool HasEdge(const VertexTable& edges, uint32_t from, uint32_t to)
+			{
+				return std::find(edges.begin(from), edges.end(from), to) != edges.end(from);
+			}
+
+			//remap points every vertex at the first vertex with the same position, wedge links those vertices in a cycle
+			void BuildPositionRemap(const std::vector<Vertex>& vertices, std::vector<uint32_t>& remap, std::vector<uint32_t>& wedge)
+			{
+				std::vector<uint32_t> order(vertices.size());
+				std::iota(order.begin(), order.end(), 0u);
+				std::sort(order.begin(), order.end(), [&vertices](uint32_t lhs, uint32_t rhs)
+					{
+						const Vector3& a = vertices[lhs].position;
+						const Vector3& b = vertices[rhs].position;
+						return std::tie(a.x, a.y, a.z, lhs) < std::tie(b.x, b.y, b.z, rhs);
+					});
+
+				remap.resize(vertices.size());
+				wedge.resize(vertices.size());
+				for (size_t first = 0; first < order.size();)
+				{
+					size_t last{ first + 1 };
+					const Vector3& position = vertices[order[first]].position;
+					while (last < order.size() && vertices[order[last]].position.x == position.x &&
+						vertices[order[last]].position.y == position.y && vertices[order[last]].position.z == position.z)
+						++last;
+
+					for (size_t i = first; i < last; ++i)
+					{
+						remap[order[i]] = order[first];
+						wedge[order[i]] = order[i + 1 < last ? i + 1 : first];
+					}
+
+					first = last;
+				}
+			}
+
+			std::vector<VertexKind> ClassifyVertices(const std::vector<uint32_t>& indices, const std::vector<uint32_t>& remap, const std::vector<uint32_t>& wedge,
+				const VertexTable& edges)
+			{
+				const size_t numVertices{ remap.size() };
+
+				//Open half-edges have no twin, in the attribute topology and in the welded position topology
+				std::vector<uint32_t> openOut(numVertices), openIn(numVertices), openPosition(numVertices);
+				const VertexTable positionEdges = BuildEdges(indices, numVertices, &remap);
+				for (size_t i = 0; i < indices.size(); i += 3)
+				{
+					for (size_t corner = 0; corner < 3; ++corner)
+					{
+						const uint32_t from{ indices[i + corner] };
+						const uint32_t to{ indices[i + (corner + 1) % 3] };
+						if (!HasEdge(edges, to, from))
+						{
+							++openOut[from];
+							++openIn[to];
+						}
+
+						if (remap[from] != remap[to] && !HasEdge(positionEdges, remap[to], remap[from]))
+							++openPosition[remap[from]];
+					}
+				}
+
+				std::vector<VertexKind> kinds(numVertices, VertexKind::Locked);
+				for (uint32_t vertex = 0; vertex < numVertices; ++vertex)
+				{
+					if (remap[vertex] != vertex)
+						continue;
+
+					const uint32_t sibling{ wedge[vertex] };
+					const bool isBorderVertex{ openOut[vertex] == 1 && openIn[vertex] == 1 };
+					if (sibling == vertex)
+					{
+						if (openOut[vertex] == 0 && openIn[vertex] == 0)
+							kinds[vertex] = VertexKind::Manifold;
+						else if (isBorderVertex)
+							kinds[vertex] = VertexKind::Border;
+					}
+					else if (wedge[sibling] == vertex && openPosition[vertex] == 0 && isBorderVertex && openOut[sibling] == 1 && openIn[sibling] == 1)
+					{
+						kinds[vertex] = VertexKind::Seam;
+						kinds[sibling] = VertexKind::Seam;
+					}
+				}
+
+				return kinds;
+			}
+
+			struct Collapse
+			{
+				uint32_t from;
+				uint32_t to;
+				float error;
+			};
+		}
+
+		std::vector<uint32_t> Simplify(const std::vector<uint32_t>& indices, const std::vector<Vertex>& vertices, size_t targetIndexCount,
+			float maxError, float* pResultError, std::vector<uint32_t>* pSourceTriangles)
+		{
+			std::vector<uint32_t> result{ indices };
+			if (pResultError)
+				*pResultError = 0.f;
+			if (pSourceTriangles)
+			{
+				pSourceTriangles->resize(result.size() / 3);
+				std::iota(pSourceTriangles->begin(), pSourceTriangles->end(), 0u);
+			}
+
+			targetIndexCount -= targetIndexCount % 3;
+			if (result.size() <= targetIndexCount || vertices.empty())
+				return result;
+
+			const size_t numVertices{ vertices.size() };
+
+			//Errors are measured in the unit cube around the mesh
+			Vector3 boundsMin{ vertices[0].position };
+			Vector3 boundsMax{ vertices[0].position };
+			for (const Vertex& vertex : vertices)
+			{
+				for (int axis = 0; axis < 3; ++axis)
+				{
+					boundsMin[axis] = std::min(boundsMin[axis], vertex.position[axis]);
+					boundsMax[axis] = std::max(boundsMax[axis], vertex.position[axis]);
+				}
+			}
+
+			const Vector3 extent{ boundsMax - boundsMin };
+			const float scale{ std::max(std::max(extent.x, extent.y), std::max(extent.z, FLT_MIN)) };
+			std::vector<Vector3> positions(numVertices);
+			for (size_t i = 0; i < numVertices; ++i)
+				positions[i] = (vertices[i].position - boundsMin) / scale;
+
+			std::vector<uint32_t> remap{}, wedge{};
+			BuildPositionRemap(vertices, remap, wedge);
+
+			VertexTable edges = BuildEdges(result, numVertices);
+			std::vector<VertexKind> kinds = ClassifyVertices(result, remap, wedge, edges);
+			for (uint32_t vertex = 0; vertex < numVertices; ++vertex)
+				kinds[vertex] = kinds[remap[vertex]];
+
+			//Face planes weighted by area, open edges add a plane through the edge along the face normal
+			std::vector<Quadric> quadrics(numVertices);
+			for (size_t i = 0; i < result.size(); i += 3)
+			{
+				const Vector3 faceNormal{ Vector3::Cross(positions[result[i + 1]] - positions[result[i]], positions[result[i + 2]] - positions[result[i]]) };
+				const float doubleArea{ faceNormal.Magnitude() };
+				if (doubleArea <= 0.f)
+					continue;
+
+				const Vector3 planeNormal{ faceNormal / doubleArea };
+				const float planeDistance{ -Vector3::Dot(planeNormal, positions[result[i]]) };
+				for (size_t corner = 0; corner < 3; ++corner)
+					quadrics[remap[result[i + corner]]].AddPlane(planeNormal, planeDistance, doubleArea * .5f);
+
+				for (size_t corner = 0; corner < 3; ++corner)
+				{
+					const uint32_t from{ result[i + corner] };
+					const uint32_t to{ result[i + (corner + 1) % 3] };
+					if (HasEdge(edges, to, from))
+						continue;
+
+					const Vector3 edge{ positions[to] - positions[from] };
+					const float edgeLength{ edge.Magnitude() };
+					const Vector3 edgeNormal{ Vector3::Cross(edge, planeNormal) };
+					const float edgeNormalLength{ edgeNormal.Magnitude() };
+					if (edgeNormalLength <= 0.f)
+						continue;
+
+					const Vector3 edgePlaneNormal{ edgeNormal / edgeNormalLength };
+					const float edgePlaneDistance{ -Vector3::Dot(edgePlaneNormal, positions[from]) };
+					quadrics[remap[from]].AddPlane(edgePlaneNormal, edgePlaneDistance, edgeLength * BorderWeight);
+					quadrics[remap[to]].AddPlane(edgePlaneNormal, edgePlaneDistance, edgeLength * BorderWeight);
+				}
+			}
+
+			const auto attributeError = [&vertices](uint32_t from, uint32_t to)
+				{
+					return NormalWeight * (vertices[from].normal - vertices[to].normal).SqrMagnitude() +
+						UvWeight * (vertices[from].uv - vertices[to].uv).SqrMagnitude();
+				};
+
+			const auto collapseError = [&](uint32_t from, uint32_t to)
+				{
+					const VertexKind fromKind{ kinds[from] };
+					if (!CanCollapse[size_t(fromKind)][size_t(kinds[to])])
+						return InvalidError;
+
+					//Borders and seams only slide along themselves, never across the interior
+					if (fromKind != VertexKind::Manifold && HasEdge(edges, from, to) && HasEdge(edges, to, from))
+						return InvalidError;
+
+					float error{ quadrics[remap[from]].Evaluate(positions[to]) + attributeError(from, to) };
+					if (fromKind == VertexKind::Seam)
+					{
+						//The other side of the seam has to collapse along the same edge
+						if (!HasEdge(edges, wedge[from], wedge[to]) && !HasEdge(edges, wedge[to], wedge[from]))
+							return InvalidError;
+
+						error += attributeError(wedge[from], wedge[to]);
+					}
+
+					return error;
+				};
+
+			VertexTable triangles{};
+			const auto hasFlip = [&](uint32_t from, uint32_t to)
+				{
+					const Vector3& target = positions[to];
+					for (const uint32_t* pTriangle = triangles.begin(from); pTriangle != triangles.end(from); ++pTriangle)
+					{
+						const uint32_t* pCorners = &result[size_t(*pTriangle) * 3];
+						const size_t corner{ size_t(pCorners[0] == from ? 0 : pCorners[1] == from ? 1 : 2) };
+						const uint32_t b{ pCorners[(corner + 1) % 3] };
+						const uint32_t c{ pCorners[(corner + 2) % 3] };
+
+						//Triangles on the collapsed edge disappear
+						if (remap[b] == remap[to] || remap[c] == remap[to])
+							continue;
+
+						const Vector3 before{ Vector3::Cross(positions[b] - positions[from], positions[c] - positions[from]) };
+						const Vector3 after{ Vector3::Cross(positions[b] - target, positions[c] - target) };
+						if (Vector3::Dot(before, after) <= MinNormalCosine * sqrtf(before.SqrMagnitude() * after.SqrMagnitude()))
+							return true;
+					}
+
+					return false;
+				};
+
+			const float maxErrorSquared{ maxError * maxError };
+			float resultError{};
+
+			std::vector<Collapse> collapses{};
+			std::vector<uint32_t> collapseRemap(numVertices);
+			std::vector<uint8_t> isLocked(numVertices);
+			while (result.size() > targetIndexCount)
+			{
+				edges = BuildEdges(result, numVertices);
+				triangles = BuildTriangles(result, numVertices);
+
+				collapses.clear();
+				for (size_t i = 0; i < result.size(); i += 3)
+				{
+					for (size_t corner = 0; corner < 3; ++corner)
+					{
+						const uint32_t a{ result[i + corner] };
+						const uint32_t b{ result[i + (corner + 1) % 3] };
+
+						//Interior edges show up in two triangles, take them once
+						if (remap[a] == remap[b] || (a > b && HasEdge(edges, b, a)))
+							continue;
+
+						const float errorAB{ collapseError(a, b) };
+						const float errorBA{ collapseError(b, a) };
+						if (std::min(errorAB, errorBA) < InvalidError)
+							collapses.push_back(errorAB <= errorBA ? Collapse{ a, b, errorAB } : Collapse{ b, a, errorBA });
+					}
+				}
+
+				if (collapses.empty())
+					break;
+
+				std::sort(collapses.begin(), collapses.end(), [](const Collapse& lhs, const Collapse& rhs)
+					{
+						return std::tie(lhs.error, lhs.from, lhs.to) < std::tie(rhs.error, rhs.from, rhs.to);
+					});
+
+				//An edge collapse removes about two triangles, so the pass stays near the cheapest collapses that reach the target
+				const size_t trianglesToRemove{ (result.size() - targetIndexCount) / 3 };
+				const size_t collapseGoal{ std::min(trianglesToRemove / 2, collapses.size() - 1) };
+				const float errorLimit{ std::min(maxErrorSquared, collapses[collapseGoal].error * 1.5f) };
+
+				std::iota(collapseRemap.begin(), collapseRemap.end(), 0u);
+				std::fill(isLocked.begin(), isLocked.end(), uint8_t{ 0 });
+
+				size_t trianglesRemoved{};
+				size_t numCollapses{};
+				float passErrorLimit{ errorLimit };
+				for (const Collapse& collapse : collapses)
+				{
+					if (trianglesRemoved >= trianglesToRemove)
+						break;
+
+					//When every collapse under the limit got rejected, the pass takes the next valid one instead of giving up
+					if (collapse.error > passErrorLimit && (numCollapses > 0 || collapse.error > maxErrorSquared))
+						break;
+
+					const uint32_t from{ collapse.from };
+					const uint32_t to{ collapse.to };
+					const bool isSeam{ kinds[from] == VertexKind::Seam };
+					if (isLocked[remap[from]] || isLocked[remap[to]])
+						continue;
+
+					if (hasFlip(from, to) || (isSeam && hasFlip(wedge[from], wedge[to])))
+						continue;
+
+					collapseRemap[from] = to;
+					if (isSeam)
+						collapseRemap[wedge[from]] = wedge[to];
+
+					isLocked[remap[from]] = 1;
+					isLocked[remap[to]] = 1;
+					quadrics[remap[to]].Add(quadrics[remap[from]]);
+
+					passErrorLimit = std::max(passErrorLimit, collapse.error);
+					resultError = std::max(resultError, collapse.error);
+					trianglesRemoved += kinds[from] == VertexKind::Border ? 1 : 2;
+					++numCollapses;
+				}
+
+				if (numCollapses == 0)
+					break;
+
+				//Drop the triangles that lost their area
+				size_t numIndices{};
+				for (size_t i = 0; i < result.size(); i += 3)
+				{
+					const uint32_t i0{ collapseRemap[result[i]] };
+					const uint32_t i1{ collapseRemap[result[i + 1]] };
+					const uint32_t i2{ collapseRemap[result[i + 2]] };
+					if (remap[i0] == remap[i1] || remap[i1] == remap[i2] || remap[i0] == remap[i2])
+						continue;
+
+					if (pSourceTriangles)
+						(*pSourceTriangles)[numIndices / 3] = (*pSourceTriangles)[i / 3];
+					result[numIndices++] = i0;
+					result[numIndices++] = i1;
+					result[numIndices++] = i2;
+				}
+				result.resize(numIndices);
+				if (pSourceTriangles)
+					pSourceTriangles->resize(numIndices / 3);
+			}
+
+			if (pResultError)
+				*pResultError = sqrtf(resultError) * scale;
+
+			return result;
+		}
+
+		std::vector<LodLevel> GenerateLodChain(const std::vector<uint32_t>& indices, const std::vector<Vertex>& vertices, const std::vector<uint32_t>& groupStarts,
+			const std::vector<float>& ratios, float maxError)
+		{
+			std::vector<LodLevel> chain{};
+			chain.push_back(LodLevel{ indices, 0.f, groupStarts });
+
+			const size_t numTriangles{ indices.size() / 3 };
+			for (const float ratio : ratios)
+			{
+				//Every level starts from the source mesh, so errors don't pile up through the chain
+				float error{};
+				std::vector<uint32_t> sourceTriangles{};
+				std::vector<uint32_t> lodIndices = Simplify(indices, vertices, size_t(float(numTriangles) * ratio) * 3, maxError, &error, &sourceTriangles);
+
+				//Less than a tenth fewer triangles isn't worth another level
+				if (lodIndices.empty() || lodIndices.size() * 10 > chain.back().indices.size() * 9)
+					break;
+
+				//Triangles kept their order, so a group starts after the surviving triangles of the groups before it
+				std::vector<uint32_t> lodGroupStarts{};
+				for (const uint32_t groupStart : groupStarts)
+				{
+					const auto firstInGroup = std::lower_bound(sourceTriangles.begin(), sourceTriangles.end(), groupStart / 3);
+					lodGroupStarts.push_back(static_cast<uint32_t>(firstInGroup - sourceTriangles.begin()) * 3);
+				}
+
+				chain.push_back(LodLevel{ std::move(lodIndices), std::max(error, chain.back().error), std::move(lodGroupStarts) });
+			}
+
+			return chain;
+		}
+
+		size_t SelectLod(const std::vector<MeshLod>& lods, float pixelsPerUnit, float maxPixelError)
+		{
+			size_t lodIdx{};
+			while (lodIdx + 1 < lods.size() && lods[lodIdx + 1].error * pixelsPerUnit <= maxPixelError)
+				++lodIdx;
+			return lodIdx;
+		}
+	}
+}
@@ -0,0 +1,48 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+#include "Vertex.h"
+
+namespace dae
+{
+	//Draw ranges and meshlets of one level of detail and the object space error it was simplified with
+	struct MeshLod
+	{
+		uint32_t firstRange;
+		uint32_t rangeCount;
+		uint32_t firstMeshlet;
+		uint32_t meshletCount;
+		float error;
+	};
+
+	//Quadric error edge collapse (Garland and Heckbert 1997) on an indexed triangle list.
+	//Vertices are never moved or added, so every level of detail indexes the same vertex buffer.
+	namespace MeshSimplifier
+	{
+		struct LodLevel
+		{
+			std::vector<uint32_t> indices{};
+			float error{}; //Object space, 0 for the source mesh
+			//Where every group of the source mesh starts in indices
+			std::vector<uint32_t> groupStarts{};
+		};
+
+		inline const std::vector<float> DefaultLodRatios{ .5f, .25f, .125f, .0625f };
+		constexpr float DefaultMaxError{ .25f };
+
+		//Collapses edges until there are at most targetIndexCount indices left or the next collapse would exceed maxError.
+		//maxError is relative to the largest extent of the mesh, pResultError receives the error reached in object space.
+		//UV seams and open borders only collapse along themselves, corners where they meet are locked.
+		//The remaining triangles keep their order, pSourceTriangles receives the source triangle each one came from.
+		std::vector<uint32_t> Simplify(const std::vector<uint32_t>& indices, const std::vector<Vertex>& vertices, size_t targetIndexCount,
+			float maxError = DefaultMaxError, float* pResultError = nullptr, std::vector<uint32_t>* pSourceTriangles = nullptr);
+
+		//The source mesh followed by one level per triangle ratio, the chain ends early once a level stops shrinking.
+		//groupStarts splits the source into consecutive index groups (materials), every level keeps them in order.
+		std::vector<LodLevel> GenerateLodChain(const std::vector<uint32_t>& indices, const std::vector<Vertex>& vertices,
+			const std::vector<uint32_t>& groupStarts = { 0 }, const std::vector<float>& ratios = DefaultLodRatios, float maxError = DefaultMaxError);
+
+		//Coarsest of lods whose error projects to at most maxPixelError at pixelsPerUnit pixels per object space unit, 0 when there are none
+		size_t SelectLod(const std::vector<MeshLod>& lods, float pixelsPerUnit, float maxPixelError);
+	}
+}
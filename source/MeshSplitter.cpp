@@ -0,0 +1,230 @@
+#include "pch.h"
+#include "MeshSplitter.h"
+
+#include <algorithm>
+#include <cstring>
+#include <numeric>
+#include <unordered_map>
+
+namespace dae
+{
+	namespace MeshSplitter
+	{
+		namespace
+		{
+			uint32_t GetGroupEnd(const std::vector<uint32_t>& groupStarts, size_t group, uint32_t numIndices)
+			{
+				return group + 1 < groupStarts.size() ? groupStarts[group + 1] : numIndices;
+			}
+		}
+
+		std::vector<DrawRange> Split(std::vector<Vertex>& vertices, std::vector<uint32_t>& indices, const std::vector<uint32_t>& groupStarts,
+			std::vector<uint32_t>& groupRanges, const std::vector<uint32_t>& groupSets, uint32_t maxRangeVertices)
+		{
+			const uint32_t numIndices{ static_cast<uint32_t>(indices.size()) };
+			std::vector<DrawRange> ranges{};
+			groupRanges.clear();
+
+			if (vertices.size() <= maxRangeVertices)
+			{
+				for (size_t group = 0; group < groupStarts.size(); ++group)
+				{
+					groupRanges.push_back(static_cast<uint32_t>(ranges.size()));
+					ranges.push_back(DrawRange{ groupStarts[group], GetGroupEnd(groupStarts, group, numIndices) - groupStarts[group], 0, static_cast<uint32_t>(vertices.size()) });
+				}
+				return ranges;
+			}
+
+			//A triangle always has to fit
+			maxRangeVertices = std::max(maxRangeVertices, 3u);
+
+			constexpr uint32_t none{ UINT32_MAX };
+
+			//Blocks collect their vertices apart and are laid out one after the other at the end, so a later group can still add to an earlier block.
+			//A vertex remembers the first block it went into, copies in other blocks are looked up by block and vertex.
+			std::vector<std::vector<uint32_t>> blockVertices{};
+			std::vector<uint32_t> blockSets{};
+			std::vector<uint32_t> firstBlock(vertices.size(), none);
+			std::vector<uint32_t> firstLocal(vertices.size(), none);
+			std::unordered_map<uint64_t, uint32_t> otherLocals{};
+			const auto findLocal = [&](uint32_t block, uint32_t vertex)
+				{
+					if (firstBlock[vertex] == block)
+						return firstLocal[vertex];
+					const auto it = otherLocals.find(uint64_t(block) << 32 | vertex);
+					return it != otherLocals.end() ? it->second : none;
+				};
+			const auto getNumMissing = [&](uint32_t block, const uint32_t* pCorners)
+				{
+					uint32_t numMissing{};
+					for (uint32_t corner = 0; corner < 3; ++corner)
+					{
+						bool isMissing{ findLocal(block, pCorners[corner]) == none };
+						for (uint32_t other = 0; other < corner && isMissing; ++other)
+							isMissing = pCorners[other] != pCorners[corner];
+						numMissing += isMissing;
+					}
+					return numMissing;
+				};
+
+			//Block of every range until the blocks have their place in the vertex buffer
+			std::vector<uint32_t> rangeBlocks{};
+			std::vector<uint32_t> triangleBlocks{};
+			std::vector<uint32_t> triangleOrder{};
+			std::vector<uint32_t> groupIndices{};
+			//Latest block of every set, the one that still has room
+			std::vector<uint32_t> setLastBlocks{};
+			for (size_t group = 0; group < groupStarts.size(); ++group)
+			{
+				groupRanges.push_back(static_cast<uint32_t>(ranges.size()));
+				const uint32_t set{ group < groupSets.size() ? groupSets[group] : static_cast<uint32_t>(groupSets.size() + group) };
+				const uint32_t groupStart{ groupStarts[group] };
+				const uint32_t numTriangles{ (GetGroupEnd(groupStarts, group, numIndices) - groupStart) / 3 };
+
+				//A triangle goes to a block of its set that already has its corners, else to the current block, one of its corners' blocks
+				//or the set's latest block while they have room for the missing ones, else it opens a new block
+				setLastBlocks.resize(std::max(setLastBlocks.size(), size_t(set) + 1), none);
+				triangleBlocks.assign(numTriangles, none);
+				uint32_t currentBlock{ none };
+				for (uint32_t triangle = 0; triangle < numTriangles; ++triangle)
+				{
+					const uint32_t* pCorners = indices.data() + groupStart + triangle * 3;
+					uint32_t candidates[5]{ currentBlock, firstBlock[pCorners[0]], firstBlock[pCorners[1]], firstBlock[pCorners[2]], setLastBlocks[set] };
+					for (uint32_t& candidate : candidates)
+					{
+						if (candidate != none && blockSets[candidate] != set)
+							candidate = none;
+					}
+
+					uint32_t block{ none };
+					for (const bool needsAllCorners : { true, false })
+					{
+						for (size_t candidateIdx = 0; candidateIdx < std::size(candidates) && block == none; ++candidateIdx)
+						{
+							const uint32_t candidate{ candidates[candidateIdx] };
+							if (candidate == none)
+								continue;
+							const uint32_t numMissing{ getNumMissing(candidate, pCorners) };
+							if (needsAllCorners ? numMissing == 0 : blockVertices[candidate].size() + numMissing <= maxRangeVertices)
+								block = candidate;
+						}
+					}
+					if (block == none)
+					{
+						block = static_cast<uint32_t>(blockVertices.size());
+						blockVertices.emplace_back();
+						blockSets.push_back(set);
+						setLastBlocks[set] = block;
+					}
+					currentBlock = block;
+					triangleBlocks[triangle] = block;
+
+					for (uint32_t corner = 0; corner < 3; ++corner)
+					{
+						const uint32_t vertex{ pCorners[corner] };
+						if (findLocal(block, vertex) != none)
+							continue;
+
+						const uint32_t local{ static_cast<uint32_t>(blockVertices[block].size()) };
+						blockVertices[block].push_back(vertex);
+						if (firstBlock[vertex] == none)
+						{
+							firstBlock[vertex] = block;
+							firstLocal[vertex] = local;
+						}
+						else
+						{
+							otherLocals.emplace(uint64_t(block) << 32 | vertex, local);
+						}
+					}
+				}
+
+				//Triangles of the same block are moved together, keeping their order, so every block the group uses is one range.
+				//The first group of a set fills its blocks one after the other and stays as it is.
+				triangleOrder.resize(numTriangles);
+				std::iota(triangleOrder.begin(), triangleOrder.end(), 0u);
+				std::stable_sort(triangleOrder.begin(), triangleOrder.end(), [&triangleBlocks](uint32_t lhs, uint32_t rhs) { return triangleBlocks[lhs] < triangleBlocks[rhs]; });
+				groupIndices.assign(indices.begin() + groupStart, indices.begin() + groupStart + numTriangles * 3);
+
+				DrawRange range{ groupStart, 0, 0, 0 };
+				uint32_t rangeBlock{ numTriangles > 0 ? triangleBlocks[triangleOrder[0]] : none };
+				for (uint32_t triangleIdx = 0; triangleIdx < numTriangles; ++triangleIdx)
+				{
+					const uint32_t triangle{ triangleOrder[triangleIdx] };
+					const uint32_t block{ triangleBlocks[triangle] };
+					if (block != rangeBlock)
+					{
+						ranges.push_back(range);
+						rangeBlocks.push_back(rangeBlock);
+						range = DrawRange{ groupStart + triangleIdx * 3, 0, 0, 0 };
+						rangeBlock = block;
+					}
+
+					for (uint32_t corner = 0; corner < 3; ++corner)
+						indices[groupStart + triangleIdx * 3 + corner] = findLocal(block, groupIndices[size_t(triangle) * 3 + corner]);
+					range.indexCount += 3;
+				}
+
+				//The next group starts a fresh range, even an empty group keeps its slot
+				ranges.push_back(range);
+				rangeBlocks.push_back(rangeBlock);
+			}
+
+			//Lay the blocks out in order and point every range at its block
+			std::vector<Vertex> splitVertices{};
+			std::vector<uint32_t> blockBases(blockVertices.size());
+			for (size_t block = 0; block < blockVertices.size(); ++block)
+			{
+				blockBases[block] = static_cast<uint32_t>(splitVertices.size());
+				for (const uint32_t vertex : blockVertices[block])
+					splitVertices.push_back(vertices[vertex]);
+			}
+			for (size_t rangeIdx = 0; rangeIdx < ranges.size(); ++rangeIdx)
+			{
+				if (rangeBlocks[rangeIdx] == none)
+					continue;
+				ranges[rangeIdx].baseVertex = blockBases[rangeBlocks[rangeIdx]];
+				ranges[rangeIdx].vertexCount = static_cast<uint32_t>(blockVertices[rangeBlocks[rangeIdx]].size());
+			}
+
+			vertices = std::move(splitVertices);
+			return ranges;
+		}
+
+		EncodedIndices EncodeShortIndices(std::vector<Vertex>& vertices, const std::vector<uint32_t>& indices, const std::vector<uint32_t>& groupStarts,
+			const std::vector<uint32_t>& groupSets, uint32_t maxRangeVertices)
+		{
+			std::vector<uint32_t> localIndices{ indices };
+
+			EncodedIndices encoded{};
+			encoded.ranges = Split(vertices, localIndices, groupStarts, encoded.groups, groupSets, std::min(maxRangeVertices, MaxShortIndexVertices));
+			encoded.stride = sizeof(uint16_t);
+			encoded.count = static_cast<uint32_t>(localIndices.size());
+			encoded.data.resize(localIndices.size() * sizeof(uint16_t));
+
+			uint16_t* pIndices = reinterpret_cast<uint16_t*>(encoded.data.data());
+			for (size_t i = 0; i < localIndices.size(); ++i)
+				pIndices[i] = static_cast<uint16_t>(localIndices[i]);
+
+			return encoded;
+		}
+
+		EncodedIndices EncodeLongIndices(const std::vector<uint32_t>& indices, uint32_t numVertices, const std::vector<uint32_t>& groupStarts)
+		{
+			EncodedIndices encoded{};
+			encoded.stride = sizeof(uint32_t);
+			encoded.count = static_cast<uint32_t>(indices.size());
+			encoded.data.resize(indices.size() * sizeof(uint32_t));
+			if (!indices.empty())
+				std::memcpy(encoded.data.data(), indices.data(), encoded.data.size());
+
+			for (size_t group = 0; group < groupStarts.size(); ++group)
+			{
+				encoded.groups.push_back(static_cast<uint32_t>(encoded.ranges.size()));
+				encoded.ranges.push_back(DrawRange{ groupStarts[group], GetGroupEnd(groupStarts, group, encoded.count) - groupStarts[group], 0, numVertices });
+			}
+
+			return encoded;
+		}
+	}
+}
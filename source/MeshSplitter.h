@@ -0,0 +1,49 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+#include "Vertex.h"
+
+namespace dae
+{
+	//One DrawIndexed call: indices in [indexStart, indexStart + indexCount) are relative to baseVertex
+	struct DrawRange
+	{
+		uint32_t indexStart;
+		uint32_t indexCount;
+		uint32_t baseVertex;
+		uint32_t vertexCount;
+	};
+
+	//Index data in 16 or 32 bit, ready to be uploaded
+	struct EncodedIndices
+	{
+		uint32_t stride{};
+		uint32_t count{};
+		std::vector<uint8_t> data{};
+		std::vector<DrawRange> ranges{};
+		//First range of every index group, a group's ranges end where the next group's start
+		std::vector<uint32_t> groups{};
+	};
+
+	//Picks the smallest index format for a triangle list, splitting it into draw ranges where needed
+	namespace MeshSplitter
+	{
+		//0xFFFF stays free so strip cut values never collide with a real index
+		constexpr uint32_t MaxShortIndexVertices{ 65535 };
+
+		//Splits the triangle list into ranges that each reference at most maxRangeVertices vertices.
+		//Every index group [groupStarts[g], groupStarts[g + 1]) is split on its own, groupRanges receives the first range of each.
+		//Ranges draw from blocks of contiguous vertices. Groups with the same groupSets entry share their blocks, so the levels of detail
+		//of a submesh index the vertices of their first level instead of copies, only vertices a block lacks are duplicated into it.
+		//A group's triangles are moved together by block, keeping their order within it, so it has one range per block it uses.
+		//Groups without an entry get a set of their own. Without a split the vertices are left as they are and every group is a single range.
+		std::vector<DrawRange> Split(std::vector<Vertex>& vertices, std::vector<uint32_t>& indices, const std::vector<uint32_t>& groupStarts,
+			std::vector<uint32_t>& groupRanges, const std::vector<uint32_t>& groupSets = {}, uint32_t maxRangeVertices = MaxShortIndexVertices);
+
+		//16 bit indices, splitting the mesh when it has more vertices than they can address
+		EncodedIndices EncodeShortIndices(std::vector<Vertex>& vertices, const std::vector<uint32_t>& indices, const std::vector<uint32_t>& groupStarts = { 0 },
+			const std::vector<uint32_t>& groupSets = {}, uint32_t maxRangeVertices = MaxShortIndexVertices);
+		//32 bit indices, a single range per group
+		EncodedIndices EncodeLongIndices(const std::vector<uint32_t>& indices, uint32_t numVertices, const std::vector<uint32_t>& groupStarts = { 0 });
+	}
+}
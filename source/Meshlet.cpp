@@ -0,0 +1,349 @@
+#include "pch.h"
+#include "Meshlet.h"
+
+#include <cfloat>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__SSE2__)
+#include <emmintrin.h>
+#define DAE_MESHLET_SSE2
+#endif
+
+namespace dae
+{
+	namespace
+	{
+		//Triangles further than 60 degrees off the meshlet's average normal start a new meshlet, wider cones hardly ever cull
+		constexpr float MinConeDot{ .5f };
+
+		constexpr int NumFrustumPlanes{ 6 };
+
+		Vector3 ScaleToUnit(float x, float y, float z)
+		{
+			const float sqrLength{ x * x + y * y + z * z };
+			const float invLength{ sqrLength > FLT_MIN ? 1.f / sqrtf(sqrLength) : 0.f };
+			return Vector3{ x * invLength, y * invLength, z * invLength };
+		}
+
+		//Unit normals facing out of the mesh for clockwise front faces, zero for degenerate triangles
+		std::vector<Vector3> ComputeTriangleNormals(const std::vector<uint32_t>& indices, const std::vector<Vertex>& vertices)
+		{
+			const size_t numTriangles{ indices.size() / 3 };
+			std::vector<Vector3> normals(numTriangles);
+
+			size_t triangleIdx{};
+#ifdef DAE_MESHLET_SSE2
+			//Four triangles per iteration, corners transposed into x, y and z registers
+			for (; triangleIdx + 4 <= numTriangles; triangleIdx += 4)
+			{
+				alignas(16) float corners[9][4];
+				for (int lane = 0; lane < 4; ++lane)
+				{
+					for (int corner = 0; corner < 3; ++corner)
+					{
+						const Vector3& position = vertices[indices[(triangleIdx + lane) * 3 + corner]].position;
+						corners[corner * 3 + 0][lane] = position.x;
+						corners[corner * 3 + 1][lane] = position.y;
+						corners[corner * 3 + 2][lane] = position.z;
+					}
+				}
+
+				const __m128 p0x{ _mm_load_ps(corners[0]) }, p0y{ _mm_load_ps(corners[1]) }, p0z{ _mm_load_ps(corners[2]) };
+				const __m128 e1x{ _mm_sub_ps(_mm_load_ps(corners[3]), p0x) }, e1y{ _mm_sub_ps(_mm_load_ps(corners[4]), p0y) }, e1z{ _mm_sub_ps(_mm_load_ps(corners[5]), p0z) };
+				const __m128 e2x{ _mm_sub_ps(_mm_load_ps(corners[6]), p0x) }, e2y{ _mm_sub_ps(_mm_load_ps(corners[7]), p0y) }, e2z{ _mm_sub_ps(_mm_load_ps(corners[8]), p0z) };
+
+				const __m128 nx{ _mm_sub_ps(_mm_mul_ps(e1y, e2z), _mm_mul_ps(e1z, e2y)) };
+				const __m128 ny{ _mm_sub_ps(_mm_mul_ps(e1z, e2x), _mm_mul_ps(e1x, e2z)) };
+				const __m128 nz{ _mm_sub_ps(_mm_mul_ps(e1x, e2y), _mm_mul_ps(e1y, e2x)) };
+
+				//Exact square root and division, so the scalar tail gives the same bits
+				const __m128 sqrLength{ _mm_add_ps(_mm_add_ps(_mm_mul_ps(nx, nx), _mm_mul_ps(ny, ny)), _mm_mul_ps(nz, nz)) };
+				const __m128 isValid{ _mm_cmpgt_ps(sqrLength, _mm_set1_ps(FLT_MIN)) };
+				const __m128 invLength{ _mm_and_ps(_mm_div_ps(_mm_set1_ps(1.f), _mm_sqrt_ps(sqrLength)), isValid) };
+
+				alignas(16) float result[3][4];
+				_mm_store_ps(result[0], _mm_mul_ps(nx, invLength));
+				_mm_store_ps(result[1], _mm_mul_ps(ny, invLength));
+				_mm_store_ps(result[2], _mm_mul_ps(nz, invLength));
+				for (int lane = 0; lane < 4; ++lane)
+					normals[triangleIdx + lane] = Vector3{ result[0][lane], result[1][lane], result[2][lane] };
+			}
+#endif
+			for (; triangleIdx < numTriangles; ++triangleIdx)
+			{
+				const Vector3& p0 = vertices[indices[triangleIdx * 3]].position;
+				const Vector3 e1{ vertices[indices[triangleIdx * 3 + 1]].position - p0 };
+				const Vector3 e2{ vertices[indices[triangleIdx * 3 + 2]].position - p0 };
+				normals[triangleIdx] = ScaleToUnit(e1.y * e2.z - e1.z * e2.y, e1.z * e2.x - e1.x * e2.z, e1.x * e2.y - e1.y * e2.x);
+			}
+
+			return normals;
+		}
+
+		//Ritter's sphere: start from the most distant pair of axis extremes, grow to take in every point
+		void ComputeBoundingSphere(const std::vector<uint32_t>& meshletVertices, const std::vector<Vertex>& vertices, Meshlet& meshlet)
+		{
+			uint32_t minVertex[3]{}, maxVertex[3]{};
+			for (int axis = 0; axis < 3; ++axis)
+			{
+				minVertex[axis] = maxVertex[axis] = meshletVertices[0];
+				for (const uint32_t vertex : meshletVertices)
+				{
+					if (vertices[vertex].position[axis] < vertices[minVertex[axis]].position[axis]) minVertex[axis] = vertex;
+					if (vertices[vertex].position[axis] > vertices[maxVertex[axis]].position[axis]) maxVertex[axis] = vertex;
+				}
+			}
+
+			int widestAxis{};
+			float widestSqrDistance{ -1.f };
+			for (int axis = 0; axis < 3; ++axis)
+			{
+				const float sqrDistance{ (vertices[maxVertex[axis]].position - vertices[minVertex[axis]].position).SqrMagnitude() };
+				if (sqrDistance > widestSqrDistance)
+				{
+					widestAxis = axis;
+					widestSqrDistance = sqrDistance;
+				}
+			}
+
+			Vector3 center{ (vertices[minVertex[widestAxis]].position + vertices[maxVertex[widestAxis]].position) * .5f };
+			float radius{ sqrtf(widestSqrDistance) * .5f };
+			for (const uint32_t vertex : meshletVertices)
+			{
+				const Vector3 toPoint{ vertices[vertex].position - center };
+				const float distance{ toPoint.Magnitude() };
+				if (distance <= radius)
+					continue;
+
+				//Move the center just far enough to keep the opposite side of the old sphere inside
+				const float newRadius{ (radius + distance) * .5f };
+				center += toPoint * ((newRadius - radius) / distance);
+				radius = newRadius;
+			}
+
+			for (int axis = 0; axis < 3; ++axis)
+				meshlet.center[axis] = center[axis];
+			meshlet.radius = radius;
+		}
+
+		void ComputeNormalCone(const std::vector<uint32_t>& meshletTriangles, const std::vector<Vector3>& normals, Meshlet& meshlet)
+		{
+			Vector3 normalSum{};
+			for (const uint32_t triangle : meshletTriangles)
+				normalSum += normals[triangle];
+
+			const Vector3 axis{ ScaleToUnit(normalSum.x, normalSum.y, normalSum.z) };
+			float minDot{ 1.f };
+			for (const uint32_t triangle : meshletTriangles)
+			{
+				if (normals[triangle].SqrMagnitude() > 0.f)
+					minDot = std::min(minDot, Vector3::Dot(axis, normals[triangle]));
+			}
+
+			for (int axisIdx = 0; axisIdx < 3; ++axisIdx)
+				meshlet.coneAxis[axisIdx] = axis[axisIdx];
+
+			//A cone of half a sphere or more has a face towards every position
+			meshlet.coneCutoff = minDot > 0.f && axis.SqrMagnitude() > 0.f ? sqrtf(1.f - minDot * minDot) : 1.f;
+		}
+
+		//Frustum planes as (normal, distance) with inward unit normals, for row vectors and D3D's [0, 1] depth (Gribb and Hartmann)
+		void ExtractFrustumPlanes(const Matrix& matrix, Vector4 planes[NumFrustumPlanes])
+		{
+			const Vector4 column[4]
+			{
+				{ matrix[0][0], matrix[1][0], matrix[2][0], matrix[3][0] },
+				{ matrix[0][1], matrix[1][1], matrix[2][1], matrix[3][1] },
+				{ matrix[0][2], matrix[1][2], matrix[2][2], matrix[3][2] },
+				{ matrix[0][3], matrix[1][3], matrix[2][3], matrix[3][3] }
+			};
+
+			planes[0] = column[3] + column[0];
+			planes[1] = column[3] - column[0];
+			planes[2] = column[3] + column[1];
+			planes[3] = column[3] - column[1];
+			planes[4] = column[2];
+			planes[5] = column[3] - column[2];
+
+			for (int planeIdx = 0; planeIdx < NumFrustumPlanes; ++planeIdx)
+			{
+				const float length{ planes[planeIdx].GetXYZ().Magnitude() };
+				if (length > 0.f)
+					planes[planeIdx] = planes[planeIdx] * (1.f / length);
+			}
+		}
+	}
+
+	namespace MeshletBuilder
+	{
+		std::vector<Meshlet> Build(const std::vector<uint32_t>& indices, const std::vector<Vertex>& vertices, uint32_t maxVertices, uint32_t maxTriangles)
+		{
+			//A triangle always has to fit
+			maxVertices = std::max(maxVertices, 3u);
+			maxTriangles = std::max(maxTriangles, 1u);
+
+			const uint32_t numTriangles{ static_cast<uint32_t>(indices.size() / 3) };
+			const std::vector<Vector3> normals = ComputeTriangleNormals(indices, vertices);
+
+			std::vector<Meshlet> meshlets{};
+
+			//Vertices of the current meshlet carry its index as stamp
+			constexpr uint32_t unused{ UINT32_MAX };
+			std::vector<uint32_t> vertexStamp(vertices.size(), unused);
+			std::vector<uint32_t> meshletVertices{};
+			std::vector<uint32_t> meshletTriangles{};
+			meshletVertices.reserve(maxVertices);
+			meshletTriangles.reserve(maxTriangles);
+			Vector3 normalSum{};
+
+			const auto countNewVertices = [&](uint32_t triangle)
+			{
+				const uint32_t meshletIdx{ static_cast<uint32_t>(meshlets.size()) };
+				const uint32_t* pTriangle = &indices[triangle * 3];
+				uint32_t numNew{};
+				for (uint32_t corner = 0; corner < 3; ++corner)
+				{
+					bool isNew{ vertexStamp[pTriangle[corner]] != meshletIdx };
+					for (uint32_t other = 0; other < corner && isNew; ++other)
+						isNew = pTriangle[other] != pTriangle[corner];
+					numNew += isNew;
+				}
+				return numNew;
+			};
+
+			const auto finishMeshlet = [&]()
+			{
+				if (meshletTriangles.empty())
+					return;
+
+				const uint32_t indexCount{ static_cast<uint32_t>(meshletTriangles.size() * 3) };
+				Meshlet meshlet{ .indexStart = meshletTriangles[0] * 3, .indexCount = indexCount, .center = {}, .radius = 0.f, .coneAxis = {}, .coneCutoff = 1.f };
+				ComputeBoundingSphere(meshletVertices, vertices, meshlet);
+				ComputeNormalCone(meshletTriangles, normals, meshlet);
+				meshlets.push_back(meshlet);
+
+				meshletVertices.clear();
+				meshletTriangles.clear();
+				normalSum = Vector3{};
+			};
+
+			for (uint32_t triangle = 0; triangle < numTriangles; ++triangle)
+			{
+				//The cone check only ends a meshlet, the triangle order stays what the cache and overdraw passes made it
+				const bool isTooFull{ meshletTriangles.size() == maxTriangles || meshletVertices.size() + countNewVertices(triangle) > maxVertices };
+				const Vector3 axis{ ScaleToUnit(normalSum.x, normalSum.y, normalSum.z) };
+				const bool isOutsideCone{ axis.SqrMagnitude() > 0.f && normals[triangle].SqrMagnitude() > 0.f && Vector3::Dot(axis, normals[triangle]) < MinConeDot };
+				if (isTooFull || isOutsideCone)
+					finishMeshlet();
+
+				const uint32_t meshletIdx{ static_cast<uint32_t>(meshlets.size()) };
+				for (uint32_t corner = 0; corner < 3; ++corner)
+				{
+					const uint32_t vertex{ indices[triangle * 3 + corner] };
+					if (vertexStamp[vertex] != meshletIdx)
+					{
+						vertexStamp[vertex] = meshletIdx;
+						meshletVertices.push_back(vertex);
+					}
+				}
+				meshletTriangles.push_back(triangle);
+				normalSum += normals[triangle];
+			}
+			finishMeshlet();
+
+			return meshlets;
+		}
+	}
+
+	void MeshletCuller::SetMeshlets(const std::vector<Meshlet>& meshlets)
+	{
+		m_NumMeshlets = static_cast<uint32_t>(meshlets.size());
+		const size_t paddedSize{ meshlets.size() + 3 };
+		for (std::vector<float>* pArray : { &m_CenterX, &m_CenterY, &m_CenterZ, &m_Radius, &m_AxisX, &m_AxisY, &m_AxisZ, &m_Cutoff })
+			pArray->assign(paddedSize, 0.f);
+
+		for (size_t i = 0; i < meshlets.size(); ++i)
+		{
+			m_CenterX[i] = meshlets[i].center[0];
+			m_CenterY[i] = meshlets[i].center[1];
+			m_CenterZ[i] = meshlets[i].center[2];
+			m_Radius[i] = meshlets[i].radius;
+			m_AxisX[i] = meshlets[i].coneAxis[0];
+			m_AxisY[i] = meshlets[i].coneAxis[1];
+			m_AxisZ[i] = meshlets[i].coneAxis[2];
+			m_Cutoff[i] = meshlets[i].coneCutoff;
+		}
+	}
+
+	void MeshletCuller::Cull(const Matrix& worldViewProjection, const Vector3& cameraPosition, bool cullBackfaces,
+		uint32_t first, uint32_t count, std::vector<uint32_t>& visible) const
+	{
+		Vector4 planes[NumFrustumPlanes];
+		ExtractFrustumPlanes(worldViewProjection, planes);
+
+		const uint32_t end{ std::min(first + count, m_NumMeshlets) };
+		uint32_t meshletIdx{ first };
+
+#ifdef DAE_MESHLET_SSE2
+		for (; meshletIdx < end; meshletIdx += 4)
+		{
+			const __m128 centerX{ _mm_loadu_ps(&m_CenterX[meshletIdx]) };
+			const __m128 centerY{ _mm_loadu_ps(&m_CenterY[meshletIdx]) };
+			const __m128 centerZ{ _mm_loadu_ps(&m_CenterZ[meshletIdx]) };
+			const __m128 radius{ _mm_loadu_ps(&m_Radius[meshletIdx]) };
+
+			//Visible while the sphere reaches the inner side of every plane
+			const __m128 negativeRadius{ _mm_sub_ps(_mm_setzero_ps(), radius) };
+			__m128 isVisible{ _mm_castsi128_ps(_mm_set1_epi32(-1)) };
+			for (const Vector4& plane : planes)
+			{
+				const __m128 distance{ _mm_add_ps(_mm_add_ps(_mm_mul_ps(centerX, _mm_set1_ps(plane.x)), _mm_mul_ps(centerY, _mm_set1_ps(plane.y))),
+					_mm_add_ps(_mm_mul_ps(centerZ, _mm_set1_ps(plane.z)), _mm_set1_ps(plane.w))) };
+				isVisible = _mm_and_ps(isVisible, _mm_cmpge_ps(distance, negativeRadius));
+			}
+
+			if (cullBackfaces)
+			{
+				//Back facing when the direction to every point of the sphere stays within 90 degrees of every normal in the cone
+				const __m128 toCenterX{ _mm_sub_ps(centerX, _mm_set1_ps(cameraPosition.x)) };
+				const __m128 toCenterY{ _mm_sub_ps(centerY, _mm_set1_ps(cameraPosition.y)) };
+				const __m128 toCenterZ{ _mm_sub_ps(centerZ, _mm_set1_ps(cameraPosition.z)) };
+				const __m128 distance{ _mm_sqrt_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(toCenterX, toCenterX), _mm_mul_ps(toCenterY, toCenterY)), _mm_mul_ps(toCenterZ, toCenterZ))) };
+				const __m128 alongAxis{ _mm_add_ps(_mm_add_ps(_mm_mul_ps(toCenterX, _mm_loadu_ps(&m_AxisX[meshletIdx])), _mm_mul_ps(toCenterY, _mm_loadu_ps(&m_AxisY[meshletIdx]))),
+					_mm_mul_ps(toCenterZ, _mm_loadu_ps(&m_AxisZ[meshletIdx]))) };
+				const __m128 isBackfacing{ _mm_cmpgt_ps(alongAxis, _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(&m_Cutoff[meshletIdx]), distance), radius)) };
+				isVisible = _mm_andnot_ps(isBackfacing, isVisible);
+			}
+
+			int mask{ _mm_movemask_ps(isVisible) };
+			if (end - meshletIdx < 4)
+				mask &= (1 << (end - meshletIdx)) - 1;
+
+			for (uint32_t lane = 0; lane < 4; ++lane)
+			{
+				if (mask & (1 << lane))
+					visible.push_back(meshletIdx + lane);
+			}
+		}
+#else
+		for (; meshletIdx < end; ++meshletIdx)
+		{
+			const Vector3 center{ m_CenterX[meshletIdx], m_CenterY[meshletIdx], m_CenterZ[meshletIdx] };
+			const float radius{ m_Radius[meshletIdx] };
+
+			bool isVisible{ true };
+			for (const Vector4& plane : planes)
+				isVisible = isVisible && center.x * plane.x + center.y * plane.y + center.z * plane.z + plane.w >= -radius;
+
+			if (isVisible && cullBackfaces)
+			{
+				const Vector3 toCenter{ center - cameraPosition };
+				const Vector3 axis{ m_AxisX[meshletIdx], m_AxisY[meshletIdx], m_AxisZ[meshletIdx] };
+				isVisible = Vector3::Dot(toCenter, axis) <= m_Cutoff[meshletIdx] * toCenter.Magnitude() + radius;
+			}
+
+			if (isVisible)
+				visible.push_back(meshletIdx);
+		}
+#endif
+	}
+}
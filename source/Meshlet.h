@@ -0,0 +1,58 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+#include "Vertex.h"
+
+namespace dae
+{
+	//A small cluster of triangles, drawn as one contiguous run of the index buffer
+	struct Meshlet
+	{
+		uint32_t indexStart;
+		uint32_t indexCount;
+		//Object space bounding sphere
+		float center[3];
+		float radius;
+		//Every triangle normal lies within the cone around coneAxis, coneCutoff is the sine of its half angle.
+		//A cutoff of 1 or more never culls.
+		float coneAxis[3];
+		float coneCutoff;
+	};
+
+	namespace MeshletBuilder
+	{
+		constexpr uint32_t MaxVertices{ 64 };
+		constexpr uint32_t MaxTriangles{ 124 };
+
+		//Cuts the triangle list into meshlets of consecutive triangles, index starts are relative to indices.
+		//The order is left as the vertex cache and overdraw passes made it, a meshlet ends when it is full
+		//or the next triangle is further than 60 degrees off its average normal, which keeps normal cones narrow enough to cull.
+		std::vector<Meshlet> Build(const std::vector<uint32_t>& indices, const std::vector<Vertex>& vertices,
+			uint32_t maxVertices = MaxVertices, uint32_t maxTriangles = MaxTriangles);
+	}
+
+	//Culls meshlets against the view frustum and their normal cones, four at a time
+	class MeshletCuller final
+	{
+	public:
+		void SetMeshlets(const std::vector<Meshlet>& meshlets);
+
+		//worldViewProjection takes object space to clip space, cameraPosition is in object space.
+		//Appends the visible meshlets of [first, first + count) to visible, in order.
+		//Cone culling assumes back faces are culled and the world matrix has no non-uniform scale.
+		void Cull(const Matrix& worldViewProjection, const Vector3& cameraPosition, bool cullBackfaces,
+			uint32_t first, uint32_t count, std::vector<uint32_t>& visible) const;
+
+	private:
+		uint32_t m_NumMeshlets{};
+		//Structure of arrays, padded so a four wide load never reads past the end
+		std::vector<float> m_CenterX{};
+		std::vector<float> m_CenterY{};
+		std::vector<float> m_CenterZ{};
+		std::vector<float> m_Radius{};
+		std::vector<float> m_AxisX{};
+		std::vector<float> m_AxisY{};
+		std::vector<float> m_AxisZ{};
+		std::vector<float> m_Cutoff{};
+	};
+}
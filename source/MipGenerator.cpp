@@ -0,0 +1,337 @@
+#include "pch.h"
+#include "MipGenerator.h"
+
+#include <cctype>
+#include <cfloat>
+#include <cmath>
+#include <filesystem>
+#include "ParallelFor.h"
+
+//DAE_NO_SIMD builds the scalar path on any CPU, MipGeneratorScalarTests checks it against the SSE2 one
+#if !defined(DAE_NO_SIMD) && (defined(_M_X64) || defined(_M_IX86) || defined(__SSE2__))
+#include <emmintrin.h>
+#define DAE_MIP_SSE2
+#endif
+
+namespace dae
+{
+	namespace MipGenerator
+	{
+		namespace
+		{
+			//Levels are filtered a tile of destination texels at a time, the source rows a tile needs stay in the cache
+			constexpr uint32_t TileWidth{ 128 };
+			constexpr uint32_t TileHeight{ 32 };
+			constexpr uint32_t MaxTaps{ 8 };
+
+			//Destination texel x is made of the source texels 2x + firstOffset + tap, it's centered between 2x and 2x + 1.
+			//The same taps are used along both axes.
+			struct Kernel
+			{
+				int firstOffset;
+				uint32_t numTaps;
+				float weights[MaxTaps];
+			};
+
+			//Modified Bessel function of the first kind, a power series converges fast enough for the window's arguments
+			double BesselI0(double x)
+			{
+				const double quarterSqr{ x * x / 4.0 };
+				double term{ 1.0 };
+				double sum{ 1.0 };
+				for (int k = 1; k < 32; ++k)
+				{
+					term *= quarterSqr / (double(k) * k);
+					sum += term;
+				}
+				return sum;
+			}
+
+			Kernel CreateKernel(MipFilter filter)
+			{
+				if (filter == MipFilter::Box)
+					return Kernel{ 0, 2, { 0.5f, 0.5f } };
+
+				//Distances in destination texels, the window reaches two of them to either side
+				constexpr double alpha{ 4.0 };
+				constexpr double radius{ 2.0 };
+				constexpr double pi{ 3.14159265358979323846 };
+				Kernel kernel{ -3, MaxTaps, {} };
+				double weights[MaxTaps]{};
+				double sum{};
+				for (uint32_t tap = 0; tap < kernel.numTaps; ++tap)
+				{
+					//Never 0, taps sit half a source texel off the center
+					const double distance{ (kernel.firstOffset + int(tap) - 0.5) / 2.0 };
+					const double sinc{ sin(pi * distance) / (pi * distance) };
+					const double t{ distance / radius };
+					weights[tap] = sinc * BesselI0(alpha * sqrt(1.0 - t * t)) / BesselI0(alpha);
+					sum += weights[tap];
+				}
+
+				//Flat areas stay flat
+				for (uint32_t tap = 0; tap < kernel.numTaps; ++tap)
+					kernel.weights[tap] = static_cast<float>(weights[tap] / sum);
+				return kernel;
+			}
+
+			const Kernel& GetKernel(MipFilter filter)
+			{
+				static const Kernel kernels[]{ CreateKernel(MipFilter::Box), CreateKernel(MipFilter::Kaiser) };
+				return kernels[static_cast<uint32_t>(filter)];
+			}
+
+			double SrgbToLinear(double value)
+			{
+				return value <= 0.04045 ? value / 12.92 : pow((value + 0.055) / 1.055, 2.4);
+			}
+
+			//Filtered values turned back into bytes, rounded to the nearest byte in sRGB space
+			struct SrgbEncoder
+			{
+				static constexpr uint32_t TableSize{ 4096 };
+
+				//Byte of linear value index / TableSize, off by at most one for the values in between
+				uint8_t guesses[TableSize + 1];
+				//Linear value halfway between byte i and i + 1
+				float thresholds[255];
+			};
+
+			SrgbEncoder CreateSrgbEncoder()
+			{
+				SrgbEncoder encoder{};
+				for (uint32_t value = 0; value < 255; ++value)
+					encoder.thresholds[value] = static_cast<float>(SrgbToLinear((value + 0.5) / 255.0));
+
+				uint32_t value{};
+				for (uint32_t index = 0; index <= SrgbEncoder::TableSize; ++index)
+				{
+					const float linear{ static_cast<float>(index) / SrgbEncoder::TableSize };
+					while (value < 255 && linear >= encoder.thresholds[value])
+						++value;
+					encoder.guesses[index] = static_cast<uint8_t>(value);
+				}
+				return encoder;
+			}
+
+			uint8_t EncodeSrgb(float linear)
+			{
+				static const SrgbEncoder encoder{ CreateSrgbEncoder() };
+				if (!(linear > 0.f))
+					return 0;
+				linear = std::min(linear, 1.f);
+
+				uint32_t value{ encoder.guesses[static_cast<uint32_t>(linear * SrgbEncoder::TableSize)] };
+				while (value < 255 && linear >= encoder.thresholds[value])
+					++value;
+				while (value > 0 && linear < encoder.thresholds[value - 1])
+					--value;
+				return static_cast<uint8_t>(value);
+			}
+
+			uint8_t EncodeUnorm(float value)
+			{
+				value = value * 255.f + 0.5f;
+				if (!(value > 0.f))
+					return 0;
+				return static_cast<uint8_t>(std::min(value, 255.f));
+			}
+
+			//The value every stored byte stands for, per channel
+			struct Decoder
+			{
+				float channels[4][256];
+			};
+
+			Decoder CreateDecoder(MipContent content)
+			{
+				Decoder decoder{};
+				for (uint32_t value = 0; value < 256; ++value)
+				{
+					const double unorm{ value / 255.0 };
+					double color{ unorm };
+					if (content == MipContent::Color)
+						color = SrgbToLinear(unorm);
+					else if (content == MipContent::Normal)
+						color = unorm * 2.0 - 1.0;
+
+					for (uint32_t channel = 0; channel < 3; ++channel)
+						decoder.channels[channel][value] = static_cast<float>(color);
+					decoder.channels[3][value] = static_cast<float>(unorm);
+				}
+				return decoder;
+			}
+
+			const Decoder& GetDecoder(MipContent content)
+			{
+				static const Decoder decoders[]{ CreateDecoder(MipContent::Color), CreateDecoder(MipContent::Linear), CreateDecoder(MipContent::Normal) };
+				return decoders[static_cast<uint32_t>(content)];
+			}
+
+			void Encode(const float* pTexel, MipContent content, uint8_t* pDestination)
+			{
+				switch (content)
+				{
+				case MipContent::Color:
+					for (uint32_t channel = 0; channel < 3; ++channel)
+						pDestination[channel] = EncodeSrgb(pTexel[channel]);
+					break;
+				case MipContent::Linear:
+					for (uint32_t channel = 0; channel < 3; ++channel)
+						pDestination[channel] = EncodeUnorm(pTexel[channel]);
+					break;
+				case MipContent::Normal:
+				{
+					//Averaged normals get shorter where they disagree, a normal that cancelled out points straight out of the surface
+					const float sqrLength{ pTexel[0] * pTexel[0] + pTexel[1] * pTexel[1] + pTexel[2] * pTexel[2] };
+					float normal[3]{ 0.f, 0.f, 1.f };
+					if (sqrLength > FLT_MIN)
+					{
+						const float invLength{ 1.f / sqrtf(sqrLength) };
+						for (uint32_t channel = 0; channel < 3; ++channel)
+							normal[channel] = pTexel[channel] * invLength;
+					}
+					for (uint32_t channel = 0; channel < 3; ++channel)
+						pDestination[channel] = EncodeUnorm(normal[channel] * 0.5f + 0.5f);
+					break;
+				}
+				}
+				pDestination[3] = EncodeUnorm(pTexel[3]);
+			}
+
+			//pOut[x] is the weighted sum of the taps pIn[x * inStep + tap * tapStride], for count texels of 4 floats. Steps count floats.
+			//Both paths add the taps in the same order without fused multiply-adds, they give the same result.
+			void FilterTexels(const float* pIn, size_t inStep, size_t tapStride, const Kernel& kernel, uint32_t count, float* pOut)
+			{
+#ifdef DAE_MIP_SSE2
+				__m128 weights[MaxTaps];
+				for (uint32_t tap = 0; tap < kernel.numTaps; ++tap)
+					weights[tap] = _mm_set1_ps(kernel.weights[tap]);
+
+				for (uint32_t x = 0; x < count; ++x)
+				{
+					const float* pTaps = pIn + x * inStep;
+					__m128 sum{ _mm_mul_ps(_mm_loadu_ps(pTaps), weights[0]) };
+					for (uint32_t tap = 1; tap < kernel.numTaps; ++tap)
+						sum = _mm_add_ps(sum, _mm_mul_ps(_mm_loadu_ps(pTaps + tap * tapStride), weights[tap]));
+					_mm_storeu_ps(pOut + x * 4, sum);
+				}
+#else
+				for (uint32_t x = 0; x < count; ++x)
+				{
+					const float* pTaps = pIn + x * inStep;
+					for (uint32_t channel = 0; channel < 4; ++channel)
+					{
+						float sum{ pTaps[channel] * kernel.weights[0] };
+						for (uint32_t tap = 1; tap < kernel.numTaps; ++tap)
+							sum += pTaps[tap * tapStride + channel] * kernel.weights[tap];
+						pOut[x * 4 + channel] = sum;
+					}
+				}
+#endif
+			}
+
+			uint32_t Wrap(int coordinate, uint32_t extent)
+			{
+				const int remainder{ coordinate % int(extent) };
+				return static_cast<uint32_t>(remainder < 0 ? remainder + int(extent) : remainder);
+			}
+
+			//Filters every tile of mip from source, horizontally into the source rows the tile covers and then vertically
+			void Downsample(const Image& source, MipContent content, const Kernel& kernel, size_t numThreads, Image& mip)
+			{
+				const Decoder& decoder = GetDecoder(content);
+				const uint32_t numTilesX{ (mip.width + TileWidth - 1) / TileWidth };
+				const uint32_t numTilesY{ (mip.height + TileHeight - 1) / TileHeight };
+				Utils::ParallelFor(size_t(numTilesX) * numTilesY, numThreads, [&](size_t begin, size_t end)
+					{
+						//4 floats a texel
+						std::vector<float> sourceRow(size_t(TileWidth * 2 + MaxTaps) * 4);
+						std::vector<float> filteredRows(size_t(TileHeight * 2 + MaxTaps) * TileWidth * 4);
+						std::vector<float> destinationRow(size_t(TileWidth) * 4);
+						for (size_t tile = begin; tile < end; ++tile)
+						{
+							const uint32_t firstX{ static_cast<uint32_t>(tile % numTilesX) * TileWidth };
+							const uint32_t firstY{ static_cast<uint32_t>(tile / numTilesX) * TileHeight };
+							const uint32_t tileWidth{ std::min(TileWidth, mip.width - firstX) };
+							const uint32_t tileHeight{ std::min(TileHeight, mip.height - firstY) };
+
+							//Taps past the edges wrap around, the way the effects' samplers address textures
+							const int firstColumn{ int(firstX) * 2 + kernel.firstOffset };
+							const int firstRow{ int(firstY) * 2 + kernel.firstOffset };
+							const uint32_t numColumns{ (tileWidth - 1) * 2 + kernel.numTaps };
+							const uint32_t numRows{ (tileHeight - 1) * 2 + kernel.numTaps };
+							for (uint32_t row = 0; row < numRows; ++row)
+							{
+								const uint32_t sourceY{ Wrap(firstRow + int(row), source.height) };
+								const uint8_t* pSourceRow = source.pixels.data() + size_t(sourceY) * source.width * 4;
+								for (uint32_t column = 0; column < numColumns; ++column)
+								{
+									const uint32_t sourceX{ Wrap(firstColumn + int(column), source.width) };
+									const uint8_t* pTexel = pSourceRow + size_t(sourceX) * 4;
+									for (uint32_t channel = 0; channel < 4; ++channel)
+										sourceRow[column * 4 + channel] = decoder.channels[channel][pTexel[channel]];
+								}
+								FilterTexels(sourceRow.data(), 8, 4, kernel, tileWidth, filteredRows.data() + size_t(row) * TileWidth * 4);
+							}
+
+							for (uint32_t y = 0; y < tileHeight; ++y)
+							{
+								FilterTexels(filteredRows.data() + size_t(y) * 2 * TileWidth * 4, 4, size_t(TileWidth) * 4, kernel, tileWidth, destinationRow.data());
+								uint8_t* pDestination = mip.pixels.data() + (size_t(firstY + y) * mip.width + firstX) * 4;
+								for (uint32_t x = 0; x < tileWidth; ++x)
+									Encode(destinationRow.data() + x * 4, content, pDestination + x * 4);
+							}
+						}
+					});
+			}
+		}
+
+		uint32_t GetMipCount(uint32_t width, uint32_t height)
+		{
+			uint32_t numMips{ 1 };
+			while (width > 1 || height > 1)
+			{
+				width = std::max(width / 2, 1u);
+				height = std::max(height / 2, 1u);
+				++numMips;
+			}
+			return numMips;
+		}
+
+		MipContent GetContentFromName(const std::string& path)
+		{
+			std::string stem{ std::filesystem::path{ path }.stem().string() };
+			std::transform(stem.begin(), stem.end(), stem.begin(), [](char c) { return static_cast<char>(std::tolower(static_cast<unsigned char>(c))); });
+			if (stem.ends_with("_normal"))
+				return MipContent::Normal;
+			if (stem.ends_with("_specular") || stem.ends_with("_gloss"))
+				return MipContent::Linear;
+			return MipContent::Color;
+		}
+
+		std::vector<Image> Generate(const Image& image, MipContent content, MipFilter filter, size_t numThreads)
+		{
+			std::vector<Image> mips{};
+			if (image.IsEmpty())
+				return mips;
+
+			const Kernel& kernel = GetKernel(filter);
+			const uint32_t numMips{ GetMipCount(image.width, image.height) };
+			mips.reserve(numMips);
+			mips.push_back(image);
+			for (uint32_t level = 1; level < numMips; ++level)
+			{
+				const Image& source = mips.back();
+				Image mip{};
+				mip.width = std::max(source.width / 2, 1u);
+				mip.height = std::max(source.height / 2, 1u);
+				mip.pixels.resize(size_t(mip.width) * mip.height * 4);
+				Downsample(source, content, kernel, numThreads, mip);
+				mips.push_back(std::move(mip));
+			}
+
+			return mips;
+		}
+	}
+}
@@ -0,0 +1,41 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "Image.h"
+
+namespace dae
+{
+	//What the texels of an image hold, decides the space mips get filtered in
+	enum class MipContent : uint32_t
+	{
+		//sRGB encoded colors, like diffuse maps: filtered in linear space
+		Color,
+		//Values used as they are stored, like specular and gloss maps
+		Linear,
+		//Tangent space normals mapped to [0, 1]: filtered as vectors and scaled back to unit length
+		Normal
+	};
+
+	enum class MipFilter : uint32_t
+	{
+		//Average of the 2x2 texels above, cheap and blurry
+		Box,
+		//8x8 taps of a Kaiser windowed sinc, keeps more detail without aliasing
+		Kaiser
+	};
+
+	//Mip chains of images: every level is half the size of the one above it, rounded down, until 1x1
+	namespace MipGenerator
+	{
+		uint32_t GetMipCount(uint32_t width, uint32_t height);
+
+		//Content by file name: *_normal for normal maps, *_specular and *_gloss as stored, anything else is color
+		MipContent GetContentFromName(const std::string& path);
+
+		//Level 0 is a copy of the image, every other level is filtered from the one above it. A level of odd size drops its last row or column,
+		//taps past the edges wrap around to the opposite edge. Alpha is always filtered as it is stored.
+		//Levels are split in tiles over numThreads threads, the result doesn't depend on numThreads.
+		std::vector<Image> Generate(const Image& image, MipContent content, MipFilter filter, size_t numThreads = 1);
+	}
+}
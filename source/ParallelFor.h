@@ -0,0 +1,45 @@
+#pragma once
+#include <algorithm>
+#include <thread>
+#include <vector>
+
+namespace dae
+{
+	namespace Utils
+	{
+		inline size_t GetWorkerCount()
+		{
+			const unsigned int hardwareThreads = std::thread::hardware_concurrency();
+			return hardwareThreads > 0 ? hardwareThreads : 1;
+		}
+
+		//Splits [0, count) into numThreads contiguous ranges and calls job(begin, end) for each range on its own thread.
+		//The ranges only depend on count and numThreads, the calling thread takes the first one.
+		template<typename Job>
+		void ParallelFor(size_t count, size_t numThreads, const Job& job)
+		{
+			numThreads = std::min(numThreads, count);
+			if (numThreads <= 1)
+			{
+				if (count > 0)
+					job(size_t{ 0 }, count);
+				return;
+			}
+
+			std::vector<std::thread> workers{};
+			workers.reserve(numThreads - 1);
+			for (size_t threadIdx = 1; threadIdx < numThreads; ++threadIdx)
+			{
+				workers.emplace_back([&job, count, numThreads, threadIdx]()
+					{
+						job(count * threadIdx / numThreads, count * (threadIdx + 1) / numThreads);
+					});
+			}
+
+			job(size_t{ 0 }, count / numThreads);
+
+			for (std::thread& worker : workers)
+				worker.join();
+		}
+	}
+}
@@ -0,0 +1,617 @@
+#include "pch.h"
+#include "PngDecoder.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <utility>
+#include "MappedFile.h"
+
+namespace dae
+{
+	namespace PngDecoder
+	{
+		namespace
+		{
+			//Inflate (RFC 1951)
+
+			constexpr uint32_t MaxCodeLength{ 15 };
+			//Codes up to this long are decoded with one table lookup, longer ones bit by bit
+			constexpr uint32_t FastBits{ 10 };
+
+			constexpr uint16_t LengthBases[29]{ 3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31, 35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258 };
+			constexpr uint8_t LengthExtraBits[29]{ 0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0 };
+			constexpr uint16_t DistanceBases[30]{ 1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193, 257, 385, 513, 769, 1025, 1537, 2049, 3073,
+				4097, 6145, 8193, 12289, 16385, 24577 };
+			constexpr uint8_t DistanceExtraBits[30]{ 0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6, 7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13 };
+			constexpr uint8_t CodeLengthOrder[19]{ 16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15 };
+
+			//Least significant bit first, reads past the end as zeros and remembers it did
+			class BitReader final
+			{
+			public:
+				BitReader(const uint8_t* pData, size_t size)
+					: m_pData{ pData }
+					, m_Size{ size }
+				{
+				}
+
+				uint32_t Peek(uint32_t numBits)
+				{
+					while (m_NumBits < numBits)
+					{
+						const uint64_t byte{ m_Position < m_Size ? m_pData[m_Position] : 0u };
+						m_Buffer |= byte << m_NumBits;
+						m_NumBits += 8;
+						++m_Position;
+					}
+					return static_cast<uint32_t>(m_Buffer & ((uint64_t{ 1 } << numBits) - 1));
+				}
+
+				void Skip(uint32_t numBits)
+				{
+					m_Buffer >>= numBits;
+					m_NumBits -= numBits;
+				}
+
+				uint32_t Read(uint32_t numBits)
+				{
+					const uint32_t bits{ Peek(numBits) };
+					Skip(numBits);
+					return bits;
+				}
+
+				void AlignToByte()
+				{
+					Skip(m_NumBits % 8);
+				}
+
+				//Bytes of the stream consumed so far
+				size_t GetPosition() const { return m_Position - m_NumBits / 8; }
+				bool IsOverrun() const { return GetPosition() > m_Size; }
+
+			private:
+				const uint8_t* m_pData;
+				size_t m_Size;
+				size_t m_Position{};
+				uint64_t m_Buffer{};
+				uint32_t m_NumBits{};
+			};
+
+			//Fixed size destination of the whole stream, the size is known up front for images
+			struct Output
+			{
+				uint8_t* pData;
+				size_t size;
+				size_t position;
+			};
+
+			//Canonical Huffman code
+			struct Huffman
+			{
+				uint16_t counts[MaxCodeLength + 1]{};
+				//Symbols sorted by code
+				uint16_t symbols[288]{};
+				//symbol << 4 | length of every code up to FastBits long, indexed by its bits in stream order. Zero for longer codes.
+				uint16_t fast[1u << FastBits]{};
+			};
+
+			bool BuildHuffman(const uint8_t* pLengths, uint32_t numSymbols, Huffman& huffman)
+			{
+				huffman = Huffman{};
+				for (uint32_t symbol = 0; symbol < numSymbols; ++symbol)
+					++huffman.counts[pLengths[symbol]];
+				huffman.counts[0] = 0;
+
+				//Over-subscribed length sets can't be decoded, incomplete ones only fail when a missing code shows up
+				int32_t left{ 1 };
+				uint16_t offsets[MaxCodeLength + 2]{};
+				for (uint32_t length = 1; length <= MaxCodeLength; ++length)
+				{
+					left = left * 2 - huffman.counts[length];
+					if (left < 0)
+						return false;
+					offsets[length + 1] = offsets[length] + huffman.counts[length];
+				}
+
+				for (uint32_t symbol = 0; symbol < numSymbols; ++symbol)
+				{
+					if (pLengths[symbol] != 0)
+						huffman.symbols[offsets[pLengths[symbol]]++] = static_cast<uint16_t>(symbol);
+				}
+
+				//Codes count up within a length and double when the length grows, the stream stores them most significant bit first
+				uint32_t code{};
+				uint32_t index{};
+				for (uint32_t length = 1; length <= FastBits; ++length)
+				{
+					for (uint32_t i = 0; i < huffman.counts[length]; ++i, ++code, ++index)
+					{
+						uint32_t reversed{};
+						for (uint32_t bit = 0; bit < length; ++bit)
+							reversed |= ((code >> bit) & 1u) << (length - 1 - bit);
+						for (uint32_t entry = reversed; entry < (1u << FastBits); entry += 1u << length)
+							huffman.fast[entry] = static_cast<uint16_t>(huffman.symbols[index] << 4 | length);
+					}
+					code <<= 1;
+				}
+
+				return true;
+			}
+
+			//-1 for a code that isn't in the table
+			int32_t DecodeSymbol(BitReader& reader, const Huffman& huffman)
+			{
+				const uint16_t entry{ huffman.fast[reader.Peek(FastBits)] };
+				if (entry != 0)
+				{
+					reader.Skip(entry & 0xF);
+					return entry >> 4;
+				}
+
+				int32_t code{};
+				int32_t first{};
+				int32_t index{};
+				for (uint32_t length = 1; length <= MaxCodeLength; ++length)
+				{
+					code |= static_cast<int32_t>(reader.Read(1));
+					const int32_t count{ huffman.counts[length] };
+					if (code - count < first)
+						return huffman.symbols[index + code - first];
+
+					index += count;
+					first = (first + count) << 1;
+					code <<= 1;
+				}
+				return -1;
+			}
+
+			bool InflateBlock(BitReader& reader, const Huffman& lengthCodes, const Huffman& distanceCodes, Output& output)
+			{
+				while (true)
+				{
+					const int32_t symbol{ DecodeSymbol(reader, lengthCodes) };
+					if (symbol < 0 || reader.IsOverrun())
+						return false;
+
+					if (symbol < 256)
+					{
+						if (output.position == output.size)
+							return false;
+						output.pData[output.position++] = static_cast<uint8_t>(symbol);
+						continue;
+					}
+					if (symbol == 256)
+						return true;
+
+					const uint32_t lengthIdx{ static_cast<uint32_t>(symbol) - 257 };
+					if (lengthIdx >= 29)
+						return false;
+					const uint32_t length{ LengthBases[lengthIdx] + reader.Read(LengthExtraBits[lengthIdx]) };
+
+					const int32_t distanceIdx{ DecodeSymbol(reader, distanceCodes) };
+					if (distanceIdx < 0 || distanceIdx >= 30)
+						return false;
+					const size_t distance{ DistanceBases[distanceIdx] + reader.Read(DistanceExtraBits[distanceIdx]) };
+					if (distance > output.position || length > output.size - output.position)
+						return false;
+
+					//Byte by byte, the source may overlap what gets written
+					const uint8_t* pSource = output.pData + output.position - distance;
+					uint8_t* pDestination = output.pData + output.position;
+					for (size_t i = 0; i < length; ++i)
+						pDestination[i] = pSource[i];
+					output.position += length;
+				}
+			}
+
+			bool Inflate(const uint8_t* pData, size_t size, Output& output)
+			{
+				BitReader reader{ pData, size };
+				bool isLastBlock{ false };
+				while (!isLastBlock)
+				{
+					isLastBlock = reader.Read(1) != 0;
+					const uint32_t type{ reader.Read(2) };
+					if (type == 0)
+					{
+						reader.AlignToByte();
+						const uint32_t length{ reader.Read(16) };
+						const uint32_t inverseLength{ reader.Read(16) };
+						if ((length ^ 0xFFFFu) != inverseLength)
+							return false;
+
+						if (length > output.size - output.position)
+							return false;
+						for (uint32_t i = 0; i < length; ++i)
+							output.pData[output.position++] = static_cast<uint8_t>(reader.Read(8));
+					}
+					else if (type == 1)
+					{
+						static const std::pair<Huffman, Huffman> fixedCodes = []()
+							{
+								std::pair<Huffman, Huffman> codes{};
+								uint8_t lengths[288]{};
+								std::fill(lengths, lengths + 144, uint8_t{ 8 });
+								std::fill(lengths + 144, lengths + 256, uint8_t{ 9 });
+								std::fill(lengths + 256, lengths + 280, uint8_t{ 7 });
+								std::fill(lengths + 280, lengths + 288, uint8_t{ 8 });
+								BuildHuffman(lengths, 288, codes.first);
+								std::fill(lengths, lengths + 30, uint8_t{ 5 });
+								BuildHuffman(lengths, 30, codes.second);
+								return codes;
+							}();
+						if (!InflateBlock(reader, fixedCodes.first, fixedCodes.second, output))
+							return false;
+					}
+					else if (type == 2)
+					{
+						const uint32_t numLengthCodes{ reader.Read(5) + 257 };
+						const uint32_t numDistanceCodes{ reader.Read(5) + 1 };
+						const uint32_t numCodeLengthCodes{ reader.Read(4) + 4 };
+						if (numLengthCodes > 286 || numDistanceCodes > 30)
+							return false;
+
+						uint8_t codeLengthLengths[19]{};
+						for (uint32_t i = 0; i < numCodeLengthCodes; ++i)
+							codeLengthLengths[CodeLengthOrder[i]] = static_cast<uint8_t>(reader.Read(3));
+
+						Huffman codeLengthCodes{};
+						if (!BuildHuffman(codeLengthLengths, 19, codeLengthCodes))
+							return false;
+
+						//Literal/length and distance code lengths form one sequence, repeats may cross from one into the other
+						uint8_t lengths[286 + 30]{};
+						uint32_t numLengths{};
+						while (numLengths < numLengthCodes + numDistanceCodes)
+						{
+							const int32_t symbol{ DecodeSymbol(reader, codeLengthCodes) };
+							if (symbol < 0 || reader.IsOverrun())
+								return false;
+
+							if (symbol < 16)
+							{
+								lengths[numLengths++] = static_cast<uint8_t>(symbol);
+								continue;
+							}
+
+							uint8_t repeated{};
+							uint32_t repeatCount{};
+							if (symbol == 16)
+							{
+								if (numLengths == 0)
+									return false;
+								repeated = lengths[numLengths - 1];
+								repeatCount = 3 + reader.Read(2);
+							}
+							else if (symbol == 17)
+							{
+								repeatCount = 3 + reader.Read(3);
+							}
+							else
+							{
+								repeatCount = 11 + reader.Read(7);
+							}
+
+							if (numLengths + repeatCount > numLengthCodes + numDistanceCodes)
+								return false;
+							std::fill(lengths + numLengths, lengths + numLengths + repeatCount, repeated);
+							numLengths += repeatCount;
+						}
+
+						//Without an end of block code the block can't end
+						if (lengths[256] == 0)
+							return false;
+
+						Huffman lengthCodes{};
+						Huffman distanceCodes{};
+						if (!BuildHuffman(lengths, numLengthCodes, lengthCodes) || !BuildHuffman(lengths + numLengthCodes, numDistanceCodes, distanceCodes) ||
+							!InflateBlock(reader, lengthCodes, distanceCodes, output))
+							return false;
+					}
+					else
+					{
+						return false;
+					}
+
+					if (reader.IsOverrun())
+						return false;
+				}
+
+				return true;
+			}
+
+			//Zlib stream (RFC 1950): two header bytes, deflate data and the Adler-32 of the result.
+			//Only succeeds when the stream fills output exactly.
+			bool Uncompress(const uint8_t* pData, size_t size, std::vector<uint8_t>& output)
+			{
+				if (size < 6)
+					return false;
+
+				const uint32_t method{ pData[0] };
+				const uint32_t flags{ pData[1] };
+				if ((method & 0xF) != 8 || (method >> 4) > 7 || (method << 8 | flags) % 31 != 0 || (flags & 0x20) != 0)
+					return false;
+
+				Output destination{ output.data(), output.size(), 0 };
+				if (!Inflate(pData + 2, size - 6, destination) || destination.position != output.size())
+					return false;
+
+				uint32_t a{ 1 };
+				uint32_t b{};
+				size_t position{};
+				while (position < output.size())
+				{
+					//5552 bytes is the most that can be summed before b overflows
+					const size_t end{ std::min(position + 5552, output.size()) };
+					for (; position < end; ++position)
+					{
+						a += output[position];
+						b += a;
+					}
+					a %= 65521;
+					b %= 65521;
+				}
+
+				const uint8_t* pChecksum = pData + size - 4;
+				const uint32_t checksum{ uint32_t(pChecksum[0]) << 24 | uint32_t(pChecksum[1]) << 16 | uint32_t(pChecksum[2]) << 8 | pChecksum[3] };
+				return checksum == (b << 16 | a);
+			}
+
+			//PNG
+
+			enum ColorType : uint8_t
+			{
+				Gray = 0,
+				Rgb = 2,
+				Palette = 3,
+				GrayAlpha = 4,
+				RgbAlpha = 6
+			};
+
+			uint32_t ReadBigEndian(const uint8_t* pData)
+			{
+				return uint32_t(pData[0]) << 24 | uint32_t(pData[1]) << 16 | uint32_t(pData[2]) << 8 | pData[3];
+			}
+
+			uint8_t Paeth(uint8_t left, uint8_t up, uint8_t upLeft)
+			{
+				const int32_t estimate{ int32_t(left) + up - upLeft };
+				const int32_t leftDistance{ std::abs(estimate - left) };
+				const int32_t upDistance{ std::abs(estimate - up) };
+				const int32_t upLeftDistance{ std::abs(estimate - upLeft) };
+				if (leftDistance <= upDistance && leftDistance <= upLeftDistance)
+					return left;
+				return upDistance <= upLeftDistance ? up : upLeft;
+			}
+
+			//Undoes the filter of every row in place, rows are stored with their filter type byte in front
+			bool Unfilter(uint8_t* pData, uint32_t numRows, size_t rowSize, size_t pixelSize)
+			{
+				const uint8_t* pPreviousRow{ nullptr };
+				for (uint32_t row = 0; row < numRows; ++row)
+				{
+					const uint8_t filter{ pData[row * (rowSize + 1)] };
+					uint8_t* pRow = pData + row * (rowSize + 1) + 1;
+					switch (filter)
+					{
+					case 0:
+						break;
+					case 1:
+						for (size_t i = pixelSize; i < rowSize; ++i)
+							pRow[i] = static_cast<uint8_t>(pRow[i] + pRow[i - pixelSize]);
+						break;
+					case 2:
+						if (pPreviousRow)
+						{
+							for (size_t i = 0; i < rowSize; ++i)
+								pRow[i] = static_cast<uint8_t>(pRow[i] + pPreviousRow[i]);
+						}
+						break;
+					case 3:
+						for (size_t i = 0; i < rowSize; ++i)
+						{
+							const uint32_t left{ i >= pixelSize ? pRow[i - pixelSize] : 0u };
+							const uint32_t up{ pPreviousRow ? pPreviousRow[i] : 0u };
+							pRow[i] = static_cast<uint8_t>(pRow[i] + ((left + up) >> 1));
+						}
+						break;
+					case 4:
+						for (size_t i = 0; i < rowSize; ++i)
+						{
+							const uint8_t left{ i >= pixelSize ? pRow[i - pixelSize] : uint8_t{} };
+							const uint8_t up{ pPreviousRow ? pPreviousRow[i] : uint8_t{} };
+							const uint8_t upLeft{ pPreviousRow && i >= pixelSize ? pPreviousRow[i - pixelSize] : uint8_t{} };
+							pRow[i] = static_cast<uint8_t>(pRow[i] + Paeth(left, up, upLeft));
+						}
+						break;
+					default:
+						return false;
+					}
+					pPreviousRow = pRow;
+				}
+				return true;
+			}
+		}
+
+		bool Decode(const uint8_t* pData, size_t size, Image& image)
+		{
+			image = Image{};
+			constexpr uint8_t signature[8]{ 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' };
+			if (size < sizeof(signature) || std::memcmp(pData, signature, sizeof(signature)) != 0)
+				return false;
+
+			uint32_t width{};
+			uint32_t height{};
+			uint8_t bitDepth{};
+			uint8_t colorType{};
+			bool hasHeader{ false };
+			bool hasEnd{ false };
+			std::vector<uint8_t> compressed{};
+			uint8_t palette[256][4]{};
+			uint32_t paletteSize{};
+			//Gray or RGB sample values that are transparent, at the image's bit depth
+			bool hasColorKey{ false };
+			uint16_t colorKey[3]{};
+
+			size_t position{ sizeof(signature) };
+			while (!hasEnd && position + 12 <= size)
+			{
+				const uint32_t length{ ReadBigEndian(pData + position) };
+				const uint8_t* pType = pData + position + 4;
+				const uint8_t* pChunk = pData + position + 8;
+				if (length > size - position - 12)
+					return false;
+				position += size_t(length) + 12;
+
+				if (std::memcmp(pType, "IHDR", 4) == 0)
+				{
+					if (length != 13)
+						return false;
+					width = ReadBigEndian(pChunk);
+					height = ReadBigEndian(pChunk + 4);
+					bitDepth = pChunk[8];
+					colorType = pChunk[9];
+					//Compression and filter method 0, no interlacing
+					if (pChunk[10] != 0 || pChunk[11] != 0 || pChunk[12] != 0)
+						return false;
+					hasHeader = true;
+				}
+				else if (std::memcmp(pType, "PLTE", 4) == 0)
+				{
+					if (length % 3 != 0 || length / 3 > 256)
+						return false;
+					paletteSize = length / 3;
+					for (uint32_t i = 0; i < paletteSize; ++i)
+					{
+						palette[i][0] = pChunk[i * 3];
+						palette[i][1] = pChunk[i * 3 + 1];
+						palette[i][2] = pChunk[i * 3 + 2];
+						palette[i][3] = 255;
+					}
+				}
+				else if (std::memcmp(pType, "tRNS", 4) == 0)
+				{
+					if (colorType == Palette)
+					{
+						for (uint32_t i = 0; i < std::min(length, 256u); ++i)
+							palette[i][3] = pChunk[i];
+					}
+					else if ((colorType == Gray && length == 2) || (colorType == Rgb && length == 6))
+					{
+						hasColorKey = true;
+						for (uint32_t i = 0; i < length / 2; ++i)
+							colorKey[i] = static_cast<uint16_t>(pChunk[i * 2] << 8 | pChunk[i * 2 + 1]);
+					}
+				}
+				else if (std::memcmp(pType, "IDAT", 4) == 0)
+				{
+					compressed.insert(compressed.end(), pChunk, pChunk + length);
+				}
+				else if (std::memcmp(pType, "IEND", 4) == 0)
+				{
+					hasEnd = true;
+				}
+			}
+
+			uint32_t numChannels{};
+			switch (colorType)
+			{
+			case Gray: numChannels = 1; break;
+			case Rgb: numChannels = 3; break;
+			case Palette: numChannels = 1; break;
+			case GrayAlpha: numChannels = 2; break;
+			case RgbAlpha: numChannels = 4; break;
+			default: return false;
+			}
+
+			const bool isValidDepth{ bitDepth == 8 || bitDepth == 16 || ((colorType == Gray || colorType == Palette) && (bitDepth == 1 || bitDepth == 2 || bitDepth == 4)) };
+			if (!hasHeader || width == 0 || height == 0 || !isValidDepth || (colorType == Palette && (bitDepth == 16 || paletteSize == 0)) ||
+				uint64_t(width) * height > (uint64_t{ 1 } << 30))
+				return false;
+
+			const size_t rowSize{ (size_t(width) * numChannels * bitDepth + 7) / 8 };
+			const size_t pixelSize{ std::max(size_t(numChannels) * bitDepth / 8, size_t{ 1 }) };
+			std::vector<uint8_t> filtered((rowSize + 1) * height);
+			if (!Uncompress(compressed.data(), compressed.size(), filtered) || !Unfilter(filtered.data(), height, rowSize, pixelSize))
+				return false;
+
+			image.width = width;
+			image.height = height;
+			image.pixels.resize(size_t(width) * height * 4);
+			const uint32_t maxSample{ (1u << bitDepth) - 1 };
+			for (uint32_t y = 0; y < height; ++y)
+			{
+				const uint8_t* pRow = filtered.data() + y * (rowSize + 1) + 1;
+				uint8_t* pPixel = image.pixels.data() + size_t(y) * width * 4;
+				if (colorType == RgbAlpha && bitDepth == 8)
+				{
+					std::memcpy(pPixel, pRow, rowSize);
+					continue;
+				}
+
+				for (uint32_t x = 0; x < width; ++x, pPixel += 4)
+				{
+					//Samples at the image's bit depth
+					uint16_t samples[4]{};
+					for (uint32_t channel = 0; channel < std::min(numChannels, 4u); ++channel)
+					{
+						const size_t sampleIdx{ size_t(x) * numChannels + channel };
+						if (bitDepth == 16)
+							samples[channel] = static_cast<uint16_t>(pRow[sampleIdx * 2] << 8 | pRow[sampleIdx * 2 + 1]);
+						else if (bitDepth == 8)
+							samples[channel] = pRow[sampleIdx];
+						else
+							samples[channel] = static_cast<uint16_t>((pRow[sampleIdx * bitDepth / 8] >> (8 - bitDepth - sampleIdx * bitDepth % 8)) & maxSample);
+					}
+
+					if (colorType == Palette)
+					{
+						if (samples[0] >= paletteSize)
+							return false;
+						std::memcpy(pPixel, palette[samples[0]], 4);
+						continue;
+					}
+
+					//Scaled to 8 bits: the high byte of 16 bit samples, low depths stretched to the full range
+					uint8_t values[4]{};
+					for (uint32_t channel = 0; channel < std::min(numChannels, 4u); ++channel)
+						values[channel] = static_cast<uint8_t>(bitDepth == 16 ? samples[channel] >> 8 : samples[channel] * 255u / maxSample);
+
+					const bool isColorKey{ hasColorKey && samples[0] == colorKey[0] && (colorType == Gray || (samples[1] == colorKey[1] && samples[2] == colorKey[2])) };
+					switch (colorType)
+					{
+					case Gray:
+						pPixel[0] = pPixel[1] = pPixel[2] = values[0];
+						pPixel[3] = isColorKey ? 0 : 255;
+						break;
+					case GrayAlpha:
+						pPixel[0] = pPixel[1] = pPixel[2] = values[0];
+						pPixel[3] = values[1];
+						break;
+					case Rgb:
+						std::memcpy(pPixel, values, 3);
+						pPixel[3] = isColorKey ? 0 : 255;
+						break;
+					default:
+						std::memcpy(pPixel, values, 4);
+						break;
+					}
+				}
+			}
+
+			return true;
+		}
+
+		bool DecodeFile(const std::string& path, Image& image)
+		{
+			const MappedFile file{ path };
+			if (!file.IsOpen())
+			{
+				image = Image{};
+				return false;
+			}
+			return Decode(reinterpret_cast<const uint8_t*>(file.GetData()), file.GetSize(), image);
+		}
+	}
+}
@@ -0,0 +1,17 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include "Image.h"
+
+namespace dae
+{
+	//PNG reader without SDL_image, so tools can load textures wherever they build.
+	//Reads every color type and bit depth of non-interlaced images into 8 bit RGBA, 16 bit channels keep their high byte.
+	namespace PngDecoder
+	{
+		//False for anything that isn't a PNG it can read, image is left empty then
+		bool Decode(const uint8_t* pData, size_t size, Image& image);
+		bool DecodeFile(const std::string& path, Image& image);
+	}
+}
@@ -4,6 +4,7 @@
 #include "Mesh.h"
 #include "Utils.h"
 #include "ShadingEffect.h"
+#include "Benchmarks.h"
 
 namespace dae {
 
@@ -59,12 +60,16 @@ namespace dae {
 		//---------------------
 		// VEHICLE
 		//---------------------
+		//Textures start out with their coarse mips only, the rest streams in once the meshes are on screen
+		m_pTextureStreamingDevice = new TextureStreamingDevice{ m_pDevice, m_pDeviceContext };
+		m_pTextureStreamer = new TextureStreamer{ *m_pTextureStreamingDevice, TextureBudget, MaxTextureUploadSize };
+
 		m_pShadingEffect = new ShadingEffect{ m_pDevice, L"Resources/PosCol3D.fx" };
 
-		m_pDiffuseTexture = Texture::LoadFromFile("Resources/vehicle_diffuse.png", m_pDevice);
-		m_pNormalTexture = Texture::LoadFromFile("Resources/vehicle_normal.png", m_pDevice);
-		m_pSpecularTexture = Texture::LoadFromFile("Resources/vehicle_specular.png", m_pDevice);
-		m_pGlossinessTexture = Texture::LoadFromFile("Resources/vehicle_gloss.png", m_pDevice);
+		m_pDiffuseTexture = Texture::LoadFromFile("Resources/vehicle_diffuse.png", m_pDevice, MipContent::Color, true);
+		m_pNormalTexture = Texture::LoadFromFile("Resources/vehicle_normal.png", m_pDevice, MipContent::Normal, true);
+		m_pSpecularTexture = Texture::LoadFromFile("Resources/vehicle_specular.png", m_pDevice, MipContent::Linear, true);
+		m_pGlossinessTexture = Texture::LoadFromFile("Resources/vehicle_gloss.png", m_pDevice, MipContent::Linear, true);
 
 		m_pShadingEffect->SetDiffuseMap(m_pDiffuseTexture);
 		m_pShadingEffect->SetNormalMap(m_pNormalTexture);
@@ -72,14 +77,24 @@ namespace dae {
 		m_pShadingEffect->SetGlossinessMap(m_pGlossinessTexture);
 
 		m_pMeshes.push_back(new Mesh{ m_pDevice, "Resources/vehicle.obj", m_pShadingEffect });
+		AddStreamedTexture(m_pDiffuseTexture, m_pMeshes.back());
+		AddStreamedTexture(m_pNormalTexture, m_pMeshes.back());
+		AddStreamedTexture(m_pSpecularTexture, m_pMeshes.back());
+		AddStreamedTexture(m_pGlossinessTexture, m_pMeshes.back());
+
+#if defined(DAE_BENCHMARK)
+		Benchmarks::Run("Resources/vehicle.obj", Utils::GetWorkerCount());
+#endif
 
 
 		m_pEffect = new Effect{ m_pDevice, L"Resources/PartialCoverage3D.fx" };
 
-		m_pFireDiffuse = Texture::LoadFromFile("Resources/fireFX_diffuse.png", m_pDevice);
+		m_pFireDiffuse = Texture::LoadFromFile("Resources/fireFX_diffuse.png", m_pDevice, MipContent::Color, true);
 		m_pEffect->SetDiffuseMap(m_pFireDiffuse);
 		
 		m_pMeshes.push_back(new Mesh{ m_pDevice, "Resources/fireFX.obj", m_pEffect });
+		m_pFireMesh = m_pMeshes.back();
+		AddStreamedTexture(m_pFireDiffuse, m_pFireMesh);
 	}
 
 	Renderer::~Renderer()
@@ -99,6 +114,9 @@ namespace dae {
 
 		if(m_pDevice) m_pDevice->Release();
 
+		delete m_pTextureStreamer;
+		delete m_pTextureStreamingDevice;
+
 		for (auto& pMesh : m_pMeshes)
 		{
 			delete pMesh;
@@ -131,7 +149,84 @@ namespace dae {
 		for (auto& pMesh : m_pMeshes)
 		{
 			pMesh->Update(m_Camera.projectionMatrix, m_Camera.GetViewMatrix());
+			pMesh->SelectLod(m_Camera, static_cast<float>(m_Height));
+			pMesh->CullMeshlets(m_Camera);
 		}
+
+		RequestTextures();
+		if (m_IsPicking)
+			PickUnderCursor();
+	}
+
+	bool Renderer::IsDrawn(const Mesh* pMesh) const
+	{
+		return pMesh != m_pFireMesh || m_DrawFireFX;
+	}
+
+	void Renderer::AddStreamedTexture(Texture* pTexture, const Mesh* pMesh)
+	{
+		if (!pTexture || !pTexture->IsStreamed())
+			return;
+
+		m_pTextureStreamingDevice->AddTexture(pTexture);
+		m_pTextureStreamer->AddTexture(pTexture->GetFormat(), pTexture->GetWidth(), pTexture->GetHeight(), pTexture->GetMipCount());
+		m_StreamedTextures.push_back(StreamedTexture{ pTexture, pMesh });
+	}
+
+	void Renderer::RequestTextures()
+	{
+		//Texels of mip 0 per pixel where the mesh is closest, meshes that aren't drawn or culled entirely request nothing
+		for (uint32_t textureIdx = 0; textureIdx < m_StreamedTextures.size(); ++textureIdx)
+		{
+			const StreamedTexture& streamedTexture = m_StreamedTextures[textureIdx];
+			if (!IsDrawn(streamedTexture.pMesh))
+				continue;
+
+			const float pixelsPerUv{ streamedTexture.pMesh->GetPixelsPerUv(m_Camera, static_cast<float>(m_Height)) };
+			if (pixelsPerUv > 0.f)
+			{
+				const uint32_t size{ std::max(streamedTexture.pTexture->GetWidth(), streamedTexture.pTexture->GetHeight()) };
+				m_pTextureStreamer->Request(textureIdx, static_cast<float>(size) / pixelsPerUv);
+			}
+		}
+		m_pTextureStreamer->Update();
+	}
+
+	void Renderer::PickUnderCursor()
+	{
+		//Through the center of the cursor's pixel
+		const Vector3 direction{ m_Camera.GetRayDirection(m_Camera.cursorX + .5f, m_Camera.cursorY + .5f, static_cast<float>(m_Width), static_cast<float>(m_Height)) };
+
+		int hoveredMesh{ -1 };
+		MeshHit closestHit{};
+		closestHit.distance = m_Camera.farClippingPlane;
+		for (size_t meshIdx = 0; meshIdx < m_pMeshes.size(); ++meshIdx)
+		{
+			if (!IsDrawn(m_pMeshes[meshIdx]))
+				continue;
+
+			MeshHit hit{};
+			if (m_pMeshes[meshIdx]->Pick(m_Camera.origin, direction, closestHit.distance, hit))
+			{
+				closestHit = hit;
+				hoveredMesh = static_cast<int>(meshIdx);
+			}
+		}
+
+		if (hoveredMesh == m_HoveredMesh && (hoveredMesh < 0 || closestHit.submesh == m_HoveredSubmesh))
+			return;
+
+		m_HoveredMesh = hoveredMesh;
+		m_HoveredSubmesh = closestHit.submesh;
+		if (hoveredMesh < 0)
+		{
+			std::cout << "Picked nothing\n";
+			return;
+		}
+
+		std::cout << "Picked mesh " << hoveredMesh << ", submesh " << closestHit.submesh << " (" << m_pMeshes[hoveredMesh]->GetSubmeshMaterial(closestHit.submesh)
+			<< "), triangle " << closestHit.triangle << ", barycentrics (" << closestHit.barycentrics.x << ", " << closestHit.barycentrics.y
+			<< "), uv (" << closestHit.uv.x << ", " << closestHit.uv.y << "), distance " << closestHit.distance << '\n';
 	}
 
 
@@ -146,8 +241,11 @@ namespace dae {
 		m_pDeviceContext->ClearDepthStencilView(m_pDepthStencilView, D3D11_CLEAR_DEPTH | D3D11_CLEAR_STENCIL, 1.f, 0);
 
 		//2. SET PIPELINE + INVOKE DRAW CALLS (= RENDER)
-		m_pMeshes[0]->Render(m_pDeviceContext);
-		if (m_DrawFireFX) m_pMeshes[1]->Render(m_pDeviceContext);
+		for (Mesh* pMesh : m_pMeshes)
+		{
+			if (IsDrawn(pMesh))
+				pMesh->Render(m_pDeviceContext);
+		}
 
 
 		//3. PRESENT BACKBUFFER (SWAP)
@@ -318,4 +416,11 @@ namespace dae {
 	{
 		m_DrawFireFX = !m_DrawFireFX;
 	}
+
+	void Renderer::TogglePicking()
+	{
+		m_IsPicking = !m_IsPicking;
+		m_HoveredMesh = -1;
+		std::cout << "Picking: " << m_IsPicking << std::endl;
+	}
 }
@@ -5,6 +5,8 @@ struct SDL_Surface;
 
 #include "Camera.h"
 #include "Texture.h"
+#include "TextureStreamer.h"
+#include "TextureStreamingDevice.h"
 
 class Effect;
 class ShadingEffect;
@@ -38,6 +40,7 @@ namespace dae
 		void ToggleRotate();
 		void ToggleNormalMap();
 		void ToggleFireFX();
+		void TogglePicking();
 
 	private:
 		SDL_Window* m_pWindow{};
@@ -78,10 +81,34 @@ namespace dae
 
 		Effect* m_pEffect{ nullptr };
 		Texture* m_pFireDiffuse{ nullptr };
+		//Drawn, picked and streamed for only while m_DrawFireFX is set
+		const Mesh* m_pFireMesh{ nullptr };
+		bool IsDrawn(const Mesh* pMesh) const;
+
+		//Finer mips of the textures stream in as their meshes come closer, within a budget of TextureBudget bytes
+		static constexpr uint64_t TextureBudget{ 32ull << 20 };
+		static constexpr uint64_t MaxTextureUploadSize{ 4ull << 20 };
+		struct StreamedTexture
+		{
+			const Texture* pTexture;
+			//The mesh sampling it
+			const Mesh* pMesh;
+		};
+		TextureStreamingDevice* m_pTextureStreamingDevice{ nullptr };
+		TextureStreamer* m_pTextureStreamer{ nullptr };
+		std::vector<StreamedTexture> m_StreamedTextures{};
+		void AddStreamedTexture(Texture* pTexture, const Mesh* pMesh);
+		void RequestTextures();
+
+		//Mesh and submesh under the mouse cursor, reported when they change while m_IsPicking is set
+		int m_HoveredMesh{ -1 };
+		uint32_t m_HoveredSubmesh{};
+		void PickUnderCursor();
 
 		SamplerState m_SamplerState = SamplerState::Point;
 		bool m_Rotate{ false };
 		bool m_UseNormalMap{ true };
 		bool m_DrawFireFX{ true };
+		bool m_IsPicking{ false };
 	};
 }
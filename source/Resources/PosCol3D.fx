@@ -79,7 +79,17 @@ struct VS_INPUT
 	float3 Position : POSITION;
     float2 UV : TEXCOORD;
     float3 Normal : NORMAL;
-    float3 Tangent : TANGENT;
+    float4 Tangent : TANGENT;
+};
+
+//Compact layouts: quantized positions are expanded by gWorldViewProj, normal and tangent are octahedral,
+//the lowest bit of the tangent's second component holds its handedness
+struct VS_COMPACT_INPUT
+{
+	float3 Position : POSITION;
+    float2 UV : TEXCOORD;
+    float2 Normal : NORMAL;
+    float2 Tangent : TANGENT;
 };
 
 struct VS_OUTPUT
@@ -87,7 +97,7 @@ struct VS_OUTPUT
 	float4 Position : SV_POSITION;
     float2 UV : TEXCOORD;
     float3 Normal : NORMAL;
-    float3 Tangent : TANGENT;
+    float4 Tangent : TANGENT; //w: bitangent = w * cross(Normal, Tangent)
 };
 
 //------------------------------------------
@@ -99,7 +109,31 @@ VS_OUTPUT VS(VS_INPUT input)
 	output.Position = mul(float4(input.Position, 1.f), gWorldViewProj);
     output.UV = input.UV;
     output.Normal = mul(normalize(input.Normal), (float3x3) gWorldMatrix);
-    output.Tangent = mul(normalize(input.Tangent), (float3x3) gWorldMatrix);
+    output.Tangent = float4(mul(normalize(input.Tangent.xyz), (float3x3) gWorldMatrix), input.Tangent.w);
+	return output;
+}
+
+float3 DecodeOctahedral(float2 encoded)
+{
+    float3 normal = float3(encoded, 1.f - abs(encoded.x) - abs(encoded.y));
+    const float fold = saturate(-normal.z);
+    normal.xy += normal.xy >= 0.f ? -fold : fold;
+    return normalize(normal);
+}
+
+float DecodeHandedness(float encoded)
+{
+    const int component = (int) round(encoded * 32767.f);
+    return (component & 1) ? -1.f : 1.f;
+}
+
+VS_OUTPUT VS_Compact(VS_COMPACT_INPUT input)
+{
+	VS_OUTPUT output = (VS_OUTPUT)0;
+	output.Position = mul(float4(input.Position, 1.f), gWorldViewProj);
+    output.UV = input.UV;
+    output.Normal = mul(DecodeOctahedral(input.Normal), (float3x3) gWorldMatrix);
+    output.Tangent = float4(mul(DecodeOctahedral(input.Tangent), (float3x3) gWorldMatrix), DecodeHandedness(input.Tangent.y));
 	return output;
 }
 
@@ -112,15 +146,17 @@ float3 ShadePixel(VS_OUTPUT input, SamplerState state)
     float3 normal = input.Normal;
     if(gUseNormalMap)
     {
-        const float3 binormal = cross(input.Normal, input.Tangent);
+        const float3 binormal = cross(input.Normal, input.Tangent.xyz) * input.Tangent.w;
         const float4x4 tangentSpaceAxis = float4x4
         (
-            float4(input.Tangent, 0.f),
+            float4(input.Tangent.xyz, 0.f),
 	    	float4(binormal, 0.f),
 	    	float4(input.Normal, 0.f),
 	    	float4(0.f, 0.f, 0.f, 1.f)
 	    );
-        const float3 sampledNormal = 2.f * gNormalMap.Sample(state, input.UV).rgb - float3(1.f, 1.f, 1.f);
+        //Only x and y are read, BC5 normal maps don't store z: it follows from the normal being unit length and facing out of the surface
+        const float2 sampledXY = 2.f * gNormalMap.Sample(state, input.UV).rg - float2(1.f, 1.f);
+        const float3 sampledNormal = float3(sampledXY, sqrt(saturate(1.f - dot(sampledXY, sampledXY))));
         normal = mul(float4(sampledNormal, 0.f), tangentSpaceAxis);
     }
     
@@ -191,4 +227,37 @@ technique11 DefaultTechnique
         SetGeometryShader(NULL);
         SetPixelShader(CompileShader(ps_5_0, PS_Anisotropic()));
     }
+}
+
+technique11 CompactTechnique
+{
+	pass P0
+	{
+        SetRasterizerState(gRasterizerState);
+        SetDepthStencilState(gDepthStencilState, 0);
+        SetBlendState(gBlendState, float4(0.f, 0.f, 0.f, 0.f), 0xFFFFFFFF);
+		SetVertexShader( CompileShader( vs_5_0, VS_Compact() ) );
+		SetGeometryShader( NULL );
+		SetPixelShader( CompileShader( ps_5_0, PS_Point() ) );
+	}
+
+    pass P1
+    {
+        SetRasterizerState(gRasterizerState);
+        SetDepthStencilState(gDepthStencilState, 0);
+        SetBlendState(gBlendState, float4(0.f, 0.f, 0.f, 0.f), 0xFFFFFFFF);
+        SetVertexShader(CompileShader(vs_5_0, VS_Compact()));
+        SetGeometryShader(NULL);
+        SetPixelShader(CompileShader(ps_5_0, PS_Linear()));
+    }
+
+    pass P2
+    {
+        SetRasterizerState(gRasterizerState);
+        SetDepthStencilState(gDepthStencilState, 0);
+        SetBlendState(gBlendState, float4(0.f, 0.f, 0.f, 0.f), 0xFFFFFFFF);
+        SetVertexShader(CompileShader(vs_5_0, VS_Compact()));
+        SetGeometryShader(NULL);
+        SetPixelShader(CompileShader(ps_5_0, PS_Anisotropic()));
+    }
 }
\ No newline at end of file
@@ -0,0 +1,196 @@
+#include "pch.h"
+#include "SdfBaker.h"
+
+#include <cfloat>
+#include <chrono>
+#include "CookedSdf.h"
+#include "HalfEdgeMesh.h"
+#include "ParallelFor.h"
+#include "TriangleBvh.h"
+#include "Utils.h"
+
+namespace dae
+{
+	namespace SdfBaker
+	{
+		namespace
+		{
+			//Angle weighted pseudonormals of the faces, edges and vertices, the sign of a distance is taken against the closest one
+			struct Pseudonormals
+			{
+				std::vector<Vector3> faces{};
+				//Three per triangle, edge i runs from corner i to corner (i + 1) % 3
+				std::vector<Vector3> edges{};
+				//One per welded position, shared by every corner at that position even across uv and normal seams
+				std::vector<Vector3> positions{};
+				HalfEdgeMesh adjacency;
+			};
+
+			Pseudonormals ComputePseudonormals(const std::vector<Vertex>& vertices, const std::vector<uint32_t>& indices, size_t numThreads)
+			{
+				const size_t numTriangles{ indices.size() / 3 };
+				Pseudonormals normals{ {}, {}, {}, HalfEdgeMesh{ vertices, indices, numThreads } };
+				const HalfEdgeMesh& adjacency = normals.adjacency;
+				normals.faces.resize(numTriangles);
+				normals.edges.resize(numTriangles * 3);
+				normals.positions.resize(adjacency.GetPositionCount());
+
+				for (size_t triangleIdx = 0; triangleIdx < numTriangles; ++triangleIdx)
+				{
+					const Vector3& a = vertices[indices[triangleIdx * 3]].position;
+					const Vector3& b = vertices[indices[triangleIdx * 3 + 1]].position;
+					const Vector3& c = vertices[indices[triangleIdx * 3 + 2]].position;
+					const Vector3 cross{ Vector3::Cross(b - a, c - a) };
+					const float length{ cross.Magnitude() };
+					if (length <= 0.f)
+						continue;
+
+					const Vector3 faceNormal{ cross / length };
+					normals.faces[triangleIdx] = faceNormal;
+
+					const Vector3 corners[3]{ a, b, c };
+					for (int corner = 0; corner < 3; ++corner)
+					{
+						const Vector3 toNext{ (corners[(corner + 1) % 3] - corners[corner]).Normalized() };
+						const Vector3 toPrevious{ (corners[(corner + 2) % 3] - corners[corner]).Normalized() };
+						const float angle{ acosf(std::min(std::max(Vector3::Dot(toNext, toPrevious), -1.f), 1.f)) };
+						normals.positions[adjacency.GetOrigin(static_cast<uint32_t>(triangleIdx * 3 + corner))] += faceNormal * angle;
+					}
+				}
+
+				//Edges without a twin only have their own face
+				for (uint32_t halfEdge = 0; halfEdge < adjacency.GetHalfEdgeCount(); ++halfEdge)
+				{
+					const uint32_t twin{ adjacency.GetTwin(halfEdge) };
+					const Vector3& faceNormal = normals.faces[HalfEdgeMesh::GetFace(halfEdge)];
+					normals.edges[halfEdge] = twin == HalfEdgeMesh::Invalid ? faceNormal : faceNormal + normals.faces[HalfEdgeMesh::GetFace(twin)];
+				}
+
+				return normals;
+			}
+
+			const Vector3& GetPseudonormal(const Pseudonormals& normals, const TriangleBvh::ClosestHit& hit)
+			{
+				switch (hit.feature)
+				{
+				case TriangleBvh::Feature::Edge0:
+				case TriangleBvh::Feature::Edge1:
+				case TriangleBvh::Feature::Edge2:
+					return normals.edges[size_t(hit.triangle) * 3 + (static_cast<int>(hit.feature) - static_cast<int>(TriangleBvh::Feature::Edge0))];
+				case TriangleBvh::Feature::Vertex0:
+				case TriangleBvh::Feature::Vertex1:
+				case TriangleBvh::Feature::Vertex2:
+					return normals.positions[normals.adjacency.GetOrigin(hit.triangle * 3 + (static_cast<int>(hit.feature) - static_cast<int>(TriangleBvh::Feature::Vertex0)))];
+				default:
+					return normals.faces[hit.triangle];
+				}
+			}
+		}
+
+		SignedDistanceField Bake(const std::vector<Vertex>& vertices, const std::vector<uint32_t>& indices, uint32_t resolution, size_t numThreads)
+		{
+			SignedDistanceField field{};
+			const TriangleBvh bvh{ vertices, indices, numThreads };
+			if (bvh.GetTriangleCount() == 0 || resolution <= PaddingVoxels * 2)
+				return field;
+
+			Vector3 boundsMin{ FLT_MAX, FLT_MAX, FLT_MAX };
+			Vector3 boundsMax{ -FLT_MAX, -FLT_MAX, -FLT_MAX };
+			for (const uint32_t index : indices)
+			{
+				const Vector3& position = vertices[index].position;
+				boundsMin = Vector3{ std::min(boundsMin.x, position.x), std::min(boundsMin.y, position.y), std::min(boundsMin.z, position.z) };
+				boundsMax = Vector3{ std::max(boundsMax.x, position.x), std::max(boundsMax.y, position.y), std::max(boundsMax.z, position.z) };
+			}
+
+			//Cubic voxels, the grid is centered on the bounds
+			const Vector3 extent{ boundsMax - boundsMin };
+			const float extents[3]{ extent.x, extent.y, extent.z };
+			const float maxExtent{ std::max(std::max(extent.x, extent.y), extent.z) };
+			field.voxelSize = std::max(maxExtent, FLT_MIN) / static_cast<float>(resolution - PaddingVoxels * 2);
+			for (int axis = 0; axis < 3; ++axis)
+				field.dimensions[axis] = std::min(static_cast<uint32_t>(ceilf(extents[axis] / field.voxelSize)), resolution - PaddingVoxels * 2) + PaddingVoxels * 2;
+
+			const Vector3 gridSize{ static_cast<float>(field.dimensions[0]) * field.voxelSize, static_cast<float>(field.dimensions[1]) * field.voxelSize, static_cast<float>(field.dimensions[2]) * field.voxelSize };
+			field.origin = (boundsMin + boundsMax) * .5f - gridSize * .5f;
+
+			const Pseudonormals normals{ ComputePseudonormals(vertices, indices, numThreads) };
+
+			const uint32_t numSlices{ field.dimensions[2] };
+			field.distances.resize(size_t(numSlices) * field.dimensions[1] * field.dimensions[0]);
+
+			//Interleaved slices even out the cost between the inside, the surface and the empty padding
+			const size_t numJobs{ std::max(std::min(numThreads, size_t{ numSlices }), size_t{ 1 }) };
+			Utils::ParallelFor(numJobs, numJobs, [&](size_t begin, size_t end)
+				{
+					for (size_t job = begin; job < end; ++job)
+					{
+						for (uint32_t z = static_cast<uint32_t>(job); z < numSlices; z += static_cast<uint32_t>(numJobs))
+						{
+							//The closest surface of a neighbouring voxel is at most one voxel further away and usually on the same triangle,
+							//rows start from the first voxel of the row below and walk along x from there
+							TriangleBvh::ClosestHit rowStartHit{};
+							bool hasRowStart{ false };
+							for (uint32_t y = 0; y < field.dimensions[1]; ++y)
+							{
+								float* pRow = field.distances.data() + (size_t(z) * field.dimensions[1] + y) * field.dimensions[0];
+								TriangleBvh::ClosestHit previousHit{ rowStartHit };
+								bool hasPrevious{ hasRowStart };
+								for (uint32_t x = 0; x < field.dimensions[0]; ++x)
+								{
+									const Vector3 position{ field.origin.x + (x + .5f) * field.voxelSize, field.origin.y + (y + .5f) * field.voxelSize, field.origin.z + (z + .5f) * field.voxelSize };
+									const float maxSqrDistance{ hasPrevious ? Square(sqrtf(previousHit.sqrDistance) + field.voxelSize) * 1.0001f + FLT_MIN : FLT_MAX };
+
+									TriangleBvh::ClosestHit hit{};
+									if (!bvh.FindClosest(position, maxSqrDistance, hit, hasPrevious ? &previousHit : nullptr))
+										bvh.FindClosest(position, FLT_MAX, hit);
+
+									const float distance{ sqrtf(hit.sqrDistance) };
+									const Vector3 toPosition{ position - hit.point };
+									pRow[x] = Vector3::Dot(toPosition, GetPseudonormal(normals, hit)) < 0.f ? -distance : distance;
+
+									previousHit = hit;
+									hasPrevious = true;
+									if (x == 0)
+									{
+										rowStartHit = hit;
+										hasRowStart = true;
+									}
+								}
+							}
+						}
+					}
+				});
+
+			return field;
+		}
+
+		bool CookObj(const std::string& objPath, uint32_t resolution, size_t numThreads, SignedDistanceField& field, std::ostream& log)
+		{
+			field = SignedDistanceField{};
+			std::vector<Vertex> vertices{};
+			std::vector<uint32_t> indices{};
+			if (!Utils::ParseOBJ(objPath, vertices, indices, true, true, numThreads))
+				return false;
+
+			const auto start = std::chrono::steady_clock::now();
+			field = Bake(vertices, indices, resolution, numThreads);
+			const std::chrono::duration<float, std::milli> bakeTime = std::chrono::steady_clock::now() - start;
+			log << objPath << " SDF " << field.dimensions[0] << "x" << field.dimensions[1] << "x" << field.dimensions[2] << " baked in " << bakeTime.count() << " ms\n";
+
+			const std::string cookedPath{ CookedSdf::GetCookedPath(objPath) };
+			if (!CookedSdf::Write(cookedPath, field, resolution, objPath))
+			{
+				log << "Couldn't write cooked SDF " << cookedPath << "\n";
+				return false;
+			}
+			return true;
+		}
+
+		bool IsUpToDate(const std::string& objPath, uint32_t resolution)
+		{
+			const CookedSdf cookedSdf{ CookedSdf::GetCookedPath(objPath) };
+			return cookedSdf.IsUpToDate(objPath) && cookedSdf.GetHeader().resolution == resolution;
+		}
+	}
+}
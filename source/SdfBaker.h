@@ -0,0 +1,30 @@
+#pragma once
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <vector>
+#include "SignedDistanceField.h"
+#include "Vertex.h"
+
+namespace dae
+{
+	//Voxelizes meshes into signed distance fields for proximity, soft shadow and collision queries
+	namespace SdfBaker
+	{
+		constexpr uint32_t DefaultResolution{ 64 };
+		//Empty voxels around the mesh bounds, so the field keeps a gradient just outside the surface
+		constexpr uint32_t PaddingVoxels{ 2 };
+
+		//resolution voxels along the longest axis of the bounds, the other axes get as many as they need for cubic voxels.
+		//Distances come from nearest triangle queries against a bounding volume hierarchy, seeded with the previous voxel of the row.
+		//The sign follows the angle weighted pseudonormal of the closest feature (Baerentzen and Aanaes 2005), so the mesh should be closed.
+		//Slices are interleaved over numThreads threads, the result doesn't depend on numThreads.
+		SignedDistanceField Bake(const std::vector<Vertex>& vertices, const std::vector<uint32_t>& indices, uint32_t resolution = DefaultResolution, size_t numThreads = 1);
+
+		//Parses and bakes the OBJ at objPath and writes the cooked field next to it, for CookedSdf to load.
+		//False when the OBJ can't be parsed or the field can't be written. The size and bake time are written to log.
+		bool CookObj(const std::string& objPath, uint32_t resolution, size_t numThreads, SignedDistanceField& field, std::ostream& log);
+		//True when the cooked field of objPath was baked from it as it is now, at this resolution
+		bool IsUpToDate(const std::string& objPath, uint32_t resolution);
+	}
+}
@@ -52,19 +52,45 @@ void ShadingEffect::SetViewInverseVariable(const dae::Matrix& matrix) const
 void ShadingEffect::SetNormalMap(const dae::Texture* pNormalTexture)
 {
 	if (pNormalTexture)
+	{
+		m_pNormalMap = pNormalTexture;
 		m_pNormalMapVariable->SetResource(pNormalTexture->GetSRV());
+	}
 }
 
 void ShadingEffect::SetSpecularMap(const dae::Texture* pSpecularTexture)
 {
 	if (pSpecularTexture)
+	{
+		m_pSpecularMap = pSpecularTexture;
 		m_pSpecularMapVariable->SetResource(pSpecularTexture->GetSRV());
+	}
 }
 
 void ShadingEffect::SetGlossinessMap(const dae::Texture* pGlossinessTexture)
 {
 	if (pGlossinessTexture)
+	{
+		m_pGlossinessMap = pGlossinessTexture;
 		m_pGlossinessMapVariable->SetResource(pGlossinessTexture->GetSRV());
+	}
+}
+
+void ShadingEffect::SetMaterial(const dae::Material* pMaterial) const
+{
+	Effect::SetMaterial(pMaterial);
+
+	const dae::Texture* pNormalMap = pMaterial && pMaterial->pNormalMap ? pMaterial->pNormalMap : m_pNormalMap;
+	if (pNormalMap)
+		m_pNormalMapVariable->SetResource(pNormalMap->GetSRV());
+
+	const dae::Texture* pSpecularMap = pMaterial && pMaterial->pSpecularMap ? pMaterial->pSpecularMap : m_pSpecularMap;
+	if (pSpecularMap)
+		m_pSpecularMapVariable->SetResource(pSpecularMap->GetSRV());
+
+	const dae::Texture* pGlossinessMap = pMaterial && pMaterial->pGlossinessMap ? pMaterial->pGlossinessMap : m_pGlossinessMap;
+	if (pGlossinessMap)
+		m_pGlossinessMapVariable->SetResource(pGlossinessMap->GetSRV());
 }
 
 //Variable
@@ -22,6 +22,7 @@ public:
 	void SetNormalMap(const dae::Texture* pNormalTexture);
 	void SetSpecularMap(const dae::Texture* pSpecularTexture);
 	void SetGlossinessMap(const dae::Texture* pGlossinessTexture);
+	virtual void SetMaterial(const dae::Material* pMaterial) const override;
 
 	//Variable
 	virtual void SetUseNormalMap(const bool useNormalMap) const override;
@@ -36,6 +37,9 @@ private:
 	ID3DX11EffectShaderResourceVariable* m_pNormalMapVariable{ nullptr };
 	ID3DX11EffectShaderResourceVariable* m_pSpecularMapVariable{ nullptr };
 	ID3DX11EffectShaderResourceVariable* m_pGlossinessMapVariable{ nullptr };
+	const dae::Texture* m_pNormalMap{ nullptr };
+	const dae::Texture* m_pSpecularMap{ nullptr };
+	const dae::Texture* m_pGlossinessMap{ nullptr };
 
 	//Variable
 	ID3DX11EffectScalarVariable* m_pUseNormalMap{ nullptr };
@@ -0,0 +1,44 @@
+#include "pch.h"
+#include "SignedDistanceField.h"
+
+#include <cfloat>
+
+namespace dae
+{
+	float SignedDistanceField::Sample(const Vector3& position) const
+	{
+		if (distances.empty())
+			return FLT_MAX;
+
+		//Voxel centers sit at half voxel offsets
+		const float coordinates[3]{ (position.x - origin.x) / voxelSize - .5f, (position.y - origin.y) / voxelSize - .5f, (position.z - origin.z) / voxelSize - .5f };
+
+		uint32_t cell[3]{};
+		float weights[3]{};
+		float outsideSqr{};
+		for (int axis = 0; axis < 3; ++axis)
+		{
+			const float maxCoordinate{ static_cast<float>(dimensions[axis] - 1) };
+			const float clamped{ std::min(std::max(coordinates[axis], 0.f), maxCoordinate) };
+			outsideSqr += Square((coordinates[axis] - clamped) * voxelSize);
+
+			cell[axis] = std::min(static_cast<uint32_t>(clamped), dimensions[axis] > 1 ? dimensions[axis] - 2 : 0u);
+			weights[axis] = dimensions[axis] > 1 ? clamped - static_cast<float>(cell[axis]) : 0.f;
+		}
+
+		const size_t strideY{ dimensions[0] };
+		const size_t strideZ{ size_t(dimensions[0]) * dimensions[1] };
+		const size_t stepX{ dimensions[0] > 1 ? 1u : 0u };
+		const size_t stepY{ dimensions[1] > 1 ? strideY : 0u };
+		const size_t stepZ{ dimensions[2] > 1 ? strideZ : 0u };
+		const float* pCorner = distances.data() + cell[0] + cell[1] * strideY + cell[2] * strideZ;
+
+		const float x00{ Lerpf(pCorner[0], pCorner[stepX], weights[0]) };
+		const float x10{ Lerpf(pCorner[stepY], pCorner[stepY + stepX], weights[0]) };
+		const float x01{ Lerpf(pCorner[stepZ], pCorner[stepZ + stepX], weights[0]) };
+		const float x11{ Lerpf(pCorner[stepZ + stepY], pCorner[stepZ + stepY + stepX], weights[0]) };
+		const float distance{ Lerpf(Lerpf(x00, x10, weights[1]), Lerpf(x01, x11, weights[1]), weights[2]) };
+
+		return outsideSqr > 0.f ? distance + sqrtf(outsideSqr) : distance;
+	}
+}
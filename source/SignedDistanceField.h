@@ -0,0 +1,22 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+#include "Math.h"
+
+namespace dae
+{
+	//Distances to the closest surface sampled at the voxel centers of a grid, negative inside
+	struct SignedDistanceField
+	{
+		uint32_t dimensions[3]{};
+		//Corner of voxel 0, voxels are cubes
+		Vector3 origin{};
+		float voxelSize{};
+		//x fastest, then y, then z
+		std::vector<float> distances{};
+
+		bool IsEmpty() const { return distances.empty(); }
+		//Trilinear between the voxel centers, positions outside the grid add their distance to it
+		float Sample(const Vector3& position) const;
+	};
+}
@@ -0,0 +1,178 @@
+#include "pch.h"
+#include "SmoothNormals.h"
+
+#include <cfloat>
+#include "HalfEdgeMesh.h"
+#include "ParallelFor.h"
+
+namespace dae
+{
+	namespace SmoothNormals
+	{
+		namespace
+		{
+			constexpr uint32_t Unassigned{ UINT32_MAX };
+
+			//Scales to unit length, zero stays zero
+			Vector3 Normalize(const Vector3& v)
+			{
+				const float sqrLength{ v.x * v.x + v.y * v.y + v.z * v.z };
+				const float invLength{ sqrLength > FLT_MIN ? 1.f / sqrtf(sqrLength) : 0.f };
+				return Vector3{ v.x * invLength, v.y * invLength, v.z * invLength };
+			}
+
+			float Dot(const Vector3& a, const Vector3& b)
+			{
+				return a.x * b.x + a.y * b.y + a.z * b.z;
+			}
+
+			//Angle between two unit vectors, sign flips b
+			float AngleBetween(const Vector3& a, const Vector3& b, float sign)
+			{
+				return AcosApprox(std::min(std::max(Dot(a, b) * sign, -1.f), 1.f));
+			}
+
+			bool operator==(const Vector3& a, const Vector3& b)
+			{
+				return a.x == b.x && a.y == b.y && a.z == b.z;
+			}
+		}
+
+		void Generate(std::vector<Vertex>& vertices, std::vector<uint32_t>& indices, float creaseAngle, size_t numThreads)
+		{
+			const size_t numTriangles{ indices.size() / 3 };
+			const size_t numCorners{ numTriangles * 3 };
+
+			//Unit face normals and the angle of every corner
+			std::vector<Vector3> faceNormals(numTriangles);
+			std::vector<float> cornerAngles(numCorners);
+			Utils::ParallelFor(numTriangles, numThreads, [&](size_t begin, size_t end)
+				{
+					for (size_t triangle = begin; triangle < end; ++triangle)
+					{
+						const Vector3& p0 = vertices[indices[triangle * 3]].position;
+						const Vector3& p1 = vertices[indices[triangle * 3 + 1]].position;
+						const Vector3& p2 = vertices[indices[triangle * 3 + 2]].position;
+
+						const Vector3 e01{ p1.x - p0.x, p1.y - p0.y, p1.z - p0.z };
+						const Vector3 e12{ p2.x - p1.x, p2.y - p1.y, p2.z - p1.z };
+						const Vector3 e20{ p0.x - p2.x, p0.y - p2.y, p0.z - p2.z };
+						faceNormals[triangle] = Normalize(Vector3{ e01.y * e12.z - e01.z * e12.y, e01.z * e12.x - e01.x * e12.z, e01.x * e12.y - e01.y * e12.x });
+
+						//The angle at a corner is between the edges leaving it, so the incoming edge is flipped
+						const Vector3 d01{ Normalize(e01) }, d12{ Normalize(e12) }, d20{ Normalize(e20) };
+						cornerAngles[triangle * 3] = AngleBetween(d01, d20, -1.f);
+						cornerAngles[triangle * 3 + 1] = AngleBetween(d12, d01, -1.f);
+						cornerAngles[triangle * 3 + 2] = AngleBetween(d20, d12, -1.f);
+					}
+				});
+
+			//Corners per welded position, in ascending corner order
+			std::vector<uint32_t> positionIds{};
+			const uint32_t numPositions{ HalfEdgeMesh::WeldPositions(vertices, positionIds, numThreads) };
+
+			std::vector<uint32_t> firstCorner(numPositions + 1, 0);
+			for (size_t i = 0; i < numCorners; ++i)
+				++firstCorner[positionIds[indices[i]] + 1];
+			for (uint32_t positionIdx = 0; positionIdx < numPositions; ++positionIdx)
+				firstCorner[positionIdx + 1] += firstCorner[positionIdx];
+
+			std::vector<uint32_t> positionCorners(numCorners);
+			std::vector<uint32_t> fillCursor(firstCorner.begin(), firstCorner.end() - 1);
+			for (size_t i = 0; i < numCorners; ++i)
+				positionCorners[fillCursor[positionIds[indices[i]]]++] = static_cast<uint32_t>(i);
+
+			//Face normals in the order of positionCorners, so every position reads its faces from one contiguous run
+			std::vector<Vector3> sortedNormals(numCorners);
+			std::vector<Vector3> sortedWeighted(numCorners);
+			Utils::ParallelFor(numCorners, numThreads, [&](size_t begin, size_t end)
+				{
+					for (size_t i = begin; i < end; ++i)
+					{
+						const Vector3& normal = faceNormals[positionCorners[i] / 3];
+						const float angle{ cornerAngles[positionCorners[i]] };
+						sortedNormals[i] = normal;
+						sortedWeighted[i] = Vector3{ normal.x * angle, normal.y * angle, normal.z * angle };
+					}
+				});
+
+			//The faces around every position are clustered in corner order: a face joins the first cluster whose first face is within the crease angle of its own,
+			//or starts a new one. Those first faces are more than the crease angle apart, so a position only ever has a handful of clusters.
+			//Every corner gets its cluster's sum, summed in corner order, so the result doesn't depend on the thread count.
+			const float cosCrease{ cosf(creaseAngle * TO_RADIANS) };
+			std::vector<Vector3> cornerNormals(numCorners);
+			Utils::ParallelFor(numPositions, numThreads, [&](size_t begin, size_t end)
+				{
+					std::vector<uint32_t> clusterFirsts{};
+					std::vector<Vector3> clusterSums{};
+					std::vector<uint32_t> cornerClusters{};
+					for (size_t positionIdx = begin; positionIdx < end; ++positionIdx)
+					{
+						const uint32_t first{ firstCorner[positionIdx] };
+						const uint32_t last{ firstCorner[positionIdx + 1] };
+						clusterFirsts.clear();
+						clusterSums.clear();
+						cornerClusters.assign(last - first, Unassigned);
+
+						Vector3 totalSum{};
+						for (uint32_t i = first; i < last; ++i)
+						{
+							const Vector3& ownNormal = sortedNormals[i];
+							totalSum += sortedWeighted[i];
+							//Degenerate faces have no crease to respect, they take the sum of every face around them
+							if (ownNormal.x == 0.f && ownNormal.y == 0.f && ownNormal.z == 0.f)
+								continue;
+
+							uint32_t clusterIdx{};
+							while (clusterIdx < clusterFirsts.size() && Dot(sortedNormals[clusterFirsts[clusterIdx]], ownNormal) < cosCrease)
+								++clusterIdx;
+							if (clusterIdx == clusterFirsts.size())
+							{
+								clusterFirsts.push_back(i);
+								clusterSums.push_back(Vector3{});
+							}
+							clusterSums[clusterIdx] += sortedWeighted[i];
+							cornerClusters[i - first] = clusterIdx;
+						}
+
+						for (uint32_t i = first; i < last; ++i)
+						{
+							const uint32_t clusterIdx{ cornerClusters[i - first] };
+							cornerNormals[positionCorners[i]] = Normalize(clusterIdx == Unassigned ? totalSum : clusterSums[clusterIdx]);
+						}
+					}
+				});
+
+			//Give every corner a vertex with its normal, copies of a vertex are chained through nextCopy
+			const size_t numSourceVertices{ vertices.size() };
+			std::vector<uint8_t> isAssigned(numSourceVertices, false);
+			std::vector<uint32_t> nextCopy(numSourceVertices, Unassigned);
+			for (size_t i = 0; i < numCorners; ++i)
+			{
+				const Vector3& normal = cornerNormals[i];
+				uint32_t vertexIdx{ indices[i] };
+				if (!isAssigned[vertexIdx])
+				{
+					isAssigned[vertexIdx] = true;
+					vertices[vertexIdx].normal = normal;
+					continue;
+				}
+
+				while (!(vertices[vertexIdx].normal == normal) && nextCopy[vertexIdx] != Unassigned)
+					vertexIdx = nextCopy[vertexIdx];
+
+				if (!(vertices[vertexIdx].normal == normal))
+				{
+					Vertex copy{ vertices[vertexIdx] };
+					copy.normal = normal;
+					nextCopy[vertexIdx] = static_cast<uint32_t>(vertices.size());
+					vertexIdx = nextCopy[vertexIdx];
+					vertices.push_back(copy);
+					nextCopy.push_back(Unassigned);
+				}
+
+				indices[i] = vertexIdx;
+			}
+		}
+	}
+}
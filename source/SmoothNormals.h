@@ -0,0 +1,20 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+#include "Vertex.h"
+
+namespace dae
+{
+	//Smooth vertex normals for meshes that come without any, such as raw scans
+	namespace SmoothNormals
+	{
+		constexpr float DefaultCreaseAngle{ 60.f };
+
+		//The faces around every position are clustered by normal, a face joins the first cluster whose first face is within creaseAngle degrees of its own.
+		//Every corner averages its cluster, weighted by the angle each face makes at that position. Corners are matched by position, so uv seams stay smooth.
+		//A vertex whose corners end up with different normals is split, creases get one vertex per side.
+		//Runs on numThreads threads in time linear in the triangle count times the clusters per position, which their crease angle spacing keeps to a handful.
+		//The result doesn't depend on numThreads.
+		void Generate(std::vector<Vertex>& vertices, std::vector<uint32_t>& indices, float creaseAngle = DefaultCreaseAngle, size_t numThreads = 1);
+	}
+}
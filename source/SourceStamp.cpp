@@ -0,0 +1,76 @@
+#include "pch.h"
+#include "SourceStamp.h"
+
+#include <cstddef>
+#include <filesystem>
+#include <fstream>
+#include "MappedFile.h"
+
+namespace dae
+{
+	namespace
+	{
+		//FNV-1a over the whole source file
+		bool HashFile(const std::string& path, uint64_t& hash)
+		{
+			const MappedFile file{ path };
+			if (!file.IsOpen())
+				return false;
+
+			hash = 0xCBF29CE484222325ull;
+			for (size_t i = 0; i < file.GetSize(); ++i)
+			{
+				hash ^= static_cast<uint8_t>(file.GetData()[i]);
+				hash *= 0x100000001B3ull;
+			}
+
+			return true;
+		}
+
+		bool GetWriteTime(const std::string& path, int64_t& writeTime)
+		{
+			std::error_code error{};
+			const auto time = std::filesystem::last_write_time(path, error);
+			if (error)
+				return false;
+
+			writeTime = static_cast<int64_t>(time.time_since_epoch().count());
+			return true;
+		}
+	}
+
+	bool SourceStamp::Create(const std::string& sourcePath, SourceStamp& stamp)
+	{
+		std::error_code error{};
+		stamp.size = std::filesystem::file_size(sourcePath, error);
+		return !error && GetWriteTime(sourcePath, stamp.writeTime) && HashFile(sourcePath, stamp.hash);
+	}
+
+	bool SourceStamp::Matches(const std::string& sourcePath, const std::string& cookedPath, uint64_t stampOffset) const
+	{
+		std::error_code error{};
+		const uint64_t sourceSize = std::filesystem::file_size(sourcePath, error);
+		if (error || sourceSize != size)
+			return false;
+
+		int64_t sourceWriteTime{};
+		const bool hasWriteTime{ GetWriteTime(sourcePath, sourceWriteTime) };
+		if (hasWriteTime && sourceWriteTime == writeTime)
+			return true;
+
+		//Touched but maybe not changed (fresh checkout, copied by the post-build step)
+		uint64_t sourceHash{};
+		if (!HashFile(sourcePath, sourceHash) || sourceHash != hash)
+			return false;
+
+		//Only the timestamp in place, the cooked file may be mapped. One that can't be written just gets hashed again next time.
+		if (hasWriteTime)
+		{
+			std::fstream file{ cookedPath, std::ios::binary | std::ios::in | std::ios::out };
+			file.seekp(static_cast<std::streamoff>(stampOffset + offsetof(SourceStamp, writeTime)));
+			file.write(reinterpret_cast<const char*>(&sourceWriteTime), sizeof(sourceWriteTime));
+		}
+
+		return true;
+	}
+}
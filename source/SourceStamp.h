@@ -0,0 +1,19 @@
+#pragma once
+#include <cstdint>
+#include <string>
+
+namespace dae
+{
+	//Identifies the source file a cooked file was made from, stored in the header of every cooked file
+	struct SourceStamp
+	{
+		uint64_t size;
+		int64_t writeTime;
+		uint64_t hash;
+
+		static bool Create(const std::string& sourcePath, SourceStamp& stamp);
+		//Same size and timestamp, or else same size and content. A source that was touched but not changed matches on its content,
+		//its new timestamp then gets written to the copy of this stamp at stampOffset in cookedPath, so later checks skip the hash again.
+		bool Matches(const std::string& sourcePath, const std::string& cookedPath, uint64_t stampOffset) const;
+	};
+}
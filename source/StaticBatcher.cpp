@@ -0,0 +1,160 @@
+#include "pch.h"
+#include "StaticBatcher.h"
+
+#include <string>
+#include <unordered_map>
+#include "ParallelFor.h"
+
+namespace dae
+{
+	namespace StaticBatcher
+	{
+		namespace
+		{
+			//Everything a vertex needs from its instance's transform
+			struct InstanceTransform
+			{
+				Matrix world;
+				//Cofactors of the upper 3x3, the inverse transpose scaled by the determinant
+				Vector3 normalX;
+				Vector3 normalY;
+				Vector3 normalZ;
+				float handedness;
+			};
+
+			InstanceTransform GetTransform(const Matrix& world)
+			{
+				const Vector3 axisX{ world.GetAxisX() };
+				const Vector3 axisY{ world.GetAxisY() };
+				const Vector3 axisZ{ world.GetAxisZ() };
+				const float determinant{ Vector3::Dot(axisX, Vector3::Cross(axisY, axisZ)) };
+				const float sign{ determinant < 0.f ? -1.f : 1.f };
+
+				//A negative determinant flips the cofactors, the sign turns them back to the outside
+				return InstanceTransform{ world, Vector3::Cross(axisY, axisZ) * sign, Vector3::Cross(axisZ, axisX) * sign, Vector3::Cross(axisX, axisY) * sign, sign };
+			}
+
+			Vector3 Normalize(const Vector3& v)
+			{
+				const float sqrLength{ v.SqrMagnitude() };
+				return sqrLength > 0.f ? v / sqrtf(sqrLength) : v;
+			}
+
+			//One run of source indices copied to the batch
+			struct IndexCopy
+			{
+				size_t instance;
+				uint32_t sourceStart;
+				uint32_t count;
+				size_t destinationStart;
+			};
+		}
+
+		StaticBatch Merge(const std::vector<StaticInstance>& instances, size_t numThreads)
+		{
+			StaticBatch batch{};
+
+			//Every instance's vertices go to one contiguous block
+			std::vector<size_t> vertexBases(instances.size() + 1, 0);
+			std::vector<InstanceTransform> transforms{};
+			transforms.reserve(instances.size());
+			for (size_t instanceIdx = 0; instanceIdx < instances.size(); ++instanceIdx)
+			{
+				vertexBases[instanceIdx + 1] = vertexBases[instanceIdx] + instances[instanceIdx].pVertices->size();
+				transforms.push_back(GetTransform(instances[instanceIdx].world));
+			}
+
+			if (vertexBases.back() > UINT32_MAX)
+				return batch;
+
+			//Materials in order of first use, with the index runs of every instance that uses them
+			std::vector<std::string> materialNames{};
+			std::unordered_map<std::string, size_t> materialIds{};
+			std::vector<std::vector<IndexCopy>> materialCopies{};
+			const auto addCopy = [&](const std::string& material, size_t instanceIdx, uint32_t start, uint32_t count)
+				{
+					const auto [it, isNew] = materialIds.try_emplace(material, materialNames.size());
+					if (isNew)
+					{
+						materialNames.push_back(material);
+						materialCopies.emplace_back();
+					}
+					materialCopies[it->second].push_back(IndexCopy{ instanceIdx, start, count, 0 });
+				};
+
+			for (size_t instanceIdx = 0; instanceIdx < instances.size(); ++instanceIdx)
+			{
+				const StaticInstance& instance = instances[instanceIdx];
+				if (!instance.pMaterialRanges)
+				{
+					addCopy("", instanceIdx, 0, static_cast<uint32_t>(instance.pIndices->size()));
+					continue;
+				}
+
+				for (const Utils::ObjMaterialRange& range : *instance.pMaterialRanges)
+					addCopy(range.material, instanceIdx, range.indexStart, range.indexCount);
+			}
+
+			//Lay the runs out material by material
+			std::vector<IndexCopy> copies{};
+			size_t numIndices{};
+			for (size_t materialIdx = 0; materialIdx < materialNames.size(); ++materialIdx)
+			{
+				const size_t materialStart{ numIndices };
+				for (IndexCopy& copy : materialCopies[materialIdx])
+				{
+					copy.destinationStart = numIndices;
+					numIndices += copy.count;
+					copies.push_back(copy);
+				}
+
+				if (numIndices > materialStart)
+					batch.materialRanges.push_back(Utils::ObjMaterialRange{ materialNames[materialIdx], static_cast<uint32_t>(materialStart), static_cast<uint32_t>(numIndices - materialStart) });
+			}
+
+			//Transform the vertices, a worker finds the instance of its first vertex and walks on from there
+			batch.vertices.resize(vertexBases.back());
+			Utils::ParallelFor(batch.vertices.size(), numThreads, [&](size_t begin, size_t end)
+				{
+					size_t instanceIdx = static_cast<size_t>(std::upper_bound(vertexBases.begin(), vertexBases.end(), begin) - vertexBases.begin()) - 1;
+					for (size_t vertexIdx = begin; vertexIdx < end; ++vertexIdx)
+					{
+						while (vertexIdx >= vertexBases[instanceIdx + 1])
+							++instanceIdx;
+
+						const InstanceTransform& transform = transforms[instanceIdx];
+						const Vertex& source = (*instances[instanceIdx].pVertices)[vertexIdx - vertexBases[instanceIdx]];
+						Vertex& vertex = batch.vertices[vertexIdx];
+
+						vertex = source;
+						vertex.position = transform.world.TransformPoint(source.position);
+						vertex.normal = Normalize(transform.normalX * source.normal.x + transform.normalY * source.normal.y + transform.normalZ * source.normal.z);
+						vertex.tangent = Vector4{ Normalize(transform.world.TransformVector(source.tangent.GetXYZ())), source.tangent.w * transform.handedness };
+					}
+				});
+
+			//Offset the indices into the instance's vertex block, mirrored instances swap two corners to keep their front faces
+			batch.indices.resize(numIndices);
+			Utils::ParallelFor(copies.size(), numThreads, [&](size_t begin, size_t end)
+				{
+					for (size_t copyIdx = begin; copyIdx < end; ++copyIdx)
+					{
+						const IndexCopy& copy = copies[copyIdx];
+						const uint32_t* pSource = instances[copy.instance].pIndices->data() + copy.sourceStart;
+						uint32_t* pDestination = batch.indices.data() + copy.destinationStart;
+						const uint32_t vertexBase{ static_cast<uint32_t>(vertexBases[copy.instance]) };
+						const bool isMirrored{ transforms[copy.instance].handedness < 0.f };
+
+						for (uint32_t i = 0; i + 2 < copy.count; i += 3)
+						{
+							pDestination[i] = pSource[i] + vertexBase;
+							pDestination[i + 1] = pSource[isMirrored ? i + 2 : i + 1] + vertexBase;
+							pDestination[i + 2] = pSource[isMirrored ? i + 1 : i + 2] + vertexBase;
+						}
+					}
+				});
+
+			return batch;
+		}
+	}
+}
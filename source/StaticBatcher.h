@@ -0,0 +1,36 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+#include "Utils.h"
+#include "Vertex.h"
+
+namespace dae
+{
+	//Geometry of a mesh that never moves and where it's placed, the batch only reads it
+	struct StaticInstance
+	{
+		const std::vector<Vertex>* pVertices{ nullptr };
+		const std::vector<uint32_t>* pIndices{ nullptr };
+		//nullptr draws every triangle with the unnamed material
+		const std::vector<Utils::ObjMaterialRange>* pMaterialRanges{ nullptr };
+		Matrix world{};
+	};
+
+	//World space geometry of many instances, grouped by material like ParseOBJ's output
+	struct StaticBatch
+	{
+		std::vector<Vertex> vertices{};
+		std::vector<uint32_t> indices{};
+		std::vector<Utils::ObjMaterialRange> materialRanges{};
+	};
+
+	//Bakes the world transforms of meshes sharing an effect into their vertices and merges them into one vertex and index list,
+	//so they draw with one buffer bind and one draw per material instead of one Mesh each
+	namespace StaticBatcher
+	{
+		//Normals and tangents follow the inverse transpose, mirroring transforms flip the winding and the tangent handedness.
+		//Materials keep the order they're first used in, the triangles of a material keep instance order.
+		//Returns an empty batch when the vertices don't fit 32 bit indices.
+		StaticBatch Merge(const std::vector<StaticInstance>& instances, size_t numThreads = 1);
+	}
+}
@@ -0,0 +1,328 @@
+#include "pch.h"
+#include "TangentSpace.h"
+
+#include <cfloat>
+#include "ParallelFor.h"
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__SSE2__)
+#include <emmintrin.h>
+#define DAE_TANGENT_SSE2
+#endif
+
+namespace dae
+{
+	namespace TangentSpace
+	{
+		namespace
+		{
+			constexpr size_t TrianglesPerGroup{ 4 };
+
+			//Handedness of a triangle, Degenerate ones have no usable uv mapping
+			enum class Orientation : int8_t
+			{
+				Degenerate = 0,
+				Positive = 1,
+				Negative = -1
+			};
+
+			//Scales to unit length, zero stays zero
+			Vector3 Normalize(const Vector3& v)
+			{
+				const float sqrLength{ v.x * v.x + v.y * v.y + v.z * v.z };
+				const float invLength{ sqrLength > FLT_MIN ? 1.f / sqrtf(sqrLength) : 0.f };
+				return Vector3{ v.x * invLength, v.y * invLength, v.z * invLength };
+			}
+
+			Vector3 ProjectOnPlane(const Vector3& v, const Vector3& normal)
+			{
+				const float along{ v.x * normal.x + v.y * normal.y + v.z * normal.z };
+				return Vector3{ v.x - normal.x * along, v.y - normal.y * along, v.z - normal.z * along };
+			}
+
+			//Angle weighted tangents of the three corners and the triangle's orientation
+			void ProcessTriangle(const Vertex& v0, const Vertex& v1, const Vertex& v2, Vector3* pCornerTangents, Orientation& orientation)
+			{
+				const Vector3 e1{ v1.position - v0.position };
+				const Vector3 e2{ v2.position - v0.position };
+				const float du1{ v1.uv.x - v0.uv.x }, dv1{ v1.uv.y - v0.uv.y };
+				const float du2{ v2.uv.x - v0.uv.x }, dv2{ v2.uv.y - v0.uv.y };
+				const float det{ du1 * dv2 - du2 * dv1 };
+
+				//Unscaled dP/du and dP/dv, both still have to be divided by det
+				const Vector3 uDirection{ e1.x * dv2 - e2.x * dv1, e1.y * dv2 - e2.y * dv1, e1.z * dv2 - e2.z * dv1 };
+				const Vector3 vDirection{ e2.x * du1 - e1.x * du2, e2.y * du1 - e1.y * du2, e2.z * du1 - e1.z * du2 };
+				const Vector3 tangent{ Normalize(det < 0.f ? Vector3{ -uDirection.x, -uDirection.y, -uDirection.z } : uDirection) };
+
+				if (!(fabsf(det) > FLT_MIN) || tangent.x * tangent.x + tangent.y * tangent.y + tangent.z * tangent.z == 0.f)
+				{
+					orientation = Orientation::Degenerate;
+					pCornerTangents[0] = pCornerTangents[1] = pCornerTangents[2] = Vector3{};
+					return;
+				}
+
+				//Positive when cross(normal, dP/du) points along dP/dv, the 1 / det scale of both cancels out
+				const Vector3 faceNormal{ e1.y * e2.z - e1.z * e2.y, e1.z * e2.x - e1.x * e2.z, e1.x * e2.y - e1.y * e2.x };
+				const Vector3 bitangent{ faceNormal.y * uDirection.z - faceNormal.z * uDirection.y, faceNormal.z * uDirection.x - faceNormal.x * uDirection.z,
+					faceNormal.x * uDirection.y - faceNormal.y * uDirection.x };
+				orientation = bitangent.x * vDirection.x + bitangent.y * vDirection.y + bitangent.z * vDirection.z > 0.f ? Orientation::Positive : Orientation::Negative;
+
+				const Vertex* pCorners[3]{ &v0, &v1, &v2 };
+				for (int corner = 0; corner < 3; ++corner)
+				{
+					const Vector3& normal = pCorners[corner]->normal;
+					const Vector3& position = pCorners[corner]->position;
+					const Vector3 toNext{ Normalize(ProjectOnPlane(pCorners[(corner + 1) % 3]->position - position, normal)) };
+					const Vector3 toPrevious{ Normalize(ProjectOnPlane(pCorners[(corner + 2) % 3]->position - position, normal)) };
+					const float cosAngle{ std::min(std::max(toNext.x * toPrevious.x + toNext.y * toPrevious.y + toNext.z * toPrevious.z, -1.f), 1.f) };
+
+					const Vector3 cornerTangent{ Normalize(ProjectOnPlane(tangent, normal)) };
+					const float angle{ AcosApprox(cosAngle) };
+					pCornerTangents[corner] = Vector3{ cornerTangent.x * angle, cornerTangent.y * angle, cornerTangent.z * angle };
+				}
+			}
+
+#ifdef DAE_TANGENT_SSE2
+			struct Vector3x4
+			{
+				__m128 x;
+				__m128 y;
+				__m128 z;
+			};
+
+			Vector3x4 Subtract(const Vector3x4& a, const Vector3x4& b)
+			{
+				return { _mm_sub_ps(a.x, b.x), _mm_sub_ps(a.y, b.y), _mm_sub_ps(a.z, b.z) };
+			}
+
+			__m128 Dot(const Vector3x4& a, const Vector3x4& b)
+			{
+				return _mm_add_ps(_mm_add_ps(_mm_mul_ps(a.x, b.x), _mm_mul_ps(a.y, b.y)), _mm_mul_ps(a.z, b.z));
+			}
+
+			Vector3x4 Cross(const Vector3x4& a, const Vector3x4& b)
+			{
+				return { _mm_sub_ps(_mm_mul_ps(a.y, b.z), _mm_mul_ps(a.z, b.y)), _mm_sub_ps(_mm_mul_ps(a.z, b.x), _mm_mul_ps(a.x, b.z)),
+					_mm_sub_ps(_mm_mul_ps(a.x, b.y), _mm_mul_ps(a.y, b.x)) };
+			}
+
+			Vector3x4 Scale(const Vector3x4& v, __m128 scale)
+			{
+				return { _mm_mul_ps(v.x, scale), _mm_mul_ps(v.y, scale), _mm_mul_ps(v.z, scale) };
+			}
+
+			Vector3x4 Normalize(const Vector3x4& v)
+			{
+				const __m128 sqrLength{ Dot(v, v) };
+				const __m128 invLength{ _mm_and_ps(_mm_div_ps(_mm_set1_ps(1.f), _mm_sqrt_ps(sqrLength)), _mm_cmpgt_ps(sqrLength, _mm_set1_ps(FLT_MIN))) };
+				return Scale(v, invLength);
+			}
+
+			Vector3x4 ProjectOnPlane(const Vector3x4& v, const Vector3x4& normal)
+			{
+				return Subtract(v, Scale(normal, Dot(v, normal)));
+			}
+
+			//The same operations in the same order as the scalar AcosApprox, so both paths agree bit for bit
+			__m128 AcosApprox(__m128 x)
+			{
+				const __m128 signMask{ _mm_set1_ps(-0.f) };
+				const __m128 absX{ _mm_andnot_ps(signMask, x) };
+				const __m128 polynomial{ _mm_add_ps(_mm_set1_ps(1.5707288f), _mm_mul_ps(absX, _mm_add_ps(_mm_set1_ps(-.2121144f),
+					_mm_mul_ps(absX, _mm_add_ps(_mm_set1_ps(.0742610f), _mm_mul_ps(absX, _mm_set1_ps(-.0187293f))))))) };
+				const __m128 angle{ _mm_mul_ps(_mm_sqrt_ps(_mm_sub_ps(_mm_set1_ps(1.f), absX)), polynomial) };
+				const __m128 isNegative{ _mm_cmplt_ps(x, _mm_setzero_ps()) };
+				return _mm_or_ps(_mm_and_ps(isNegative, _mm_sub_ps(_mm_set1_ps(3.14159265f), angle)), _mm_andnot_ps(isNegative, angle));
+			}
+
+			//ProcessTriangle on four triangles at once, every lane runs the scalar operations in the same order
+			void ProcessTriangles(const std::vector<Vertex>& vertices, const uint32_t* pIndices, Vector3* pCornerTangents, Orientation* pOrientations)
+			{
+				alignas(16) float positions[3][3][4], normals[3][3][4], uvs[3][2][4];
+				for (int lane = 0; lane < 4; ++lane)
+				{
+					for (int corner = 0; corner < 3; ++corner)
+					{
+						const Vertex& vertex = vertices[pIndices[lane * 3 + corner]];
+						for (int axis = 0; axis < 3; ++axis)
+						{
+							positions[corner][axis][lane] = vertex.position[axis];
+							normals[corner][axis][lane] = vertex.normal[axis];
+						}
+						uvs[corner][0][lane] = vertex.uv.x;
+						uvs[corner][1][lane] = vertex.uv.y;
+					}
+				}
+
+				Vector3x4 position[3], normal[3];
+				for (int corner = 0; corner < 3; ++corner)
+				{
+					position[corner] = { _mm_load_ps(positions[corner][0]), _mm_load_ps(positions[corner][1]), _mm_load_ps(positions[corner][2]) };
+					normal[corner] = { _mm_load_ps(normals[corner][0]), _mm_load_ps(normals[corner][1]), _mm_load_ps(normals[corner][2]) };
+				}
+
+				const Vector3x4 e1{ Subtract(position[1], position[0]) };
+				const Vector3x4 e2{ Subtract(position[2], position[0]) };
+				const __m128 du1{ _mm_sub_ps(_mm_load_ps(uvs[1][0]), _mm_load_ps(uvs[0][0])) }, dv1{ _mm_sub_ps(_mm_load_ps(uvs[1][1]), _mm_load_ps(uvs[0][1])) };
+				const __m128 du2{ _mm_sub_ps(_mm_load_ps(uvs[2][0]), _mm_load_ps(uvs[0][0])) }, dv2{ _mm_sub_ps(_mm_load_ps(uvs[2][1]), _mm_load_ps(uvs[0][1])) };
+				const __m128 det{ _mm_sub_ps(_mm_mul_ps(du1, dv2), _mm_mul_ps(du2, dv1)) };
+
+				const Vector3x4 uDirection{ _mm_sub_ps(_mm_mul_ps(e1.x, dv2), _mm_mul_ps(e2.x, dv1)), _mm_sub_ps(_mm_mul_ps(e1.y, dv2), _mm_mul_ps(e2.y, dv1)),
+					_mm_sub_ps(_mm_mul_ps(e1.z, dv2), _mm_mul_ps(e2.z, dv1)) };
+				const Vector3x4 vDirection{ _mm_sub_ps(_mm_mul_ps(e2.x, du1), _mm_mul_ps(e1.x, du2)), _mm_sub_ps(_mm_mul_ps(e2.y, du1), _mm_mul_ps(e1.y, du2)),
+					_mm_sub_ps(_mm_mul_ps(e2.z, du1), _mm_mul_ps(e1.z, du2)) };
+
+				//Flipping the sign bit is the same negation the scalar path does
+				const __m128 detSign{ _mm_and_ps(det, _mm_set1_ps(-0.f)) };
+				const Vector3x4 tangent{ Normalize(Vector3x4{ _mm_xor_ps(uDirection.x, detSign), _mm_xor_ps(uDirection.y, detSign), _mm_xor_ps(uDirection.z, detSign) }) };
+
+				const __m128 absDet{ _mm_andnot_ps(_mm_set1_ps(-0.f), det) };
+				const __m128 isValid{ _mm_and_ps(_mm_cmpgt_ps(absDet, _mm_set1_ps(FLT_MIN)), _mm_cmpneq_ps(Dot(tangent, tangent), _mm_setzero_ps())) };
+				const __m128 isPositive{ _mm_cmpgt_ps(Dot(Cross(Cross(e1, e2), uDirection), vDirection), _mm_setzero_ps()) };
+
+				alignas(16) float cornerTangents[3][3][4];
+				for (int corner = 0; corner < 3; ++corner)
+				{
+					const Vector3x4 toNext{ Normalize(ProjectOnPlane(Subtract(position[(corner + 1) % 3], position[corner]), normal[corner])) };
+					const Vector3x4 toPrevious{ Normalize(ProjectOnPlane(Subtract(position[(corner + 2) % 3], position[corner]), normal[corner])) };
+					const __m128 cosAngle{ _mm_min_ps(_mm_max_ps(Dot(toNext, toPrevious), _mm_set1_ps(-1.f)), _mm_set1_ps(1.f)) };
+
+					const Vector3x4 cornerTangent{ Scale(Normalize(ProjectOnPlane(tangent, normal[corner])), _mm_and_ps(AcosApprox(cosAngle), isValid)) };
+					_mm_store_ps(cornerTangents[corner][0], cornerTangent.x);
+					_mm_store_ps(cornerTangents[corner][1], cornerTangent.y);
+					_mm_store_ps(cornerTangents[corner][2], cornerTangent.z);
+				}
+
+				const int validMask{ _mm_movemask_ps(isValid) };
+				const int positiveMask{ _mm_movemask_ps(isPositive) };
+				for (int lane = 0; lane < 4; ++lane)
+				{
+					for (int corner = 0; corner < 3; ++corner)
+						pCornerTangents[lane * 3 + corner] = Vector3{ cornerTangents[corner][0][lane], cornerTangents[corner][1][lane], cornerTangents[corner][2][lane] };
+
+					if (!(validMask & (1 << lane)))
+						pOrientations[lane] = Orientation::Degenerate;
+					else
+						pOrientations[lane] = positiveMask & (1 << lane) ? Orientation::Positive : Orientation::Negative;
+				}
+			}
+#endif
+
+			//Any unit vector perpendicular to the normal
+			Vector3 PerpendicularTangent(const Vector3& normal)
+			{
+				const Vector3 axis{ fabsf(normal.x) < .9f ? Vector3::UnitX : Vector3::UnitY };
+				return Normalize(ProjectOnPlane(axis, Normalize(normal)));
+			}
+		}
+
+		void Generate(std::vector<Vertex>& vertices, std::vector<uint32_t>& indices, size_t numThreads)
+		{
+			const size_t numTriangles{ indices.size() / 3 };
+			const size_t numGroups{ (numTriangles + TrianglesPerGroup - 1) / TrianglesPerGroup };
+			std::vector<Vector3> cornerTangents(numTriangles * 3);
+			std::vector<Orientation> orientations(numTriangles);
+
+			//Fixed groups of four, so a triangle takes the same path whatever the thread count
+			Utils::ParallelFor(numGroups, numThreads, [&](size_t begin, size_t end)
+				{
+					for (size_t group = begin; group < end; ++group)
+					{
+						const size_t firstTriangle{ group * TrianglesPerGroup };
+						const size_t lastTriangle{ std::min(firstTriangle + TrianglesPerGroup, numTriangles) };
+#ifdef DAE_TANGENT_SSE2
+						if (lastTriangle - firstTriangle == TrianglesPerGroup)
+						{
+							ProcessTriangles(vertices, &indices[firstTriangle * 3], &cornerTangents[firstTriangle * 3], &orientations[firstTriangle]);
+							continue;
+						}
+#endif
+						for (size_t triangle = firstTriangle; triangle < lastTriangle; ++triangle)
+						{
+							const uint32_t* pTriangle = &indices[triangle * 3];
+							ProcessTriangle(vertices[pTriangle[0]], vertices[pTriangle[1]], vertices[pTriangle[2]], &cornerTangents[triangle * 3], orientations[triangle]);
+						}
+					}
+				});
+
+			//Vertices used by both orientations get a copy for the negative corners, degenerate corners stay with the original
+			const size_t numSourceVertices{ vertices.size() };
+			std::vector<uint8_t> usedOrientations(numSourceVertices, 0);
+			for (size_t i = 0; i < numTriangles * 3; ++i)
+			{
+				if (orientations[i / 3] != Orientation::Degenerate)
+					usedOrientations[indices[i]] |= orientations[i / 3] == Orientation::Positive ? 1 : 2;
+			}
+
+			constexpr uint32_t noCopy{ UINT32_MAX };
+			std::vector<uint32_t> negativeCopy(numSourceVertices, noCopy);
+			for (size_t vertexIdx = 0; vertexIdx < numSourceVertices; ++vertexIdx)
+			{
+				if (usedOrientations[vertexIdx] == 3)
+				{
+					const Vertex copy{ vertices[vertexIdx] };
+					negativeCopy[vertexIdx] = static_cast<uint32_t>(vertices.size());
+					vertices.push_back(copy);
+				}
+			}
+
+			for (size_t i = 0; i < numTriangles * 3; ++i)
+			{
+				if (orientations[i / 3] == Orientation::Negative && negativeCopy[indices[i]] != noCopy)
+					indices[i] = negativeCopy[indices[i]];
+			}
+
+			//Every vertex adds up its corners in corner order, the threaded path sorts the corners per vertex to keep that order
+			std::vector<Vector3> sums(vertices.size());
+			std::vector<Orientation> vertexOrientations(vertices.size(), Orientation::Degenerate);
+			if (numThreads <= 1)
+			{
+				for (size_t i = 0; i < numTriangles * 3; ++i)
+				{
+					sums[indices[i]] += cornerTangents[i];
+					if (vertexOrientations[indices[i]] == Orientation::Degenerate)
+						vertexOrientations[indices[i]] = orientations[i / 3];
+				}
+			}
+			else
+			{
+				std::vector<uint32_t> firstCorner(vertices.size() + 1, 0);
+				for (size_t i = 0; i < numTriangles * 3; ++i)
+					++firstCorner[indices[i] + 1];
+				for (size_t vertexIdx = 0; vertexIdx < vertices.size(); ++vertexIdx)
+					firstCorner[vertexIdx + 1] += firstCorner[vertexIdx];
+
+				std::vector<uint32_t> vertexCorners(numTriangles * 3);
+				std::vector<uint32_t> fillCursor(firstCorner.begin(), firstCorner.end() - 1);
+				for (size_t i = 0; i < numTriangles * 3; ++i)
+					vertexCorners[fillCursor[indices[i]]++] = static_cast<uint32_t>(i);
+
+				Utils::ParallelFor(vertices.size(), numThreads, [&](size_t begin, size_t end)
+					{
+						for (size_t vertexIdx = begin; vertexIdx < end; ++vertexIdx)
+						{
+							for (uint32_t i = firstCorner[vertexIdx]; i < firstCorner[vertexIdx + 1]; ++i)
+							{
+								sums[vertexIdx] += cornerTangents[vertexCorners[i]];
+								if (vertexOrientations[vertexIdx] == Orientation::Degenerate)
+									vertexOrientations[vertexIdx] = orientations[vertexCorners[i] / 3];
+							}
+						}
+					});
+			}
+
+			//Gram-Schmidt against the vertex normal
+			Utils::ParallelFor(vertices.size(), numThreads, [&](size_t begin, size_t end)
+				{
+					for (size_t vertexIdx = begin; vertexIdx < end; ++vertexIdx)
+					{
+						Vertex& vertex = vertices[vertexIdx];
+						Vector3 tangent{ Normalize(ProjectOnPlane(sums[vertexIdx], Normalize(vertex.normal))) };
+						if (tangent.SqrMagnitude() == 0.f)
+							tangent = PerpendicularTangent(vertex.normal);
+
+						vertex.tangent = Vector4{ tangent, vertexOrientations[vertexIdx] == Orientation::Negative ? -1.f : 1.f };
+					}
+				});
+		}
+	}
+}
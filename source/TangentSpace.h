@@ -0,0 +1,18 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+#include "Vertex.h"
+
+namespace dae
+{
+	//Per-vertex tangent frames following MikkTSpace (Mikkelsen 2008)
+	namespace TangentSpace
+	{
+		//Writes tangent.xyz and the handedness in tangent.w, the bitangent is tangent.w * cross(normal, tangent.xyz).
+		//Every corner contributes its triangle's uv tangent projected onto the vertex normal, weighted by the corner angle.
+		//Vertices shared by mirrored and unmirrored triangles are split, so each side keeps its own frame.
+		//Triangles with degenerate uvs are skipped, a vertex left without a tangent gets one perpendicular to its normal.
+		//Triangles are processed in groups of four on numThreads threads, the result doesn't depend on numThreads.
+		void Generate(std::vector<Vertex>& vertices, std::vector<uint32_t>& indices, size_t numThreads = 1);
+	}
+}
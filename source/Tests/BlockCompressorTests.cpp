@@ -0,0 +1,161 @@
+#include "pch.h"
+
+#include <cmath>
+#include "BlockCompressor.h"
+#include "Check.h"
+#include "PngDecoder.h"
+
+using namespace dae;
+
+//Every block format decodes to within its quality's PSNR floor of the source, on any number of threads
+namespace
+{
+	constexpr size_t NumThreads{ 4 };
+	//Side of the crops from the middle of the textures, enough texels for a stable PSNR
+	constexpr uint32_t CropSize{ 256 };
+
+	struct Case
+	{
+		const char* path;
+		TextureFormat format;
+		CompressionQuality quality;
+		//Measured 2 to 3 dB above these
+		float minPsnr;
+	};
+
+	Image Crop(const Image& image, uint32_t left, uint32_t top, uint32_t width, uint32_t height)
+	{
+		Image crop{ width, height, std::vector<uint8_t>(size_t(width) * height * 4) };
+		for (uint32_t y = 0; y < height; ++y)
+		{
+			const uint8_t* pRow = image.pixels.data() + (size_t(top + y) * image.width + left) * 4;
+			std::copy(pRow, pRow + size_t(width) * 4, crop.pixels.begin() + size_t(y) * width * 4);
+		}
+		return crop;
+	}
+
+	Image LoadCrop(const std::string& path, uint32_t width = CropSize, uint32_t height = CropSize)
+	{
+		Image image{};
+		if (!CHECK(PngDecoder::DecodeFile(path, image) && image.width >= width && image.height >= height))
+			return Image{};
+		return Crop(image, (image.width - width) / 2, (image.height - height) / 2, width, height);
+	}
+
+	//The channels a format stores: BC1 RGB, BC4 red, BC5 red and green, BC7 RGBA
+	uint32_t GetChannelCount(TextureFormat format)
+	{
+		switch (format)
+		{
+		case TextureFormat::BC1:
+			return 3;
+		case TextureFormat::BC4:
+			return 1;
+		case TextureFormat::BC5:
+			return 2;
+		default:
+			return 4;
+		}
+	}
+
+	float GetPsnr(const Image& source, const Image& decoded, uint32_t numChannels)
+	{
+		double sqrError{};
+		for (size_t texel = 0; texel < source.pixels.size() / 4; ++texel)
+		{
+			for (uint32_t channel = 0; channel < numChannels; ++channel)
+			{
+				const double difference{ double(source.pixels[texel * 4 + channel]) - decoded.pixels[texel * 4 + channel] };
+				sqrError += difference * difference;
+			}
+		}
+		const double meanSqrError{ sqrError / (source.pixels.size() / 4 * numChannels) };
+		return meanSqrError == 0. ? 99.f : static_cast<float>(10. * std::log10(255. * 255. / meanSqrError));
+	}
+
+	void TestQuality()
+	{
+		const Case cases[]{
+			{ "Resources/vehicle_diffuse.png", TextureFormat::BC1, CompressionQuality::Fast, 35.f },
+			{ "Resources/vehicle_diffuse.png", TextureFormat::BC1, CompressionQuality::High, 36.f },
+			{ "Resources/vehicle_diffuse.png", TextureFormat::BC7, CompressionQuality::Fast, 44.f },
+			{ "Resources/vehicle_diffuse.png", TextureFormat::BC7, CompressionQuality::High, 46.f },
+			{ "Resources/uv_grid_2.png", TextureFormat::BC1, CompressionQuality::Fast, 34.f },
+			{ "Resources/uv_grid_2.png", TextureFormat::BC7, CompressionQuality::High, 48.f },
+			{ "Resources/fireFX_diffuse.png", TextureFormat::BC7, CompressionQuality::Fast, 47.f },
+			{ "Resources/fireFX_diffuse.png", TextureFormat::BC7, CompressionQuality::High, 47.f },
+			{ "Resources/vehicle_normal.png", TextureFormat::BC5, CompressionQuality::Fast, 43.f },
+			{ "Resources/vehicle_normal.png", TextureFormat::BC5, CompressionQuality::High, 45.f },
+			{ "Resources/vehicle_specular.png", TextureFormat::BC4, CompressionQuality::Fast, 38.f },
+			{ "Resources/vehicle_specular.png", TextureFormat::BC4, CompressionQuality::High, 39.f },
+			{ "Resources/vehicle_gloss.png", TextureFormat::BC4, CompressionQuality::High, 43.f }
+		};
+
+		for (const Case& testCase : cases)
+		{
+			const Image source{ LoadCrop(testCase.path) };
+			const std::vector<uint8_t> blocks{ BlockCompressor::Encode(source, testCase.format, testCase.quality) };
+			Image decoded{};
+			if (!CHECK(BlockCompressor::Decode(blocks.data(), source.width, source.height, testCase.format, decoded)))
+				continue;
+
+			const float psnr{ GetPsnr(source, decoded, GetChannelCount(testCase.format)) };
+			if (!CHECK(psnr >= testCase.minPsnr))
+				std::cout << testCase.path << " in format " << uint32_t(testCase.format) << ", quality " << uint32_t(testCase.quality) << ": " << psnr << " dB\n";
+
+			//High only ever refines what Fast finds
+			if (testCase.quality == CompressionQuality::High)
+			{
+				const std::vector<uint8_t> fastBlocks{ BlockCompressor::Encode(source, testCase.format, CompressionQuality::Fast) };
+				Image fastDecoded{};
+				CHECK(BlockCompressor::Decode(fastBlocks.data(), source.width, source.height, testCase.format, fastDecoded) &&
+					psnr >= GetPsnr(source, fastDecoded, GetChannelCount(testCase.format)));
+			}
+		}
+	}
+
+	void TestPadding()
+	{
+		//Blocks past the edge repeat the last row and column, the texels inside decode as well as whole blocks do
+		const Image source{ LoadCrop("Resources/vehicle_diffuse.png", 250, 130) };
+		CHECK(BlockCompressor::ChooseFormat(source, MipContent::Color, CompressionQuality::High) == TextureFormat::R8G8B8A8);
+		for (const TextureFormat format : { TextureFormat::BC1, TextureFormat::BC7 })
+		{
+			const std::vector<uint8_t> blocks{ BlockCompressor::Encode(source, format, CompressionQuality::High) };
+			CHECK(blocks.size() == size_t(63) * 33 * (format == TextureFormat::BC1 ? 8 : 16));
+			Image decoded{};
+			CHECK(BlockCompressor::Decode(blocks.data(), source.width, source.height, format, decoded) &&
+				GetPsnr(source, decoded, GetChannelCount(format)) >= (format == TextureFormat::BC1 ? 35.f : 45.f));
+		}
+
+		//Uncompressed images stay as they are and don't decode
+		CHECK(BlockCompressor::Encode(source, TextureFormat::R8G8B8A8, CompressionQuality::None) == source.pixels);
+		Image decoded{};
+		CHECK(!BlockCompressor::Decode(source.pixels.data(), source.width, source.height, TextureFormat::R8G8B8A8, decoded));
+	}
+
+	void TestThreadCounts()
+	{
+		const Image color{ LoadCrop("Resources/vehicle_diffuse.png", 512, 512) };
+		const Image normal{ LoadCrop("Resources/vehicle_normal.png", 512, 512) };
+		bool isSame{ true };
+		for (const CompressionQuality quality : { CompressionQuality::Fast, CompressionQuality::High })
+		{
+			for (const TextureFormat format : { TextureFormat::BC1, TextureFormat::BC4, TextureFormat::BC5, TextureFormat::BC7 })
+			{
+				const Image& image = format == TextureFormat::BC5 ? normal : color;
+				isSame = isSame && BlockCompressor::Encode(image, format, quality, 1) == BlockCompressor::Encode(image, format, quality, NumThreads);
+			}
+		}
+		CHECK(isSame);
+	}
+}
+
+int main()
+{
+	return Tests::Run({
+		{ "Quality", TestQuality },
+		{ "Padding", TestPadding },
+		{ "Thread counts", TestThreadCounts }
+	});
+}
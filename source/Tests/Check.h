@@ -0,0 +1,72 @@
+#pragma once
+#include <filesystem>
+#include <fstream>
+#include <initializer_list>
+#include <iostream>
+#include <string>
+
+//Checks for the Linux test executables: every failed check is printed with its line, and main returns non-zero when any failed
+#define CHECK(condition) ::dae::Tests::Check((condition), #condition, __FILE__, __LINE__)
+
+namespace dae
+{
+	namespace Tests
+	{
+		struct Test
+		{
+			const char* name;
+			void (*pFunction)();
+		};
+
+		inline int& GetFailureCount()
+		{
+			static int failureCount{};
+			return failureCount;
+		}
+
+		inline bool Check(bool condition, const char* expression, const char* file, int line)
+		{
+			if (!condition)
+			{
+				std::cout << file << ":" << line << ": check failed: " << expression << "\n";
+				++GetFailureCount();
+			}
+			return condition;
+		}
+
+		//Scratch directory for files a test writes, emptied on first use. Sources under Resources are copied there first,
+		//so cooking never writes next to them.
+		inline std::filesystem::path GetTempDirectory()
+		{
+			static const std::filesystem::path directory{ []()
+				{
+					const std::filesystem::path path{ std::filesystem::temp_directory_path() / "dae_tests" };
+					std::error_code error{};
+					std::filesystem::remove_all(path, error);
+					std::filesystem::create_directories(path, error);
+					return path;
+				}() };
+			return directory;
+		}
+
+		//Writes text to a file in the scratch directory and returns its path
+		inline std::string WriteTempFile(const std::string& name, const std::string& text)
+		{
+			const std::filesystem::path path{ GetTempDirectory() / name };
+			std::ofstream{ path, std::ios::binary | std::ios::trunc } << text;
+			return path.string();
+		}
+
+		//Runs every test in order and returns what main should
+		inline int Run(std::initializer_list<Test> tests)
+		{
+			for (const Test& test : tests)
+			{
+				const int failuresBefore{ GetFailureCount() };
+				test.pFunction();
+				std::cout << test.name << (GetFailureCount() == failuresBefore ? ": passed\n" : ": FAILED\n");
+			}
+			return GetFailureCount() == 0 ? 0 : 1;
+		}
+	}
+}
@@ -0,0 +1,184 @@
+#include "pch.h"
+
+#include <algorithm>
+#include "Check.h"
+#include "HalfEdgeMesh.h"
+#include "TestMeshes.h"
+
+using namespace dae;
+
+//Twins pair the two halves of every manifold edge, fans walk every half-edge around a position, and seams don't cut the connectivity
+namespace
+{
+	constexpr size_t NumThreads{ 4 };
+
+	bool IsPaired(const HalfEdgeMesh& mesh)
+	{
+		bool isPaired{ true };
+		for (uint32_t halfEdge = 0; halfEdge < mesh.GetHalfEdgeCount(); ++halfEdge)
+		{
+			if (mesh.IsBorder(halfEdge))
+				continue;
+
+			const uint32_t twin{ mesh.GetTwin(halfEdge) };
+			isPaired = isPaired && twin != halfEdge && mesh.GetTwin(twin) == halfEdge && mesh.GetOrigin(twin) == mesh.GetTarget(halfEdge) &&
+				mesh.GetTarget(twin) == mesh.GetOrigin(halfEdge) && HalfEdgeMesh::GetFace(twin) != HalfEdgeMesh::GetFace(halfEdge);
+		}
+		return isPaired;
+	}
+
+	//Every position's fan visits exactly the half-edges leaving it, each once
+	bool IsEveryFanComplete(const HalfEdgeMesh& mesh)
+	{
+		std::vector<std::vector<uint32_t>> expected(mesh.GetPositionCount());
+		for (uint32_t halfEdge = 0; halfEdge < mesh.GetHalfEdgeCount(); ++halfEdge)
+			expected[mesh.GetOrigin(halfEdge)].push_back(halfEdge);
+
+		bool isComplete{ true };
+		for (uint32_t position = 0; position < mesh.GetPositionCount(); ++position)
+		{
+			std::vector<uint32_t> visited{};
+			mesh.ForEachOutgoing(position, [&](uint32_t halfEdge) { visited.push_back(halfEdge); });
+			std::sort(visited.begin(), visited.end());
+			isComplete = isComplete && visited == expected[position];
+		}
+		return isComplete;
+	}
+
+	void TestTwins()
+	{
+		//A grid has a border all around, a sphere none
+		constexpr uint32_t numQuads{ 8 };
+		std::vector<Vertex> vertices{};
+		std::vector<uint32_t> indices{};
+		Tests::CreateGrid(numQuads, vertices, indices);
+		const HalfEdgeMesh grid{ vertices, indices };
+		CHECK(grid.GetHalfEdgeCount() == indices.size() && grid.GetPositionCount() == vertices.size());
+		CHECK(grid.GetBorderCount() == 4 * numQuads && grid.GetNonManifoldCount() == 0);
+		CHECK(IsPaired(grid));
+
+		//Border half-edges run along the outline
+		bool isOnOutline{ true };
+		for (uint32_t halfEdge = 0; halfEdge < grid.GetHalfEdgeCount(); ++halfEdge)
+		{
+			const Vector3& origin = vertices[indices[halfEdge]].position;
+			const Vector3& target = vertices[indices[HalfEdgeMesh::GetNext(halfEdge)]].position;
+			const bool isOutline{ (origin.x == target.x && (origin.x == 0.f || origin.x == numQuads)) || (origin.z == target.z && (origin.z == 0.f || origin.z == numQuads)) };
+			isOnOutline = isOnOutline && grid.IsBorder(halfEdge) == isOutline;
+		}
+		CHECK(isOnOutline);
+
+		Tests::CreateSphere(8, vertices, indices);
+		const HalfEdgeMesh sphere{ vertices, indices };
+		CHECK(sphere.GetBorderCount() == 0 && sphere.GetNonManifoldCount() == 0 && IsPaired(sphere));
+	}
+
+	void TestFans()
+	{
+		std::vector<Vertex> vertices{};
+		std::vector<uint32_t> indices{};
+		Tests::CreateGrid(6, vertices, indices);
+		const HalfEdgeMesh grid{ vertices, indices };
+		CHECK(IsEveryFanComplete(grid));
+
+		//Positions on the border start their fan at the border
+		bool isBorderFirst{ true };
+		for (uint32_t position = 0; position < grid.GetPositionCount(); ++position)
+		{
+			const Vector3& point = vertices[position].position;
+			const bool isOnBorder{ point.x == 0.f || point.z == 0.f || point.x == 6.f || point.z == 6.f };
+			isBorderFirst = isBorderFirst && grid.IsBorder(grid.GetOutgoing(position)) == isOnBorder;
+		}
+		CHECK(isBorderFirst);
+
+		Tests::CreateSphere(8, vertices, indices);
+		CHECK(IsEveryFanComplete(HalfEdgeMesh{ vertices, indices }));
+	}
+
+	void TestSeams()
+	{
+		//The halves of the seam grid share positions but not vertices, they're still twins, and the seam is exactly the middle column
+		constexpr uint32_t numQuads{ 8 };
+		std::vector<Vertex> vertices{};
+		std::vector<uint32_t> indices{};
+		Tests::CreateSeamGrid(numQuads, vertices, indices);
+		const HalfEdgeMesh mesh{ vertices, indices };
+		CHECK(mesh.GetPositionCount() == (numQuads + 1) * (numQuads + 1) && mesh.GetBorderCount() == 4 * numQuads && IsPaired(mesh));
+
+		bool isSeamInTheMiddle{ true };
+		uint32_t numSeams{};
+		for (uint32_t halfEdge = 0; halfEdge < mesh.GetHalfEdgeCount(); ++halfEdge)
+		{
+			const float originX{ vertices[indices[halfEdge]].position.x };
+			const float targetX{ vertices[indices[HalfEdgeMesh::GetNext(halfEdge)]].position.x };
+			const bool isMiddle{ originX == numQuads / 2 && targetX == numQuads / 2 && !mesh.IsBorder(halfEdge) };
+			isSeamInTheMiddle = isSeamInTheMiddle && mesh.IsSeam(halfEdge) == isMiddle;
+			numSeams += mesh.IsSeam(halfEdge);
+		}
+		CHECK(isSeamInTheMiddle && numSeams == 2 * numQuads);
+
+		//Welded, the same grid has no seam
+		Tests::CreateGrid(numQuads, vertices, indices);
+		const HalfEdgeMesh welded{ vertices, indices };
+		bool hasSeam{ false };
+		for (uint32_t halfEdge = 0; halfEdge < welded.GetHalfEdgeCount(); ++halfEdge)
+			hasSeam = hasSeam || welded.IsSeam(halfEdge);
+		CHECK(!hasSeam);
+	}
+
+	void TestNonManifold()
+	{
+		//Three triangles on one edge: a fin. None of its three half-edges gets a twin, every other edge is a border.
+		std::vector<Vertex> vertices(5);
+		vertices[1].position = Vector3::UnitX;
+		vertices[2].position = Vector3::UnitY;
+		vertices[3].position = Vector3::UnitZ;
+		vertices[4].position = -Vector3::UnitY;
+		const std::vector<uint32_t> fin{ 0, 1, 2, 1, 0, 3, 0, 1, 4 };
+		const HalfEdgeMesh finMesh{ vertices, fin };
+		CHECK(finMesh.GetNonManifoldCount() == 3 && finMesh.GetBorderCount() == 6);
+		CHECK(finMesh.IsBorder(0) && finMesh.IsBorder(3) && finMesh.IsBorder(6));
+
+		//Two triangles wound the same way over their shared edge aren't twins either
+		const std::vector<uint32_t> flipped{ 0, 1, 2, 0, 1, 4 };
+		const HalfEdgeMesh flippedMesh{ vertices, flipped };
+		CHECK(flippedMesh.GetNonManifoldCount() == 2 && flippedMesh.GetBorderCount() == 4 && flippedMesh.IsBorder(0) && flippedMesh.IsBorder(3));
+
+		//Wound the other way they are
+		const std::vector<uint32_t> folded{ 0, 1, 2, 1, 0, 4 };
+		const HalfEdgeMesh foldedMesh{ vertices, folded };
+		CHECK(foldedMesh.GetNonManifoldCount() == 0 && foldedMesh.GetTwin(0) == 3 && IsPaired(foldedMesh));
+	}
+
+	void TestThreadCounts()
+	{
+		std::vector<Vertex> vertices{};
+		std::vector<uint32_t> indices{};
+		CHECK(Tests::LoadVehicle(vertices, indices));
+		const HalfEdgeMesh serial{ vertices, indices, 1 };
+		CHECK(IsPaired(serial));
+
+		for (const size_t numThreads : { size_t{ 2 }, NumThreads })
+		{
+			const HalfEdgeMesh parallel{ vertices, indices, numThreads };
+			bool isSame{ parallel.GetHalfEdgeCount() == serial.GetHalfEdgeCount() && parallel.GetPositionCount() == serial.GetPositionCount() &&
+				parallel.GetBorderCount() == serial.GetBorderCount() && parallel.GetNonManifoldCount() == serial.GetNonManifoldCount() };
+			for (uint32_t halfEdge = 0; halfEdge < serial.GetHalfEdgeCount() && isSame; ++halfEdge)
+				isSame = parallel.GetTwin(halfEdge) == serial.GetTwin(halfEdge) && parallel.GetOrigin(halfEdge) == serial.GetOrigin(halfEdge);
+			for (uint32_t position = 0; position < serial.GetPositionCount() && isSame; ++position)
+				isSame = parallel.GetOutgoing(position) == serial.GetOutgoing(position);
+			CHECK(isSame);
+		}
+	}
+}
+
+int main()
+{
+	return Tests::Run({
+		{ "Twins", TestTwins },
+		{ "Fans", TestFans },
+		{ "Seams", TestSeams },
+		{ "Non-manifold", TestNonManifold },
+		{ "Thread counts", TestThreadCounts }
+	});
+}
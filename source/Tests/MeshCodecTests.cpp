@@ -0,0 +1,181 @@
+#include "pch.h"
+
+#include <cstring>
+#include <random>
+#include "Check.h"
+#include "MeshCodec.h"
+#include "MeshSplitter.h"
+#include "TestMeshes.h"
+#include "VertexLayout.h"
+
+using namespace dae;
+
+//The cooked mesh codec: exact round trips for every layout, stride and index width, on any thread count, and no pass for damaged data
+namespace
+{
+	constexpr size_t NumThreads{ 4 };
+
+	bool RoundTripVertices(const void* pVertices, size_t count, size_t stride, std::vector<uint8_t>* pEncoded = nullptr)
+	{
+		const std::vector<uint8_t> encoded{ MeshCodec::EncodeVertices(pVertices, count, stride) };
+		bool isSame{ true };
+		for (const size_t numThreads : { size_t{ 1 }, NumThreads })
+		{
+			std::vector<uint8_t> decoded(count * stride + 1, 0xCD);
+			isSame = isSame && MeshCodec::DecodeVertices(decoded.data(), count, stride, encoded.data(), encoded.size(), numThreads) &&
+				(count == 0 || std::memcmp(decoded.data(), pVertices, count * stride) == 0) && decoded.back() == 0xCD;
+		}
+		if (pEncoded)
+			*pEncoded = encoded;
+		return isSame;
+	}
+
+	template<typename Index>
+	bool RoundTripIndices(const std::vector<Index>& indices, std::vector<uint8_t>* pEncoded = nullptr)
+	{
+		const std::vector<uint8_t> encoded{ MeshCodec::EncodeIndices(indices.data(), indices.size(), sizeof(Index)) };
+		bool isSame{ true };
+		for (const size_t numThreads : { size_t{ 1 }, NumThreads })
+		{
+			std::vector<Index> decoded(indices.size());
+			isSame = isSame && MeshCodec::DecodeIndices(decoded.data(), decoded.size(), sizeof(Index), encoded.data(), encoded.size(), numThreads) && decoded == indices;
+		}
+		if (pEncoded)
+			*pEncoded = encoded;
+		return isSame;
+	}
+
+	void TestVertices()
+	{
+		std::vector<Vertex> vertices{};
+		std::vector<uint32_t> indices{};
+		CHECK(Tests::LoadVehicle(vertices, indices));
+
+		//The layouts the cooker writes, the vertex deltas make them smaller than they are
+		for (const VertexLayout layout : { VertexLayout::Full, VertexLayout::Compact, VertexLayout::CompactQuantized })
+		{
+			const EncodedVertices layoutVertices{ VertexCodec::Encode(vertices, layout) };
+			std::vector<uint8_t> encoded{};
+			CHECK(RoundTripVertices(layoutVertices.data.data(), layoutVertices.count, layoutVertices.stride, &encoded));
+			CHECK(encoded.size() < layoutVertices.data.size());
+		}
+
+		//Odd strides, random bytes and counts around the block size
+		std::mt19937 generator{ 11 };
+		for (const size_t stride : { 1, 3, 7, 13, 64 })
+		{
+			for (const size_t count : { 0, 1, 15, 17, 255, 256, 257, 1000 })
+			{
+				std::vector<uint8_t> bytes(count * stride);
+				for (uint8_t& byte : bytes)
+					byte = static_cast<uint8_t>(generator() % 4 == 0 ? generator() : byte);
+				CHECK(RoundTripVertices(bytes.data(), count, stride));
+			}
+		}
+	}
+
+	void TestIndices()
+	{
+		std::vector<Vertex> vertices{};
+		std::vector<uint32_t> indices{};
+		CHECK(Tests::LoadVehicle(vertices, indices));
+
+		//Mesh order, the predictions make it a fraction of its size
+		std::vector<uint8_t> encoded{};
+		CHECK(RoundTripIndices(indices, &encoded));
+		CHECK(encoded.size() < indices.size() * sizeof(uint32_t) / 4);
+
+		//The 16 bit ranges a split grid is drawn with
+		std::vector<Vertex> gridVertices{};
+		std::vector<uint32_t> gridIndices{};
+		Tests::CreateGrid(300, gridVertices, gridIndices);
+		const EncodedIndices shortIndices{ MeshSplitter::EncodeShortIndices(gridVertices, gridIndices) };
+		const uint16_t* pShortIndices = reinterpret_cast<const uint16_t*>(shortIndices.data.data());
+		CHECK(shortIndices.stride == sizeof(uint16_t) && RoundTripIndices(std::vector<uint16_t>(pShortIndices, pShortIndices + shortIndices.count)));
+
+		//No shared edges, indices anywhere in their range, and leftovers that don't make a triangle
+		std::mt19937 generator{ 5 };
+		for (const size_t count : { 0, 1, 2, 3, 4, 3 * 4096 - 1, 3 * 4096 + 2, 50'000 })
+		{
+			std::vector<uint32_t> wide(count);
+			std::vector<uint16_t> narrow(count);
+			for (size_t i = 0; i < count; ++i)
+			{
+				wide[i] = generator() >> (generator() % 32);
+				narrow[i] = static_cast<uint16_t>(wide[i]);
+			}
+			CHECK(RoundTripIndices(wide));
+			CHECK(RoundTripIndices(narrow));
+		}
+	}
+
+	void TestMalformed()
+	{
+		std::vector<Vertex> vertices{};
+		std::vector<uint32_t> indices{};
+		CHECK(Tests::LoadVehicle(vertices, indices));
+		vertices.resize(1000);
+		indices.resize(3 * 4096 * 2 + 300);
+		const EncodedVertices layoutVertices{ VertexCodec::Encode(vertices, VertexLayout::CompactQuantized) };
+		const std::vector<uint8_t> vertexData{ MeshCodec::EncodeVertices(layoutVertices.data.data(), layoutVertices.count, layoutVertices.stride) };
+		const std::vector<uint8_t> indexData{ MeshCodec::EncodeIndices(indices.data(), indices.size(), sizeof(uint32_t)) };
+
+		std::vector<uint8_t> decodedVertices(layoutVertices.data.size());
+		std::vector<uint32_t> decodedIndices(indices.size());
+		const auto decodeVertices = [&](const std::vector<uint8_t>& data, size_t count)
+			{
+				return MeshCodec::DecodeVertices(decodedVertices.data(), count, layoutVertices.stride, data.data(), data.size(), NumThreads);
+			};
+		const auto decodeIndices = [&](const std::vector<uint8_t>& data, size_t count, uint32_t stride)
+			{
+				return MeshCodec::DecodeIndices(decodedIndices.data(), count, stride, data.data(), data.size(), NumThreads);
+			};
+
+		//Every truncation and a trailing byte
+		bool isTruncationRejected{ true };
+		for (size_t size = 0; size < vertexData.size(); ++size)
+			isTruncationRejected = isTruncationRejected && !decodeVertices(std::vector<uint8_t>(vertexData.begin(), vertexData.begin() + size), layoutVertices.count);
+		for (size_t size = 0; size < indexData.size(); ++size)
+			isTruncationRejected = isTruncationRejected && !decodeIndices(std::vector<uint8_t>(indexData.begin(), indexData.begin() + size), indices.size(), sizeof(uint32_t));
+		CHECK(isTruncationRejected);
+
+		std::vector<uint8_t> longer{ vertexData };
+		longer.push_back(0);
+		CHECK(!decodeVertices(longer, layoutVertices.count));
+		longer = indexData;
+		longer.push_back(0);
+		CHECK(!decodeIndices(longer, indices.size(), sizeof(uint32_t)));
+
+		//Another count or index width than the data was written with
+		CHECK(!decodeVertices(vertexData, layoutVertices.count + MeshCodec::VertexBlockSize));
+		CHECK(!decodeIndices(indexData, indices.size() - 3 * 4096, sizeof(uint32_t)));
+		CHECK(!decodeIndices(indexData, indices.size(), 3));
+
+		//32 bit indices past 16 bits don't decode as 16 bit ones
+		std::vector<uint32_t> largeIndices(indices);
+		for (uint32_t& index : largeIndices)
+			index += 70'000;
+		CHECK(!decodeIndices(MeshCodec::EncodeIndices(largeIndices.data(), largeIndices.size(), sizeof(uint32_t)), largeIndices.size(), sizeof(uint16_t)));
+
+		//Damaged bytes either fail or decode to something, they never read or write past the buffers
+		std::mt19937 generator{ 17 };
+		size_t numDecoded{};
+		for (int attempt = 0; attempt < 2000; ++attempt)
+		{
+			std::vector<uint8_t> damaged{ attempt % 2 ? vertexData : indexData };
+			for (int flip = 0; flip < 1 + attempt % 4; ++flip)
+				damaged[generator() % damaged.size()] ^= static_cast<uint8_t>(1u << (generator() % 8));
+			numDecoded += attempt % 2 ? decodeVertices(damaged, layoutVertices.count) : decodeIndices(damaged, indices.size(), sizeof(uint32_t));
+		}
+		CHECK(numDecoded < 2000);
+	}
+}
+
+int main()
+{
+	return Tests::Run({
+		{ "Vertices", TestVertices },
+		{ "Indices", TestIndices },
+		{ "Malformed", TestMalformed }
+	});
+}
@@ -0,0 +1,177 @@
+#include "pch.h"
+
+#include <cstddef>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <sstream>
+#include "Check.h"
+#include "CookedMesh.h"
+#include "MeshCooker.h"
+#include "TestMeshes.h"
+#include "VertexLightBaker.h"
+
+using namespace dae;
+
+//Baked vertex light is occlusion and Lambert, cooked meshes remember the light baked into them, a cook with another light or sample count isn't up to date, and damaged headers don't load
+namespace
+{
+	const std::string QuadObj{
+		"v 0 0 0\nv 1 0 0\nv 1 0 1\nv 0 0 1\n"
+		"vt 0 0\nvt 1 0\nvt 1 1\nvt 0 1\n"
+		"vn 0 1 0\n"
+		"f 1/1/1 2/2/1 3/3/1\nf 1/1/1 3/3/1 4/4/1\n" };
+
+	bool Cook(const std::string& objPath, VertexLayout layout, const Vector3* pLightDirection, uint32_t numLightSamples)
+	{
+		CookedMeshData data{};
+		std::ostringstream log{};
+		return MeshCooker::CookObj(objPath, layout, true, pLightDirection, numLightSamples, 1, data, log);
+	}
+
+	void TestBakedLight()
+	{
+		const std::string objPath{ Tests::WriteTempFile("baked_quad.obj", QuadObj) };
+		const Vector3 lightDirection{ Vector3{ .577f, -.577f, .577f }.Normalized() };
+		const Vector3 otherDirection{ -Vector3::UnitY };
+
+		CHECK(Cook(objPath, VertexLayout::Full, &lightDirection, 8));
+		const CookedMesh cookedMesh{ CookedMesh::GetCookedPath(objPath) };
+		CHECK(cookedMesh.IsValid() && cookedMesh.IsBakedWith(lightDirection, 8) && !cookedMesh.IsBakedWith(Vector3{}, 0));
+
+		CHECK(MeshCooker::IsUpToDate(objPath, VertexLayout::Full, true, &lightDirection, 8));
+		CHECK(!MeshCooker::IsUpToDate(objPath, VertexLayout::Full, true, &lightDirection, 16));
+		CHECK(!MeshCooker::IsUpToDate(objPath, VertexLayout::Full, true, &otherDirection, 8));
+		CHECK(!MeshCooker::IsUpToDate(objPath, VertexLayout::Full, true, nullptr, 8));
+		CHECK(!MeshCooker::IsUpToDate(objPath, VertexLayout::Full, true));
+
+		//Occlusion only, no light
+		CHECK(Cook(objPath, VertexLayout::Full, nullptr, 8));
+		CHECK(MeshCooker::IsUpToDate(objPath, VertexLayout::Full, true, nullptr, 8));
+		CHECK(!MeshCooker::IsUpToDate(objPath, VertexLayout::Full, true, &lightDirection, 8));
+
+		//Compact layouts drop the color, nothing gets baked whatever the settings
+		CHECK(Cook(objPath, VertexLayout::CompactQuantized, &lightDirection, 8));
+		CHECK(MeshCooker::IsUpToDate(objPath, VertexLayout::CompactQuantized, true));
+		CHECK(MeshCooker::IsUpToDate(objPath, VertexLayout::CompactQuantized, true, &otherDirection, 4));
+		const CookedMesh compactMesh{ CookedMesh::GetCookedPath(objPath) };
+		CHECK(compactMesh.IsValid() && compactMesh.IsBakedWith(Vector3{}, 0));
+	}
+
+	//Quad in the xz plane facing up, offset by center and scaled by size
+	void AddQuad(const Vector3& center, float size, std::vector<Vertex>& vertices, std::vector<uint32_t>& indices)
+	{
+		const uint32_t first{ static_cast<uint32_t>(vertices.size()) };
+		for (const Vector2 corner : { Vector2{ -1.f, -1.f }, Vector2{ -1.f, 1.f }, Vector2{ 1.f, 1.f }, Vector2{ 1.f, -1.f } })
+		{
+			Vertex vertex{};
+			vertex.position = center + Vector3{ corner.x, 0.f, corner.y } * size;
+			vertex.normal = Vector3::UnitY;
+			vertices.push_back(vertex);
+		}
+		indices.insert(indices.end(), { first, first + 1, first + 2, first, first + 2, first + 3 });
+	}
+
+	void TestBakedValues()
+	{
+		const Vector3 lightDirection{ Vector3{ .577f, -.577f, .577f }.Normalized() };
+
+		//Nothing above an open quad: every ray escapes, the light falls in at its Lambert term
+		std::vector<Vertex> vertices{};
+		std::vector<uint32_t> indices{};
+		AddQuad(Vector3::Zero, 1.f, vertices, indices);
+		VertexLightBaker::Bake(vertices, indices, &lightDirection, 32);
+		bool isLit{ true };
+		for (const Vertex& vertex : vertices)
+			isLit = isLit && vertex.color.r == 1.f && std::abs(vertex.color.g - Vector3::Dot(Vector3::UnitY, -lightDirection)) < 1e-6f && vertex.color.b == 0.f;
+		CHECK(isLit);
+
+		//Without a light only the occlusion is baked, the light term stays one
+		VertexLightBaker::Bake(vertices, indices, nullptr, 32);
+		bool isUnlit{ true };
+		for (const Vertex& vertex : vertices)
+			isUnlit = isUnlit && vertex.color.r == 1.f && vertex.color.g == 1.f;
+		CHECK(isUnlit);
+
+		//A small quad inside a closed shell, a coarse sphere: every ray hits the shell and so does the light.
+		//A far away quad stretches the bounds, so the occlusion range reaches all of the shell.
+		std::vector<Vertex> shellVertices{};
+		std::vector<uint32_t> shellIndices{};
+		Tests::CreateSphere(4, shellVertices, shellIndices);
+		for (Vertex& vertex : shellVertices)
+			vertex.position = vertex.position * 2.f;
+		const size_t numShellVertices{ shellVertices.size() };
+		AddQuad(Vector3::Zero, .1f, shellVertices, shellIndices);
+		AddQuad(Vector3{ 100.f, 100.f, 100.f }, .1f, shellVertices, shellIndices);
+		VertexLightBaker::Bake(shellVertices, shellIndices, &lightDirection, 32);
+		bool isDark{ true };
+		for (size_t vertexIdx = numShellVertices; vertexIdx < numShellVertices + 4; ++vertexIdx)
+			isDark = isDark && shellVertices[vertexIdx].color.r == 0.f && shellVertices[vertexIdx].color.g == 0.f;
+		CHECK(isDark);
+
+		//Same seed, same colors on any thread count, another seed moves the samples
+		std::vector<Vertex> vehicleVertices{};
+		std::vector<uint32_t> vehicleIndices{};
+		CHECK(Tests::LoadVehicle(vehicleVertices, vehicleIndices));
+		std::vector<Vertex> serial{ vehicleVertices };
+		VertexLightBaker::Bake(serial, vehicleIndices, &lightDirection, 8, 3, 1);
+		bool isSame{ true };
+		for (const size_t numThreads : { size_t{ 2 }, size_t{ 4 } })
+		{
+			std::vector<Vertex> parallel{ vehicleVertices };
+			VertexLightBaker::Bake(parallel, vehicleIndices, &lightDirection, 8, 3, numThreads);
+			for (size_t vertexIdx = 0; vertexIdx < serial.size() && isSame; ++vertexIdx)
+				isSame = parallel[vertexIdx].color.r == serial[vertexIdx].color.r && parallel[vertexIdx].color.g == serial[vertexIdx].color.g;
+		}
+		CHECK(isSame);
+
+		std::vector<Vertex> reseeded{ vehicleVertices };
+		VertexLightBaker::Bake(reseeded, vehicleIndices, &lightDirection, 8, 4, 1);
+		bool isReseeded{ false };
+		for (size_t vertexIdx = 0; vertexIdx < serial.size(); ++vertexIdx)
+			isReseeded = isReseeded || reseeded[vertexIdx].color.r != serial[vertexIdx].color.r;
+		CHECK(isReseeded);
+	}
+
+	void TestDamagedHeader()
+	{
+		const std::string objPath{ Tests::WriteTempFile("damaged_quad.obj", QuadObj) };
+		CHECK(Cook(objPath, VertexLayout::CompactQuantized, nullptr, 0));
+		std::ifstream file{ CookedMesh::GetCookedPath(objPath), std::ios::binary };
+		const std::string cooked{ std::istreambuf_iterator<char>{ file }, std::istreambuf_iterator<char>{} };
+		CHECK(cooked.size() > sizeof(CookedMesh::Header) && CookedMesh{ CookedMesh::GetCookedPath(objPath) }.IsValid());
+
+		//Offsets just below 2^64, still aligned: added to their block's size they wrap around to somewhere inside the file
+		const size_t offsetFields[]{ offsetof(CookedMesh::Header, vertexOffset), offsetof(CookedMesh::Header, indexOffset), offsetof(CookedMesh::Header, rangeOffset),
+			offsetof(CookedMesh::Header, lodOffset), offsetof(CookedMesh::Header, meshletOffset), offsetof(CookedMesh::Header, rangeSubmeshOffset),
+			offsetof(CookedMesh::Header, materialNamesOffset) };
+		bool isRejected{ true };
+		for (const size_t field : offsetFields)
+		{
+			std::string damaged{ cooked };
+			const uint64_t offset{ ~uint64_t{ 15 } };
+			std::memcpy(damaged.data() + field, &offset, sizeof(offset));
+			const std::string damagedPath{ Tests::WriteTempFile("damaged_quad.mesh", damaged) };
+			isRejected = isRejected && !CookedMesh{ damagedPath }.IsValid();
+		}
+
+		//Sizes that wrap around the same way
+		for (const size_t field : { offsetof(CookedMesh::Header, vertexDataSize), offsetof(CookedMesh::Header, indexDataSize) })
+		{
+			std::string damaged{ cooked };
+			const uint64_t size{ ~uint64_t{ 0 } };
+			std::memcpy(damaged.data() + field, &size, sizeof(size));
+			isRejected = isRejected && !CookedMesh{ Tests::WriteTempFile("damaged_quad.mesh", damaged) }.IsValid();
+		}
+		CHECK(isRejected);
+	}
+}
+
+int main()
+{
+	return Tests::Run({
+		{ "Baked light", TestBakedLight },
+		{ "Baked values", TestBakedValues },
+		{ "Damaged header", TestDamagedHeader }
+	});
+}
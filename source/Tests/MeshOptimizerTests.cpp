@@ -0,0 +1,98 @@
+#include "pch.h"
+
+#include "Check.h"
+#include "MeshOptimizer.h"
+#include "TestMeshes.h"
+
+using namespace dae;
+
+//The vertex cache simulation, and the triangle and vertex order passes measured with it
+namespace
+{
+	void TestCacheSimulation()
+	{
+		//Cache of 3, worked by hand. FIFO: 3 misses, then 3, then 0, 1 and 2 all miss again. LRU keeps 1, hit by the second triangle.
+		const std::vector<uint32_t> indices{ 0, 1, 2, 2, 1, 3, 0, 1, 2 };
+		const MeshOptimizer::CacheStats fifo{ MeshOptimizer::AnalyzeVertexCache(indices, 4, 3, MeshOptimizer::CacheModel::Fifo) };
+		const MeshOptimizer::CacheStats lru{ MeshOptimizer::AnalyzeVertexCache(indices, 4, 3, MeshOptimizer::CacheModel::Lru) };
+		CHECK(fifo.acmr == 7.f / 3.f && fifo.atvr == 7.f / 4.f);
+		CHECK(lru.acmr == 6.f / 3.f && lru.atvr == 6.f / 4.f);
+
+		//A cache as large as the mesh only misses every vertex once
+		const MeshOptimizer::CacheStats large{ MeshOptimizer::AnalyzeVertexCache(indices, 4, 16) };
+		CHECK(large.atvr == 1.f);
+	}
+
+	void TestVertexCache()
+	{
+		std::vector<Vertex> vehicleVertices{};
+		std::vector<uint32_t> vehicleIndices{};
+		CHECK(Tests::LoadVehicle(vehicleVertices, vehicleIndices));
+		std::vector<Vertex> gridVertices{};
+		std::vector<uint32_t> gridIndices{};
+		Tests::CreateGrid(64, gridVertices, gridIndices);
+
+		//The parsed order, and a grid row by row, both well above what the cache allows. Upper bounds leave some slack over today's numbers.
+		const struct
+		{
+			std::vector<Vertex>& vertices;
+			std::vector<uint32_t>& indices;
+			float maxAcmr;
+		} meshes[]{ { vehicleVertices, vehicleIndices, 1.2f }, { gridVertices, gridIndices, .8f } };
+		for (const auto& mesh : meshes)
+		{
+			const std::vector<std::array<float, 9>> triangles{ Tests::GetTriangleSet(mesh.vertices, mesh.indices) };
+			for (const MeshOptimizer::CacheModel model : { MeshOptimizer::CacheModel::Fifo, MeshOptimizer::CacheModel::Lru })
+			{
+				const MeshOptimizer::CacheStats before{ MeshOptimizer::AnalyzeVertexCache(mesh.indices, mesh.vertices.size(), MeshOptimizer::DefaultCacheSize, model) };
+				std::vector<uint32_t> indices{ mesh.indices };
+				MeshOptimizer::OptimizeVertexCache(indices, mesh.vertices.size());
+				const MeshOptimizer::CacheStats after{ MeshOptimizer::AnalyzeVertexCache(indices, mesh.vertices.size(), MeshOptimizer::DefaultCacheSize, model) };
+				CHECK(after.acmr < before.acmr && after.acmr < mesh.maxAcmr);
+				CHECK(Tests::GetTriangleSet(mesh.vertices, indices) == triangles);
+			}
+		}
+	}
+
+	void TestVertexFetch()
+	{
+		std::vector<Vertex> vertices{};
+		std::vector<uint32_t> indices{};
+		CHECK(Tests::LoadVehicle(vertices, indices));
+		MeshOptimizer::OptimizeVertexCache(indices, vertices.size());
+
+		//A vertex nothing uses gets dropped
+		vertices.push_back(Vertex{ Vector3{ 1e6f, 0.f, 0.f } });
+		const std::vector<Vertex> originalVertices{ vertices };
+		const std::vector<uint32_t> originalIndices{ indices };
+		MeshOptimizer::OptimizeVertexFetch(vertices, indices);
+		CHECK(vertices.size() == originalVertices.size() - 1);
+
+		//Vertices are numbered in the order the triangles first use them, every corner keeps its attributes
+		uint32_t nextVertex{};
+		bool isFirstUseOrder{ true };
+		bool isSameCorner{ true };
+		for (size_t index = 0; index < indices.size(); ++index)
+		{
+			if (indices[index] == nextVertex)
+				++nextVertex;
+			else
+				isFirstUseOrder = isFirstUseOrder && indices[index] < nextVertex;
+
+			const Vertex& vertex = vertices[indices[index]];
+			const Vertex& original = originalVertices[originalIndices[index]];
+			isSameCorner = isSameCorner && std::memcmp(&vertex, &original, sizeof(Vertex)) == 0;
+		}
+		CHECK(isFirstUseOrder && nextVertex == vertices.size());
+		CHECK(isSameCorner);
+	}
+}
+
+int main()
+{
+	return Tests::Run({
+		{ "Cache simulation", TestCacheSimulation },
+		{ "Vertex cache", TestVertexCache },
+		{ "Vertex fetch", TestVertexFetch }
+	});
+}
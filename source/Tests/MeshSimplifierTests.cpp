@@ -0,0 +1,149 @@
+#include "pch.h"
+
+#include <cmath>
+#include "Check.h"
+#include "MeshSimplifier.h"
+#include "TestMeshes.h"
+
+using namespace dae;
+
+//Levels of detail shrink to their ratios without moving borders or seams, and get picked coarser the further away the mesh is
+namespace
+{
+	float GetArea(const std::vector<Vertex>& vertices, const uint32_t* pCorners)
+	{
+		const Vector3& p0 = vertices[pCorners[0]].position;
+		return Vector3::Cross(vertices[pCorners[1]].position - p0, vertices[pCorners[2]].position - p0).y * .5f;
+	}
+
+	void TestRatios()
+	{
+		//A smooth sphere has nothing to lock, every level reaches its ratio
+		std::vector<Vertex> vertices{};
+		std::vector<uint32_t> indices{};
+		Tests::CreateSphere(32, vertices, indices);
+		const std::vector<MeshSimplifier::LodLevel> chain{ MeshSimplifier::GenerateLodChain(indices, vertices, { 0 }, MeshSimplifier::DefaultLodRatios, 1.f) };
+		if (!CHECK(chain.size() == MeshSimplifier::DefaultLodRatios.size() + 1))
+			return;
+
+		for (size_t lodIdx = 1; lodIdx < chain.size(); ++lodIdx)
+		{
+			const size_t targetCount{ size_t(float(indices.size() / 3) * MeshSimplifier::DefaultLodRatios[lodIdx - 1]) * 3 };
+			CHECK(chain[lodIdx].indices.size() <= targetCount && chain[lodIdx].indices.size() * 10 <= chain[lodIdx - 1].indices.size() * 9);
+			CHECK(chain[lodIdx].error >= chain[lodIdx - 1].error);
+		}
+
+		//The vehicle locks its hard corners and stops early, each level still shrinks by a tenth and the errors only grow
+		std::vector<Vertex> vehicleVertices{};
+		std::vector<uint32_t> vehicleIndices{};
+		CHECK(Tests::LoadVehicle(vehicleVertices, vehicleIndices));
+		const std::vector<MeshSimplifier::LodLevel> vehicleChain{ MeshSimplifier::GenerateLodChain(vehicleIndices, vehicleVertices) };
+		CHECK(vehicleChain.size() > 1);
+		for (size_t lodIdx = 1; lodIdx < vehicleChain.size(); ++lodIdx)
+		{
+			const size_t targetCount{ size_t(float(vehicleIndices.size() / 3) * MeshSimplifier::DefaultLodRatios[lodIdx - 1]) * 3 };
+			const MeshSimplifier::LodLevel& level = vehicleChain[lodIdx];
+			CHECK(level.indices.size() * 10 <= vehicleChain[lodIdx - 1].indices.size() * 9 && level.error >= vehicleChain[lodIdx - 1].error);
+
+			//Short of its target only when the simplifier is stuck: it's the last level, and even no target gets at most a tenth further
+			if (level.indices.size() > targetCount)
+				CHECK(lodIdx + 1 == vehicleChain.size() && MeshSimplifier::Simplify(vehicleIndices, vehicleVertices, 0).size() * 10 >= level.indices.size() * 9);
+		}
+	}
+
+	void TestBorders()
+	{
+		//A flat grid simplifies to almost nothing, its border keeps the outline: same area, nothing flipped, border vertices on the border
+		constexpr uint32_t numQuads{ 32 };
+		std::vector<Vertex> vertices{};
+		std::vector<uint32_t> indices{};
+		Tests::CreateGrid(numQuads, vertices, indices);
+		float error{};
+		const std::vector<uint32_t> simplified{ MeshSimplifier::Simplify(indices, vertices, indices.size() / 16, MeshSimplifier::DefaultMaxError, &error) };
+		CHECK(simplified.size() <= indices.size() / 16);
+
+		float area{};
+		bool isUnflipped{ true };
+		for (size_t i = 0; i < simplified.size(); i += 3)
+		{
+			const float triangleArea{ GetArea(vertices, &simplified[i]) };
+			isUnflipped = isUnflipped && triangleArea > 0.f;
+			area += triangleArea;
+		}
+		CHECK(isUnflipped);
+		CHECK(std::abs(area - float(numQuads * numQuads)) < 1e-3f);
+
+		//Corners are still there
+		for (const Vector3 corner : { Vector3{ 0.f, 0.f, 0.f }, Vector3{ float(numQuads), 0.f, 0.f }, Vector3{ 0.f, 0.f, float(numQuads) }, Vector3{ float(numQuads), 0.f, float(numQuads) } })
+		{
+			bool isKept{ false };
+			for (const uint32_t index : simplified)
+				isKept = isKept || (vertices[index].position - corner).SqrMagnitude() == 0.f;
+			CHECK(isKept);
+		}
+	}
+
+	void TestSeams()
+	{
+		//Each UV island keeps covering its half, the seam between them stays where it is
+		constexpr uint32_t numQuads{ 32 };
+		std::vector<Vertex> vertices{};
+		std::vector<uint32_t> indices{};
+		Tests::CreateSeamGrid(numQuads, vertices, indices);
+		const std::vector<uint32_t> simplified{ MeshSimplifier::Simplify(indices, vertices, indices.size() / 8) };
+		CHECK(simplified.size() < indices.size() / 2);
+
+		float areas[2]{};
+		bool isOnItsSide{ true };
+		for (size_t i = 0; i < simplified.size(); i += 3)
+		{
+			const uint32_t side{ vertices[simplified[i]].uv.x >= 2.f ? 1u : 0u };
+			for (size_t corner = 0; corner < 3; ++corner)
+			{
+				const Vertex& vertex = vertices[simplified[i + corner]];
+				isOnItsSide = isOnItsSide && (vertex.uv.x >= 2.f ? 1u : 0u) == side &&
+					(side == 0 ? vertex.position.x <= numQuads / 2 : vertex.position.x >= numQuads / 2);
+			}
+			areas[side] += GetArea(vertices, &simplified[i]);
+		}
+		CHECK(isOnItsSide);
+		CHECK(std::abs(areas[0] - float(numQuads * numQuads / 2)) < 1e-3f && std::abs(areas[1] - float(numQuads * numQuads / 2)) < 1e-3f);
+	}
+
+	void TestSelection()
+	{
+		//The vehicle's chain seen from further and further away, through a 90 degree field of view on a 1080 pixel viewport
+		std::vector<Vertex> vertices{};
+		std::vector<uint32_t> indices{};
+		CHECK(Tests::LoadVehicle(vertices, indices));
+		std::vector<MeshLod> lods{};
+		for (const MeshSimplifier::LodLevel& level : MeshSimplifier::GenerateLodChain(indices, vertices))
+			lods.push_back(MeshLod{ 0, 0, 0, 0, level.error });
+		if (!CHECK(lods.size() > 2))
+			return;
+
+		size_t previousLod{};
+		bool isCoarsening{ true };
+		for (float distance = 1.f; distance < 1e5f; distance *= 1.5f)
+		{
+			const float pixelsPerUnit{ 1080.f / (2.f * 1.f * distance) };
+			const size_t lodIdx{ MeshSimplifier::SelectLod(lods, pixelsPerUnit, 1.f) };
+			isCoarsening = isCoarsening && lodIdx >= previousLod && lods[lodIdx].error * pixelsPerUnit <= 1.f;
+			previousLod = lodIdx;
+		}
+		CHECK(isCoarsening);
+		CHECK(MeshSimplifier::SelectLod(lods, 1e9f, 1.f) == 0);
+		CHECK(previousLod == lods.size() - 1);
+		CHECK(MeshSimplifier::SelectLod({}, 1.f, 1.f) == 0);
+	}
+}
+
+int main()
+{
+	return Tests::Run({
+		{ "Ratios", TestRatios },
+		{ "Borders", TestBorders },
+		{ "Seams", TestSeams },
+		{ "Selection", TestSelection }
+	});
+}
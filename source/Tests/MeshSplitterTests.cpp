@@ -0,0 +1,183 @@
+#include "pch.h"
+
+#include "Check.h"
+#include "MeshOptimizer.h"
+#include "MeshSimplifier.h"
+#include "MeshSplitter.h"
+#include "TestMeshes.h"
+
+using namespace dae;
+
+//The 16 bit split: ranges draw the same triangles in the same order, and levels of detail share their submesh's vertex blocks
+namespace
+{
+	using Triangle = std::array<float, 9>;
+
+	//Corner positions of every triangle in order
+	std::vector<Triangle> GetTriangles(const std::vector<Vertex>& vertices, const std::vector<uint32_t>& indices)
+	{
+		std::vector<Triangle> triangles(indices.size() / 3);
+		for (size_t index = 0; index < triangles.size() * 3; ++index)
+		{
+			const Vector3& position = vertices[indices[index]].position;
+			std::copy(&position.x, &position.x + 3, triangles[index / 3].begin() + index % 3 * 3);
+		}
+		return triangles;
+	}
+
+	bool IsSubsequence(const std::vector<Triangle>& triangles, const std::vector<Triangle>& sequence)
+	{
+		size_t next{};
+		for (const Triangle& triangle : triangles)
+		{
+			if (next < sequence.size() && sequence[next] == triangle)
+				++next;
+		}
+		return next == sequence.size();
+	}
+
+	//A grid of two submeshes with its levels of detail, laid out level by level and submesh by submesh like the cooker does
+	struct SplitMesh
+	{
+		std::vector<Vertex> vertices{};
+		std::vector<uint32_t> indices{};
+		std::vector<uint32_t> groupStarts{};
+		std::vector<uint32_t> groupSets{};
+	};
+
+	SplitMesh CreateLodGrid(uint32_t numQuads)
+	{
+		SplitMesh mesh{};
+		std::vector<uint32_t> sourceIndices{};
+		Tests::CreateGrid(numQuads, mesh.vertices, sourceIndices);
+		const std::vector<uint32_t> submeshStarts{ 0, static_cast<uint32_t>(sourceIndices.size() / 6 * 3) };
+
+		for (const MeshSimplifier::LodLevel& lodLevel : MeshSimplifier::GenerateLodChain(sourceIndices, mesh.vertices, submeshStarts))
+		{
+			for (size_t submeshIdx = 0; submeshIdx < submeshStarts.size(); ++submeshIdx)
+			{
+				const uint32_t submeshEnd{ submeshIdx + 1 < submeshStarts.size() ? lodLevel.groupStarts[submeshIdx + 1] : static_cast<uint32_t>(lodLevel.indices.size()) };
+				std::vector<uint32_t> submeshIndices(lodLevel.indices.begin() + lodLevel.groupStarts[submeshIdx], lodLevel.indices.begin() + submeshEnd);
+				MeshOptimizer::OptimizeVertexCache(submeshIndices, mesh.vertices.size());
+
+				mesh.groupStarts.push_back(static_cast<uint32_t>(mesh.indices.size()));
+				mesh.groupSets.push_back(static_cast<uint32_t>(submeshIdx));
+				mesh.indices.insert(mesh.indices.end(), submeshIndices.begin(), submeshIndices.end());
+			}
+		}
+		MeshOptimizer::OptimizeVertexFetch(mesh.vertices, mesh.indices);
+		return mesh;
+	}
+
+	//Every group is covered by its ranges in order, every range stays in its block.
+	//A group draws the same triangles as before, each range keeps their order.
+	bool IsSameDrawing(const SplitMesh& source, const std::vector<Vertex>& vertices, const std::vector<uint32_t>& indices,
+		const std::vector<DrawRange>& ranges, const std::vector<uint32_t>& groupRanges, uint32_t maxRangeVertices)
+	{
+		if (groupRanges.size() != source.groupStarts.size() || indices.size() != source.indices.size())
+			return false;
+
+		bool isSame{ true };
+		for (size_t group = 0; group < groupRanges.size(); ++group)
+		{
+			const uint32_t groupEnd{ group + 1 < source.groupStarts.size() ? source.groupStarts[group + 1] : static_cast<uint32_t>(source.indices.size()) };
+			const uint32_t endRange{ group + 1 < groupRanges.size() ? groupRanges[group + 1] : static_cast<uint32_t>(ranges.size()) };
+			const std::vector<uint32_t> groupIndices(source.indices.begin() + source.groupStarts[group], source.indices.begin() + groupEnd);
+			const std::vector<Triangle> groupTriangles{ GetTriangles(source.vertices, groupIndices) };
+
+			std::vector<uint32_t> drawnIndices{};
+			uint32_t nextIndex{ source.groupStarts[group] };
+			for (uint32_t rangeIdx = groupRanges[group]; rangeIdx < endRange; ++rangeIdx)
+			{
+				const DrawRange& range = ranges[rangeIdx];
+				isSame = isSame && range.indexStart == nextIndex && range.vertexCount <= maxRangeVertices && range.baseVertex + range.vertexCount <= vertices.size();
+				nextIndex = range.indexStart + range.indexCount;
+
+				std::vector<uint32_t> rangeIndices{};
+				for (uint32_t i = range.indexStart; i < range.indexStart + range.indexCount && isSame; ++i)
+				{
+					isSame = indices[i] < range.vertexCount;
+					rangeIndices.push_back(indices[i] + range.baseVertex);
+				}
+				isSame = isSame && IsSubsequence(groupTriangles, GetTriangles(vertices, rangeIndices));
+				drawnIndices.insert(drawnIndices.end(), rangeIndices.begin(), rangeIndices.end());
+			}
+			isSame = isSame && nextIndex == groupEnd && Tests::GetTriangleSet(vertices, drawnIndices) == Tests::GetTriangleSet(source.vertices, groupIndices);
+		}
+		return isSame;
+	}
+
+	void TestNoSplit()
+	{
+		const SplitMesh mesh{ CreateLodGrid(32) };
+		std::vector<Vertex> vertices{ mesh.vertices };
+		std::vector<uint32_t> indices{ mesh.indices };
+		std::vector<uint32_t> groupRanges{};
+		const std::vector<DrawRange> ranges{ MeshSplitter::Split(vertices, indices, mesh.groupStarts, groupRanges, mesh.groupSets) };
+
+		//Small enough for 16 bits, nothing moves and every group is one range
+		CHECK(ranges.size() == mesh.groupStarts.size());
+		CHECK(indices == mesh.indices && vertices.size() == mesh.vertices.size());
+		CHECK(IsSameDrawing(mesh, vertices, indices, ranges, groupRanges, MeshSplitter::MaxShortIndexVertices));
+	}
+
+	void TestSharedBlocks()
+	{
+		//401 x 401 vertices, each submesh has more than 16 bit indices address
+		const SplitMesh mesh{ CreateLodGrid(400) };
+		if (!CHECK(mesh.vertices.size() > MeshSplitter::MaxShortIndexVertices && mesh.groupStarts.size() > 2))
+			return;
+
+		std::vector<Vertex> vertices{ mesh.vertices };
+		std::vector<uint32_t> indices{ mesh.indices };
+		std::vector<uint32_t> groupRanges{};
+		const std::vector<DrawRange> ranges{ MeshSplitter::Split(vertices, indices, mesh.groupStarts, groupRanges, mesh.groupSets) };
+		CHECK(IsSameDrawing(mesh, vertices, indices, ranges, groupRanges, MeshSplitter::MaxShortIndexVertices));
+
+		//Each submesh needs two blocks, every level draws one range from each.
+		//The coarser levels only use vertices of the first one, so the blocks barely grow past the source.
+		CHECK(ranges.size() == groupRanges.size() * 2);
+		CHECK(vertices.size() < mesh.vertices.size() * 21 / 20);
+
+		//Without sets every group gets blocks of its own, the levels copy their vertices
+		std::vector<Vertex> separateVertices{ mesh.vertices };
+		std::vector<uint32_t> separateIndices{ mesh.indices };
+		std::vector<uint32_t> separateGroupRanges{};
+		const std::vector<DrawRange> separateRanges{ MeshSplitter::Split(separateVertices, separateIndices, mesh.groupStarts, separateGroupRanges) };
+		CHECK(IsSameDrawing(mesh, separateVertices, separateIndices, separateRanges, separateGroupRanges, MeshSplitter::MaxShortIndexVertices));
+		CHECK(separateVertices.size() > mesh.vertices.size() * 3 / 2);
+	}
+
+	void TestSmallBlocks()
+	{
+		//Many blocks per submesh, every level revisits them
+		const SplitMesh mesh{ CreateLodGrid(64) };
+		constexpr uint32_t maxRangeVertices{ 500 };
+		std::vector<Vertex> vertices{ mesh.vertices };
+		std::vector<uint32_t> indices{ mesh.indices };
+		std::vector<uint32_t> groupRanges{};
+		const std::vector<DrawRange> ranges{ MeshSplitter::Split(vertices, indices, mesh.groupStarts, groupRanges, mesh.groupSets, maxRangeVertices) };
+		CHECK(IsSameDrawing(mesh, vertices, indices, ranges, groupRanges, maxRangeVertices));
+		//Blocks this small copy their borders, still well below a copy per level
+		CHECK(vertices.size() < mesh.vertices.size() * 3 / 2);
+
+		//The encoded 16 bit indices are the split ones
+		std::vector<Vertex> encodedVertices{ mesh.vertices };
+		const EncodedIndices encoded{ MeshSplitter::EncodeShortIndices(encodedVertices, mesh.indices, mesh.groupStarts, mesh.groupSets, maxRangeVertices) };
+		bool isSameIndex{ encoded.stride == sizeof(uint16_t) && encoded.count == indices.size() && encoded.data.size() == indices.size() * sizeof(uint16_t) };
+		const uint16_t* pShortIndices = reinterpret_cast<const uint16_t*>(encoded.data.data());
+		for (size_t i = 0; i < indices.size() && isSameIndex; ++i)
+			isSameIndex = pShortIndices[i] == indices[i];
+		CHECK(isSameIndex);
+		CHECK(encoded.groups == groupRanges && encodedVertices.size() == vertices.size());
+	}
+}
+
+int main()
+{
+	return Tests::Run({
+		{ "No split", TestNoSplit },
+		{ "Shared blocks", TestSharedBlocks },
+		{ "Small blocks", TestSmallBlocks }
+	});
+}
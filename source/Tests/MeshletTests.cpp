@@ -0,0 +1,277 @@
+#include "pch.h"
+
+#include <random>
+#include <sstream>
+#include "Check.h"
+#include "MeshCooker.h"
+#include "MeshOptimizer.h"
+#include "Meshlet.h"
+#include "TestMeshes.h"
+
+using namespace dae;
+
+//Meshlets cut from the optimized order within their limits, and the culler against a reference of the same tests
+namespace
+{
+	//Unit normal for clockwise front faces, like the builder's
+	Vector3 GetTriangleNormal(const std::vector<Vertex>& vertices, const uint32_t* pCorners)
+	{
+		const Vector3& p0 = vertices[pCorners[0]].position;
+		return Vector3::Cross(vertices[pCorners[1]].position - p0, vertices[pCorners[2]].position - p0);
+	}
+
+	//Meshlets follow each other through the whole list, stay within the limits, and their spheres and cones hold their triangles
+	bool IsValidMeshletList(const std::vector<Meshlet>& meshlets, const std::vector<uint32_t>& indices, const std::vector<Vertex>& vertices,
+		uint32_t maxVertices, uint32_t maxTriangles)
+	{
+		bool isValid{ true };
+		uint32_t nextIndex{};
+		for (const Meshlet& meshlet : meshlets)
+		{
+			isValid = isValid && meshlet.indexStart == nextIndex && meshlet.indexCount > 0 && meshlet.indexCount % 3 == 0 && meshlet.indexCount / 3 <= maxTriangles;
+			nextIndex = meshlet.indexStart + meshlet.indexCount;
+			if (!isValid || nextIndex > indices.size())
+				return false;
+
+			std::vector<uint32_t> meshletVertices(indices.begin() + meshlet.indexStart, indices.begin() + nextIndex);
+			std::sort(meshletVertices.begin(), meshletVertices.end());
+			meshletVertices.erase(std::unique(meshletVertices.begin(), meshletVertices.end()), meshletVertices.end());
+			isValid = isValid && meshletVertices.size() <= maxVertices;
+
+			const Vector3 center{ meshlet.center[0], meshlet.center[1], meshlet.center[2] };
+			for (const uint32_t vertex : meshletVertices)
+				isValid = isValid && (vertices[vertex].position - center).Magnitude() <= meshlet.radius * 1.0001f + 1e-5f;
+
+			//Every face normal is within the cone, its half angle has cos = sqrt(1 - cutoff^2)
+			if (meshlet.coneCutoff < 1.f)
+			{
+				const Vector3 axis{ meshlet.coneAxis[0], meshlet.coneAxis[1], meshlet.coneAxis[2] };
+				const float minDot{ sqrtf(1.f - meshlet.coneCutoff * meshlet.coneCutoff) };
+				for (uint32_t i = meshlet.indexStart; i < nextIndex; i += 3)
+				{
+					const Vector3 normal{ GetTriangleNormal(vertices, &indices[i]) };
+					if (normal.SqrMagnitude() > 0.f)
+						isValid = isValid && Vector3::Dot(axis, normal.Normalized()) >= minDot - 1e-4f;
+				}
+			}
+		}
+		return isValid && nextIndex == indices.size();
+	}
+
+	void TestBuilder()
+	{
+		std::vector<Vertex> vertices{};
+		std::vector<uint32_t> indices{};
+		CHECK(Tests::LoadVehicle(vertices, indices));
+		MeshOptimizer::OptimizeVertexCache(indices, vertices.size());
+
+		const std::vector<Meshlet> meshlets{ MeshletBuilder::Build(indices, vertices) };
+		CHECK(IsValidMeshletList(meshlets, indices, vertices, MeshletBuilder::MaxVertices, MeshletBuilder::MaxTriangles));
+		//Narrow cones don't cut the runs down to nothing, the faceted vehicle averages about 8 triangles a meshlet
+		CHECK(meshlets.size() * 6 < indices.size() / 3);
+
+		//A flat grid is a single cone, meshlets end at the limits only and all face up
+		std::vector<Vertex> gridVertices{};
+		std::vector<uint32_t> gridIndices{};
+		Tests::CreateGrid(32, gridVertices, gridIndices);
+		MeshOptimizer::OptimizeVertexCache(gridIndices, gridVertices.size());
+		const std::vector<Meshlet> gridMeshlets{ MeshletBuilder::Build(gridIndices, gridVertices) };
+		CHECK(IsValidMeshletList(gridMeshlets, gridIndices, gridVertices, MeshletBuilder::MaxVertices, MeshletBuilder::MaxTriangles));
+		bool isFacingUp{ true };
+		for (const Meshlet& meshlet : gridMeshlets)
+			isFacingUp = isFacingUp && meshlet.coneAxis[1] > .9999f && meshlet.coneCutoff < 1e-3f;
+		CHECK(isFacingUp);
+
+		//Limits below a triangle still fit one
+		const std::vector<Meshlet> single{ MeshletBuilder::Build(gridIndices, gridVertices, 1, 1) };
+		CHECK(single.size() == gridIndices.size() / 3 && IsValidMeshletList(single, gridIndices, gridVertices, 3, 1));
+	}
+
+	void TestCookedOrder()
+	{
+		std::vector<Vertex> vertices{};
+		std::vector<uint32_t> indices{};
+		std::vector<Utils::ObjMaterialRange> materialRanges{};
+		CHECK(Tests::LoadVehicle(vertices, indices, &materialRanges));
+
+		//The first level as the cache and overdraw passes leave it, submesh by submesh
+		std::vector<uint32_t> optimized{};
+		for (size_t rangeIdx = 0; rangeIdx < materialRanges.size(); ++rangeIdx)
+		{
+			const uint32_t end{ rangeIdx + 1 < materialRanges.size() ? materialRanges[rangeIdx + 1].indexStart : static_cast<uint32_t>(indices.size()) };
+			std::vector<uint32_t> submeshIndices(indices.begin() + materialRanges[rangeIdx].indexStart, indices.begin() + end);
+			MeshOptimizer::OptimizeVertexCache(submeshIndices, vertices.size());
+			MeshOptimizer::OptimizeOverdraw(submeshIndices, vertices);
+			optimized.insert(optimized.end(), submeshIndices.begin(), submeshIndices.end());
+		}
+
+		std::vector<Vertex> cookVertices{ vertices };
+		std::vector<uint32_t> cookIndices{ indices };
+		std::ostringstream log{};
+		const CookedMeshData data{ MeshCooker::Cook(cookVertices, cookIndices, materialRanges, VertexLayout::Full, true, "vehicle", log) };
+		if (!CHECK(!data.lods.empty() && data.indices.stride == sizeof(uint16_t)))
+			return;
+
+		//The cooked first level draws the same corners in the same order, so its cache and overdraw figures are the optimized ones
+		const std::vector<Vertex> cookedVertices{ VertexCodec::Decode(data.vertices) };
+		const uint16_t* pShortIndices = reinterpret_cast<const uint16_t*>(data.indices.data.data());
+		std::vector<uint32_t> cooked{};
+		for (uint32_t rangeIdx = data.lods[0].firstRange; rangeIdx < data.lods[0].firstRange + data.lods[0].rangeCount; ++rangeIdx)
+		{
+			const DrawRange& range = data.indices.ranges[rangeIdx];
+			for (uint32_t i = range.indexStart; i < range.indexStart + range.indexCount; ++i)
+				cooked.push_back(pShortIndices[i] + range.baseVertex);
+		}
+
+		bool isSameOrder{ cooked.size() == optimized.size() };
+		for (size_t i = 0; i < cooked.size() && isSameOrder; ++i)
+		{
+			const Vector3& position = cookedVertices[cooked[i]].position;
+			const Vector3& expected = vertices[optimized[i]].position;
+			isSameOrder = position.x == expected.x && position.y == expected.y && position.z == expected.z;
+		}
+		CHECK(isSameOrder);
+		CHECK(MeshOptimizer::AnalyzeVertexCache(cooked, cookedVertices.size()).acmr == MeshOptimizer::AnalyzeVertexCache(optimized, vertices.size()).acmr);
+		CHECK(MeshOptimizer::AnalyzeOverdraw(cooked, cookedVertices).overdraw == MeshOptimizer::AnalyzeOverdraw(optimized, vertices).overdraw);
+
+		//The meshlets of every level cover its ranges
+		bool isCovered{ true };
+		for (const MeshLod& lod : data.lods)
+		{
+			const DrawRange& firstRange = data.indices.ranges[lod.firstRange];
+			const DrawRange& lastRange = data.indices.ranges[lod.firstRange + lod.rangeCount - 1];
+			uint32_t nextIndex{ firstRange.indexStart };
+			for (uint32_t meshletIdx = lod.firstMeshlet; meshletIdx < lod.firstMeshlet + lod.meshletCount; ++meshletIdx)
+			{
+				isCovered = isCovered && data.meshlets[meshletIdx].indexStart == nextIndex;
+				nextIndex += data.meshlets[meshletIdx].indexCount;
+			}
+			isCovered = isCovered && nextIndex == lastRange.indexStart + lastRange.indexCount;
+		}
+		CHECK(isCovered);
+	}
+
+	//The frustum of CreatePerspectiveFovLH with a 90 degree field of view, square, looking down +z
+	constexpr float NearPlane{ .1f };
+	constexpr float FarPlane{ 100.f };
+
+	//Signed distances of a view space point to the six planes, positive inside
+	std::array<float, 6> GetPlaneDistances(const Vector3& point)
+	{
+		const float invSqrt2{ 1.f / sqrtf(2.f) };
+		return { (point.z + point.x) * invSqrt2, (point.z - point.x) * invSqrt2, (point.z + point.y) * invSqrt2, (point.z - point.y) * invSqrt2,
+			point.z - NearPlane, FarPlane - point.z };
+	}
+
+	void TestCuller()
+	{
+		//Random spheres and cones around a translated frustum, skipping the ones too close to a decision to call
+		const Vector3 translation{ 3.f, -2.f, 10.f };
+		const Matrix worldViewProjection{ Matrix::CreateTranslation(translation) * Matrix::CreatePerspectiveFovLH(1.f, 1.f, NearPlane, FarPlane) };
+		const Vector3 cameraPosition{ -translation };
+
+		std::mt19937 generator{ 11 };
+		std::uniform_real_distribution<float> position{ -60.f, 60.f };
+		std::uniform_real_distribution<float> unit{ 0.f, 1.f };
+		std::normal_distribution<float> normal{};
+		std::vector<Meshlet> meshlets{};
+		std::vector<bool> isInFrustum{};
+		std::vector<bool> isFrontFacing{};
+		while (meshlets.size() < 2003)
+		{
+			Meshlet meshlet{};
+			const Vector3 center{ position(generator), position(generator), position(generator) + 40.f };
+			const Vector3 axis{ Vector3{ normal(generator), normal(generator), normal(generator) }.Normalized() };
+			for (int axisIdx = 0; axisIdx < 3; ++axisIdx)
+			{
+				meshlet.center[axisIdx] = center[axisIdx];
+				meshlet.coneAxis[axisIdx] = axis[axisIdx];
+			}
+			meshlet.radius = unit(generator) * 5.f;
+			meshlet.coneCutoff = meshlets.size() % 7 == 0 ? 1.f : unit(generator);
+
+			float closest{ FLT_MAX };
+			bool isInside{ true };
+			for (const float distance : GetPlaneDistances(center + translation))
+			{
+				isInside = isInside && distance >= -meshlet.radius;
+				closest = std::min(closest, std::abs(distance + meshlet.radius));
+			}
+			const Vector3 toCenter{ center - cameraPosition };
+			const float backfaceMargin{ Vector3::Dot(toCenter, axis) - (meshlet.coneCutoff * toCenter.Magnitude() + meshlet.radius) };
+			if (closest < 1e-2f || std::abs(backfaceMargin) < 1e-2f)
+				continue;
+
+			meshlets.push_back(meshlet);
+			isInFrustum.push_back(isInside);
+			isFrontFacing.push_back(backfaceMargin <= 0.f);
+		}
+
+		MeshletCuller culler{};
+		culler.SetMeshlets(meshlets);
+		size_t numVisible{};
+		size_t numCulledBackfaces{};
+		for (const bool cullBackfaces : { false, true })
+		{
+			//Every start and count, so each meshlet goes through every lane and the ragged ends
+			bool isSame{ true };
+			for (const uint32_t first : { 0u, 1u, 2u, 3u, 5u, 1001u })
+			{
+				for (const uint32_t count : { 0u, 1u, 2u, 3u, 4u, 7u, 2003u })
+				{
+					std::vector<uint32_t> visible{};
+					culler.Cull(worldViewProjection, cameraPosition, cullBackfaces, first, count, visible);
+
+					std::vector<uint32_t> expected{};
+					for (uint32_t meshletIdx = first; meshletIdx < std::min(first + count, static_cast<uint32_t>(meshlets.size())); ++meshletIdx)
+					{
+						if (isInFrustum[meshletIdx] && (!cullBackfaces || isFrontFacing[meshletIdx]))
+							expected.push_back(meshletIdx);
+					}
+					isSame = isSame && visible == expected;
+					if (first == 0 && count == meshlets.size())
+						(cullBackfaces ? numCulledBackfaces : numVisible) = visible.size();
+				}
+			}
+			CHECK(isSame);
+		}
+		//Both tests decide for a good share of the meshlets
+		CHECK(numVisible > meshlets.size() / 10 && numVisible < meshlets.size() * 9 / 10);
+		CHECK(numCulledBackfaces > numVisible / 10 && numCulledBackfaces < numVisible);
+	}
+
+	void TestGridFacing()
+	{
+		std::vector<Vertex> vertices{};
+		std::vector<uint32_t> indices{};
+		Tests::CreateGrid(32, vertices, indices);
+		MeshOptimizer::OptimizeVertexCache(indices, vertices.size());
+		const std::vector<Meshlet> meshlets{ MeshletBuilder::Build(indices, vertices) };
+		MeshletCuller culler{};
+		culler.SetMeshlets(meshlets);
+
+		//The grid in front of the camera: below it, it shows its front faces, above it only its back faces
+		for (const float height : { -20.f, 20.f })
+		{
+			const Vector3 translation{ -16.f, height, 40.f };
+			const Matrix worldViewProjection{ Matrix::CreateTranslation(translation) * Matrix::CreatePerspectiveFovLH(1.f, 1.f, NearPlane, FarPlane) };
+			std::vector<uint32_t> visible{};
+			culler.Cull(worldViewProjection, -translation, false, 0, static_cast<uint32_t>(meshlets.size()), visible);
+			CHECK(visible.size() == meshlets.size());
+
+			visible.clear();
+			culler.Cull(worldViewProjection, -translation, true, 0, static_cast<uint32_t>(meshlets.size()), visible);
+			CHECK(visible.size() == (height < 0.f ? meshlets.size() : 0));
+		}
+	}
+}
+
+int main()
+{
+	return Tests::Run({
+		{ "Builder", TestBuilder },
+		{ "Cooked order", TestCookedOrder },
+		{ "Culler", TestCuller },
+		{ "Grid facing", TestGridFacing }
+	});
+}
@@ -0,0 +1,222 @@
+#include "pch.h"
+
+#include <cmath>
+#include <random>
+#include "Check.h"
+#include "MipGenerator.h"
+#include "PngDecoder.h"
+
+using namespace dae;
+
+//Mips keep flat areas flat and unit normals unit length, box mips round like a double precision reference,
+//and the scalar build (MipGeneratorScalarTests) writes the very same bytes as the SSE2 one
+namespace
+{
+	constexpr size_t NumThreads{ 4 };
+
+	//FNV-1a of every level of Generate on the images of TestSimd, printed when it doesn't match.
+	//The scalar and SSE2 builds check against the same value, so they agree byte for byte.
+	constexpr uint64_t ExpectedHash{ 10490639203869383311ull };
+
+	Image CreateNoise(uint32_t width, uint32_t height, uint32_t seed)
+	{
+		std::mt19937 generator{ seed };
+		std::uniform_int_distribution<uint32_t> distribution{ 0, 255 };
+		Image image{ width, height, std::vector<uint8_t>(size_t(width) * height * 4) };
+		for (uint8_t& value : image.pixels)
+			value = static_cast<uint8_t>(distribution(generator));
+		return image;
+	}
+
+	Image CreateConstant(uint32_t width, uint32_t height, const uint8_t (&texel)[4])
+	{
+		Image image{ width, height, std::vector<uint8_t>(size_t(width) * height * 4) };
+		for (size_t texelIdx = 0; texelIdx < size_t(width) * height; ++texelIdx)
+			std::copy(texel, texel + 4, image.pixels.begin() + texelIdx * 4);
+		return image;
+	}
+
+	Image LoadCrop(const std::string& path, uint32_t size)
+	{
+		Image image{};
+		if (!CHECK(PngDecoder::DecodeFile(path, image) && image.width >= size && image.height >= size))
+			return Image{};
+		Image crop{ size, size, std::vector<uint8_t>(size_t(size) * size * 4) };
+		const uint32_t left{ (image.width - size) / 2 }, top{ (image.height - size) / 2 };
+		for (uint32_t y = 0; y < size; ++y)
+		{
+			const uint8_t* pRow = image.pixels.data() + (size_t(top + y) * image.width + left) * 4;
+			std::copy(pRow, pRow + size_t(size) * 4, crop.pixels.begin() + size_t(y) * size * 4);
+		}
+		return crop;
+	}
+
+	void TestSimd()
+	{
+		//Odd sizes and tiles cut short by the edges go through the same filter loops
+		const Image images[]{ LoadCrop("Resources/vehicle_normal.png", 256), CreateNoise(301, 77, 1), CreateNoise(1, 9, 2) };
+		uint64_t hash{ 14695981039346656037ull };
+		for (const Image& image : images)
+		{
+			for (const MipContent content : { MipContent::Color, MipContent::Linear, MipContent::Normal })
+			{
+				for (const MipFilter filter : { MipFilter::Box, MipFilter::Kaiser })
+				{
+					for (const Image& mip : MipGenerator::Generate(image, content, filter, NumThreads))
+					{
+						for (const uint8_t value : mip.pixels)
+							hash = (hash ^ value) * 1099511628211ull;
+					}
+				}
+			}
+		}
+		if (!CHECK(hash == ExpectedHash))
+			std::cout << "Mip hash " << hash << "\n";
+	}
+
+	void TestConstant()
+	{
+		//Weights add up to one, a flat image gives the same bytes on every level in every space. The normal is unit length as stored.
+		const uint8_t color[4]{ 200, 31, 97, 128 };
+		const uint8_t normal[4]{ 85, 164, 242, 255 };
+		bool isConstant{ true };
+		for (const MipContent content : { MipContent::Color, MipContent::Linear, MipContent::Normal })
+		{
+			const uint8_t (&texel)[4] = content == MipContent::Normal ? normal : color;
+			for (const MipFilter filter : { MipFilter::Box, MipFilter::Kaiser })
+			{
+				for (const Image& mip : MipGenerator::Generate(CreateConstant(100, 37, texel), content, filter, NumThreads))
+				{
+					for (size_t i = 0; i < mip.pixels.size(); ++i)
+						isConstant = isConstant && mip.pixels[i] == texel[i % 4];
+				}
+			}
+		}
+		CHECK(isConstant);
+	}
+
+	double SrgbToLinear(double value)
+	{
+		return value <= 0.04045 ? value / 12.92 : pow((value + 0.055) / 1.055, 2.4);
+	}
+
+	double LinearToSrgb(double value)
+	{
+		return value <= 0.0031308 ? value * 12.92 : 1.055 * pow(value, 1.0 / 2.4) - 0.055;
+	}
+
+	void TestBoxReference()
+	{
+		//Each box texel is the mean of its 2x2 texels in linear space, rounded to the nearest sRGB byte. Alpha is averaged as stored.
+		const Image image{ CreateNoise(64, 48, 3) };
+		const std::vector<Image> mips{ MipGenerator::Generate(image, MipContent::Color, MipFilter::Box, NumThreads) };
+		if (!CHECK(mips.size() == 7))
+			return;
+
+		bool isRounded{ true };
+		const Image& mip = mips[1];
+		for (uint32_t y = 0; y < mip.height; ++y)
+		{
+			for (uint32_t x = 0; x < mip.width; ++x)
+			{
+				for (uint32_t channel = 0; channel < 4; ++channel)
+				{
+					double sum{};
+					for (const uint32_t corner : { 0u, 1u, 2u, 3u })
+					{
+						const uint8_t value{ image.pixels[((size_t(y) * 2 + corner / 2) * image.width + x * 2 + corner % 2) * 4 + channel] };
+						sum += channel == 3 ? value / 255.0 : SrgbToLinear(value / 255.0);
+					}
+					const double mean{ sum / 4.0 };
+					const double expected{ (channel == 3 ? mean : LinearToSrgb(mean)) * 255.0 };
+					//Off by one only where float rounding meets a halfway value
+					const double difference{ std::abs(mip.pixels[(size_t(y) * mip.width + x) * 4 + channel] - expected) };
+					isRounded = isRounded && (difference <= 0.5 || (difference < 0.5 + 1e-4 && std::abs(expected - std::floor(expected) - 0.5) < 1e-4));
+				}
+			}
+		}
+		CHECK(isRounded);
+	}
+
+	void TestNormals()
+	{
+		//Filtered normals are scaled back to unit length, within what 8 bits a component can hold
+		const Image image{ LoadCrop("Resources/vehicle_normal.png", 256) };
+		for (const MipFilter filter : { MipFilter::Box, MipFilter::Kaiser })
+		{
+			const std::vector<Image> mips{ MipGenerator::Generate(image, MipContent::Normal, filter, NumThreads) };
+			bool isUnit{ mips.size() == 9 };
+			for (size_t level = 1; level < mips.size(); ++level)
+			{
+				for (size_t texel = 0; texel < mips[level].pixels.size(); texel += 4)
+				{
+					double sqrLength{};
+					for (uint32_t channel = 0; channel < 3; ++channel)
+					{
+						const double component{ mips[level].pixels[texel + channel] / 255.0 * 2.0 - 1.0 };
+						sqrLength += component * component;
+					}
+					isUnit = isUnit && std::abs(std::sqrt(sqrLength) - 1.0) < 0.01;
+				}
+			}
+			CHECK(isUnit);
+		}
+	}
+
+	void TestOddSizes()
+	{
+		//Odd levels drop their last row or column, a side that reaches 1 stays 1 until the other one does
+		struct Size
+		{
+			uint32_t width;
+			uint32_t height;
+		};
+		const std::vector<std::vector<Size>> chains{
+			{ { 7, 3 }, { 3, 1 }, { 1, 1 } },
+			{ { 1, 5 }, { 1, 2 }, { 1, 1 } },
+			{ { 1, 1 } },
+			{ { 33, 1 }, { 16, 1 }, { 8, 1 }, { 4, 1 }, { 2, 1 }, { 1, 1 } }
+		};
+		const uint8_t texel[4]{ 12, 230, 140, 60 };
+		for (const std::vector<Size>& chain : chains)
+		{
+			CHECK(MipGenerator::GetMipCount(chain[0].width, chain[0].height) == chain.size());
+			for (const MipFilter filter : { MipFilter::Box, MipFilter::Kaiser })
+			{
+				//Kaiser taps reach past every edge of these and wrap around, more than once on the 1 texel sides
+				const std::vector<Image> mips{ MipGenerator::Generate(CreateConstant(chain[0].width, chain[0].height, texel), MipContent::Color, filter, NumThreads) };
+				bool isExpected{ mips.size() == chain.size() };
+				for (size_t level = 0; level < mips.size() && isExpected; ++level)
+				{
+					isExpected = mips[level].width == chain[level].width && mips[level].height == chain[level].height &&
+						mips[level].pixels.size() == size_t(chain[level].width) * chain[level].height * 4;
+					for (size_t i = 0; i < mips[level].pixels.size(); ++i)
+						isExpected = isExpected && mips[level].pixels[i] == texel[i % 4];
+				}
+				CHECK(isExpected);
+
+				//The same on any thread count
+				const Image noise{ CreateNoise(chain[0].width, chain[0].height, 4) };
+				bool isSame{ true };
+				const std::vector<Image> serial{ MipGenerator::Generate(noise, MipContent::Color, filter, 1) };
+				const std::vector<Image> parallel{ MipGenerator::Generate(noise, MipContent::Color, filter, NumThreads) };
+				for (size_t level = 0; level < serial.size(); ++level)
+					isSame = isSame && serial[level].pixels == parallel[level].pixels;
+				CHECK(isSame);
+			}
+		}
+
+		CHECK(MipGenerator::Generate(Image{}, MipContent::Color, MipFilter::Box).empty());
+	}
+}
+
+int main()
+{
+	return Tests::Run({
+		{ "SIMD", TestSimd },
+		{ "Constant", TestConstant },
+		{ "Box reference", TestBoxReference },
+		{ "Normals", TestNormals },
+		{ "Odd sizes", TestOddSizes }
+	});
+}
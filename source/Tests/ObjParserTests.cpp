@@ -0,0 +1,186 @@
+#include "pch.h"
+
+#include <cmath>
+#include "Check.h"
+#include "ReferenceObjParser.h"
+#include "Utils.h"
+
+using namespace dae;
+
+//Utils::ParseOBJ against the ifstream parser it replaced, on the vehicle and on the cases only the new parser reads
+namespace
+{
+	const std::string VehiclePath{ "Resources/vehicle.obj" };
+
+	bool IsSame(const Vector3& a, const Vector3& b)
+	{
+		return a.x == b.x && a.y == b.y && a.z == b.z;
+	}
+
+	bool IsSame(const Vector2& a, const Vector2& b)
+	{
+		return a.x == b.x && a.y == b.y;
+	}
+
+	//Same indices and the same attributes per vertex, tangents aside. Normals only with compareNormals.
+	bool IsSameMesh(const std::vector<Vertex>& vertices, const std::vector<uint32_t>& indices,
+		const std::vector<Vertex>& referenceVertices, const std::vector<uint32_t>& referenceIndices, bool compareNormals = true)
+	{
+		if (indices != referenceIndices || vertices.size() != referenceVertices.size())
+			return false;
+
+		for (size_t vertexIdx = 0; vertexIdx < vertices.size(); ++vertexIdx)
+		{
+			const Vertex& vertex = vertices[vertexIdx];
+			const Vertex& reference = referenceVertices[vertexIdx];
+			if (!IsSame(vertex.position, reference.position) || !IsSame(vertex.uv, reference.uv) ||
+				(compareNormals && !IsSame(vertex.normal, reference.normal)))
+				return false;
+		}
+		return true;
+	}
+
+	//Parses both files, the first with Utils::ParseOBJ and the second with the reference, and compares the results
+	bool ParsesLikeReference(const std::string& path, const std::string& referencePath, bool flipAxisAndWinding = true, bool compareNormals = true)
+	{
+		std::vector<Vertex> vertices{};
+		std::vector<uint32_t> indices{};
+		std::vector<Vertex> referenceVertices{};
+		std::vector<uint32_t> referenceIndices{};
+		return Utils::ParseOBJ(path, vertices, indices, flipAxisAndWinding) && Tests::ParseObjReference(referencePath, referenceVertices, referenceIndices, flipAxisAndWinding) &&
+			IsSameMesh(vertices, indices, referenceVertices, referenceIndices, compareNormals);
+	}
+
+	void TestVehicle()
+	{
+		CHECK(ParsesLikeReference(VehiclePath, VehiclePath));
+		CHECK(ParsesLikeReference(VehiclePath, VehiclePath, false));
+
+		//Chunked parsing gives the same result on any number of threads
+		std::vector<Vertex> vertices{};
+		std::vector<uint32_t> indices{};
+		std::vector<Vertex> parallelVertices{};
+		std::vector<uint32_t> parallelIndices{};
+		CHECK(Utils::ParseOBJ(VehiclePath, vertices, indices) && Utils::ParseOBJ(VehiclePath, parallelVertices, parallelIndices, true, false, 4));
+		CHECK(IsSameMesh(parallelVertices, parallelIndices, vertices, indices));
+	}
+
+	void TestNegativeIndices()
+	{
+		//Relative indices count back from the elements read so far, not from the end of the file
+		const std::string header{ "v 0 0 0\nv 1 0 0\nv 0 1 0\nvt 0 0\nvt 1 0\nvt 0 1\nvn 0 0 1\n" };
+		const std::string middle{ "v 1 1 0\nvt 1 1\n" };
+		const std::string relativePath{ Tests::WriteTempFile("relative.obj",
+			header + "f -3/-3/-1 -2/-2/-1 -1/-1/-1\n" + middle + "f -3/-3/-1 -1/-1/-1 -2/-2/-1\n") };
+		const std::string absolutePath{ Tests::WriteTempFile("absolute.obj",
+			header + "f 1/1/1 2/2/1 3/3/1\n" + middle + "f 2/2/1 4/4/1 3/3/1\n") };
+		CHECK(ParsesLikeReference(relativePath, absolutePath));
+
+		//Before the first element or past the end
+		std::vector<Vertex> vertices{};
+		std::vector<uint32_t> indices{};
+		CHECK(!Utils::ParseOBJ(Tests::WriteTempFile("before.obj", "v 0 0 0\nv 1 0 0\nf -1 -2 -3\n"), vertices, indices));
+		CHECK(!Utils::ParseOBJ(Tests::WriteTempFile("past.obj", "v 0 0 0\nv 1 0 0\nv 0 1 0\nf 1 2 4\n"), vertices, indices));
+	}
+
+	void TestPolygons()
+	{
+		//A convex quad splits along its first diagonal, the same as two triangles written out
+		const std::string header{ "v 0 0 0\nv 1 0 0\nv 1 1 0\nv 0 1 0\nvt 0 0\nvt 1 0\nvt 1 1\nvt 0 1\nvn 0 0 1\n" };
+		const std::string quadPath{ Tests::WriteTempFile("quad.obj", header + "f 1/1/1 2/2/1 3/3/1 4/4/1\n") };
+		const std::string trianglesPath{ Tests::WriteTempFile("quad_triangles.obj", header + "f 1/1/1 2/2/1 3/3/1\nf 1/1/1 3/3/1 4/4/1\n") };
+		CHECK(ParsesLikeReference(quadPath, trianglesPath));
+		CHECK(ParsesLikeReference(quadPath, trianglesPath, false));
+
+		//A concave L, its triangles have to cover it exactly and keep its winding
+		const std::string lPath{ Tests::WriteTempFile("l.obj", "v 0 0 0\nv 2 0 0\nv 2 1 0\nv 1 1 0\nv 1 2 0\nv 0 2 0\nf 1 2 3 4 5 6\n") };
+		//A regular pentagon
+		std::string pentagon{};
+		for (int corner = 0; corner < 5; ++corner)
+			pentagon += "v " + std::to_string(cosf(corner * 2.f * PI / 5.f)) + " " + std::to_string(sinf(corner * 2.f * PI / 5.f)) + " 0\n";
+		const std::string pentagonPath{ Tests::WriteTempFile("pentagon.obj", pentagon + "f 1 2 3 4 5\n") };
+
+		for (const std::string& path : { lPath, pentagonPath })
+		{
+			std::vector<Vertex> vertices{};
+			std::vector<uint32_t> indices{};
+			if (!CHECK(Utils::ParseOBJ(path, vertices, indices, false)))
+				continue;
+
+			std::vector<Vector3> corners{};
+			std::ifstream file{ path };
+			std::string command{};
+			while (file >> command)
+			{
+				if (command != "v")
+				{
+					file.ignore(1000, '\n');
+					continue;
+				}
+				Vector3 position{};
+				file >> position.x >> position.y >> position.z;
+				corners.push_back(position);
+			}
+			CHECK(indices.size() == (corners.size() - 2) * 3);
+
+			//Twice the area of the polygon, by the shoelace formula over its corners in file order
+			float polygonArea{};
+			for (size_t corner = 0; corner < corners.size(); ++corner)
+			{
+				const Vector3& current = corners[corner];
+				const Vector3& next = corners[(corner + 1) % corners.size()];
+				polygonArea += current.x * next.y - next.x * current.y;
+			}
+
+			float triangleArea{};
+			bool isSameWinding{ true };
+			for (size_t index = 0; index + 2 < indices.size(); index += 3)
+			{
+				const Vector3& a = vertices[indices[index]].position;
+				const Vector3& b = vertices[indices[index + 1]].position;
+				const Vector3& c = vertices[indices[index + 2]].position;
+				const float area{ Vector3::Cross(b - a, c - a).z };
+				isSameWinding = isSameWinding && area > 0.f;
+				triangleArea += area;
+			}
+			CHECK(isSameWinding);
+			CHECK(std::abs(triangleArea - polygonArea) < 1e-5f);
+		}
+	}
+
+	void TestMissingAttributes()
+	{
+		//Corners without a uv or a normal keep the previous corner's within the face, and nothing at the first corner
+		const std::string header{ "v 0 0 0\nv 1 0 0\nv 1 1 0\nv 0 1 0\nvt 0 0\nvt 1 0\nvt 1 1\nvt 0 1\nvn 0 0 1\nvn 0 1 0\n" };
+		const std::string mixedPath{ Tests::WriteTempFile("mixed.obj", header +
+			"f 1 2 3\nf 1/1 2/2 3/3\nf 1//1 2//2 3//1\nf 1/1/1 2/2/2 3/3/1\nf 1/4/2 3 4//1\n") };
+		CHECK(ParsesLikeReference(mixedPath, mixedPath));
+
+		//Without any vn the normals are generated, on a flat quad they're the ones the file could have had
+		const std::string faces{ "f 1/1 2/2 3/3\nf 1/1 3/3 4/4\n" };
+		const std::string noNormalsPath{ Tests::WriteTempFile("no_normals.obj", "v 0 0 0\nv 1 0 0\nv 1 1 0\nv 0 1 0\nvt 0 0\nvt 1 0\nvt 1 1\nvt 0 1\n" + faces) };
+		const std::string normalsPath{ Tests::WriteTempFile("normals.obj",
+			"v 0 0 0\nv 1 0 0\nv 1 1 0\nv 0 1 0\nvt 0 0\nvt 1 0\nvt 1 1\nvt 0 1\nvn 0 0 1\nf 1/1/1 2/2/1 3/3/1\nf 1/1/1 3/3/1 4/4/1\n") };
+		CHECK(ParsesLikeReference(noNormalsPath, normalsPath, true, false));
+
+		std::vector<Vertex> vertices{};
+		std::vector<uint32_t> indices{};
+		std::vector<Vertex> referenceVertices{};
+		std::vector<uint32_t> referenceIndices{};
+		if (CHECK(Utils::ParseOBJ(noNormalsPath, vertices, indices) && Tests::ParseObjReference(normalsPath, referenceVertices, referenceIndices)))
+		{
+			for (size_t vertexIdx = 0; vertexIdx < vertices.size(); ++vertexIdx)
+				CHECK(Vector3::Dot(vertices[vertexIdx].normal, referenceVertices[vertexIdx].normal) > .9999f);
+		}
+	}
+}
+
+int main()
+{
+	return Tests::Run({
+		{ "Vehicle", TestVehicle },
+		{ "Negative indices", TestNegativeIndices },
+		{ "Polygons", TestPolygons },
+		{ "Missing attributes", TestMissingAttributes }
+	});
+}
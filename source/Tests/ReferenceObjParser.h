@@ -0,0 +1,123 @@
+#pragma once
+#include <fstream>
+#include <string>
+#include <vector>
+#include "Math.h"
+#include "Vertex.h"
+
+namespace dae
+{
+	namespace Tests
+	{
+		//The ifstream parser Utils::ParseOBJ replaced, kept to check that it still reads triangle-only files the same way.
+		//Two changes: commands are read until extraction fails, eof() ran the last command a second time on files ending in a newline,
+		//and the tangent loop is gone, tangents come from TangentSpace now and have their own checks.
+		inline bool ParseObjReference(const std::string& filename, std::vector<Vertex>& vertices, std::vector<uint32_t>& indices, bool flipAxisAndWinding = true)
+		{
+			std::ifstream file(filename);
+			if (!file)
+				return false;
+
+			std::vector<Vector3> positions{};
+			std::vector<Vector3> normals{};
+			std::vector<Vector2> UVs{};
+
+			vertices.clear();
+			indices.clear();
+
+			std::string sCommand;
+			while (file >> sCommand)
+			{
+				if (sCommand == "#")
+				{
+					// Ignore Comment
+				}
+				else if (sCommand == "v")
+				{
+					//Vertex
+					float x, y, z;
+					file >> x >> y >> z;
+
+					positions.emplace_back(x, y, z);
+				}
+				else if (sCommand == "vt")
+				{
+					// Vertex TexCoord
+					float u, v;
+					file >> u >> v;
+					UVs.emplace_back(u, 1 - v);
+				}
+				else if (sCommand == "vn")
+				{
+					// Vertex Normal
+					float x, y, z;
+					file >> x >> y >> z;
+
+					normals.emplace_back(x, y, z);
+				}
+				else if (sCommand == "f")
+				{
+					Vertex vertex{};
+					size_t iPosition, iTexCoord, iNormal;
+
+					uint32_t tempIndices[3];
+					for (size_t iFace = 0; iFace < 3; iFace++)
+					{
+						// OBJ format uses 1-based arrays
+						file >> iPosition;
+						vertex.position = positions[iPosition - 1];
+
+						if ('/' == file.peek())//is next in buffer ==  '/' ?
+						{
+							file.ignore();//read and ignore one element ('/')
+
+							if ('/' != file.peek())
+							{
+								// Optional texture coordinate
+								file >> iTexCoord;
+								vertex.uv = UVs[iTexCoord - 1];
+							}
+
+							if ('/' == file.peek())
+							{
+								file.ignore();
+
+								// Optional vertex normal
+								file >> iNormal;
+								vertex.normal = normals[iNormal - 1];
+							}
+						}
+
+						vertices.push_back(vertex);
+						tempIndices[iFace] = uint32_t(vertices.size()) - 1;
+					}
+
+					indices.push_back(tempIndices[0]);
+					if (flipAxisAndWinding)
+					{
+						indices.push_back(tempIndices[2]);
+						indices.push_back(tempIndices[1]);
+					}
+					else
+					{
+						indices.push_back(tempIndices[1]);
+						indices.push_back(tempIndices[2]);
+					}
+				}
+				//read till end of line and ignore all remaining chars
+				file.ignore(1000, '\n');
+			}
+
+			if (flipAxisAndWinding)
+			{
+				for (auto& v : vertices)
+				{
+					v.position.z *= -1.f;
+					v.normal.z *= -1.f;
+				}
+			}
+
+			return true;
+		}
+	}
+}
@@ -0,0 +1,83 @@
+#pragma once
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <vector>
+#include "Image.h"
+#include "TextureSampler.h"
+
+namespace dae
+{
+	namespace Tests
+	{
+		//Most a channel of TextureSampler may be off SampleReference: float weights against doubles, and the float sRGB table
+		constexpr float MaxSampleError{ 1e-5f };
+
+		//What TextureSampler should return, straight from the rows of the mips and in doubles. UVs have to be small enough for their texel coordinates to fit in 64 bits.
+		inline Vector4 SampleReference(const std::vector<Image>& mips, MipContent content, SampleFilter filter, AddressMode addressMode, const Vector2& uv, float lod)
+		{
+			const auto address = [addressMode](int64_t x, int64_t size)
+				{
+					if (addressMode == AddressMode::Clamp)
+						return std::clamp(x, int64_t{ 0 }, size - 1);
+					if (addressMode == AddressMode::Wrap)
+						return (x % size + size) % size;
+					const int64_t mirrored{ (x % (2 * size) + 2 * size) % (2 * size) };
+					return mirrored < size ? mirrored : 2 * size - 1 - mirrored;
+				};
+			const auto sampleLevel = [&](const Image& mip) -> std::array<double, 4>
+				{
+					const auto texel = [&](int64_t x, int64_t y) -> std::array<double, 4>
+						{
+							const uint8_t* pTexel = mip.pixels.data() + (address(y, mip.height) * mip.width + address(x, mip.width)) * 4;
+							std::array<double, 4> channels{};
+							for (int channel = 0; channel < 4; ++channel)
+							{
+								const double stored{ pTexel[channel] / 255.0 };
+								channels[channel] = content != MipContent::Color || channel == 3 ? stored :
+									stored <= .04045 ? stored / 12.92 : std::pow((stored + .055) / 1.055, 2.4);
+							}
+							return channels;
+						};
+
+					const double x{ double(uv.x) * mip.width };
+					const double y{ double(uv.y) * mip.height };
+					if (filter == SampleFilter::Point)
+						return texel(static_cast<int64_t>(std::floor(x)), static_cast<int64_t>(std::floor(y)));
+
+					const double left{ std::floor(x - .5) };
+					const double top{ std::floor(y - .5) };
+					const double fractionX{ x - .5 - left };
+					const double fractionY{ y - .5 - top };
+					const int64_t x0{ static_cast<int64_t>(left) };
+					const int64_t y0{ static_cast<int64_t>(top) };
+					const std::array<double, 4> corners[4]{ texel(x0, y0), texel(x0 + 1, y0), texel(x0, y0 + 1), texel(x0 + 1, y0 + 1) };
+					std::array<double, 4> channels{};
+					for (int channel = 0; channel < 4; ++channel)
+					{
+						channels[channel] = (corners[0][channel] * (1.0 - fractionX) + corners[1][channel] * fractionX) * (1.0 - fractionY) +
+							(corners[2][channel] * (1.0 - fractionX) + corners[3][channel] * fractionX) * fractionY;
+					}
+					return channels;
+				};
+
+			const float lastLevel{ static_cast<float>(mips.size() - 1) };
+			lod = std::clamp(lod, 0.f, lastLevel);
+			std::array<double, 4> channels{};
+			if (filter == SampleFilter::Trilinear)
+			{
+				const size_t level0{ static_cast<size_t>(lod) };
+				const double blend{ lod - static_cast<double>(level0) };
+				const std::array<double, 4> channels0{ sampleLevel(mips[level0]) };
+				const std::array<double, 4> channels1{ sampleLevel(mips[std::min(level0 + 1, mips.size() - 1)]) };
+				for (int channel = 0; channel < 4; ++channel)
+					channels[channel] = channels0[channel] + (channels1[channel] - channels0[channel]) * blend;
+			}
+			else
+			{
+				channels = sampleLevel(mips[static_cast<size_t>(lod + .5f)]);
+			}
+			return Vector4{ static_cast<float>(channels[0]), static_cast<float>(channels[1]), static_cast<float>(channels[2]), static_cast<float>(channels[3]) };
+		}
+	}
+}
@@ -0,0 +1,132 @@
+#include "pch.h"
+
+#include <cmath>
+#include <cstddef>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <sstream>
+#include "Check.h"
+#include "CookedSdf.h"
+#include "SdfBaker.h"
+#include "TestMeshes.h"
+
+using namespace dae;
+
+//Baked fields hold the distance to the surface, negative inside, on any thread count, and cook to files that load back the same
+namespace
+{
+	constexpr size_t NumThreads{ 4 };
+	constexpr uint32_t Resolution{ 32 };
+
+	Vector3 GetVoxelCenter(const SignedDistanceField& field, uint32_t x, uint32_t y, uint32_t z)
+	{
+		return field.origin + Vector3{ x + .5f, y + .5f, z + .5f } * field.voxelSize;
+	}
+
+	void TestSphere()
+	{
+		//The sphere's facets sit up to 1 - cos(pi / 32) inside the unit sphere, the field can't be closer than that
+		std::vector<Vertex> vertices{};
+		std::vector<uint32_t> indices{};
+		Tests::CreateSphere(32, vertices, indices);
+		const SignedDistanceField field{ SdfBaker::Bake(vertices, indices, Resolution) };
+		if (!CHECK(!field.IsEmpty() && field.distances.size() == size_t(field.dimensions[0]) * field.dimensions[1] * field.dimensions[2]))
+			return;
+		CHECK(field.dimensions[0] == Resolution && field.dimensions[1] == Resolution && field.dimensions[2] == Resolution);
+
+		const float tolerance{ 1.f - std::cos(float(M_PI) / 32.f) + 1e-4f };
+		bool isNear{ true };
+		bool isSigned{ true };
+		for (uint32_t z = 0; z < field.dimensions[2]; ++z)
+		{
+			for (uint32_t y = 0; y < field.dimensions[1]; ++y)
+			{
+				for (uint32_t x = 0; x < field.dimensions[0]; ++x)
+				{
+					const Vector3 center{ GetVoxelCenter(field, x, y, z) };
+					const float expected{ center.Magnitude() - 1.f };
+					const float distance{ field.distances[(size_t(z) * field.dimensions[1] + y) * field.dimensions[0] + x] };
+					isNear = isNear && std::abs(distance - expected) <= tolerance;
+					//Clearly inside or outside, voxels closer than the facets are to the sphere could go either way
+					if (std::abs(expected) > tolerance)
+						isSigned = isSigned && (distance < 0.f) == (expected < 0.f);
+				}
+			}
+		}
+		CHECK(isNear);
+		CHECK(isSigned);
+
+		//Between the voxel centers and outside the grid too, trilinear filtering rounds off the cone at the center by up to a voxel
+		CHECK(std::abs(field.Sample(Vector3::Zero) + 1.f) < field.voxelSize && std::abs(field.Sample(Vector3{ 0.f, 1.5f, 0.f }) - .5f) < field.voxelSize);
+	}
+
+	void TestThreadCounts()
+	{
+		std::vector<Vertex> vertices{};
+		std::vector<uint32_t> indices{};
+		CHECK(Tests::LoadVehicle(vertices, indices));
+		const SignedDistanceField serial{ SdfBaker::Bake(vertices, indices, Resolution, 1) };
+		const SignedDistanceField parallel{ SdfBaker::Bake(vertices, indices, Resolution, NumThreads) };
+		CHECK(!serial.IsEmpty() && serial.distances == parallel.distances && serial.voxelSize == parallel.voxelSize);
+	}
+
+	void TestCooked()
+	{
+		std::vector<Vertex> vertices{};
+		std::vector<uint32_t> indices{};
+		Tests::CreateSphere(8, vertices, indices);
+		std::ostringstream obj{};
+		for (const Vertex& vertex : vertices)
+			obj << "v " << vertex.position.x << " " << vertex.position.y << " " << vertex.position.z << "\n";
+		for (size_t i = 0; i < indices.size(); i += 3)
+			obj << "f " << indices[i] + 1 << " " << indices[i + 1] + 1 << " " << indices[i + 2] + 1 << "\n";
+		const std::string objPath{ Tests::WriteTempFile("sdf_sphere.obj", obj.str()) };
+
+		std::ostringstream log{};
+		SignedDistanceField field{};
+		CHECK(SdfBaker::CookObj(objPath, 16, 1, field, log) && !field.IsEmpty());
+		CHECK(SdfBaker::IsUpToDate(objPath, 16) && !SdfBaker::IsUpToDate(objPath, 32));
+
+		//Loads back bit for bit
+		{
+			const CookedSdf cookedSdf{ CookedSdf::GetCookedPath(objPath) };
+			const SignedDistanceField loaded{ cookedSdf.IsValid() ? cookedSdf.GetField() : SignedDistanceField{} };
+			CHECK(loaded.distances == field.distances && loaded.voxelSize == field.voxelSize && loaded.origin.x == field.origin.x &&
+				loaded.origin.y == field.origin.y && loaded.origin.z == field.origin.z && cookedSdf.GetHeader().resolution == 16);
+			for (int axis = 0; axis < 3; ++axis)
+				CHECK(loaded.dimensions[axis] == field.dimensions[axis]);
+		}
+
+		//An edited source makes it stale
+		Tests::WriteTempFile("sdf_sphere.obj", obj.str() + "v 0 0 0\n");
+		CHECK(!SdfBaker::IsUpToDate(objPath, 16));
+
+		//Truncated files, and dimensions or offsets that wrap around past the file size, don't load
+		const std::string cookedPath{ CookedSdf::GetCookedPath(objPath) };
+		std::ifstream file{ cookedPath, std::ios::binary };
+		const std::string cooked{ std::istreambuf_iterator<char>{ file }, std::istreambuf_iterator<char>{} };
+		const auto isLoaded = [&](const std::string& bytes) { return CookedSdf{ Tests::WriteTempFile("damaged.sdf", bytes) }.IsValid(); };
+		CHECK(isLoaded(cooked) && !isLoaded(cooked.substr(0, cooked.size() - sizeof(float))));
+
+		std::string damaged{ cooked };
+		const uint32_t wrappingDimensions[3]{ 1u << 31, 1u << 31, 5 };
+		std::memcpy(damaged.data() + offsetof(CookedSdf::Header, dimensions), wrappingDimensions, sizeof(wrappingDimensions));
+		CHECK(!isLoaded(damaged));
+		damaged = cooked;
+		const uint64_t wrappingOffset{ ~uint64_t{ 3 } };
+		std::memcpy(damaged.data() + offsetof(CookedSdf::Header, distanceOffset), &wrappingOffset, sizeof(wrappingOffset));
+		CHECK(!isLoaded(damaged));
+
+		CHECK(!SdfBaker::CookObj(objPath + ".missing", 16, 1, field, log) && field.IsEmpty());
+	}
+}
+
+int main()
+{
+	return Tests::Run({
+		{ "Sphere", TestSphere },
+		{ "Thread counts", TestThreadCounts },
+		{ "Cooked", TestCooked }
+	});
+}
@@ -0,0 +1,125 @@
+#include "pch.h"
+
+#include <cstring>
+#include "Check.h"
+#include "SmoothNormals.h"
+#include "TestMeshes.h"
+
+using namespace dae;
+
+//Generated normals break at creases and only there, whatever the thread count
+namespace
+{
+	constexpr size_t NumThreads{ 4 };
+
+	Vector3 GetFaceNormal(const std::vector<Vertex>& vertices, const uint32_t* pCorners)
+	{
+		const Vector3& p0 = vertices[pCorners[0]].position;
+		return Vector3::Cross(vertices[pCorners[1]].position - p0, vertices[pCorners[2]].position - p0).Normalized();
+	}
+
+	//Unit cube with its 8 corners welded, every face split along another diagonal so the corners see different numbers of triangles
+	void CreateCube(std::vector<Vertex>& vertices, std::vector<uint32_t>& indices)
+	{
+		vertices.assign(8, Vertex{});
+		for (uint32_t corner = 0; corner < 8; ++corner)
+			vertices[corner].position = Vector3{ float(corner & 1), float((corner >> 1) & 1), float((corner >> 2) & 1) };
+
+		indices.clear();
+		for (uint32_t axis = 0; axis < 3; ++axis)
+		{
+			const uint32_t bit{ 1u << axis }, uBit{ 1u << (axis + 1) % 3 }, vBit{ 1u << (axis + 2) % 3 };
+			for (const uint32_t side : { 0u, bit })
+			{
+				const uint32_t quad[4]{ side, side | uBit, side | uBit | vBit, side | vBit };
+				const uint32_t split{ axis + side % 2 };
+				for (const uint32_t first : { split % 2, split % 2 + 2 })
+				{
+					uint32_t triangle[3]{ quad[first], quad[(first + 1) % 4], quad[(first + 2) % 4] };
+					//Facing out
+					const Vector3 outward{ (vertices[triangle[0]].position - Vector3{ .5f, .5f, .5f }) };
+					if (Vector3::Dot(GetFaceNormal(vertices, triangle), outward) < 0.f)
+						std::swap(triangle[1], triangle[2]);
+					indices.insert(indices.end(), triangle, triangle + 3);
+				}
+			}
+		}
+	}
+
+	void TestCreases()
+	{
+		//Every corner of a cube meets three faces at 90 degrees, it gets one vertex for each with that face's normal
+		std::vector<Vertex> vertices{};
+		std::vector<uint32_t> indices{};
+		CreateCube(vertices, indices);
+		SmoothNormals::Generate(vertices, indices);
+		CHECK(vertices.size() == 24);
+
+		bool isFlat{ true };
+		for (size_t i = 0; i < indices.size(); i += 3)
+		{
+			const Vector3 faceNormal{ GetFaceNormal(vertices, &indices[i]) };
+			for (size_t corner = 0; corner < 3; ++corner)
+				isFlat = isFlat && (vertices[indices[i + corner]].normal - faceNormal).Magnitude() < 1e-5f;
+		}
+		CHECK(isFlat);
+
+		//Past the crease angle everything is smooth: the 8 corners stay welded, their normals point out along the diagonals
+		CreateCube(vertices, indices);
+		SmoothNormals::Generate(vertices, indices, 100.f);
+		bool isDiagonal{ vertices.size() == 8 };
+		for (const Vertex& vertex : vertices)
+			isDiagonal = isDiagonal && (vertex.normal - (vertex.position - Vector3{ .5f, .5f, .5f }).Normalized()).Magnitude() < 1e-2f;
+		CHECK(isDiagonal);
+	}
+
+	void TestSmooth()
+	{
+		//A sphere has no crease, nothing gets split and the normals point out
+		std::vector<Vertex> vertices{};
+		std::vector<uint32_t> indices{};
+		Tests::CreateSphere(32, vertices, indices);
+		const std::vector<uint32_t> sourceIndices{ indices };
+		const size_t numSourceVertices{ vertices.size() };
+		for (Vertex& vertex : vertices)
+			vertex.normal = Vector3{};
+		SmoothNormals::Generate(vertices, indices);
+		CHECK(vertices.size() == numSourceVertices && indices == sourceIndices);
+
+		bool isOutward{ true };
+		for (const Vertex& vertex : vertices)
+			isOutward = isOutward && Vector3::Dot(vertex.normal, vertex.position) > .999f;
+		CHECK(isOutward);
+	}
+
+	void TestThreadCounts()
+	{
+		std::vector<Vertex> sourceVertices{};
+		std::vector<uint32_t> sourceIndices{};
+		CHECK(Tests::LoadVehicle(sourceVertices, sourceIndices));
+
+		std::vector<Vertex> serialVertices{ sourceVertices };
+		std::vector<uint32_t> serialIndices{ sourceIndices };
+		SmoothNormals::Generate(serialVertices, serialIndices, SmoothNormals::DefaultCreaseAngle, 1);
+
+		bool isSame{ true };
+		for (const size_t numThreads : { size_t{ 2 }, NumThreads })
+		{
+			std::vector<Vertex> vertices{ sourceVertices };
+			std::vector<uint32_t> indices{ sourceIndices };
+			SmoothNormals::Generate(vertices, indices, SmoothNormals::DefaultCreaseAngle, numThreads);
+			isSame = isSame && indices == serialIndices && vertices.size() == serialVertices.size() &&
+				std::memcmp(vertices.data(), serialVertices.data(), vertices.size() * sizeof(Vertex)) == 0;
+		}
+		CHECK(isSame);
+	}
+}
+
+int main()
+{
+	return Tests::Run({
+		{ "Creases", TestCreases },
+		{ "Smooth", TestSmooth },
+		{ "Thread counts", TestThreadCounts }
+	});
+}
@@ -0,0 +1,90 @@
+#include "pch.h"
+
+#include <chrono>
+#include <cstring>
+#include "Check.h"
+#include "MappedFile.h"
+#include "SourceStamp.h"
+
+using namespace dae;
+
+//The stamp cooked files keep of their source, and the timestamp it refreshes when a source was only touched
+namespace
+{
+	//Where the stamp sits in the stand-in cooked file, behind a header of its own like in the real ones
+	constexpr uint64_t StampOffset{ 24 };
+
+	std::string WriteCookedFile(const SourceStamp& stamp)
+	{
+		std::string text(StampOffset, 'h');
+		text.append(reinterpret_cast<const char*>(&stamp), sizeof(SourceStamp));
+		return Tests::WriteTempFile("source.cooked", text);
+	}
+
+	SourceStamp ReadStamp(const std::string& cookedPath)
+	{
+		SourceStamp stamp{};
+		const MappedFile file{ cookedPath };
+		if (file.GetSize() == StampOffset + sizeof(SourceStamp))
+			std::memcpy(&stamp, file.GetData() + StampOffset, sizeof(SourceStamp));
+		return stamp;
+	}
+
+	void Touch(const std::string& path, int seconds)
+	{
+		std::filesystem::last_write_time(path, std::filesystem::last_write_time(path) + std::chrono::seconds{ seconds });
+	}
+
+	void TestMatches()
+	{
+		const std::string sourcePath{ Tests::WriteTempFile("source.txt", "v 0 0 0\n") };
+		SourceStamp stamp{};
+		if (!CHECK(SourceStamp::Create(sourcePath, stamp)))
+			return;
+
+		const std::string cookedPath{ WriteCookedFile(stamp) };
+		CHECK(stamp.Matches(sourcePath, cookedPath, StampOffset));
+
+		//Same size, other content
+		Tests::WriteTempFile("source.txt", "v 1 0 0\n");
+		CHECK(!stamp.Matches(sourcePath, cookedPath, StampOffset));
+
+		//Other size
+		Tests::WriteTempFile("source.txt", "v 0 0 0 \n");
+		CHECK(!stamp.Matches(sourcePath, cookedPath, StampOffset));
+		CHECK(!stamp.Matches(Tests::GetTempDirectory().string() + "/missing.txt", cookedPath, StampOffset));
+	}
+
+	void TestTouchedSourceRefreshesStamp()
+	{
+		const std::string sourcePath{ Tests::WriteTempFile("source.txt", "v 0 0 0\n") };
+		SourceStamp stamp{};
+		if (!CHECK(SourceStamp::Create(sourcePath, stamp)))
+			return;
+
+		const std::string cookedPath{ WriteCookedFile(stamp) };
+		Touch(sourcePath, 10);
+		CHECK(stamp.Matches(sourcePath, cookedPath, StampOffset));
+
+		//The cooked file now has the touched source's timestamp, the rest of it is as it was
+		SourceStamp touchedStamp{};
+		CHECK(SourceStamp::Create(sourcePath, touchedStamp));
+		const SourceStamp refreshedStamp{ ReadStamp(cookedPath) };
+		CHECK(refreshedStamp.writeTime == touchedStamp.writeTime && refreshedStamp.writeTime != stamp.writeTime);
+		CHECK(refreshedStamp.size == stamp.size && refreshedStamp.hash == stamp.hash);
+		const MappedFile cookedFile{ cookedPath };
+		CHECK(cookedFile.GetSize() == StampOffset + sizeof(SourceStamp) && std::string(cookedFile.GetData(), StampOffset) == std::string(StampOffset, 'h'));
+
+		//A cooked file that can't be written doesn't change the answer
+		Touch(sourcePath, 10);
+		CHECK(stamp.Matches(sourcePath, Tests::GetTempDirectory().string() + "/missing/source.cooked", StampOffset));
+	}
+}
+
+int main()
+{
+	return Tests::Run({
+		{ "Matches", TestMatches },
+		{ "Touched source refreshes stamp", TestTouchedSourceRefreshesStamp }
+	});
+}
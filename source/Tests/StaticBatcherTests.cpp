@@ -0,0 +1,182 @@
+#include "pch.h"
+
+#include <cstring>
+#include "Check.h"
+#include "StaticBatcher.h"
+#include "TestMeshes.h"
+
+using namespace dae;
+
+//Batches draw what their instances drew, grouped by material, with frames that stay on their faces
+namespace
+{
+	//Grid with a tangent along x, split into two materials
+	struct Source
+	{
+		std::vector<Vertex> vertices{};
+		std::vector<uint32_t> indices{};
+		std::vector<Utils::ObjMaterialRange> materialRanges{};
+	};
+
+	Source CreateSource(uint32_t numQuads, const std::string& firstMaterial, const std::string& secondMaterial)
+	{
+		Source source{};
+		Tests::CreateGrid(numQuads, source.vertices, source.indices);
+		for (Vertex& vertex : source.vertices)
+			vertex.tangent = Vector4{ Vector3::UnitX, 1.f };
+
+		const uint32_t half{ static_cast<uint32_t>(source.indices.size() / 6 * 3) };
+		source.materialRanges = { { firstMaterial, 0, half }, { secondMaterial, half, static_cast<uint32_t>(source.indices.size()) - half } };
+		return source;
+	}
+
+	//Face normal for clockwise front faces
+	Vector3 GetFaceNormal(const std::vector<Vertex>& vertices, const uint32_t* pCorners)
+	{
+		const Vector3& p0 = vertices[pCorners[0]].position;
+		return Vector3::Cross(vertices[pCorners[1]].position - p0, vertices[pCorners[2]].position - p0).Normalized();
+	}
+
+	bool IsNear(const Vector3& a, const Vector3& b, float tolerance)
+	{
+		return (a - b).Magnitude() <= tolerance * std::max(1.f, b.Magnitude());
+	}
+
+	//A plain, a rotated and non-uniformly scaled, and a mirrored instance, then one without materials
+	std::vector<Matrix> GetWorlds()
+	{
+		return {
+			Matrix::CreateTranslation(10.f, 0.f, 0.f),
+			Matrix::CreateScale(1.f, 3.f, .5f) * Matrix::CreateRotation(.3f, 1.1f, -.7f) * Matrix::CreateTranslation(0.f, 5.f, -2.f),
+			Matrix::CreateScale(-1.f, 1.f, 2.f) * Matrix::CreateRotationY(.4f),
+			Matrix::CreateRotationX(2.f) * Matrix::CreateTranslation(-4.f, 1.f, 1.f)
+		};
+	}
+
+	void TestMerge()
+	{
+		const Source first{ CreateSource(8, "a", "b") };
+		const Source second{ CreateSource(5, "c", "b") };
+		const std::vector<Matrix> worlds{ GetWorlds() };
+		const std::vector<StaticInstance> instances{
+			{ &first.vertices, &first.indices, &first.materialRanges, worlds[0] },
+			{ &second.vertices, &second.indices, &second.materialRanges, worlds[1] },
+			{ &first.vertices, &first.indices, &first.materialRanges, worlds[2] },
+			{ &second.vertices, &second.indices, nullptr, worlds[3] }
+		};
+		const StaticBatch batch{ StaticBatcher::Merge(instances) };
+
+		//Materials in order of first use, the unnamed one last since only the last instance has it
+		const std::vector<std::string> expectedMaterials{ "a", "b", "c", "" };
+		bool isSameMaterials{ batch.materialRanges.size() == expectedMaterials.size() };
+		uint32_t nextIndex{};
+		for (size_t rangeIdx = 0; rangeIdx < batch.materialRanges.size() && isSameMaterials; ++rangeIdx)
+		{
+			isSameMaterials = batch.materialRanges[rangeIdx].material == expectedMaterials[rangeIdx] && batch.materialRanges[rangeIdx].indexStart == nextIndex;
+			nextIndex += batch.materialRanges[rangeIdx].indexCount;
+		}
+		if (!CHECK(isSameMaterials && nextIndex == batch.indices.size()))
+			return;
+		CHECK(batch.vertices.size() == first.vertices.size() * 2 + second.vertices.size() * 2);
+
+		//Every material draws its instances' triangles in instance order, transformed, mirrored ones with two corners swapped
+		std::vector<std::vector<Vector3>> expectedCorners(expectedMaterials.size());
+		for (size_t instanceIdx = 0; instanceIdx < instances.size(); ++instanceIdx)
+		{
+			const StaticInstance& instance = instances[instanceIdx];
+			const bool isMirrored{ instanceIdx == 2 };
+			const std::vector<Utils::ObjMaterialRange> ranges{ instance.pMaterialRanges ? *instance.pMaterialRanges
+				: std::vector<Utils::ObjMaterialRange>{ { "", 0, static_cast<uint32_t>(instance.pIndices->size()) } } };
+			for (const Utils::ObjMaterialRange& range : ranges)
+			{
+				const size_t materialIdx{ static_cast<size_t>(std::find(expectedMaterials.begin(), expectedMaterials.end(), range.material) - expectedMaterials.begin()) };
+				for (uint32_t i = range.indexStart; i < range.indexStart + range.indexCount; i += 3)
+				{
+					for (const uint32_t corner : { 0u, isMirrored ? 2u : 1u, isMirrored ? 1u : 2u })
+						expectedCorners[materialIdx].push_back(instance.world.TransformPoint((*instance.pVertices)[(*instance.pIndices)[i + corner]].position));
+				}
+			}
+		}
+
+		bool isSameCorners{ true };
+		for (size_t materialIdx = 0; materialIdx < expectedMaterials.size(); ++materialIdx)
+		{
+			const Utils::ObjMaterialRange& range = batch.materialRanges[materialIdx];
+			isSameCorners = isSameCorners && expectedCorners[materialIdx].size() == range.indexCount;
+			for (uint32_t i = 0; i < range.indexCount && isSameCorners; ++i)
+			{
+				const Vector3& position = batch.vertices[batch.indices[range.indexStart + i]].position;
+				isSameCorners = position.x == expectedCorners[materialIdx][i].x && position.y == expectedCorners[materialIdx][i].y && position.z == expectedCorners[materialIdx][i].z;
+			}
+		}
+		CHECK(isSameCorners);
+	}
+
+	void TestFrames()
+	{
+		//The grid's normals are its face normals, they have to stay so under every transform
+		const Source source{ CreateSource(4, "a", "a") };
+		for (const Matrix& world : GetWorlds())
+		{
+			const StaticBatch batch{ StaticBatcher::Merge({ { &source.vertices, &source.indices, nullptr, world } }) };
+			const float handedness{ Vector3::Dot(world.GetAxisX(), Vector3::Cross(world.GetAxisY(), world.GetAxisZ())) < 0.f ? -1.f : 1.f };
+
+			bool isOnFace{ true };
+			for (size_t i = 0; i + 2 < batch.indices.size(); i += 3)
+			{
+				const Vector3 faceNormal{ GetFaceNormal(batch.vertices, &batch.indices[i]) };
+				for (size_t corner = 0; corner < 3; ++corner)
+					isOnFace = isOnFace && IsNear(batch.vertices[batch.indices[i + corner]].normal, faceNormal, 1e-5f);
+			}
+			CHECK(isOnFace);
+
+			//Unit tangents along the transformed x axis, still perpendicular to the normal, handedness flipped by mirrors
+			bool isTangentFrame{ true };
+			for (const Vertex& vertex : batch.vertices)
+			{
+				const Vector3 tangent{ vertex.tangent.GetXYZ() };
+				isTangentFrame = isTangentFrame && IsNear(tangent, world.TransformVector(Vector3::UnitX).Normalized(), 1e-5f) &&
+					std::abs(Vector3::Dot(tangent, vertex.normal)) < 1e-5f && std::abs(vertex.normal.Magnitude() - 1.f) < 1e-5f && vertex.tangent.w == handedness;
+			}
+			CHECK(isTangentFrame);
+		}
+	}
+
+	void TestThreadCounts()
+	{
+		std::vector<Vertex> vertices{};
+		std::vector<uint32_t> indices{};
+		std::vector<Utils::ObjMaterialRange> materialRanges{};
+		CHECK(Tests::LoadVehicle(vertices, indices, &materialRanges));
+
+		std::vector<StaticInstance> instances{};
+		for (int instanceIdx = 0; instanceIdx < 9; ++instanceIdx)
+		{
+			const Matrix world{ Matrix::CreateScale(instanceIdx % 3 == 0 ? -1.f : 1.f, 1.f, 1.f) * Matrix::CreateRotationY(static_cast<float>(instanceIdx)) *
+				Matrix::CreateTranslation(instanceIdx * 300.f, 0.f, 0.f) };
+			instances.push_back(StaticInstance{ &vertices, &indices, instanceIdx % 2 ? &materialRanges : nullptr, world });
+		}
+
+		const StaticBatch serial{ StaticBatcher::Merge(instances, 1) };
+		const StaticBatch parallel{ StaticBatcher::Merge(instances, 4) };
+		CHECK(serial.indices == parallel.indices && serial.vertices.size() == parallel.vertices.size() &&
+			std::memcmp(serial.vertices.data(), parallel.vertices.data(), serial.vertices.size() * sizeof(Vertex)) == 0);
+		bool isSameRanges{ serial.materialRanges.size() == parallel.materialRanges.size() };
+		for (size_t rangeIdx = 0; rangeIdx < serial.materialRanges.size() && isSameRanges; ++rangeIdx)
+		{
+			const Utils::ObjMaterialRange& a = serial.materialRanges[rangeIdx];
+			const Utils::ObjMaterialRange& b = parallel.materialRanges[rangeIdx];
+			isSameRanges = a.material == b.material && a.indexStart == b.indexStart && a.indexCount == b.indexCount;
+		}
+		CHECK(isSameRanges);
+	}
+}
+
+int main()
+{
+	return Tests::Run({
+		{ "Merge", TestMerge },
+		{ "Frames", TestFrames },
+		{ "Thread counts", TestThreadCounts }
+	});
+}
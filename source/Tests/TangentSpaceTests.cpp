@@ -0,0 +1,157 @@
+#include "pch.h"
+
+#include <cstring>
+#include "Check.h"
+#include "TangentSpace.h"
+#include "TestMeshes.h"
+
+using namespace dae;
+
+//Tangent frames follow the uv mapping, mirrored uvs flip the handedness and split the vertices both sides share
+namespace
+{
+	constexpr size_t NumThreads{ 4 };
+
+	//Strip of quads one unit wide in the xz plane facing up, v runs against z the way flipped OBJ uvs do.
+	//u runs along x on the unmirrored quads and against it on the mirrored ones, the quads share their edge vertices.
+	void CreateStrip(const std::vector<bool>& isMirrored, std::vector<Vertex>& vertices, std::vector<uint32_t>& indices)
+	{
+		vertices.clear();
+		indices.clear();
+		float u{};
+		for (size_t column = 0; column <= isMirrored.size(); ++column)
+		{
+			for (uint32_t z = 0; z < 2; ++z)
+			{
+				Vertex vertex{};
+				vertex.position = Vector3{ float(column), 0.f, float(z) };
+				vertex.uv = Vector2{ u, 1.f - z };
+				vertex.normal = Vector3::UnitY;
+				vertices.push_back(vertex);
+			}
+			if (column < isMirrored.size())
+				u += isMirrored[column] ? -1.f : 1.f;
+		}
+
+		for (uint32_t quad = 0; quad < isMirrored.size(); ++quad)
+		{
+			const uint32_t corner{ quad * 2 };
+			indices.insert(indices.end(), { corner, corner + 1, corner + 2, corner + 2, corner + 1, corner + 3 });
+		}
+	}
+
+	//Whether w * cross(normal, tangent) is the bitangent, pointing the way v grows on the triangle
+	bool IsBitangentAlongV(const std::vector<Vertex>& vertices, const uint32_t* pCorners)
+	{
+		const Vertex& v0 = vertices[pCorners[0]];
+		const Vertex& v1 = vertices[pCorners[1]];
+		const Vertex& v2 = vertices[pCorners[2]];
+		const Vector3 e1{ v1.position - v0.position }, e2{ v2.position - v0.position };
+		const float du1{ v1.uv.x - v0.uv.x }, dv1{ v1.uv.y - v0.uv.y };
+		const float du2{ v2.uv.x - v0.uv.x }, dv2{ v2.uv.y - v0.uv.y };
+		const Vector3 vDirection{ (e2 * du1 - e1 * du2) * (1.f / (du1 * dv2 - du2 * dv1)) };
+
+		bool isAlong{ true };
+		for (const Vertex* pVertex : { &v0, &v1, &v2 })
+			isAlong = isAlong && Vector3::Dot(Vector3::Cross(pVertex->normal, pVertex->tangent.GetXYZ()) * pVertex->tangent.w, vDirection) > 0.f;
+		return isAlong;
+	}
+
+	void TestHandedness()
+	{
+		for (const bool isMirrored : { false, true })
+		{
+			std::vector<Vertex> vertices{};
+			std::vector<uint32_t> indices{};
+			CreateStrip({ isMirrored }, vertices, indices);
+			TangentSpace::Generate(vertices, indices);
+
+			const float expectedW{ isMirrored ? -1.f : 1.f };
+			bool isExpected{ vertices.size() == 4 };
+			for (const Vertex& vertex : vertices)
+				isExpected = isExpected && vertex.tangent.w == expectedW && (vertex.tangent.GetXYZ() - Vector3::UnitX * expectedW).Magnitude() < 1e-5f;
+			CHECK(isExpected);
+			CHECK(IsBitangentAlongV(vertices, &indices[0]) && IsBitangentAlongV(vertices, &indices[3]));
+		}
+	}
+
+	void TestMirrorSplit()
+	{
+		//The middle edge is shared by an unmirrored and a mirrored quad, its two vertices get a copy each
+		std::vector<Vertex> vertices{};
+		std::vector<uint32_t> indices{};
+		CreateStrip({ false, true }, vertices, indices);
+		const size_t numSourceVertices{ vertices.size() };
+		TangentSpace::Generate(vertices, indices);
+		if (!CHECK(vertices.size() == numSourceVertices + 2))
+			return;
+
+		bool isSplit{ true };
+		for (size_t i = 0; i < indices.size(); ++i)
+		{
+			const Vertex& vertex = vertices[indices[i]];
+			isSplit = isSplit && vertex.tangent.w == (i < 6 ? 1.f : -1.f);
+		}
+		for (size_t i = 0; i < indices.size(); i += 3)
+			isSplit = isSplit && IsBitangentAlongV(vertices, &indices[i]);
+		CHECK(isSplit);
+
+		//The copies sit where their originals do
+		bool isSamePlace{ true };
+		for (size_t vertexIdx = numSourceVertices; vertexIdx < vertices.size(); ++vertexIdx)
+		{
+			const Vertex& copy = vertices[vertexIdx];
+			isSamePlace = isSamePlace && copy.position.x == 1.f && copy.uv.x == 1.f;
+		}
+		CHECK(isSamePlace);
+	}
+
+	void TestOrthogonal()
+	{
+		std::vector<Vertex> vertices{};
+		std::vector<uint32_t> indices{};
+		CHECK(Tests::LoadVehicle(vertices, indices));
+		TangentSpace::Generate(vertices, indices, NumThreads);
+
+		bool isOrthonormal{ true };
+		for (const Vertex& vertex : vertices)
+		{
+			const Vector3 tangent{ vertex.tangent.GetXYZ() };
+			isOrthonormal = isOrthonormal && std::abs(Vector3::Dot(tangent, vertex.normal.Normalized())) < 1e-4f && std::abs(tangent.Magnitude() - 1.f) < 1e-4f &&
+				(vertex.tangent.w == 1.f || vertex.tangent.w == -1.f);
+		}
+		CHECK(isOrthonormal);
+	}
+
+	void TestThreadCounts()
+	{
+		std::vector<Vertex> sourceVertices{};
+		std::vector<uint32_t> sourceIndices{};
+		CHECK(Tests::LoadVehicle(sourceVertices, sourceIndices));
+
+		std::vector<Vertex> serialVertices{ sourceVertices };
+		std::vector<uint32_t> serialIndices{ sourceIndices };
+		TangentSpace::Generate(serialVertices, serialIndices, 1);
+
+		bool isSame{ true };
+		for (const size_t numThreads : { size_t{ 2 }, NumThreads })
+		{
+			std::vector<Vertex> vertices{ sourceVertices };
+			std::vector<uint32_t> indices{ sourceIndices };
+			TangentSpace::Generate(vertices, indices, numThreads);
+			isSame = isSame && indices == serialIndices && vertices.size() == serialVertices.size() &&
+				std::memcmp(vertices.data(), serialVertices.data(), vertices.size() * sizeof(Vertex)) == 0;
+		}
+		CHECK(isSame);
+	}
+}
+
+int main()
+{
+	return Tests::Run({
+		{ "Handedness", TestHandedness },
+		{ "Mirror split", TestMirrorSplit },
+		{ "Orthogonal", TestOrthogonal },
+		{ "Thread counts", TestThreadCounts }
+	});
+}
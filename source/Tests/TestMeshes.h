@@ -0,0 +1,150 @@
+#pragma once
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <string>
+#include <vector>
+#include "Utils.h"
+#include "Vertex.h"
+
+//Meshes the tests run the pipeline on, and ways to compare what comes out of it
+namespace dae
+{
+	namespace Tests
+	{
+		const std::string VehiclePath{ "Resources/vehicle.obj" };
+
+		//The vehicle the way Mesh parses it, welded
+		inline bool LoadVehicle(std::vector<Vertex>& vertices, std::vector<uint32_t>& indices, std::vector<Utils::ObjMaterialRange>* pMaterialRanges = nullptr)
+		{
+			return Utils::ParseOBJ(VehiclePath, vertices, indices, true, true, 1, pMaterialRanges);
+		}
+
+		//Flat grid of numQuads x numQuads quads in the xz plane, two triangles each, facing up for clockwise front faces
+		inline void CreateGrid(uint32_t numQuads, std::vector<Vertex>& vertices, std::vector<uint32_t>& indices)
+		{
+			const uint32_t numColumns{ numQuads + 1 };
+			vertices.assign(size_t(numColumns) * numColumns, Vertex{});
+			for (uint32_t y = 0; y < numColumns; ++y)
+			{
+				for (uint32_t x = 0; x < numColumns; ++x)
+				{
+					Vertex& vertex = vertices[size_t(y) * numColumns + x];
+					vertex.position = Vector3{ static_cast<float>(x), 0.f, static_cast<float>(y) };
+					vertex.uv = Vector2{ static_cast<float>(x) / numQuads, static_cast<float>(y) / numQuads };
+					vertex.normal = Vector3::UnitY;
+				}
+			}
+
+			indices.clear();
+			for (uint32_t y = 0; y < numQuads; ++y)
+			{
+				for (uint32_t x = 0; x < numQuads; ++x)
+				{
+					const uint32_t corner{ y * numColumns + x };
+					indices.insert(indices.end(), { corner, corner + numColumns, corner + 1, corner + 1, corner + numColumns, corner + numColumns + 1 });
+				}
+			}
+		}
+
+		//Grid of numQuads x numQuads in the xz plane facing up, whose left and right halves are UV islands.
+		//The halves share positions but not vertices along x = numQuads / 2, the right one's u is offset by 2.
+		inline void CreateSeamGrid(uint32_t numQuads, std::vector<Vertex>& vertices, std::vector<uint32_t>& indices)
+		{
+			const uint32_t half{ numQuads / 2 };
+			const uint32_t numColumns{ half + 1 };
+			vertices.clear();
+			indices.clear();
+			for (uint32_t side = 0; side < 2; ++side)
+			{
+				const uint32_t first{ static_cast<uint32_t>(vertices.size()) };
+				for (uint32_t z = 0; z <= numQuads; ++z)
+				{
+					for (uint32_t column = 0; column < numColumns; ++column)
+					{
+						Vertex vertex{};
+						vertex.position = Vector3{ float(side * half + column), 0.f, float(z) };
+						vertex.uv = Vector2{ float(column) / half + side * 2.f, float(z) / numQuads };
+						vertex.normal = Vector3::UnitY;
+						vertices.push_back(vertex);
+					}
+				}
+				for (uint32_t z = 0; z < numQuads; ++z)
+				{
+					for (uint32_t column = 0; column < half; ++column)
+					{
+						const uint32_t corner{ first + z * numColumns + column };
+						indices.insert(indices.end(), { corner, corner + numColumns, corner + numColumns + 1, corner, corner + numColumns + 1, corner + 1 });
+					}
+				}
+			}
+		}
+
+		//Unit sphere of rings x 2 * rings quads, welded, with normals pointing out, so nothing is a crease, border or seam
+		inline void CreateSphere(uint32_t rings, std::vector<Vertex>& vertices, std::vector<uint32_t>& indices)
+		{
+			const uint32_t segments{ rings * 2 };
+			vertices.clear();
+			indices.clear();
+			vertices.push_back(Vertex{});
+			vertices.back().position = vertices.back().normal = Vector3::UnitY;
+			for (uint32_t ring = 1; ring < rings; ++ring)
+			{
+				const float theta{ float(M_PI) * ring / rings };
+				for (uint32_t segment = 0; segment < segments; ++segment)
+				{
+					const float phi{ 2.f * float(M_PI) * segment / segments };
+					Vertex vertex{};
+					vertex.position = vertex.normal = Vector3{ std::sin(theta) * std::cos(phi), std::cos(theta), std::sin(theta) * std::sin(phi) };
+					vertices.push_back(vertex);
+				}
+			}
+			vertices.push_back(Vertex{});
+			vertices.back().position = vertices.back().normal = -Vector3::UnitY;
+
+			//Clockwise seen from outside
+			const auto getVertex = [&](uint32_t ring, uint32_t segment) { return 1 + (ring - 1) * segments + segment % segments; };
+			const uint32_t bottom{ static_cast<uint32_t>(vertices.size() - 1) };
+			for (uint32_t segment = 0; segment < segments; ++segment)
+			{
+				indices.insert(indices.end(), { 0, getVertex(1, segment + 1), getVertex(1, segment) });
+				for (uint32_t ring = 1; ring + 1 < rings; ++ring)
+				{
+					indices.insert(indices.end(), { getVertex(ring, segment), getVertex(ring, segment + 1), getVertex(ring + 1, segment + 1) });
+					indices.insert(indices.end(), { getVertex(ring, segment), getVertex(ring + 1, segment + 1), getVertex(ring + 1, segment) });
+				}
+				indices.insert(indices.end(), { bottom, getVertex(rings - 1, segment), getVertex(rings - 1, segment + 1) });
+			}
+		}
+
+		//Every triangle as the positions of its corners, rotated to start at the smallest so winding is kept, sorted.
+		//Equal for two triangle lists that draw the same triangles in any order and from any vertex order.
+		inline std::vector<std::array<float, 9>> GetTriangleSet(const std::vector<Vertex>& vertices, const uint32_t* pIndices, size_t numIndices)
+		{
+			std::vector<std::array<float, 9>> triangles{};
+			triangles.reserve(numIndices / 3);
+			for (size_t index = 0; index + 2 < numIndices; index += 3)
+			{
+				std::array<std::array<float, 3>, 3> corners{};
+				for (size_t corner = 0; corner < 3; ++corner)
+				{
+					const Vector3& position = vertices[pIndices[index + corner]].position;
+					corners[corner] = { position.x, position.y, position.z };
+				}
+				std::rotate(corners.begin(), std::min_element(corners.begin(), corners.end()), corners.end());
+
+				std::array<float, 9> triangle{};
+				for (size_t corner = 0; corner < 3; ++corner)
+					std::copy(corners[corner].begin(), corners[corner].end(), triangle.begin() + corner * 3);
+				triangles.push_back(triangle);
+			}
+			std::sort(triangles.begin(), triangles.end());
+			return triangles;
+		}
+
+		inline std::vector<std::array<float, 9>> GetTriangleSet(const std::vector<Vertex>& vertices, const std::vector<uint32_t>& indices)
+		{
+			return GetTriangleSet(vertices, indices.data(), indices.size());
+		}
+	}
+}
@@ -0,0 +1,165 @@
+#include "pch.h"
+
+#include <chrono>
+#include <cstddef>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <sstream>
+#include "Check.h"
+#include "CookedTexture.h"
+#include "TextureCooker.h"
+
+using namespace dae;
+
+//Cooked textures read back every level as it was cooked, a touched PNG stays up to date while a changed one doesn't, and damaged headers don't load
+namespace
+{
+	constexpr size_t NumThreads{ 4 };
+
+	//A copy of a PNG from Resources in the scratch directory, its cooked texture gets written next to it
+	std::string CopyPng(const std::string& name)
+	{
+		const std::filesystem::path path{ Tests::GetTempDirectory() / name };
+		std::filesystem::copy_file("Resources/" + name, path, std::filesystem::copy_options::overwrite_existing);
+		return path.string();
+	}
+
+	std::string ReadFile(const std::string& path)
+	{
+		std::ifstream file{ path, std::ios::binary };
+		return std::string{ std::istreambuf_iterator<char>{ file }, std::istreambuf_iterator<char>{} };
+	}
+
+	void TestRoundTrip()
+	{
+		const std::string pngPath{ CopyPng("vehicle_specular.png") };
+		for (const CompressionQuality quality : { CompressionQuality::None, CompressionQuality::Fast })
+		{
+			CookedTextureData data{};
+			std::ostringstream log{};
+			if (!CHECK(TextureCooker::CookPng(pngPath, MipContent::Linear, MipFilter::Box, quality, NumThreads, data, log)))
+				continue;
+			CHECK(data.width == 1024 && data.height == 1024 && data.levels.size() == 11);
+			CHECK((quality == CompressionQuality::None) == (data.format == TextureFormat::R8G8B8A8));
+
+			const CookedTexture cookedTexture{ CookedTexture::GetCookedPath(pngPath) };
+			if (!CHECK(cookedTexture.IsValid()))
+				continue;
+			CHECK(cookedTexture.GetFormat() == data.format && cookedTexture.GetContent() == MipContent::Linear && cookedTexture.GetFilter() == MipFilter::Box &&
+				cookedTexture.GetQuality() == quality && cookedTexture.GetMipCount() == data.levels.size());
+
+			bool isSame{ true };
+			for (uint32_t level = 0; level < cookedTexture.GetMipCount(); ++level)
+			{
+				const std::vector<uint8_t>& expected = data.levels[level];
+				isSame = isSame && cookedTexture.GetWidth(level) == std::max(1024u >> level, 1u) && cookedTexture.GetHeight(level) == cookedTexture.GetWidth(level) &&
+					cookedTexture.GetMipSize(level) == expected.size() && reinterpret_cast<uintptr_t>(cookedTexture.GetMipData(level)) % 16 == 0 &&
+					std::memcmp(cookedTexture.GetMipData(level), expected.data(), expected.size()) == 0;
+			}
+			CHECK(isSame);
+		}
+
+		//Level sizes have to match the format, and there are no more levels than the chain has
+		const std::string path{ (Tests::GetTempDirectory() / "written.tex").string() };
+		CHECK(CookedTexture::Write(path, TextureFormat::BC1, 8, 4, { std::vector<uint8_t>(16), std::vector<uint8_t>(8), std::vector<uint8_t>(8), std::vector<uint8_t>(8) },
+			MipContent::Color, MipFilter::Box, CompressionQuality::Fast, pngPath));
+		CHECK(CookedTexture{ path }.IsValid() && CookedTexture{ path }.GetMipCount() == 4);
+		CHECK(!CookedTexture::Write(path, TextureFormat::BC1, 8, 4, { std::vector<uint8_t>(8) }, MipContent::Color, MipFilter::Box, CompressionQuality::Fast, pngPath));
+		CHECK(!CookedTexture::Write(path, TextureFormat::BC1, 1, 1, { std::vector<uint8_t>(8), std::vector<uint8_t>(8) }, MipContent::Color, MipFilter::Box,
+			CompressionQuality::Fast, pngPath));
+		CHECK(!CookedTexture::Write(path, TextureFormat::BC1, 8, 4, {}, MipContent::Color, MipFilter::Box, CompressionQuality::Fast, pngPath));
+	}
+
+	void TestUpToDate()
+	{
+		const std::string pngPath{ CopyPng("vehicle_gloss.png") };
+		CookedTextureData data{};
+		std::ostringstream log{};
+		CHECK(TextureCooker::CookPng(pngPath, MipContent::Linear, MipFilter::Box, CompressionQuality::Fast, NumThreads, data, log));
+		CHECK(TextureCooker::IsUpToDate(pngPath, MipContent::Linear, MipFilter::Box, CompressionQuality::Fast));
+
+		//Other settings need another cook
+		CHECK(!TextureCooker::IsUpToDate(pngPath, MipContent::Color, MipFilter::Box, CompressionQuality::Fast));
+		CHECK(!TextureCooker::IsUpToDate(pngPath, MipContent::Linear, MipFilter::Kaiser, CompressionQuality::Fast));
+		CHECK(!TextureCooker::IsUpToDate(pngPath, MipContent::Linear, MipFilter::Box, CompressionQuality::High));
+
+		//Touched without changing a byte: the content still matches, and the new timestamp is taken over
+		std::filesystem::last_write_time(pngPath, std::filesystem::last_write_time(pngPath) + std::chrono::seconds{ 10 });
+		CHECK(TextureCooker::IsUpToDate(pngPath, MipContent::Linear, MipFilter::Box, CompressionQuality::Fast));
+		const CookedTexture cookedTexture{ CookedTexture::GetCookedPath(pngPath) };
+		SourceStamp stamp{};
+		CHECK(SourceStamp::Create(pngPath, stamp) && cookedTexture.IsValid() && cookedTexture.GetHeader().source.writeTime == stamp.writeTime);
+
+		//Same size, one byte changed near the end of the file, in the image data
+		std::string png{ ReadFile(pngPath) };
+		png[png.size() - 20] ^= 1;
+		std::ofstream{ pngPath, std::ios::binary | std::ios::trunc } << png;
+		CHECK(!TextureCooker::IsUpToDate(pngPath, MipContent::Linear, MipFilter::Box, CompressionQuality::Fast));
+
+		//No PNG, no cook
+		CHECK(!TextureCooker::IsUpToDate((Tests::GetTempDirectory() / "missing.png").string(), MipContent::Linear, MipFilter::Box, CompressionQuality::Fast));
+		CHECK(!TextureCooker::CookPng((Tests::GetTempDirectory() / "missing.png").string(), MipContent::Linear, MipFilter::Box, CompressionQuality::Fast, 1, data, log));
+		CHECK(data.levels.empty());
+	}
+
+	//Whether the cooked file with its bytes from offset replaced by value loads
+	template<typename T>
+	bool LoadsWith(const std::string& cooked, size_t offset, T value)
+	{
+		std::string damaged{ cooked };
+		std::memcpy(damaged.data() + offset, &value, sizeof(value));
+		return CookedTexture{ Tests::WriteTempFile("damaged.tex", damaged) }.IsValid();
+	}
+
+	void TestDamagedHeader()
+	{
+		//8x8 BC1, four levels
+		const std::string pngPath{ CopyPng("vehicle_gloss.png") };
+		const std::string path{ (Tests::GetTempDirectory() / "damaged_source.tex").string() };
+		CHECK(CookedTexture::Write(path, TextureFormat::BC1, 8, 8, { std::vector<uint8_t>(32), std::vector<uint8_t>(8), std::vector<uint8_t>(8), std::vector<uint8_t>(8) },
+			MipContent::Color, MipFilter::Box, CompressionQuality::Fast, pngPath));
+		const std::string cooked{ ReadFile(path) };
+		if (!CHECK(cooked.size() > sizeof(CookedTexture::Header) && LoadsWith(cooked, 0, CookedTexture::Magic)))
+			return;
+
+		//Truncated inside the last level and inside the header
+		CHECK(!CookedTexture{ Tests::WriteTempFile("damaged.tex", cooked.substr(0, cooked.size() - 1)) }.IsValid());
+		CHECK(!CookedTexture{ Tests::WriteTempFile("damaged.tex", cooked.substr(0, sizeof(CookedTexture::Header) - 1)) }.IsValid());
+		CHECK(!CookedTexture{ Tests::WriteTempFile("damaged.tex", std::string{}) }.IsValid());
+
+		//Fields out of range
+		CHECK(!LoadsWith(cooked, offsetof(CookedTexture::Header, magic), uint32_t{ 0 }));
+		CHECK(!LoadsWith(cooked, offsetof(CookedTexture::Header, version), CookedTexture::Version + 1));
+		CHECK(!LoadsWith(cooked, offsetof(CookedTexture::Header, format), uint32_t(TextureFormat::BC7) + 1));
+		CHECK(!LoadsWith(cooked, offsetof(CookedTexture::Header, content), uint32_t(MipContent::Normal) + 1));
+		CHECK(!LoadsWith(cooked, offsetof(CookedTexture::Header, filter), uint32_t(MipFilter::Kaiser) + 1));
+		CHECK(!LoadsWith(cooked, offsetof(CookedTexture::Header, quality), uint32_t(CompressionQuality::High) + 1));
+		CHECK(!LoadsWith(cooked, offsetof(CookedTexture::Header, width), uint32_t{ 0 }));
+		CHECK(!LoadsWith(cooked, offsetof(CookedTexture::Header, mipCount), uint32_t{ 0 }));
+		CHECK(!LoadsWith(cooked, offsetof(CookedTexture::Header, mipCount), uint32_t{ 5 }));
+		CHECK(!LoadsWith(cooked, offsetof(CookedTexture::Header, mipCount), CookedTexture::MaxMipCount + 1));
+		//A bigger texture needs bigger levels than the file has
+		CHECK(!LoadsWith(cooked, offsetof(CookedTexture::Header, width), uint32_t{ 64 }));
+
+		//Offsets misaligned, past the end, or just below 2^64 and still aligned: added to their level's size they wrap around to somewhere inside the file
+		bool isRejected{ true };
+		for (uint32_t level = 0; level < 4; ++level)
+		{
+			const size_t field{ offsetof(CookedTexture::Header, mipOffsets) + level * sizeof(uint64_t) };
+			isRejected = isRejected && !LoadsWith(cooked, field, uint64_t{ sizeof(CookedTexture::Header) + 1 }) &&
+				!LoadsWith(cooked, field, uint64_t{ cooked.size() + 15 } & ~uint64_t{ 15 }) && !LoadsWith(cooked, field, ~uint64_t{ 15 });
+		}
+		CHECK(isRejected);
+	}
+}
+
+int main()
+{
+	return Tests::Run({
+		{ "Round trip", TestRoundTrip },
+		{ "Up to date", TestUpToDate },
+		{ "Damaged header", TestDamagedHeader }
+	});
+}
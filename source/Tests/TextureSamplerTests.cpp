@@ -0,0 +1,173 @@
+#include "pch.h"
+
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <random>
+#include "Check.h"
+#include "MipGenerator.h"
+#include "ReferenceTextureSampler.h"
+#include "TextureSampler.h"
+
+using namespace dae;
+
+//Every filter and address mode samples like a plain sampler in doubles, batches give the same bits as single samples,
+//and NaN or far out of range UVs and levels of detail read texels like their reduced values do
+namespace
+{
+	constexpr SampleFilter Filters[]{ SampleFilter::Point, SampleFilter::Bilinear, SampleFilter::Trilinear };
+	constexpr AddressMode AddressModes[]{ AddressMode::Wrap, AddressMode::Clamp, AddressMode::Mirror };
+
+	std::vector<Image> CreateMips(uint32_t width, uint32_t height, MipContent content, uint32_t seed)
+	{
+		std::mt19937 generator{ seed };
+		std::uniform_int_distribution<uint32_t> distribution{ 0, 255 };
+		Image image{ width, height, std::vector<uint8_t>(size_t(width) * height * 4) };
+		for (uint8_t& value : image.pixels)
+			value = static_cast<uint8_t>(distribution(generator));
+		return MipGenerator::Generate(image, content, MipFilter::Box);
+	}
+
+	//A few times around the texture and every level of detail, past both ends
+	void CreateSamples(size_t count, float maxLod, std::vector<Vector2>& uvs, std::vector<float>& lods)
+	{
+		std::mt19937 generator{ 5 };
+		std::uniform_real_distribution<float> coordinate{ -2.f, 3.f };
+		std::uniform_real_distribution<float> levelOfDetail{ -1.f, maxLod + 1.f };
+		uvs.resize(count);
+		lods.resize(count);
+		for (size_t sample = 0; sample < count; ++sample)
+		{
+			uvs[sample] = Vector2{ coordinate(generator), coordinate(generator) };
+			lods[sample] = levelOfDetail(generator);
+		}
+	}
+
+	bool IsSame(const Vector4& a, const Vector4& b)
+	{
+		return std::memcmp(&a, &b, sizeof(Vector4)) == 0;
+	}
+
+	void TestReference()
+	{
+		//Sides that aren't whole tiles on some levels, and a chain that ends in a row
+		for (const MipContent content : { MipContent::Color, MipContent::Linear })
+		{
+			const std::vector<Image> mips{ content == MipContent::Color ? CreateMips(64, 48, content, 1) : CreateMips(37, 6, content, 2) };
+			TextureSampler sampler{ mips, content };
+			std::vector<Vector2> uvs{};
+			std::vector<float> lods{};
+			CreateSamples(20'000, static_cast<float>(mips.size()), uvs, lods);
+			for (const SampleFilter filter : Filters)
+			{
+				for (const AddressMode addressMode : AddressModes)
+				{
+					sampler.SetFilter(filter);
+					sampler.SetAddressMode(addressMode);
+					float maxError{};
+					for (size_t sample = 0; sample < uvs.size(); ++sample)
+					{
+						const Vector4 texel{ sampler.Sample(uvs[sample], lods[sample]) };
+						const Vector4 reference{ Tests::SampleReference(mips, content, filter, addressMode, uvs[sample], lods[sample]) };
+						for (int channel = 0; channel < 4; ++channel)
+							maxError = std::max(maxError, std::abs(reference[channel] - texel[channel]));
+					}
+					if (!CHECK(maxError <= Tests::MaxSampleError))
+						std::cout << "Filter " << uint32_t(filter) << ", address mode " << uint32_t(addressMode) << ": max error " << maxError << "\n";
+				}
+			}
+		}
+	}
+
+	void TestBatches()
+	{
+		//Counts that leave a partial batch, with and without levels of detail
+		const std::vector<Image> mips{ CreateMips(64, 48, MipContent::Color, 3) };
+		TextureSampler sampler{ mips, MipContent::Color };
+		std::vector<Vector2> uvs{};
+		std::vector<float> lods{};
+		CreateSamples(1003, static_cast<float>(mips.size()), uvs, lods);
+		bool isSame{ true };
+		for (const SampleFilter filter : Filters)
+		{
+			for (const AddressMode addressMode : AddressModes)
+			{
+				sampler.SetFilter(filter);
+				sampler.SetAddressMode(addressMode);
+				for (const size_t count : { uvs.size(), TextureSampler::BatchSize, size_t{ 3 } })
+				{
+					std::vector<Vector4> texels(count);
+					std::vector<Vector4> unlodded(count);
+					sampler.SampleN(uvs.data(), lods.data(), count, texels.data());
+					sampler.SampleN(uvs.data(), nullptr, count, unlodded.data());
+					for (size_t sample = 0; sample < count; ++sample)
+						isSame = isSame && IsSame(texels[sample], sampler.Sample(uvs[sample], lods[sample])) && IsSame(unlodded[sample], sampler.Sample(uvs[sample]));
+				}
+			}
+		}
+		CHECK(isSame);
+
+		//Nothing to sample is black
+		const TextureSampler empty{};
+		Vector4 texel{ 1.f, 1.f, 1.f, 1.f };
+		empty.SampleN(uvs.data(), nullptr, 1, &texel);
+		CHECK(empty.IsEmpty() && IsSame(empty.Sample(uvs[0]), Vector4{}) && IsSame(texel, Vector4{}));
+	}
+
+	void TestOutOfRange()
+	{
+		const std::vector<Image> mips{ CreateMips(16, 16, MipContent::Color, 4) };
+		TextureSampler sampler{ mips, MipContent::Color };
+		constexpr float nan{ std::numeric_limits<float>::quiet_NaN() };
+		constexpr float infinity{ std::numeric_limits<float>::infinity() };
+		const float lastLevel{ static_cast<float>(mips.size() - 1) };
+		const Vector2 inside{ .3f, .7f };
+
+		for (const SampleFilter filter : Filters)
+		{
+			for (const AddressMode addressMode : AddressModes)
+			{
+				sampler.SetFilter(filter);
+				sampler.SetAddressMode(addressMode);
+
+				//Whole numbers this large are even, wrap and mirror reduce them to 0 and clamp to the edge they're past
+				const float farEdge{ addressMode == AddressMode::Clamp ? 1.f : 0.f };
+				const Vector2 uvs[]{ { nan, .5f }, { .5f, nan }, { nan, nan }, { infinity, -infinity }, { 1e30f, 1e30f }, { -1e30f, -1e30f }, { 3e9f, -3e9f } };
+				const Vector2 reduced[]{ { 0.f, .5f }, { .5f, 0.f }, { 0.f, 0.f }, { addressMode == AddressMode::Clamp ? 1.f : 0.f, 0.f }, { farEdge, farEdge },
+					{ 0.f, 0.f }, { addressMode == AddressMode::Clamp ? 1.f : 0.f, 0.f } };
+				bool isReduced{ true };
+				for (size_t sample = 0; sample < std::size(uvs); ++sample)
+				{
+					const Vector4 texel{ sampler.Sample(uvs[sample], 1.f) };
+					isReduced = isReduced && IsSame(texel, sampler.Sample(reduced[sample], 1.f));
+					for (int channel = 0; channel < 4; ++channel)
+						isReduced = isReduced && texel[channel] >= 0.f && texel[channel] <= 1.f;
+				}
+				if (!CHECK(isReduced))
+					std::cout << "Filter " << uint32_t(filter) << ", address mode " << uint32_t(addressMode) << "\n";
+
+				//NaN and below is the first level, infinity the last
+				CHECK(IsSame(sampler.Sample(inside, nan), sampler.Sample(inside, 0.f)) && IsSame(sampler.Sample(inside, -infinity), sampler.Sample(inside, 0.f)));
+				CHECK(IsSame(sampler.Sample(inside, infinity), sampler.Sample(inside, lastLevel)) && IsSame(sampler.Sample(inside, 1e30f), sampler.Sample(inside, lastLevel)));
+
+				//Batches reduce them the same way
+				const float lods[std::size(uvs)]{ nan, infinity, -infinity, 1e30f, -1e30f, nan, 2.5f };
+				Vector4 texels[std::size(uvs)]{};
+				sampler.SampleN(uvs, lods, std::size(uvs), texels);
+				bool isSame{ true };
+				for (size_t sample = 0; sample < std::size(uvs); ++sample)
+					isSame = isSame && IsSame(texels[sample], sampler.Sample(uvs[sample], lods[sample]));
+				CHECK(isSame);
+			}
+		}
+	}
+}
+
+int main()
+{
+	return Tests::Run({
+		{ "Reference", TestReference },
+		{ "Batches", TestBatches },
+		{ "Out of range", TestOutOfRange }
+	});
+}
@@ -0,0 +1,276 @@
+#include "pch.h"
+
+#include <cmath>
+#include "Check.h"
+#include "TextureStreamer.h"
+
+using namespace dae;
+
+//The streamer keeps the budget and the device in step with it, evicts the textures wanted longest ago first, loads coarse mips before fine ones
+//within the upload size, and never starts a block compressed texture at a mip that isn't whole blocks
+namespace
+{
+	//Keeps the mips a GPU would, without one, and counts the mips a GPU couldn't create a texture from
+	class SimulatedStreamingDevice final : public IStreamingDevice
+	{
+	public:
+		void AddTexture(TextureFormat format, uint32_t width, uint32_t height, uint32_t mipCount)
+		{
+			m_Textures.push_back(Texture{ format, width, height, mipCount, TextureStreamer::GetAlwaysResidentMip(format, width, height, mipCount) });
+		}
+
+		uint32_t GetMostDetailedMip(uint32_t texture) const { return m_Textures[texture].mostDetailedMip; }
+		uint32_t GetInvalidMipCount() const { return m_NumInvalidMips; }
+
+		//Bytes of every resident mip, counted apart from the streamer
+		uint64_t GetResidentSize() const
+		{
+			uint64_t size{};
+			for (const Texture& texture : m_Textures)
+			{
+				for (uint32_t mip = texture.mostDetailedMip; mip < texture.mipCount; ++mip)
+					size += uint64_t(GetRowPitch(texture.format, std::max(texture.width >> mip, 1u))) * GetRowCount(texture.format, std::max(texture.height >> mip, 1u));
+			}
+			return size;
+		}
+
+		virtual bool SetMostDetailedMip(uint32_t texture, uint32_t mostDetailedMip) override
+		{
+			Texture& simulated = m_Textures[texture];
+			if (IsBlockCompressed(simulated.format) && ((simulated.width >> mostDetailedMip) % 4 != 0 || (simulated.height >> mostDetailedMip) % 4 != 0))
+				++m_NumInvalidMips;
+			simulated.mostDetailedMip = mostDetailedMip;
+			return true;
+		}
+
+	private:
+		struct Texture
+		{
+			TextureFormat format;
+			uint32_t width;
+			uint32_t height;
+			uint32_t mipCount;
+			uint32_t mostDetailedMip;
+		};
+
+		std::vector<Texture> m_Textures{};
+		uint32_t m_NumInvalidMips{};
+	};
+
+	//Texels per pixel that want mip
+	float GetTexelsPerPixel(uint32_t mip)
+	{
+		return std::ldexp(1.f, static_cast<int>(mip));
+	}
+
+	void TestScriptedCamera()
+	{
+		//A camera flies down the middle of a grid of quads and back, low over them and looking left and right.
+		//Each quad has a 2048x2048 BC7 texture of its own, the budget holds a fraction of them.
+		constexpr uint32_t numTextures{ 256 };
+		constexpr uint32_t textureSize{ 2048 };
+		constexpr uint32_t mipCount{ 12 };
+		constexpr float quadSize{ 4.f };
+		constexpr float spacing{ 8.f };
+		constexpr float viewportHeight{ 1080.f };
+		constexpr uint32_t numFrames{ 600 };
+		//tan of half the vertical field of view of 45 degrees, 16:9
+		const float fov{ tanf(22.5f * TO_RADIANS) };
+		const float horizontalAngle{ atanf(fov * 16.f / 9.f) };
+
+		for (const uint64_t budget : { 16ull << 20, 64ull << 20 })
+		{
+			SimulatedStreamingDevice device{};
+			TextureStreamer streamer{ device, budget, 4ull << 20 };
+			const uint32_t numColumns{ 16 };
+			std::vector<Vector3> centers{};
+			for (uint32_t textureIdx = 0; textureIdx < numTextures; ++textureIdx)
+			{
+				device.AddTexture(TextureFormat::BC7, textureSize, textureSize, mipCount);
+				streamer.AddTexture(TextureFormat::BC7, textureSize, textureSize, mipCount);
+				centers.push_back(Vector3{ (textureIdx % numColumns) * spacing, 0.f, (textureIdx / numColumns) * spacing });
+			}
+			CHECK(streamer.GetResidentSize() == device.GetResidentSize() && streamer.GetResidentSize() < budget);
+
+			const float gridLength{ (numTextures / numColumns) * spacing };
+			bool isInBudget{ true };
+			bool isInSync{ true };
+			bool isSharp{ false };
+			for (uint32_t frame = 0; frame < numFrames; ++frame)
+			{
+				const float progress{ static_cast<float>(frame) / numFrames };
+				const float along{ (progress < .5f ? progress * 2.f : 2.f - progress * 2.f) * (gridLength + 2.f * spacing) - spacing };
+				const Vector3 origin{ numColumns * spacing * .5f, 2.f, along };
+				const float yaw{ sinf(progress * 12.f) * 1.2f + (progress < .5f ? 0.f : PI) };
+				const Vector3 forward{ sinf(yaw), 0.f, cosf(yaw) };
+
+				for (uint32_t textureIdx = 0; textureIdx < numTextures; ++textureIdx)
+				{
+					//In front of the camera and within the horizontal field of view, widened by the quad's angular radius
+					const Vector3 toCenter{ centers[textureIdx] - origin };
+					const float centerDistance{ toCenter.Magnitude() };
+					const float radius{ quadSize * .7071f };
+					const float angle{ acosf(std::clamp(Vector3::Dot(toCenter, forward) / centerDistance, -1.f, 1.f)) };
+					if (centerDistance > radius && angle > horizontalAngle + asinf(radius / centerDistance))
+						continue;
+
+					//Same as Mesh::GetPixelsPerUv, with a quad that spans the texture once
+					const float distance{ std::max(centerDistance - radius, .1f) };
+					const float pixelsPerUv{ viewportHeight / (2.f * fov * distance) * quadSize };
+					streamer.Request(textureIdx, textureSize / pixelsPerUv);
+				}
+
+				streamer.Update();
+				isInBudget = isInBudget && streamer.GetResidentSize() <= budget;
+				isInSync = isInSync && streamer.GetResidentSize() == device.GetResidentSize();
+				for (uint32_t textureIdx = 0; textureIdx < numTextures; ++textureIdx)
+				{
+					isInSync = isInSync && device.GetMostDetailedMip(textureIdx) == streamer.GetMostDetailedMip(textureIdx);
+					isSharp = isSharp || streamer.GetMostDetailedMip(textureIdx) < TextureStreamer::GetAlwaysResidentMip(TextureFormat::BC7, textureSize, textureSize, mipCount);
+				}
+			}
+			CHECK(isInBudget);
+			CHECK(isInSync);
+			CHECK(isSharp && streamer.GetLoadCount() > 0 && streamer.GetEvictionCount() > 0);
+		}
+	}
+
+	void TestEviction()
+	{
+		//256x256 BC1: 32 KB at mip 0, 8 KB at mip 1, from mip 2 on always resident. Room for two textures at mip 0, not three.
+		constexpr uint32_t numTextures{ 3 };
+		SimulatedStreamingDevice device{};
+		uint64_t alwaysResidentSize{};
+		{
+			SimulatedStreamingDevice sizes{};
+			TextureStreamer streamer{ sizes, 0, 0 };
+			streamer.AddTexture(TextureFormat::BC1, 256, 256, 9);
+			alwaysResidentSize = streamer.GetResidentSize();
+		}
+		TextureStreamer streamer{ device, numTextures * alwaysResidentSize + 2 * (32768 + 8192), 1ull << 30 };
+		for (uint32_t textureIdx = 0; textureIdx < numTextures; ++textureIdx)
+		{
+			device.AddTexture(TextureFormat::BC1, 256, 256, 9);
+			streamer.AddTexture(TextureFormat::BC1, 256, 256, 9);
+		}
+		CHECK(streamer.GetMostDetailedMip(0) == 2);
+
+		//One texture a frame, the ones no longer requested stay cached as long as they fit
+		const auto requestOnly = [&](uint32_t texture)
+			{
+				streamer.Request(texture, GetTexelsPerPixel(0));
+				streamer.Update();
+			};
+		requestOnly(0);
+		requestOnly(1);
+		CHECK(streamer.GetMostDetailedMip(0) == 0 && streamer.GetMostDetailedMip(1) == 0 && streamer.GetEvictionCount() == 0);
+
+		//The third doesn't fit next to both, 0 was wanted longest ago
+		requestOnly(2);
+		CHECK(streamer.GetMostDetailedMip(0) == 2 && streamer.GetMostDetailedMip(1) == 0 && streamer.GetMostDetailedMip(2) == 0);
+
+		//Back to 0: now 1 is the oldest
+		requestOnly(0);
+		CHECK(streamer.GetMostDetailedMip(0) == 0 && streamer.GetMostDetailedMip(1) == 2 && streamer.GetMostDetailedMip(2) == 0);
+		CHECK(streamer.GetEvictionCount() == 4 && streamer.GetResidentSize() <= streamer.GetBudget());
+
+		//Room for one of the requested textures at mip 0, the other one stays a mip coarser than it wants
+		streamer.SetBudget(numTextures * alwaysResidentSize + 32768 + 8192 + 8192);
+		streamer.Request(0, GetTexelsPerPixel(0));
+		streamer.Request(2, GetTexelsPerPixel(0));
+		streamer.Update();
+		CHECK(streamer.GetMostDetailedMip(0) + streamer.GetMostDetailedMip(2) == 1 && streamer.GetMostDetailedMip(1) == 2);
+		CHECK(streamer.GetWantedMip(0) == 0 && streamer.GetWantedMip(2) == 0 && streamer.GetResidentSize() <= streamer.GetBudget());
+		for (uint32_t textureIdx = 0; textureIdx < numTextures; ++textureIdx)
+			CHECK(device.GetMostDetailedMip(textureIdx) == streamer.GetMostDetailedMip(textureIdx));
+	}
+
+	void TestCoarseToFine()
+	{
+		//1024x1024 BC1 is always resident from mip 4 on, mip 3 to 0 are 8 KB, 32 KB, 128 KB and 512 KB
+		SimulatedStreamingDevice device{};
+		device.AddTexture(TextureFormat::BC1, 1024, 1024, 11);
+		TextureStreamer streamer{ device, 1ull << 30, 1 };
+		streamer.AddTexture(TextureFormat::BC1, 1024, 1024, 11);
+		CHECK(streamer.GetMostDetailedMip(0) == 4);
+
+		//One mip an update when a single one is over the upload size, the coarsest missing one first
+		bool isCoarseToFine{ true };
+		for (uint32_t mip = 4; mip-- > 0;)
+		{
+			streamer.Request(0, GetTexelsPerPixel(0));
+			streamer.Update();
+			isCoarseToFine = isCoarseToFine && streamer.GetMostDetailedMip(0) == mip && device.GetMostDetailedMip(0) == mip && streamer.GetLoadCount() == 4 - mip;
+		}
+		CHECK(isCoarseToFine);
+
+		//Mips load until their sizes reach the upload size, the mip that goes past it is the last one
+		SimulatedStreamingDevice limitedDevice{};
+		TextureStreamer limited{ limitedDevice, 1ull << 30, 40000 };
+		for (uint32_t textureIdx = 0; textureIdx < 2; ++textureIdx)
+		{
+			limitedDevice.AddTexture(TextureFormat::BC1, 1024, 1024, 11);
+			limited.AddTexture(TextureFormat::BC1, 1024, 1024, 11);
+		}
+		//Candidates with the fewest texels per pixel first: texture 0 wants mip 1 and has mip 3 at a quarter texel per pixel, texture 1 wants mip 2
+		//and has mip 3 at half a texel. Texture 0 gets mips 3 and 2, then texture 1 its mip 3 and texture 0 its mip 1, then texture 1 its mip 2.
+		const auto update = [&]()
+			{
+				limited.Request(0, GetTexelsPerPixel(1));
+				limited.Request(1, GetTexelsPerPixel(2));
+				limited.Update();
+			};
+		update();
+		CHECK(limited.GetMostDetailedMip(0) == 2 && limited.GetMostDetailedMip(1) == 4 && limited.GetUploadedSize() == 8192 + 32768);
+		update();
+		CHECK(limited.GetMostDetailedMip(0) == 1 && limited.GetMostDetailedMip(1) == 3 && limited.GetUploadedSize() == 2 * 8192 + 32768 + 131072);
+		update();
+		CHECK(limited.GetMostDetailedMip(0) == 1 && limited.GetMostDetailedMip(1) == 2 && limited.GetUploadedSize() == 2 * 8192 + 2 * 32768 + 131072);
+	}
+
+	void TestWholeBlocks()
+	{
+		//Block compressed textures start at whole blocks: 1000x1000 halves to 500, 250, 125 and 62, only the first two are whole blocks
+		CHECK(TextureStreamer::GetAlwaysResidentMip(TextureFormat::BC1, 1000, 1000, 10) == 1);
+		CHECK(TextureStreamer::GetAlwaysResidentMip(TextureFormat::R8G8B8A8, 1000, 1000, 10) == 4);
+		CHECK(TextureStreamer::GetAlwaysResidentMip(TextureFormat::BC7, 2048, 2048, 12) == 5);
+		CHECK(TextureStreamer::GetAlwaysResidentMip(TextureFormat::BC7, 1024, 1000, 11) == 1);
+		CHECK(TextureStreamer::GetAlwaysResidentMip(TextureFormat::BC7, 64, 64, 7) == 0);
+		CHECK(TextureStreamer::CanBeMostDetailed(TextureFormat::BC5, 1000, 1000, 1) && !TextureStreamer::CanBeMostDetailed(TextureFormat::BC5, 1000, 1000, 2));
+
+		//Streamed in and out again, the device only ever gets asked for whole blocks
+		SimulatedStreamingDevice device{};
+		TextureStreamer streamer{ device, 1ull << 30, 1 };
+		device.AddTexture(TextureFormat::BC1, 1000, 1000, 10);
+		streamer.AddTexture(TextureFormat::BC1, 1000, 1000, 10);
+		device.AddTexture(TextureFormat::BC1, 1200, 1200, 11);
+		streamer.AddTexture(TextureFormat::BC1, 1200, 1200, 11);
+		CHECK(streamer.GetMostDetailedMip(0) == 1 && streamer.GetMostDetailedMip(1) == 2);
+		CHECK(streamer.GetResidentSize() == device.GetResidentSize());
+
+		//Mip 0 of the 1000 texture is one step from its always resident mip, so is mip 1 of the 1200 one at 600x600
+		for (uint32_t frame = 0; frame < 4; ++frame)
+		{
+			streamer.Request(0, GetTexelsPerPixel(0));
+			streamer.Request(1, GetTexelsPerPixel(1));
+			streamer.Update();
+		}
+		CHECK(streamer.GetWantedMip(0) == 0 && streamer.GetMostDetailedMip(0) == 0);
+		CHECK(streamer.GetWantedMip(1) == 1 && streamer.GetMostDetailedMip(1) == 1);
+
+		streamer.SetBudget(0);
+		streamer.Update();
+		CHECK(streamer.GetMostDetailedMip(0) == 1 && streamer.GetMostDetailedMip(1) == 2);
+		CHECK(device.GetInvalidMipCount() == 0 && streamer.GetResidentSize() == device.GetResidentSize());
+	}
+}
+
+int main()
+{
+	return Tests::Run({
+		{ "Scripted camera", TestScriptedCamera },
+		{ "Eviction", TestEviction },
+		{ "Coarse to fine", TestCoarseToFine },
+		{ "Whole blocks", TestWholeBlocks }
+	});
+}
@@ -0,0 +1,342 @@
+#include "pch.h"
+
+#include <cfloat>
+#include <random>
+#include "Check.h"
+#include "TestMeshes.h"
+#include "TriangleBvh.h"
+
+using namespace dae;
+
+//The vehicle's hierarchy against testing every triangle, its packets against single rays, and the same answers on any number of build threads
+namespace
+{
+	constexpr size_t NumThreads{ 4 };
+	constexpr size_t NumRays{ 4000 };
+
+	struct Ray
+	{
+		Vector3 origin;
+		Vector3 direction;
+		float maxDistance;
+	};
+
+	struct Mesh
+	{
+		std::vector<Vertex> vertices{};
+		std::vector<uint32_t> indices{};
+		Vector3 boundsMin{ FLT_MAX, FLT_MAX, FLT_MAX };
+		Vector3 boundsMax{ -FLT_MAX, -FLT_MAX, -FLT_MAX };
+
+		const Vector3& GetCorner(size_t triangle, size_t corner) const
+		{
+			return vertices[indices[triangle * 3 + corner]].position;
+		}
+
+		bool IsDegenerate(size_t triangle) const
+		{
+			return Vector3::Cross(GetCorner(triangle, 1) - GetCorner(triangle, 0), GetCorner(triangle, 2) - GetCorner(triangle, 0)).SqrMagnitude() == 0.f;
+		}
+	};
+
+	Mesh LoadMesh()
+	{
+		Mesh mesh{};
+		CHECK(Tests::LoadVehicle(mesh.vertices, mesh.indices));
+		for (const Vertex& vertex : mesh.vertices)
+		{
+			for (int axis = 0; axis < 3; ++axis)
+			{
+				mesh.boundsMin[axis] = std::min(mesh.boundsMin[axis], vertex.position[axis]);
+				mesh.boundsMax[axis] = std::max(mesh.boundsMax[axis], vertex.position[axis]);
+			}
+		}
+		return mesh;
+	}
+
+	//Closest hit from either side, in doubles (Moeller and Trumbore 1997), -1 for none
+	double IntersectTriangle(const Mesh& mesh, size_t triangle, const Ray& ray)
+	{
+		double corners[3][3]{};
+		for (size_t corner = 0; corner < 3; ++corner)
+		{
+			for (int axis = 0; axis < 3; ++axis)
+				corners[corner][axis] = mesh.GetCorner(triangle, corner)[axis];
+		}
+		const double origin[3]{ ray.origin.x, ray.origin.y, ray.origin.z };
+		const double direction[3]{ ray.direction.x, ray.direction.y, ray.direction.z };
+
+		const auto cross = [](const double* a, const double* b, double* result)
+			{
+				result[0] = a[1] * b[2] - a[2] * b[1];
+				result[1] = a[2] * b[0] - a[0] * b[2];
+				result[2] = a[0] * b[1] - a[1] * b[0];
+			};
+		const auto dot = [](const double* a, const double* b) { return a[0] * b[0] + a[1] * b[1] + a[2] * b[2]; };
+
+		double edge1[3]{}, edge2[3]{}, toOrigin[3]{};
+		for (int axis = 0; axis < 3; ++axis)
+		{
+			edge1[axis] = corners[1][axis] - corners[0][axis];
+			edge2[axis] = corners[2][axis] - corners[0][axis];
+			toOrigin[axis] = origin[axis] - corners[0][axis];
+		}
+		double p[3]{}, q[3]{};
+		cross(direction, edge2, p);
+		const double determinant{ dot(edge1, p) };
+		if (determinant == 0.)
+			return -1.;
+
+		const double u{ dot(toOrigin, p) / determinant };
+		cross(toOrigin, edge1, q);
+		const double v{ dot(direction, q) / determinant };
+		const double distance{ dot(edge2, q) / determinant };
+		return u >= 0. && v >= 0. && u + v <= 1. && distance > 0. && distance < ray.maxDistance ? distance : -1.;
+	}
+
+	double IntersectAll(const Mesh& mesh, const Ray& ray)
+	{
+		double closest{ -1. };
+		for (size_t triangle = 0; triangle < mesh.indices.size() / 3; ++triangle)
+		{
+			const double distance{ IntersectTriangle(mesh, triangle, ray) };
+			if (distance >= 0. && (closest < 0. || distance < closest))
+				closest = distance;
+		}
+		return closest;
+	}
+
+	//Closest point on a triangle (Ericson, Real-Time Collision Detection 5.1.5)
+	Vector3 GetClosestPoint(const Vector3& point, const Vector3& a, const Vector3& b, const Vector3& c)
+	{
+		const Vector3 ab{ b - a };
+		const Vector3 ac{ c - a };
+		const Vector3 ap{ point - a };
+		const float d1{ Vector3::Dot(ab, ap) };
+		const float d2{ Vector3::Dot(ac, ap) };
+		if (d1 <= 0.f && d2 <= 0.f)
+			return a;
+
+		const Vector3 bp{ point - b };
+		const float d3{ Vector3::Dot(ab, bp) };
+		const float d4{ Vector3::Dot(ac, bp) };
+		if (d3 >= 0.f && d4 <= d3)
+			return b;
+
+		const float vc{ d1 * d4 - d3 * d2 };
+		if (vc <= 0.f && d1 >= 0.f && d3 <= 0.f)
+			return a + ab * (d1 / (d1 - d3));
+
+		const Vector3 cp{ point - c };
+		const float d5{ Vector3::Dot(ab, cp) };
+		const float d6{ Vector3::Dot(ac, cp) };
+		if (d6 >= 0.f && d5 <= d6)
+			return c;
+
+		const float vb{ d5 * d2 - d1 * d6 };
+		if (vb <= 0.f && d2 >= 0.f && d6 <= 0.f)
+			return a + ac * (d2 / (d2 - d6));
+
+		const float va{ d3 * d6 - d5 * d4 };
+		if (va <= 0.f && d4 - d3 >= 0.f && d5 - d6 >= 0.f)
+			return b + (c - b) * ((d4 - d3) / ((d4 - d3) + (d5 - d6)));
+
+		const float denominator{ 1.f / (va + vb + vc) };
+		return a + ab * (vb * denominator) + ac * (vc * denominator);
+	}
+
+	//Rays from around the bounds at points on the mesh, so most of them hit, some cut short before they get there
+	std::vector<Ray> CreateRays(const Mesh& mesh, std::mt19937& generator)
+	{
+		std::uniform_real_distribution<float> unit{ 0.f, 1.f };
+		const Vector3 extent{ mesh.boundsMax - mesh.boundsMin };
+		std::vector<Ray> rays(NumRays);
+		for (Ray& ray : rays)
+		{
+			const size_t triangle{ generator() % (mesh.indices.size() / 3) };
+			const float u{ unit(generator) };
+			const float v{ unit(generator) * (1.f - u) };
+			const Vector3 target{ mesh.GetCorner(triangle, 0) * (1.f - u - v) + mesh.GetCorner(triangle, 1) * u + mesh.GetCorner(triangle, 2) * v };
+
+			ray.origin = mesh.boundsMin - extent * .5f + Vector3{ extent.x * unit(generator), extent.y * unit(generator), extent.z * unit(generator) } * 2.f;
+			const Vector3 toTarget{ target - ray.origin };
+			ray.direction = toTarget.Normalized();
+			ray.maxDistance = generator() % 4 == 0 ? toTarget.Magnitude() * unit(generator) : FLT_MAX;
+		}
+		return rays;
+	}
+
+	bool IsNear(double a, double b)
+	{
+		return std::abs(a - b) <= 1e-4 * std::max(1., std::abs(b));
+	}
+
+	void TestRays()
+	{
+		const Mesh mesh{ LoadMesh() };
+		const TriangleBvh bvh{ mesh.vertices, mesh.indices };
+		size_t numDegenerate{};
+		for (size_t triangle = 0; triangle < mesh.indices.size() / 3; ++triangle)
+			numDegenerate += mesh.IsDegenerate(triangle);
+		CHECK(bvh.GetTriangleCount() == mesh.indices.size() / 3 - numDegenerate);
+
+		//A ray grazing an edge may hit on one side of the comparison and miss on the other, a few of those are fine
+		std::mt19937 generator{ 23 };
+		size_t numHits{};
+		size_t numMismatches{};
+		bool isHitValid{ true };
+		for (const Ray& ray : CreateRays(mesh, generator))
+		{
+			const double reference{ IntersectAll(mesh, ray) };
+			TriangleBvh::RayHit hit{};
+			const bool isHit{ bvh.Intersect(ray.origin, ray.direction, ray.maxDistance, hit) };
+			const bool isOccluded{ bvh.IsOccluded(ray.origin, ray.direction, ray.maxDistance) };
+			numHits += isHit;
+			numMismatches += isHit != (reference >= 0.) || isOccluded != isHit || (isHit && !IsNear(hit.distance, reference));
+
+			//The hit lies on its triangle where its barycentrics say
+			if (isHit)
+			{
+				const Vector3 point{ mesh.GetCorner(hit.triangle, 0) * (1.f - hit.u - hit.v) + mesh.GetCorner(hit.triangle, 1) * hit.u + mesh.GetCorner(hit.triangle, 2) * hit.v };
+				isHitValid = isHitValid && hit.u >= -1e-5f && hit.v >= -1e-5f && hit.u + hit.v <= 1.f + 1e-5f &&
+					(ray.origin + ray.direction * hit.distance - point).Magnitude() <= 1e-3f * std::max(1.f, hit.distance);
+			}
+		}
+		CHECK(numHits > NumRays / 2);
+		CHECK(numMismatches <= NumRays / 1000);
+		CHECK(isHitValid);
+	}
+
+	void TestPackets()
+	{
+		const Mesh mesh{ LoadMesh() };
+		const TriangleBvh bvh{ mesh.vertices, mesh.indices };
+
+		//Incoherent packets of the random rays, and coherent ones through neighbouring pixels of a view of the vehicle
+		std::mt19937 generator{ 29 };
+		std::vector<Ray> rays{ CreateRays(mesh, generator) };
+		const Vector3 eye{ (mesh.boundsMin + mesh.boundsMax) * .5f + Vector3{ 0.f, .5f, -2.f } * (mesh.boundsMax - mesh.boundsMin).Magnitude() };
+		const Vector3 center{ (mesh.boundsMin + mesh.boundsMax) * .5f };
+		const Vector3 forward{ (center - eye).Normalized() };
+		const Vector3 right{ Vector3::Cross(Vector3::UnitY, forward).Normalized() };
+		const Vector3 up{ Vector3::Cross(forward, right) };
+		for (int y = 0; y < 64; ++y)
+		{
+			for (int x = 0; x < 64; ++x)
+			{
+				const Vector3 direction{ forward + right * ((x - 32) / 160.f) + up * ((y - 32) / 160.f) };
+				rays.push_back(Ray{ eye, direction.Normalized(), FLT_MAX });
+			}
+		}
+
+		bool isSame{ true };
+		bool isMissUntouched{ true };
+		size_t numHits{};
+		for (size_t first = 0; first + TriangleBvh::PacketSize <= rays.size(); first += TriangleBvh::PacketSize)
+		{
+			Vector3 origins[TriangleBvh::PacketSize]{};
+			Vector3 directions[TriangleBvh::PacketSize]{};
+			float maxDistances[TriangleBvh::PacketSize]{};
+			TriangleBvh::RayHit hits[TriangleBvh::PacketSize]{};
+			for (uint32_t ray = 0; ray < TriangleBvh::PacketSize; ++ray)
+			{
+				origins[ray] = rays[first + ray].origin;
+				directions[ray] = rays[first + ray].direction;
+				maxDistances[ray] = rays[first + ray].maxDistance;
+				hits[ray] = TriangleBvh::RayHit{ UINT32_MAX, -1.f, -1.f, -1.f };
+			}
+
+			const uint32_t hitMask{ bvh.IntersectPacket(origins, directions, maxDistances, hits) };
+			for (uint32_t ray = 0; ray < TriangleBvh::PacketSize; ++ray)
+			{
+				TriangleBvh::RayHit single{};
+				const bool isHit{ bvh.Intersect(origins[ray], directions[ray], maxDistances[ray], single) };
+				const bool isPacketHit{ (hitMask >> ray & 1u) != 0 };
+				isSame = isSame && isHit == isPacketHit &&
+					(!isHit || (hits[ray].triangle == single.triangle && IsNear(hits[ray].distance, single.distance) && std::abs(hits[ray].u - single.u) < 1e-4f &&
+						std::abs(hits[ray].v - single.v) < 1e-4f));
+				isMissUntouched = isMissUntouched && (isPacketHit || hits[ray].triangle == UINT32_MAX);
+				numHits += isHit;
+			}
+		}
+		CHECK(isSame);
+		CHECK(isMissUntouched);
+		CHECK(numHits > rays.size() / 2);
+	}
+
+	void TestClosest()
+	{
+		const Mesh mesh{ LoadMesh() };
+		const TriangleBvh bvh{ mesh.vertices, mesh.indices };
+
+		//Points around and inside the vehicle, with and without the previous hit as a hint
+		std::mt19937 generator{ 31 };
+		std::uniform_real_distribution<float> unit{ 0.f, 1.f };
+		const Vector3 extent{ mesh.boundsMax - mesh.boundsMin };
+		bool isClosest{ true };
+		bool isHintSame{ true };
+		TriangleBvh::ClosestHit previous{};
+		bool hasPrevious{ false };
+		for (int query = 0; query < 300; ++query)
+		{
+			const Vector3 position{ mesh.boundsMin - extent * .25f + Vector3{ extent.x * unit(generator), extent.y * unit(generator), extent.z * unit(generator) } * 1.5f };
+			float referenceSqrDistance{ FLT_MAX };
+			for (size_t triangle = 0; triangle < mesh.indices.size() / 3; ++triangle)
+			{
+				if (!mesh.IsDegenerate(triangle))
+					referenceSqrDistance = std::min(referenceSqrDistance, (GetClosestPoint(position, mesh.GetCorner(triangle, 0), mesh.GetCorner(triangle, 1), mesh.GetCorner(triangle, 2)) - position).SqrMagnitude());
+			}
+
+			TriangleBvh::ClosestHit hit{};
+			isClosest = isClosest && bvh.FindClosest(position, FLT_MAX, hit) && IsNear(hit.sqrDistance, referenceSqrDistance) &&
+				IsNear((hit.point - position).SqrMagnitude(), referenceSqrDistance);
+
+			TriangleBvh::ClosestHit hintedHit{};
+			isHintSame = isHintSame && bvh.FindClosest(position, FLT_MAX, hintedHit, hasPrevious ? &previous : nullptr) && IsNear(hintedHit.sqrDistance, hit.sqrDistance);
+			previous = hit;
+			hasPrevious = true;
+		}
+		CHECK(isClosest);
+		CHECK(isHintSame);
+
+		//Nothing within a radius smaller than the distance to the mesh
+		TriangleBvh::ClosestHit hit{};
+		CHECK(!bvh.FindClosest(mesh.boundsMax + extent, extent.SqrMagnitude() * .5f, hit));
+	}
+
+	void TestThreadCounts()
+	{
+		const Mesh mesh{ LoadMesh() };
+		const TriangleBvh serial{ mesh.vertices, mesh.indices, 1 };
+		const TriangleBvh parallel{ mesh.vertices, mesh.indices, NumThreads };
+		CHECK(serial.GetNodeCount() == parallel.GetNodeCount() && serial.GetTriangleCount() == parallel.GetTriangleCount());
+
+		//The same tree answers every query the same
+		std::mt19937 generator{ 37 };
+		bool isSame{ true };
+		for (const Ray& ray : CreateRays(mesh, generator))
+		{
+			TriangleBvh::RayHit serialHit{};
+			TriangleBvh::RayHit parallelHit{};
+			const bool isSerialHit{ serial.Intersect(ray.origin, ray.direction, ray.maxDistance, serialHit) };
+			const bool isParallelHit{ parallel.Intersect(ray.origin, ray.direction, ray.maxDistance, parallelHit) };
+			isSame = isSame && isSerialHit == isParallelHit && (!isSerialHit || (serialHit.triangle == parallelHit.triangle && serialHit.distance == parallelHit.distance));
+
+			TriangleBvh::ClosestHit serialClosest{};
+			TriangleBvh::ClosestHit parallelClosest{};
+			isSame = isSame && serial.FindClosest(ray.origin, FLT_MAX, serialClosest) && parallel.FindClosest(ray.origin, FLT_MAX, parallelClosest) &&
+				serialClosest.triangle == parallelClosest.triangle && serialClosest.slot == parallelClosest.slot && serialClosest.sqrDistance == parallelClosest.sqrDistance;
+		}
+		CHECK(isSame);
+	}
+}
+
+int main()
+{
+	return Tests::Run({
+		{ "Rays", TestRays },
+		{ "Packets", TestPackets },
+		{ "Closest", TestClosest },
+		{ "Thread counts", TestThreadCounts }
+	});
+}
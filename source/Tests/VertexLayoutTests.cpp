@@ -0,0 +1,178 @@
+#include "pch.h"
+
+#include <cfloat>
+#include <cmath>
+#include <cstring>
+#include <random>
+#include "Check.h"
+#include "TestMeshes.h"
+#include "VertexLayout.h"
+
+using namespace dae;
+
+//The compact vertex layouts and their kernels, within the error their formats allow
+namespace
+{
+	//Largest angle between a unit vector and its octahedral snorm16 round trip, a little over the 0.0007 rad measured on random directions
+	constexpr float MaxOctahedralAngle{ .001f };
+
+	float GetAngle(const Vector3& a, const Vector3& b)
+	{
+		return acosf(std::clamp(Vector3::Dot(a.Normalized(), b.Normalized()), -1.f, 1.f));
+	}
+
+	bool IsHalfNaN(uint16_t half)
+	{
+		return (half & 0x7C00u) == 0x7C00u && (half & 0x03FFu) != 0;
+	}
+
+	void TestHalfConversion()
+	{
+		//Every half survives the round trip through float, NaNs stay NaNs
+		std::vector<uint16_t> halves(65536);
+		for (uint32_t bits = 0; bits < halves.size(); ++bits)
+			halves[bits] = static_cast<uint16_t>(bits);
+		std::vector<float> floats(halves.size());
+		std::vector<uint16_t> roundTrip(halves.size());
+		VertexCodec::HalfToFloat(halves.data(), floats.data(), halves.size());
+		VertexCodec::FloatToHalf(floats.data(), roundTrip.data(), roundTrip.size());
+		bool isSame{ true };
+		for (size_t i = 0; i < halves.size(); ++i)
+			isSame = isSame && (IsHalfNaN(halves[i]) ? IsHalfNaN(roundTrip[i]) : roundTrip[i] == halves[i]);
+		CHECK(isSame);
+
+		//Rounding to nearest, the SIMD body and the scalar tail agree
+		std::mt19937 generator{ 7 };
+		std::uniform_real_distribution<float> range{ -70000.f, 70000.f };
+		std::vector<float> values(1003);
+		for (float& value : values)
+			value = range(generator) * (generator() % 2 ? 1.f : 1e-6f);
+		values[0] = FLT_MAX;
+		values[1] = -0.f;
+		values[2] = 6e-8f;
+		values[3] = NAN;
+		std::vector<uint16_t> batch(values.size());
+		VertexCodec::FloatToHalf(values.data(), batch.data(), values.size());
+		bool isSameAsSingle{ true };
+		bool isWithinHalfUlp{ true };
+		for (size_t i = 0; i < values.size(); ++i)
+		{
+			uint16_t single{};
+			VertexCodec::FloatToHalf(&values[i], &single, 1);
+			isSameAsSingle = isSameAsSingle && (std::isnan(values[i]) ? IsHalfNaN(batch[i]) && IsHalfNaN(single) : batch[i] == single);
+
+			//Half of the spacing of halves around the value, 2^-24 for subnormals
+			float decoded{};
+			VertexCodec::HalfToFloat(&batch[i], &decoded, 1);
+			if (std::isfinite(values[i]) && std::abs(values[i]) <= 65504.f)
+			{
+				const float spacing{ std::max(std::ldexp(1.f, std::ilogb(std::max(std::abs(values[i]), 6.2e-5f)) - 10), std::ldexp(1.f, -24)) };
+				isWithinHalfUlp = isWithinHalfUlp && std::abs(decoded - values[i]) <= spacing * .5f;
+			}
+		}
+		CHECK(isSameAsSingle);
+		CHECK(isWithinHalfUlp);
+		CHECK(batch[0] == 0x7C00u);
+	}
+
+	void TestOctahedral()
+	{
+		//Random directions, the axes and the folds between the octants
+		std::mt19937 generator{ 3 };
+		std::normal_distribution<float> normal{};
+		std::vector<Vector3> directions{ Vector3::UnitX, -Vector3::UnitX, Vector3::UnitY, -Vector3::UnitY, Vector3::UnitZ, -Vector3::UnitZ,
+			Vector3{ 1.f, 1.f, 0.f }.Normalized(), Vector3{ -1.f, 0.f, -1.f }.Normalized(), Vector3{ 1.f, -1.f, -1e-7f }.Normalized() };
+		while (directions.size() < 100'003)
+			directions.push_back(Vector3{ normal(generator), normal(generator), normal(generator) }.Normalized());
+
+		std::vector<int16_t> encoded(directions.size() * 2);
+		std::vector<Vector3> decoded(directions.size());
+		VertexCodec::EncodeOctahedral(directions.data(), encoded.data(), directions.size());
+		VertexCodec::DecodeOctahedral(encoded.data(), decoded.data(), decoded.size());
+
+		float maxAngle{};
+		bool isUnit{ true };
+		for (size_t i = 0; i < directions.size(); ++i)
+		{
+			maxAngle = std::max(maxAngle, GetAngle(directions[i], decoded[i]));
+			isUnit = isUnit && std::abs(decoded[i].Magnitude() - 1.f) < 1e-5f;
+		}
+		CHECK(maxAngle < MaxOctahedralAngle);
+		CHECK(isUnit);
+	}
+
+	void TestLayouts()
+	{
+		std::vector<Vertex> vertices{};
+		std::vector<uint32_t> indices{};
+		CHECK(Tests::LoadVehicle(vertices, indices));
+		for (Vertex& vertex : vertices)
+			vertex.color = ColorRGB{ .25f, .5f, .75f };
+
+		//Every attribute starts inside the vertex
+		for (const VertexLayout layout : { VertexLayout::Full, VertexLayout::Compact, VertexLayout::CompactQuantized })
+		{
+			for (const VertexAttribute& attribute : VertexCodec::GetAttributes(layout))
+				CHECK(attribute.offset < VertexCodec::GetStride(layout));
+		}
+		CHECK(VertexCodec::GetStride(VertexLayout::Full) == sizeof(Vertex));
+		CHECK(VertexCodec::GetStride(VertexLayout::Compact) == 24);
+		CHECK(VertexCodec::GetStride(VertexLayout::CompactQuantized) == 20);
+
+		//The full layout is the vertex as is
+		const EncodedVertices full{ VertexCodec::Encode(vertices, VertexLayout::Full) };
+		const std::vector<Vertex> fullDecoded{ VertexCodec::Decode(full) };
+		CHECK(fullDecoded.size() == vertices.size() && std::memcmp(fullDecoded.data(), vertices.data(), vertices.size() * sizeof(Vertex)) == 0);
+
+		for (const VertexLayout layout : { VertexLayout::Compact, VertexLayout::CompactQuantized })
+		{
+			const EncodedVertices encoded{ VertexCodec::Encode(vertices, layout) };
+			CHECK(encoded.count == vertices.size() && encoded.data.size() == size_t(encoded.stride) * encoded.count);
+			const std::vector<Vertex> decoded{ VertexCodec::Decode(encoded) };
+			if (!CHECK(decoded.size() == vertices.size()))
+				continue;
+
+			//Float positions stay exact, quantized ones are within half a step of the bounds over 65535
+			const Vector3 extent{ encoded.boundsMax - encoded.boundsMin };
+			bool isPositionWithinBound{ true };
+			bool isUvWithinBound{ true };
+			bool isHandednessKept{ true };
+			bool isColorDropped{ true };
+			float maxNormalAngle{};
+			float maxTangentAngle{};
+			for (size_t vertexIdx = 0; vertexIdx < vertices.size(); ++vertexIdx)
+			{
+				const Vertex& vertex = vertices[vertexIdx];
+				const Vertex& result = decoded[vertexIdx];
+				for (int axis = 0; axis < 3; ++axis)
+				{
+					const float bound{ layout == VertexLayout::Compact ? 0.f : extent[axis] / 65535.f * .5f + extent[axis] * 1e-6f };
+					isPositionWithinBound = isPositionWithinBound && std::abs(result.position[axis] - vertex.position[axis]) <= bound;
+				}
+				for (int axis = 0; axis < 2; ++axis)
+					isUvWithinBound = isUvWithinBound && std::abs(result.uv[axis] - vertex.uv[axis]) <= std::abs(vertex.uv[axis]) / 2048.f + 6e-8f;
+
+				maxNormalAngle = std::max(maxNormalAngle, GetAngle(result.normal, vertex.normal));
+				maxTangentAngle = std::max(maxTangentAngle, GetAngle(result.tangent.GetXYZ(), vertex.tangent.GetXYZ()));
+				isHandednessKept = isHandednessKept && result.tangent.w == vertex.tangent.w;
+				isColorDropped = isColorDropped && result.color.r == 0.f && result.color.g == 0.f && result.color.b == 0.f;
+			}
+			CHECK(isPositionWithinBound);
+			CHECK(isUvWithinBound);
+			CHECK(maxNormalAngle < MaxOctahedralAngle);
+			//The handedness bit moves the tangent's second component by one step
+			CHECK(maxTangentAngle < MaxOctahedralAngle * 1.5f);
+			CHECK(isHandednessKept);
+			CHECK(isColorDropped);
+		}
+	}
+}
+
+int main()
+{
+	return Tests::Run({
+		{ "Half conversion", TestHalfConversion },
+		{ "Octahedral", TestOctahedral },
+		{ "Layouts", TestLayouts }
+	});
+}
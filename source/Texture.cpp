@@ -1,5 +1,9 @@
 #include "pch.h"
 #include "Texture.h"
+#include "BlockCompressor.h"
+#include "CookedTexture.h"
+#include "ParallelFor.h"
+#include "TextureStreamer.h"
 #include "Vector2.h"
 #include <SDL_image.h>
 
@@ -7,15 +11,94 @@
 
 namespace dae
 {
-	Texture::Texture(SDL_Surface* pSurface, ID3D11Device* pDevice) :
-		m_pSurface{ pSurface },
-		m_pSurfacePixels{ (uint32_t*)pSurface->pixels }
+	namespace
 	{
-		DXGI_FORMAT format = DXGI_FORMAT_R8G8B8A8_UNORM;
+		//Every mip decoded back to RGBA8, levels holds them in format the way cooked textures store them
+		TextureSampler CreateSampler(TextureFormat format, uint32_t width, uint32_t height, const std::vector<const uint8_t*>& levels, MipContent content)
+		{
+			std::vector<Image> mips(levels.size());
+			for (uint32_t level = 0; level < levels.size(); ++level)
+			{
+				Image& mip = mips[level];
+				mip.width = std::max(width >> level, 1u);
+				mip.height = std::max(height >> level, 1u);
+				if (format == TextureFormat::R8G8B8A8)
+				{
+					mip.pixels.assign(levels[level], levels[level] + size_t(mip.width) * mip.height * 4);
+				}
+				else if (!BlockCompressor::Decode(levels[level], mip.width, mip.height, format, mip))
+				{
+					mips.resize(level);
+					break;
+				}
+			}
+			return TextureSampler{ mips, content };
+		}
+
+		TextureSampler CreateSampler(const CookedTexture& cookedTexture)
+		{
+			std::vector<const uint8_t*> levels{};
+			for (uint32_t level = 0; level < cookedTexture.GetMipCount(); ++level)
+				levels.push_back(cookedTexture.GetMipData(level));
+			return CreateSampler(cookedTexture.GetFormat(), cookedTexture.GetWidth(), cookedTexture.GetHeight(), levels, cookedTexture.GetContent());
+		}
+
+		TextureSampler CreateSampler(const CookedTextureData& data, MipContent content)
+		{
+			std::vector<const uint8_t*> levels{};
+			for (const std::vector<uint8_t>& level : data.levels)
+				levels.push_back(level.data());
+			return CreateSampler(data.format, data.width, data.height, levels, content);
+		}
+	}
+
+	Texture::Texture(const CookedTextureData& data, ID3D11Device* pDevice)
+	{
+		D3D11_SUBRESOURCE_DATA mips[CookedTexture::MaxMipCount]{};
+		const uint32_t numMips{ std::min(static_cast<uint32_t>(data.levels.size()), CookedTexture::MaxMipCount) };
+		for (uint32_t level = 0; level < numMips; ++level)
+		{
+			mips[level].pSysMem = data.levels[level].data();
+			mips[level].SysMemPitch = GetRowPitch(data.format, std::max(data.width >> level, 1u));
+			mips[level].SysMemSlicePitch = static_cast<UINT>(data.levels[level].size());
+		}
+		m_Format = data.format;
+		m_Width = data.width;
+		m_Height = data.height;
+		m_MipCount = numMips;
+		CreateResource(pDevice, data.format, data.width, data.height, mips, numMips);
+	}
+
+	Texture::Texture(std::unique_ptr<CookedTexture> pCookedTexture, ID3D11Device* pDevice, bool isStreamed)
+	{
+		m_Format = pCookedTexture->GetFormat();
+		m_Width = pCookedTexture->GetWidth();
+		m_Height = pCookedTexture->GetHeight();
+		m_MipCount = pCookedTexture->GetMipCount();
+		m_MostDetailedMip = isStreamed ? TextureStreamer::GetAlwaysResidentMip(m_Format, m_Width, m_Height, m_MipCount) : 0;
+
+		D3D11_SUBRESOURCE_DATA mips[CookedTexture::MaxMipCount]{};
+		for (uint32_t mip = m_MostDetailedMip; mip < m_MipCount; ++mip)
+		{
+			mips[mip - m_MostDetailedMip].pSysMem = pCookedTexture->GetMipData(mip);
+			mips[mip - m_MostDetailedMip].SysMemPitch = pCookedTexture->GetRowPitch(mip);
+			mips[mip - m_MostDetailedMip].SysMemSlicePitch = static_cast<UINT>(pCookedTexture->GetMipSize(mip));
+		}
+		CreateResource(pDevice, m_Format, pCookedTexture->GetWidth(m_MostDetailedMip), pCookedTexture->GetHeight(m_MostDetailedMip), mips, m_MipCount - m_MostDetailedMip);
+
+		if (isStreamed)
+			m_pCookedTexture = std::move(pCookedTexture);
+	}
+
+	void Texture::CreateResource(ID3D11Device* pDevice, TextureFormat textureFormat, uint32_t width, uint32_t height, const D3D11_SUBRESOURCE_DATA* pMips, uint32_t numMips)
+	{
+		//Same order as TextureFormat
+		constexpr DXGI_FORMAT formats[]{ DXGI_FORMAT_R8G8B8A8_UNORM, DXGI_FORMAT_BC1_UNORM, DXGI_FORMAT_BC4_UNORM, DXGI_FORMAT_BC5_UNORM, DXGI_FORMAT_BC7_UNORM };
+		DXGI_FORMAT format = formats[static_cast<uint32_t>(textureFormat)];
 		D3D11_TEXTURE2D_DESC desc{};
-		desc.Width = pSurface->w;
-		desc.Height = pSurface->h;
-		desc.MipLevels = 1;
+		desc.Width = width;
+		desc.Height = height;
+		desc.MipLevels = numMips;
 		desc.ArraySize = 1;
 		desc.Format = format;
 		desc.SampleDesc.Count = 1;
@@ -25,12 +108,7 @@ namespace dae
 		desc.CPUAccessFlags = 0;
 		desc.MiscFlags = 0;
 
-		D3D11_SUBRESOURCE_DATA initData;
-		initData.pSysMem = pSurface->pixels;
-		initData.SysMemPitch = static_cast<UINT>(pSurface->pitch);
-		initData.SysMemSlicePitch = static_cast<UINT>(pSurface->h * pSurface->pitch);
-
-		HRESULT hr = pDevice->CreateTexture2D(&desc, &initData, &m_pResource);
+		HRESULT hr = pDevice->CreateTexture2D(&desc, pMips, &m_pResource);
 		if (FAILED(hr))
 		{
 			std::cout << "CreateTexture2D failed: " << hr << std::endl;
@@ -40,32 +118,51 @@ namespace dae
 		D3D11_SHADER_RESOURCE_VIEW_DESC SRVDEsc{};
 		SRVDEsc.Format = format;
 		SRVDEsc.ViewDimension = D3D11_SRV_DIMENSION_TEXTURE2D;
-		SRVDEsc.Texture2D.MipLevels = 1;
+		SRVDEsc.Texture2D.MipLevels = numMips;
 
 		hr = pDevice->CreateShaderResourceView(m_pResource, &SRVDEsc, &m_pSRV);
-
-		if (m_pSurface)
-		{
-			SDL_FreeSurface(m_pSurface);
-			m_pSurface = nullptr;
-		}
 	}
 
 	Texture::~Texture()
 	{
-		if (m_pSurface)
-		{
-			SDL_FreeSurface(m_pSurface);
-			m_pSurface = nullptr;
-		}
 		if (m_pResource) m_pResource->Release();
 		if (m_pSRV) m_pSRV->Release();
 	}
 
-	Texture* Texture::LoadFromFile(const std::string& path, ID3D11Device* pDevice)
+	Texture* Texture::LoadFromFile(const std::string& path, ID3D11Device* pDevice, MipContent content, bool isStreamed, bool isCpuSampled)
 	{
-		//TODO
-		//Load SDL_Surface using IMG_LOAD
+		//The asset cooker stores the decoded image with its mip chain
+		{
+			std::unique_ptr<CookedTexture> pCookedTexture{ std::make_unique<CookedTexture>(CookedTexture::GetCookedPath(path)) };
+			if (pCookedTexture->IsUpToDate(path) && pCookedTexture->GetContent() == content)
+			{
+				TextureSampler sampler{ isCpuSampled ? CreateSampler(*pCookedTexture) : TextureSampler{} };
+				Texture* pTexture{ new Texture(std::move(pCookedTexture), pDevice, isStreamed) };
+				pTexture->m_Sampler = std::move(sampler);
+				return pTexture;
+			}
+		}
+
+		//Cooking costs more than decoding alone but only happens once, every launch after that maps the cooked file
+		CookedTextureData data{};
+		Texture* pTexture{ nullptr };
+		if (TextureCooker::CookPng(path, content, MipFilter::Kaiser, CompressionQuality::Fast, Utils::GetWorkerCount(), data, std::cout))
+		{
+			//Streamed ones need the file mapped, they only stream when it could be written
+			if (isStreamed)
+			{
+				std::unique_ptr<CookedTexture> pCookedTexture{ std::make_unique<CookedTexture>(CookedTexture::GetCookedPath(path)) };
+				if (pCookedTexture->IsUpToDate(path))
+					pTexture = new Texture(std::move(pCookedTexture), pDevice, true);
+			}
+			if (!pTexture)
+				pTexture = new Texture(data, pDevice);
+			if (isCpuSampled)
+				pTexture->m_Sampler = CreateSampler(data, content);
+			return pTexture;
+		}
+
+		//Images other than PNG go through SDL_image and aren't kept
 		SDL_Surface* tex_surf = IMG_Load(path.c_str());
 
 		if (!tex_surf)
@@ -73,31 +170,73 @@ namespace dae
 			std::cout << "Unable to load texture from: " << path.c_str() << std::endl;
 			return 0;
 		}
-		//Create & Return a new Texture Object (using SDL_Surface)
 
-		return new Texture(tex_surf, pDevice);
+		//Bytes in R, G, B, A order whatever the file stored
+		SDL_Surface* pRgbaSurface = SDL_ConvertSurfaceFormat(tex_surf, SDL_PIXELFORMAT_RGBA32, 0);
+		SDL_FreeSurface(tex_surf);
+		if (!pRgbaSurface)
+		{
+			std::cout << "Unable to convert texture from: " << path.c_str() << std::endl;
+			return 0;
+		}
+
+		Image image{};
+		image.width = static_cast<uint32_t>(pRgbaSurface->w);
+		image.height = static_cast<uint32_t>(pRgbaSurface->h);
+		image.pixels.resize(size_t(image.width) * image.height * 4);
+		for (uint32_t y = 0; y < image.height; ++y)
+		{
+			const uint8_t* pRow = static_cast<const uint8_t*>(pRgbaSurface->pixels) + size_t(y) * pRgbaSurface->pitch;
+			std::copy(pRow, pRow + size_t(image.width) * 4, image.pixels.data() + size_t(y) * image.width * 4);
+		}
+		SDL_FreeSurface(pRgbaSurface);
+
+		data = TextureCooker::Cook(image, content, MipFilter::Kaiser, CompressionQuality::Fast, Utils::GetWorkerCount(), path, std::cout);
+		pTexture = new Texture(data, pDevice);
+		if (isCpuSampled)
+			pTexture->m_Sampler = CreateSampler(data, content);
+		return pTexture;
 	}
 
-	ColorRGB Texture::Sample(Vector2& uv) const
+	bool Texture::SetMostDetailedMip(ID3D11Device* pDevice, ID3D11DeviceContext* pDeviceContext, uint32_t mostDetailedMip)
 	{
-		//TODO
-		//Sample the correct texel for the given uv
-
-		//Convert from [0,1] to [0, width/height]
-		const int u = static_cast<int>(uv.x * m_pSurface->w);
-		const int v = static_cast<int>(uv.y * m_pSurface->h);
+		if (!m_pCookedTexture || !m_pSRV || mostDetailedMip >= m_MipCount || !TextureStreamer::CanBeMostDetailed(m_Format, m_Width, m_Height, mostDetailedMip))
+			return false;
+		if (mostDetailedMip == m_MostDetailedMip)
+			return true;
+
+		ID3D11Texture2D* pPreviousResource{ m_pResource };
+		ID3D11ShaderResourceView* pPreviousSRV{ m_pSRV };
+		m_pResource = nullptr;
+		m_pSRV = nullptr;
+		CreateResource(pDevice, m_Format, m_pCookedTexture->GetWidth(mostDetailedMip), m_pCookedTexture->GetHeight(mostDetailedMip), nullptr, m_MipCount - mostDetailedMip);
+		if (!m_pSRV)
+		{
+			if (m_pResource) m_pResource->Release();
+			m_pResource = pPreviousResource;
+			m_pSRV = pPreviousSRV;
+			return false;
+		}
 
-		//Convert to single array
-		const int surfacePixel = m_pSurfacePixels[u + v * m_pSurface->w];
+		//Subresource i of a texture without an array is mip i of it
+		for (uint32_t mip = mostDetailedMip; mip < m_MipCount; ++mip)
+		{
+			if (mip >= m_MostDetailedMip)
+				pDeviceContext->CopySubresourceRegion(m_pResource, mip - mostDetailedMip, 0, 0, 0, pPreviousResource, mip - m_MostDetailedMip, nullptr);
+			else
+				pDeviceContext->UpdateSubresource(m_pResource, mip - mostDetailedMip, nullptr, m_pCookedTexture->GetMipData(mip), m_pCookedTexture->GetRowPitch(mip), 0);
+		}
 
-		Uint8 r{};
-		Uint8 g{};
-		Uint8 b{};
-		SDL_GetRGB(surfacePixel, m_pSurface->format, &r, &g, &b);
+		pPreviousSRV->Release();
+		pPreviousResource->Release();
+		m_MostDetailedMip = mostDetailedMip;
+		return true;
+	}
 
-		return { r / 255.f,
-				g / 255.f,
-				b / 255.f };
+	ColorRGB Texture::Sample(const Vector2& uv, float lod) const
+	{
+		const Vector4 texel{ m_Sampler.Sample(uv, lod) };
+		return { texel.x, texel.y, texel.z };
 	}
 
 	ID3D11ShaderResourceView* Texture::GetSRV() const
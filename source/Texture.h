@@ -1,26 +1,64 @@
 #pragma once
-#include <SDL_surface.h>
+#include <memory>
 #include <string>
 #include "ColorRGB.h"
+#include "MipGenerator.h"
+#include "TextureCooker.h"
+#include "TextureFormat.h"
+#include "TextureSampler.h"
 
 namespace dae
 {
 	struct Vector2;
+	class CookedTexture;
 
 	class Texture
 	{
 	public:
 		~Texture();
 
-		static Texture* LoadFromFile(const std::string& path, ID3D11Device* pDevice);
-		ColorRGB Sample(Vector2& uv) const;
+		//Uploads the cooked texture straight from the mapped file when it's up to date and cooked for content.
+		//Else cooks the image the way the asset cooker does, with fast compression so loading doesn't stall, and writes the cooked texture for the next launch.
+		//Streamed textures keep the cooked texture mapped and start out with only the mips TextureStreamer always keeps resident.
+		//Textures that can't be cooked, like images other than PNG, are never streamed.
+		//CPU sampled ones keep a decoded copy of every mip for Sample, which the others leave black.
+		static Texture* LoadFromFile(const std::string& path, ID3D11Device* pDevice, MipContent content = MipContent::Color, bool isStreamed = false,
+			bool isCpuSampled = false);
+		//With the sampler's filter and address mode, lod is the mip level. Color maps come back in linear space.
+		ColorRGB Sample(const Vector2& uv, float lod = 0.f) const;
+		TextureSampler& GetSampler() { return m_Sampler; }
+		const TextureSampler& GetSampler() const { return m_Sampler; }
 
 		ID3D11ShaderResourceView* GetSRV() const;
+
+		//Of the full texture, whatever mips are resident
+		TextureFormat GetFormat() const { return m_Format; }
+		uint32_t GetWidth() const { return m_Width; }
+		uint32_t GetHeight() const { return m_Height; }
+		uint32_t GetMipCount() const { return m_MipCount; }
+
+		bool IsStreamed() const { return m_pCookedTexture != nullptr; }
+		uint32_t GetMostDetailedMip() const { return m_MostDetailedMip; }
+		//Recreates the resource with mips [mostDetailedMip, mip count), the ones it had are copied over on the GPU and the others uploaded
+		//from the mapped cooked texture. The view changes, effects pick it up when they bind the texture.
+		//False when it isn't streamed, its format can't start at mostDetailedMip (TextureStreamer::CanBeMostDetailed) or creation failed.
+		bool SetMostDetailedMip(ID3D11Device* pDevice, ID3D11DeviceContext* pDeviceContext, uint32_t mostDetailedMip);
 	private:
-		Texture(SDL_Surface* pSurface, ID3D11Device* pDevice);
+		Texture(const CookedTextureData& data, ID3D11Device* pDevice);
+		//Mips of the cooked texture uploaded straight from the mapped file, streamed ones keep it
+		Texture(std::unique_ptr<CookedTexture> pCookedTexture, ID3D11Device* pDevice, bool isStreamed);
+		void CreateResource(ID3D11Device* pDevice, TextureFormat format, uint32_t width, uint32_t height, const D3D11_SUBRESOURCE_DATA* pMips, uint32_t numMips);
+
+		TextureSampler m_Sampler{};
+
+		TextureFormat m_Format{ TextureFormat::R8G8B8A8 };
+		uint32_t m_Width{};
+		uint32_t m_Height{};
+		uint32_t m_MipCount{};
 
-		SDL_Surface* m_pSurface{ nullptr };
-		uint32_t* m_pSurfacePixels{ nullptr };
+		//Streaming, the resource only holds mips [m_MostDetailedMip, m_MipCount)
+		std::unique_ptr<CookedTexture> m_pCookedTexture{};
+		uint32_t m_MostDetailedMip{};
 
 		ID3D11Texture2D* m_pResource{ nullptr };
 		ID3D11ShaderResourceView* m_pSRV{ nullptr };
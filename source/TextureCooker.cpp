@@ -0,0 +1,58 @@
+#include "pch.h"
+#include "TextureCooker.h"
+#include "CookedTexture.h"
+#include "PngDecoder.h"
+
+namespace dae
+{
+	namespace TextureCooker
+	{
+		CookedTextureData Cook(const Image& image, MipContent content, MipFilter filter, CompressionQuality quality, size_t numThreads,
+			const std::string& name, std::ostream& log)
+		{
+			CookedTextureData data{};
+			data.format = BlockCompressor::ChooseFormat(image, content, quality);
+			data.width = image.width;
+			data.height = image.height;
+
+			const std::vector<Image> mips{ MipGenerator::Generate(image, content, filter, numThreads) };
+			size_t size{};
+			size_t uncompressedSize{};
+			for (const Image& mip : mips)
+			{
+				data.levels.push_back(BlockCompressor::Encode(mip, data.format, quality, numThreads));
+				size += data.levels.back().size();
+				uncompressedSize += mip.pixels.size();
+			}
+
+			constexpr const char* formatNames[]{ "R8G8B8A8", "BC1", "BC4", "BC5", "BC7" };
+			log << name << ": " << image.width << "x" << image.height << ", " << mips.size() << " mips, " << formatNames[static_cast<uint32_t>(data.format)]
+				<< ", " << size << " bytes (x" << static_cast<float>(uncompressedSize) / size << " smaller)\n";
+			return data;
+		}
+
+		bool CookPng(const std::string& pngPath, MipContent content, MipFilter filter, CompressionQuality quality, size_t numThreads,
+			CookedTextureData& data, std::ostream& log)
+		{
+			data = CookedTextureData{};
+			Image image{};
+			if (!PngDecoder::DecodeFile(pngPath, image))
+				return false;
+
+			data = Cook(image, content, filter, quality, numThreads, pngPath, log);
+
+			const std::string cookedPath{ CookedTexture::GetCookedPath(pngPath) };
+			if (!CookedTexture::Write(cookedPath, data.format, data.width, data.height, data.levels, content, filter, quality, pngPath))
+				log << "Couldn't write cooked texture " << cookedPath << "\n";
+
+			return true;
+		}
+
+		bool IsUpToDate(const std::string& pngPath, MipContent content, MipFilter filter, CompressionQuality quality)
+		{
+			const CookedTexture cookedTexture{ CookedTexture::GetCookedPath(pngPath) };
+			return cookedTexture.IsUpToDate(pngPath) && cookedTexture.GetContent() == content && cookedTexture.GetFilter() == filter &&
+				cookedTexture.GetQuality() == quality;
+		}
+	}
+}
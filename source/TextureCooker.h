@@ -0,0 +1,38 @@
+#pragma once
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <vector>
+#include "BlockCompressor.h"
+#include "Image.h"
+#include "MipGenerator.h"
+#include "TextureFormat.h"
+
+namespace dae
+{
+	//Everything a Texture uploads and a cooked texture stores
+	struct CookedTextureData
+	{
+		TextureFormat format{ TextureFormat::R8G8B8A8 };
+		uint32_t width{};
+		uint32_t height{};
+		//Every mip level in format, level 0 first
+		std::vector<std::vector<uint8_t>> levels{};
+	};
+
+	//The processing a Texture does before it can upload, without a device, so the asset cooker runs it ahead of time:
+	//the mip chain and its block compression
+	namespace TextureCooker
+	{
+		//Mips of image filtered with filter for content and compressed at quality into the format content gets.
+		//The format and the sizes are written to log.
+		CookedTextureData Cook(const Image& image, MipContent content, MipFilter filter, CompressionQuality quality, size_t numThreads,
+			const std::string& name, std::ostream& log);
+
+		//Decodes and cooks the PNG at pngPath and writes the cooked texture next to it. False when the PNG can't be decoded, data is left empty then.
+		bool CookPng(const std::string& pngPath, MipContent content, MipFilter filter, CompressionQuality quality, size_t numThreads,
+			CookedTextureData& data, std::ostream& log);
+		//True when the cooked texture of pngPath was made from it as it is now, with these settings
+		bool IsUpToDate(const std::string& pngPath, MipContent content, MipFilter filter, CompressionQuality quality);
+	}
+}
@@ -0,0 +1,53 @@
+#pragma once
+#include <algorithm>
+#include <cstdint>
+
+namespace dae
+{
+	//Texel layouts of cooked textures, every one maps to the DXGI format of the same name
+	enum class TextureFormat : uint32_t
+	{
+		R8G8B8A8,
+		//Block compressed, 4x4 texels a block: RGB in 8 bytes
+		BC1,
+		//Red in 8 bytes
+		BC4,
+		//Red and green in 16 bytes, two BC4 blocks
+		BC5,
+		//RGBA in 16 bytes
+		BC7
+	};
+
+	inline bool IsBlockCompressed(TextureFormat format)
+	{
+		return format != TextureFormat::R8G8B8A8;
+	}
+
+	//Bytes of a 4x4 block, of a texel for uncompressed formats
+	inline uint32_t GetBlockSize(TextureFormat format)
+	{
+		switch (format)
+		{
+		case TextureFormat::BC1:
+		case TextureFormat::BC4:
+			return 8;
+		case TextureFormat::BC5:
+		case TextureFormat::BC7:
+			return 16;
+		default:
+			return 4;
+		}
+	}
+
+	//Bytes from one row of texels, or of blocks, to the next
+	inline uint32_t GetRowPitch(TextureFormat format, uint32_t width)
+	{
+		return IsBlockCompressed(format) ? std::max((width + 3) / 4, 1u) * GetBlockSize(format) : width * 4;
+	}
+
+	//Rows of texels, or of blocks
+	inline uint32_t GetRowCount(TextureFormat format, uint32_t height)
+	{
+		return IsBlockCompressed(format) ? std::max((height + 3) / 4, 1u) : height;
+	}
+}
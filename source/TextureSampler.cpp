@@ -0,0 +1,387 @@
+#include "pch.h"
+#include "TextureSampler.h"
+
+#include <cmath>
+#include <cstring>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__SSE2__)
+#include <emmintrin.h>
+#define DAE_SAMPLER_SSE2
+#endif
+
+namespace dae
+{
+	namespace
+	{
+		//Into [0, 1] for wrap and clamp, [0, 2] for mirror, so texel coordinates stay small whatever the UV.
+		//NaN, and the NaN wrap and mirror make of infinities, reads as 0: converted to a texel it would be undefined.
+		float ReduceCoordinate(float u, AddressMode addressMode)
+		{
+			float reduced{};
+			switch (addressMode)
+			{
+			case AddressMode::Wrap:
+				reduced = u - std::floor(u);
+				break;
+			case AddressMode::Mirror:
+			{
+				const float half{ u * .5f };
+				reduced = (half - std::floor(half)) * 2.f;
+				break;
+			}
+			default:
+				reduced = std::min(std::max(u, 0.f), 1.f);
+				break;
+			}
+			return reduced == reduced ? reduced : 0.f;
+		}
+
+		//Texel x of a row size texels wide, from [-1, 2 * size] after ReduceCoordinate. The last clamp is all clamp addressing needs.
+		int32_t AddressTexel(int32_t x, int32_t size, AddressMode addressMode)
+		{
+			if (addressMode == AddressMode::Wrap)
+			{
+				x += x < 0 ? size : 0;
+				x -= x >= size ? size : 0;
+			}
+			else if (addressMode == AddressMode::Mirror)
+			{
+				x = x < 0 ? -x - 1 : x;
+				x -= x >= 2 * size ? 2 * size : 0;
+				x = x >= size ? 2 * size - 1 - x : x;
+			}
+			return std::min(std::max(x, 0), size - 1);
+		}
+
+		uint32_t GetTexelIndex(uint32_t offset, uint32_t tilesPerRow, uint32_t x, uint32_t y)
+		{
+			return offset + (((y >> 2) * tilesPerRow + (x >> 2)) << 4) + ((y & 3) << 2) + (x & 3);
+		}
+
+#if defined(DAE_SAMPLER_SSE2)
+		//Largest float with a fraction, every float from 2^23 on is a whole number already
+		const __m128 WholeNumbers{ _mm_set1_ps(8388608.f) };
+
+		//std::floor without SSE4.1
+		__m128 Floor(__m128 x)
+		{
+			const __m128 truncated{ _mm_cvtepi32_ps(_mm_cvttps_epi32(x)) };
+			const __m128 floored{ _mm_sub_ps(truncated, _mm_and_ps(_mm_cmpgt_ps(truncated, x), _mm_set1_ps(1.f))) };
+			const __m128 isWhole{ _mm_cmpge_ps(_mm_andnot_ps(_mm_set1_ps(-0.f), x), WholeNumbers) };
+			return _mm_or_ps(_mm_and_ps(isWhole, x), _mm_andnot_ps(isWhole, floored));
+		}
+
+		__m128i Select(__m128i mask, __m128i a, __m128i b)
+		{
+			return _mm_or_si128(_mm_and_si128(mask, a), _mm_andnot_si128(mask, b));
+		}
+
+		//Low 32 bits of the products, _mm_mullo_epi32 is SSE4.1
+		__m128i Multiply(__m128i a, __m128i b)
+		{
+			const __m128i even{ _mm_mul_epu32(a, b) };
+			const __m128i odd{ _mm_mul_epu32(_mm_srli_si128(a, 4), _mm_srli_si128(b, 4)) };
+			return _mm_unpacklo_epi32(_mm_shuffle_epi32(even, _MM_SHUFFLE(0, 0, 2, 0)), _mm_shuffle_epi32(odd, _MM_SHUFFLE(0, 0, 2, 0)));
+		}
+
+		__m128 ReduceCoordinates(__m128 u, AddressMode addressMode)
+		{
+			__m128 reduced{};
+			switch (addressMode)
+			{
+			case AddressMode::Wrap:
+				reduced = _mm_sub_ps(u, Floor(u));
+				break;
+			case AddressMode::Mirror:
+			{
+				const __m128 half{ _mm_mul_ps(u, _mm_set1_ps(.5f)) };
+				reduced = _mm_mul_ps(_mm_sub_ps(half, Floor(half)), _mm_set1_ps(2.f));
+				break;
+			}
+			default:
+				reduced = _mm_min_ps(_mm_max_ps(u, _mm_setzero_ps()), _mm_set1_ps(1.f));
+				break;
+			}
+			return _mm_and_ps(_mm_cmpord_ps(reduced, reduced), reduced);
+		}
+
+		__m128i AddressTexels(__m128i x, __m128i size, AddressMode addressMode)
+		{
+			const __m128i one{ _mm_set1_epi32(1) };
+			const __m128i lastTexel{ _mm_sub_epi32(size, one) };
+			if (addressMode == AddressMode::Wrap)
+			{
+				x = _mm_add_epi32(x, _mm_and_si128(_mm_cmplt_epi32(x, _mm_setzero_si128()), size));
+				x = _mm_sub_epi32(x, _mm_and_si128(_mm_cmpgt_epi32(x, lastTexel), size));
+			}
+			else if (addressMode == AddressMode::Mirror)
+			{
+				const __m128i period{ _mm_add_epi32(size, size) };
+				x = Select(_mm_cmplt_epi32(x, _mm_setzero_si128()), _mm_sub_epi32(_mm_setzero_si128(), _mm_add_epi32(x, one)), x);
+				x = _mm_sub_epi32(x, _mm_and_si128(_mm_cmpgt_epi32(x, _mm_sub_epi32(period, one)), period));
+				x = Select(_mm_cmpgt_epi32(x, lastTexel), _mm_sub_epi32(_mm_sub_epi32(period, one), x), x);
+			}
+			x = Select(_mm_cmplt_epi32(x, _mm_setzero_si128()), _mm_setzero_si128(), x);
+			return Select(_mm_cmpgt_epi32(x, lastTexel), lastTexel, x);
+		}
+
+		__m128i GetTexelIndices(__m128i offset, __m128i tilesPerRow, __m128i x, __m128i y)
+		{
+			const __m128i three{ _mm_set1_epi32(3) };
+			const __m128i tile{ _mm_add_epi32(Multiply(_mm_srli_epi32(y, 2), tilesPerRow), _mm_srli_epi32(x, 2)) };
+			const __m128i texel{ _mm_add_epi32(_mm_slli_epi32(_mm_and_si128(y, three), 2), _mm_and_si128(x, three)) };
+			return _mm_add_epi32(_mm_add_epi32(offset, _mm_slli_epi32(tile, 4)), texel);
+		}
+#endif
+	}
+
+	TextureSampler::TextureSampler(const std::vector<Image>& mips, MipContent content)
+	{
+		for (uint32_t value = 0; value < 256; ++value)
+		{
+			const float stored{ value / 255.f };
+			m_AlphaLut[value] = stored;
+			m_ColorLut[value] = content != MipContent::Color ? stored :
+				stored <= .04045f ? stored / 12.92f : static_cast<float>(std::pow((stored + .055) / 1.055, 2.4));
+		}
+
+		size_t numTexels{};
+		for (const Image& mip : mips)
+		{
+			if (mip.width == 0 || mip.height == 0 || mip.pixels.size() != size_t(mip.width) * mip.height * 4)
+				break;
+
+			const uint32_t tilesPerRow{ (mip.width + TileSize - 1) / TileSize };
+			const uint32_t tileRows{ (mip.height + TileSize - 1) / TileSize };
+			m_Levels.push_back(Level{ mip.width, mip.height, tilesPerRow, static_cast<uint32_t>(numTexels) });
+			numTexels += size_t(tilesPerRow) * tileRows * TileSize * TileSize;
+		}
+
+		//The padding of tiles past the edges is never read, addressing keeps to the level's texels
+		m_Texels.resize(numTexels);
+		for (size_t levelIdx = 0; levelIdx < m_Levels.size(); ++levelIdx)
+		{
+			const Level& level = m_Levels[levelIdx];
+			const uint8_t* pPixels = mips[levelIdx].pixels.data();
+			for (uint32_t y = 0; y < level.height; ++y)
+			{
+				for (uint32_t x = 0; x < level.width; ++x)
+					std::memcpy(&m_Texels[GetTexelIndex(level.offset, level.tilesPerRow, x, y)], pPixels + (size_t(y) * level.width + x) * 4, 4);
+			}
+		}
+	}
+
+	Vector4 TextureSampler::Sample(const Vector2& uv, float lod) const
+	{
+		if (m_Levels.empty())
+			return Vector4{ 0.f, 0.f, 0.f, 0.f };
+
+		uint32_t level0{};
+		uint32_t level1{};
+		float blend{};
+		GetLevels(lod, level0, level1, blend);
+
+		Footprint footprint0{};
+		GetFootprint(m_Levels[level0], uv.x, uv.y, footprint0);
+		if (m_Filter != SampleFilter::Trilinear)
+			return Blend(footprint0);
+
+		Footprint footprint1{};
+		GetFootprint(m_Levels[level1], uv.x, uv.y, footprint1);
+		return Blend(footprint0, footprint1, blend);
+	}
+
+	void TextureSampler::SampleN(const Vector2* pUvs, const float* pLods, size_t count, Vector4* pTexels) const
+	{
+		if (m_Levels.empty())
+		{
+			std::fill(pTexels, pTexels + count, Vector4{ 0.f, 0.f, 0.f, 0.f });
+			return;
+		}
+
+		//Batches past the end are padded with the first UV and thrown away
+		for (size_t first = 0; first < count; first += BatchSize)
+		{
+			const size_t batchSize{ std::min(BatchSize, count - first) };
+			float u[BatchSize]{};
+			float v[BatchSize]{};
+			float blends[BatchSize]{};
+			const Level* pLevels0[BatchSize]{};
+			const Level* pLevels1[BatchSize]{};
+			for (size_t i = 0; i < BatchSize; ++i)
+			{
+				const size_t sample{ first + (i < batchSize ? i : 0) };
+				u[i] = pUvs[sample].x;
+				v[i] = pUvs[sample].y;
+
+				uint32_t level0{};
+				uint32_t level1{};
+				GetLevels(pLods ? pLods[sample] : 0.f, level0, level1, blends[i]);
+				pLevels0[i] = &m_Levels[level0];
+				pLevels1[i] = &m_Levels[level1];
+			}
+
+			Footprint footprints0[BatchSize]{};
+			Footprint footprints1[BatchSize]{};
+			for (size_t i = 0; i < BatchSize; i += 4)
+				GetFootprints(pLevels0 + i, u + i, v + i, footprints0 + i);
+			if (m_Filter == SampleFilter::Trilinear)
+			{
+				for (size_t i = 0; i < BatchSize; i += 4)
+					GetFootprints(pLevels1 + i, u + i, v + i, footprints1 + i);
+			}
+
+			for (size_t i = 0; i < batchSize; ++i)
+				pTexels[first + i] = m_Filter == SampleFilter::Trilinear ? Blend(footprints0[i], footprints1[i], blends[i]) : Blend(footprints0[i]);
+		}
+	}
+
+	void TextureSampler::GetLevels(float lod, uint32_t& level0, uint32_t& level1, float& blend) const
+	{
+		//NaN is level 0, it would be undefined converted to a level
+		const float lastLevel{ static_cast<float>(m_Levels.size() - 1) };
+		lod = lod > 0.f ? std::min(lod, lastLevel) : 0.f;
+		if (m_Filter != SampleFilter::Trilinear)
+		{
+			level0 = static_cast<uint32_t>(lod + .5f);
+			level1 = level0;
+			blend = 0.f;
+			return;
+		}
+
+		level0 = static_cast<uint32_t>(lod);
+		level1 = std::min(level0 + 1, static_cast<uint32_t>(m_Levels.size() - 1));
+		blend = lod - static_cast<float>(level0);
+	}
+
+	void TextureSampler::GetFootprint(const Level& level, float u, float v, Footprint& footprint) const
+	{
+		const int32_t width{ static_cast<int32_t>(level.width) };
+		const int32_t height{ static_cast<int32_t>(level.height) };
+		const float x{ ReduceCoordinate(u, m_AddressMode) * static_cast<float>(width) };
+		const float y{ ReduceCoordinate(v, m_AddressMode) * static_cast<float>(height) };
+		if (m_Filter == SampleFilter::Point)
+		{
+			const uint32_t index{ GetTexelIndex(level.offset, level.tilesPerRow, AddressTexel(static_cast<int32_t>(std::floor(x)), width, m_AddressMode),
+				AddressTexel(static_cast<int32_t>(std::floor(y)), height, m_AddressMode)) };
+			footprint = Footprint{ { index, index, index, index }, { 1.f, 0.f, 0.f, 0.f } };
+			return;
+		}
+
+		//Texel centers are at half texels
+		const float left{ std::floor(x - .5f) };
+		const float top{ std::floor(y - .5f) };
+		const float fractionX{ x - .5f - left };
+		const float fractionY{ y - .5f - top };
+		const uint32_t x0{ static_cast<uint32_t>(AddressTexel(static_cast<int32_t>(left), width, m_AddressMode)) };
+		const uint32_t x1{ static_cast<uint32_t>(AddressTexel(static_cast<int32_t>(left) + 1, width, m_AddressMode)) };
+		const uint32_t y0{ static_cast<uint32_t>(AddressTexel(static_cast<int32_t>(top), height, m_AddressMode)) };
+		const uint32_t y1{ static_cast<uint32_t>(AddressTexel(static_cast<int32_t>(top) + 1, height, m_AddressMode)) };
+		footprint.indices[0] = GetTexelIndex(level.offset, level.tilesPerRow, x0, y0);
+		footprint.indices[1] = GetTexelIndex(level.offset, level.tilesPerRow, x1, y0);
+		footprint.indices[2] = GetTexelIndex(level.offset, level.tilesPerRow, x0, y1);
+		footprint.indices[3] = GetTexelIndex(level.offset, level.tilesPerRow, x1, y1);
+		footprint.weights[0] = (1.f - fractionX) * (1.f - fractionY);
+		footprint.weights[1] = fractionX * (1.f - fractionY);
+		footprint.weights[2] = (1.f - fractionX) * fractionY;
+		footprint.weights[3] = fractionX * fractionY;
+	}
+
+	void TextureSampler::GetFootprints(const Level* const pLevels[4], const float* pU, const float* pV, Footprint* pFootprints) const
+	{
+#if defined(DAE_SAMPLER_SSE2)
+		//Same operations as GetFootprint, four lanes at a time
+		const __m128i width{ _mm_setr_epi32(static_cast<int>(pLevels[0]->width), static_cast<int>(pLevels[1]->width),
+			static_cast<int>(pLevels[2]->width), static_cast<int>(pLevels[3]->width)) };
+		const __m128i height{ _mm_setr_epi32(static_cast<int>(pLevels[0]->height), static_cast<int>(pLevels[1]->height),
+			static_cast<int>(pLevels[2]->height), static_cast<int>(pLevels[3]->height)) };
+		const __m128i tilesPerRow{ _mm_setr_epi32(static_cast<int>(pLevels[0]->tilesPerRow), static_cast<int>(pLevels[1]->tilesPerRow),
+			static_cast<int>(pLevels[2]->tilesPerRow), static_cast<int>(pLevels[3]->tilesPerRow)) };
+		const __m128i offset{ _mm_setr_epi32(static_cast<int>(pLevels[0]->offset), static_cast<int>(pLevels[1]->offset),
+			static_cast<int>(pLevels[2]->offset), static_cast<int>(pLevels[3]->offset)) };
+		const __m128 x{ _mm_mul_ps(ReduceCoordinates(_mm_loadu_ps(pU), m_AddressMode), _mm_cvtepi32_ps(width)) };
+		const __m128 y{ _mm_mul_ps(ReduceCoordinates(_mm_loadu_ps(pV), m_AddressMode), _mm_cvtepi32_ps(height)) };
+
+		alignas(16) uint32_t indices[4][4]{};
+		alignas(16) float weights[4][4]{};
+		if (m_Filter == SampleFilter::Point)
+		{
+			const __m128i index{ GetTexelIndices(offset, tilesPerRow, AddressTexels(_mm_cvttps_epi32(Floor(x)), width, m_AddressMode),
+				AddressTexels(_mm_cvttps_epi32(Floor(y)), height, m_AddressMode)) };
+			for (int corner = 0; corner < 4; ++corner)
+				_mm_store_si128(reinterpret_cast<__m128i*>(indices[corner]), index);
+			_mm_store_ps(weights[0], _mm_set1_ps(1.f));
+		}
+		else
+		{
+			const __m128 half{ _mm_set1_ps(.5f) };
+			const __m128 one{ _mm_set1_ps(1.f) };
+			const __m128 left{ Floor(_mm_sub_ps(x, half)) };
+			const __m128 top{ Floor(_mm_sub_ps(y, half)) };
+			const __m128 fractionX{ _mm_sub_ps(_mm_sub_ps(x, half), left) };
+			const __m128 fractionY{ _mm_sub_ps(_mm_sub_ps(y, half), top) };
+			const __m128i leftTexel{ _mm_cvttps_epi32(left) };
+			const __m128i topTexel{ _mm_cvttps_epi32(top) };
+			const __m128i x0{ AddressTexels(leftTexel, width, m_AddressMode) };
+			const __m128i x1{ AddressTexels(_mm_add_epi32(leftTexel, _mm_set1_epi32(1)), width, m_AddressMode) };
+			const __m128i y0{ AddressTexels(topTexel, height, m_AddressMode) };
+			const __m128i y1{ AddressTexels(_mm_add_epi32(topTexel, _mm_set1_epi32(1)), height, m_AddressMode) };
+			_mm_store_si128(reinterpret_cast<__m128i*>(indices[0]), GetTexelIndices(offset, tilesPerRow, x0, y0));
+			_mm_store_si128(reinterpret_cast<__m128i*>(indices[1]), GetTexelIndices(offset, tilesPerRow, x1, y0));
+			_mm_store_si128(reinterpret_cast<__m128i*>(indices[2]), GetTexelIndices(offset, tilesPerRow, x0, y1));
+			_mm_store_si128(reinterpret_cast<__m128i*>(indices[3]), GetTexelIndices(offset, tilesPerRow, x1, y1));
+			_mm_store_ps(weights[0], _mm_mul_ps(_mm_sub_ps(one, fractionX), _mm_sub_ps(one, fractionY)));
+			_mm_store_ps(weights[1], _mm_mul_ps(fractionX, _mm_sub_ps(one, fractionY)));
+			_mm_store_ps(weights[2], _mm_mul_ps(_mm_sub_ps(one, fractionX), fractionY));
+			_mm_store_ps(weights[3], _mm_mul_ps(fractionX, fractionY));
+		}
+
+		for (int lane = 0; lane < 4; ++lane)
+		{
+			for (int corner = 0; corner < 4; ++corner)
+			{
+				pFootprints[lane].indices[corner] = indices[corner][lane];
+				pFootprints[lane].weights[corner] = weights[corner][lane];
+			}
+		}
+#else
+		for (int lane = 0; lane < 4; ++lane)
+			GetFootprint(*pLevels[lane], pU[lane], pV[lane], pFootprints[lane]);
+#endif
+	}
+
+	Vector4 TextureSampler::Blend(const Footprint& footprint) const
+	{
+#if defined(DAE_SAMPLER_SSE2)
+		__m128 result{ _mm_setzero_ps() };
+		for (int corner = 0; corner < 4; ++corner)
+		{
+			const uint32_t texel{ m_Texels[footprint.indices[corner]] };
+			const __m128 color{ _mm_setr_ps(m_ColorLut[texel & 0xFF], m_ColorLut[(texel >> 8) & 0xFF], m_ColorLut[(texel >> 16) & 0xFF], m_AlphaLut[texel >> 24]) };
+			result = _mm_add_ps(result, _mm_mul_ps(color, _mm_set1_ps(footprint.weights[corner])));
+		}
+		Vector4 sample{};
+		_mm_storeu_ps(&sample.x, result);
+		return sample;
+#else
+		Vector4 sample{ 0.f, 0.f, 0.f, 0.f };
+		for (int corner = 0; corner < 4; ++corner)
+		{
+			const uint32_t texel{ m_Texels[footprint.indices[corner]] };
+			const float weight{ footprint.weights[corner] };
+			sample.x += m_ColorLut[texel & 0xFF] * weight;
+			sample.y += m_ColorLut[(texel >> 8) & 0xFF] * weight;
+			sample.z += m_ColorLut[(texel >> 16) & 0xFF] * weight;
+			sample.w += m_AlphaLut[texel >> 24] * weight;
+		}
+		return sample;
+#endif
+	}
+
+	Vector4 TextureSampler::Blend(const Footprint& footprint0, const Footprint& footprint1, float blend) const
+	{
+		const Vector4 sample0{ Blend(footprint0) };
+		const Vector4 sample1{ Blend(footprint1) };
+		return sample0 + (sample1 - sample0) * blend;
+	}
+}
@@ -0,0 +1,94 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+#include "Image.h"
+#include "MipGenerator.h"
+#include "Vector2.h"
+#include "Vector4.h"
+
+namespace dae
+{
+	enum class SampleFilter : uint32_t
+	{
+		//Nearest texel of the nearest mip
+		Point,
+		//The 2x2 texels around the UV, of the nearest mip
+		Bilinear,
+		//Bilinear in the two mips around the level of detail, blended
+		Trilinear
+	};
+
+	//What UVs outside [0, 1] read
+	enum class AddressMode : uint32_t
+	{
+		//The texture repeats
+		Wrap,
+		//The edge texels repeat
+		Clamp,
+		//The texture repeats, every other copy flipped
+		Mirror
+	};
+
+	//Samples a mip chain on the CPU the way the GPU's samplers do. Keeps its own copy of the texels in tiles of 4x4, 64 bytes to a tile,
+	//so the 2x2 texels a bilinear sample reads are in the same tile for 9 out of 16 positions instead of always spanning two rows.
+	class TextureSampler final
+	{
+	public:
+		static constexpr uint32_t TileSize{ 4 };
+		//UVs SampleN takes in one go
+		static constexpr size_t BatchSize{ 8 };
+
+		TextureSampler() = default;
+		//mips is a chain like MipGenerator makes, level 0 first. Color content has its RGB decoded from sRGB, so it gets filtered
+		//and returned in linear space, other content and alpha come back as stored. Every channel ends up in [0, 1].
+		TextureSampler(const std::vector<Image>& mips, MipContent content);
+
+		bool IsEmpty() const { return m_Levels.empty(); }
+		uint32_t GetMipCount() const { return static_cast<uint32_t>(m_Levels.size()); }
+
+		SampleFilter GetFilter() const { return m_Filter; }
+		void SetFilter(SampleFilter filter) { m_Filter = filter; }
+		AddressMode GetAddressMode() const { return m_AddressMode; }
+		void SetAddressMode(AddressMode addressMode) { m_AddressMode = addressMode; }
+
+		//RGBA at uv, lod is the mip level: point and bilinear round it to the nearest mip, trilinear blends the two around it
+		Vector4 Sample(const Vector2& uv, float lod = 0.f) const;
+		//The same as count calls of Sample, BatchSize UVs at a time. pLods can be null for lod 0 everywhere.
+		void SampleN(const Vector2* pUvs, const float* pLods, size_t count, Vector4* pTexels) const;
+
+	private:
+		struct Level
+		{
+			uint32_t width;
+			uint32_t height;
+			uint32_t tilesPerRow;
+			//Of the level's first tile in m_Texels
+			uint32_t offset;
+		};
+
+		//The texels a sample reads and their weights, point samples read the same texel four times with all the weight on the first
+		struct Footprint
+		{
+			uint32_t indices[4];
+			float weights[4];
+		};
+
+		//The mips one sample reads and how much of the second it gets, 0 without trilinear
+		void GetLevels(float lod, uint32_t& level0, uint32_t& level1, float& blend) const;
+		void GetFootprint(const Level& level, float u, float v, Footprint& footprint) const;
+		//Four footprints at once, each in its own level
+		void GetFootprints(const Level* const pLevels[4], const float* pU, const float* pV, Footprint* pFootprints) const;
+		Vector4 Blend(const Footprint& footprint) const;
+		Vector4 Blend(const Footprint& footprint0, const Footprint& footprint1, float blend) const;
+
+		//Tiles of TileSize x TileSize RGBA8 texels, rows of tiles top to bottom and the texels of a tile in rows
+		std::vector<uint32_t> m_Texels{};
+		std::vector<Level> m_Levels{};
+		//Bytes to floats, RGB by content and alpha as stored
+		float m_ColorLut[256]{};
+		float m_AlphaLut[256]{};
+
+		SampleFilter m_Filter{ SampleFilter::Bilinear };
+		AddressMode m_AddressMode{ AddressMode::Wrap };
+	};
+}
@@ -0,0 +1,209 @@
+#include "pch.h"
+#include "TextureStreamer.h"
+
+#include <cfloat>
+#include <cmath>
+
+namespace dae
+{
+	bool TextureStreamer::CanBeMostDetailed(TextureFormat format, uint32_t width, uint32_t height, uint32_t mip)
+	{
+		return !IsBlockCompressed(format) || (std::max(width >> mip, 1u) % 4 == 0 && std::max(height >> mip, 1u) % 4 == 0);
+	}
+
+	uint32_t TextureStreamer::GetAlwaysResidentMip(TextureFormat format, uint32_t width, uint32_t height, uint32_t mipCount)
+	{
+		uint32_t mip{};
+		while (mip + 1 < mipCount && std::max(width >> mip, height >> mip) > AlwaysResidentSize)
+			++mip;
+
+		//1000x1000 would stop at 62x62, half a block short, its last whole blocks are at 500x500
+		while (mip > 0 && !CanBeMostDetailed(format, width, height, mip))
+			--mip;
+		return mip;
+	}
+
+	TextureStreamer::TextureStreamer(IStreamingDevice& device, uint64_t budget, uint64_t maxUploadSize)
+		: m_Device{ device }
+		, m_Budget{ budget }
+		, m_MaxUploadSize{ maxUploadSize }
+	{
+	}
+
+	uint32_t TextureStreamer::AddTexture(TextureFormat format, uint32_t width, uint32_t height, uint32_t mipCount)
+	{
+		const uint32_t alwaysResidentMip{ GetAlwaysResidentMip(format, width, height, mipCount) };
+		m_Textures.push_back(StreamedTexture{ format, width, height, mipCount, alwaysResidentMip, alwaysResidentMip, alwaysResidentMip, alwaysResidentMip, FLT_MAX, 0 });
+		m_ResidentSize += GetResidentSize(m_Textures.back(), alwaysResidentMip);
+		return static_cast<uint32_t>(m_Textures.size() - 1);
+	}
+
+	void TextureStreamer::Request(uint32_t texture, float texelsPerPixel)
+	{
+		m_Textures[texture].texelsPerPixel = std::min(m_Textures[texture].texelsPerPixel, std::max(texelsPerPixel, 0.f));
+	}
+
+	void TextureStreamer::Update()
+	{
+		++m_Frame;
+		ChooseTargets();
+		Evict();
+		Load();
+	}
+
+	uint64_t TextureStreamer::GetMipSize(const StreamedTexture& texture, uint32_t mip) const
+	{
+		return uint64_t(GetRowPitch(texture.format, std::max(texture.width >> mip, 1u))) * GetRowCount(texture.format, std::max(texture.height >> mip, 1u));
+	}
+
+	uint32_t TextureStreamer::GetNextMip(const StreamedTexture& texture, uint32_t mip) const
+	{
+		do
+			++mip;
+		while (mip < texture.alwaysResidentMip && !CanBeMostDetailed(texture.format, texture.width, texture.height, mip));
+		return mip;
+	}
+
+	uint64_t TextureStreamer::GetLoadSize(const StreamedTexture& texture, uint32_t mip) const
+	{
+		return GetResidentSize(texture, mip) - GetResidentSize(texture, GetNextMip(texture, mip));
+	}
+
+	uint64_t TextureStreamer::GetResidentSize(const StreamedTexture& texture, uint32_t mostDetailedMip) const
+	{
+		uint64_t size{};
+		for (uint32_t mip = mostDetailedMip; mip < texture.mipCount; ++mip)
+			size += GetMipSize(texture, mip);
+		return size;
+	}
+
+	void TextureStreamer::ChooseTargets()
+	{
+		m_Candidates.clear();
+		uint64_t size{};
+		for (uint32_t textureIdx = 0; textureIdx < m_Textures.size(); ++textureIdx)
+		{
+			StreamedTexture& texture = m_Textures[textureIdx];
+			size += GetResidentSize(texture, texture.alwaysResidentMip);
+			texture.wantedMip = texture.alwaysResidentMip;
+			texture.targetMip = texture.alwaysResidentMip;
+			if (texture.texelsPerPixel == FLT_MAX)
+				continue;
+
+			//Finest mip that isn't magnified, mip m has half the texels per pixel of mip m - 1
+			texture.lastRequest = m_Frame;
+			const uint32_t finestMip{ texture.texelsPerPixel > 1.f ? static_cast<uint32_t>(std::floor(std::log2(texture.texelsPerPixel))) : 0 };
+			texture.wantedMip = std::min(finestMip, texture.alwaysResidentMip);
+			while (texture.wantedMip > 0 && !CanBeMostDetailed(texture.format, texture.width, texture.height, texture.wantedMip))
+				--texture.wantedMip;
+			for (uint32_t mip = texture.wantedMip; mip < texture.alwaysResidentMip; mip = GetNextMip(texture, mip))
+				m_Candidates.push_back(Candidate{ std::ldexp(texture.texelsPerPixel, -static_cast<int>(mip)), textureIdx, mip });
+			texture.texelsPerPixel = FLT_MAX;
+		}
+
+		//The most magnified mips first, so a texture's coarser mips always come before its finer ones
+		std::sort(m_Candidates.begin(), m_Candidates.end(), [](const Candidate& a, const Candidate& b)
+			{
+				if (a.texelsPerPixel != b.texelsPerPixel)
+					return a.texelsPerPixel < b.texelsPerPixel;
+				if (a.texture != b.texture)
+					return a.texture < b.texture;
+				return a.mip > b.mip;
+			});
+
+		//A texture gets its mips up to the first one that doesn't fit, smaller mips of other textures still might
+		for (const Candidate& candidate : m_Candidates)
+		{
+			StreamedTexture& texture = m_Textures[candidate.texture];
+			const uint64_t loadSize{ GetLoadSize(texture, candidate.mip) };
+			if (GetNextMip(texture, candidate.mip) != texture.targetMip || size + loadSize > m_Budget)
+				continue;
+
+			size += loadSize;
+			texture.targetMip = candidate.mip;
+		}
+	}
+
+	void TextureStreamer::Evict()
+	{
+		//Cached mips past the targets stay as long as the targets fit next to them
+		uint64_t size{};
+		std::vector<uint32_t> cached{};
+		for (uint32_t textureIdx = 0; textureIdx < m_Textures.size(); ++textureIdx)
+		{
+			const StreamedTexture& texture = m_Textures[textureIdx];
+			size += GetResidentSize(texture, std::min(texture.mostDetailedMip, texture.targetMip));
+			if (texture.mostDetailedMip < texture.targetMip)
+				cached.push_back(textureIdx);
+		}
+		if (size <= m_Budget)
+			return;
+
+		//Textures wanted longest ago lose their finest mips first
+		std::sort(cached.begin(), cached.end(), [this](uint32_t a, uint32_t b)
+			{
+				if (m_Textures[a].lastRequest != m_Textures[b].lastRequest)
+					return m_Textures[a].lastRequest < m_Textures[b].lastRequest;
+				return a < b;
+			});
+
+		for (const uint32_t textureIdx : cached)
+		{
+			const StreamedTexture& texture = m_Textures[textureIdx];
+			uint32_t mostDetailedMip{ texture.mostDetailedMip };
+			while (mostDetailedMip < texture.targetMip && size > m_Budget)
+			{
+				size -= GetLoadSize(texture, mostDetailedMip);
+				mostDetailedMip = GetNextMip(texture, mostDetailedMip);
+			}
+
+			SetMostDetailedMip(textureIdx, mostDetailedMip);
+			if (size <= m_Budget)
+				return;
+		}
+	}
+
+	void TextureStreamer::Load()
+	{
+		//In the order the targets were chosen, so the budget for uploads goes to the mips that are wanted most
+		uint64_t uploadedSize{};
+		for (const Candidate& candidate : m_Candidates)
+		{
+			if (uploadedSize >= m_MaxUploadSize && uploadedSize > 0)
+				return;
+
+			const StreamedTexture& texture = m_Textures[candidate.texture];
+			if (GetNextMip(texture, candidate.mip) != texture.mostDetailedMip || candidate.mip < texture.targetMip)
+				continue;
+
+			const uint64_t loadSize{ GetLoadSize(texture, candidate.mip) };
+			if (SetMostDetailedMip(candidate.texture, candidate.mip))
+				uploadedSize += loadSize;
+		}
+	}
+
+	bool TextureStreamer::SetMostDetailedMip(uint32_t texture, uint32_t mostDetailedMip)
+	{
+		StreamedTexture& streamedTexture = m_Textures[texture];
+		if (mostDetailedMip == streamedTexture.mostDetailedMip)
+			return true;
+		if (!m_Device.SetMostDetailedMip(texture, mostDetailedMip))
+			return false;
+
+		const uint64_t previousSize{ GetResidentSize(streamedTexture, streamedTexture.mostDetailedMip) };
+		const uint64_t size{ GetResidentSize(streamedTexture, mostDetailedMip) };
+		if (mostDetailedMip < streamedTexture.mostDetailedMip)
+		{
+			m_UploadedSize += size - previousSize;
+			m_NumLoads += streamedTexture.mostDetailedMip - mostDetailedMip;
+		}
+		else
+		{
+			m_NumEvictions += mostDetailedMip - streamedTexture.mostDetailedMip;
+		}
+
+		m_ResidentSize = m_ResidentSize - previousSize + size;
+		streamedTexture.mostDetailedMip = mostDetailedMip;
+		return true;
+	}
+}
@@ -0,0 +1,116 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+#include "TextureFormat.h"
+
+namespace dae
+{
+	//Where the mips TextureStreamer decides on live, the GPU or a simulation of it
+	class IStreamingDevice
+	{
+	public:
+		virtual ~IStreamingDevice() = default;
+
+		//Makes mips [mostDetailedMip, mip count) of texture resident, finer ones get freed and missing ones loaded.
+		//False when the device couldn't, the texture keeps the mips it had then.
+		virtual bool SetMostDetailedMip(uint32_t texture, uint32_t mostDetailedMip) = 0;
+	};
+
+	//Decides which mips of every texture are resident: the coarse ones always, finer ones as far as the meshes sampling the texture
+	//are large enough on screen to need them, as long as they fit the memory budget. Mips no texture needs any more stay cached
+	//until their memory is needed, the ones wanted longest ago go first.
+	class TextureStreamer final
+	{
+	public:
+		//Mips no larger than this on either side never get evicted, they're all a texture has until it's first requested
+		static constexpr uint32_t AlwaysResidentSize{ 64 };
+
+		//Whether a texture can be created from mip on: block compressed ones need both sides of it to be whole blocks
+		static bool CanBeMostDetailed(TextureFormat format, uint32_t width, uint32_t height, uint32_t mip);
+		//Finest mip of a texture that's always resident, finer than AlwaysResidentSize asks for when a block compressed texture can't start there
+		static uint32_t GetAlwaysResidentMip(TextureFormat format, uint32_t width, uint32_t height, uint32_t mipCount);
+
+		//budget is in bytes of every resident mip, the always resident ones count but are kept over it.
+		//Update loads mips until it has uploaded maxUploadSize bytes, at least one mip when any is missing.
+		TextureStreamer(IStreamingDevice& device, uint64_t budget, uint64_t maxUploadSize);
+		~TextureStreamer() = default;
+
+		TextureStreamer(const TextureStreamer&) = delete;
+		TextureStreamer(TextureStreamer&&) noexcept = delete;
+		TextureStreamer& operator=(const TextureStreamer&) = delete;
+		TextureStreamer& operator=(TextureStreamer&&) noexcept = delete;
+
+		//A texture the device holds from its always resident mip on, returns the index the device and Request know it by
+		uint32_t AddTexture(TextureFormat format, uint32_t width, uint32_t height, uint32_t mipCount);
+
+		//The texture gets sampled this frame at texelsPerPixel texels of mip 0 per screen pixel, the finest request of a frame counts
+		void Request(uint32_t texture, float texelsPerPixel);
+		//Once a frame, after the requests: evicts what doesn't fit the budget and loads the mips that are wanted most
+		void Update();
+
+		uint32_t GetTextureCount() const { return static_cast<uint32_t>(m_Textures.size()); }
+		uint32_t GetMostDetailedMip(uint32_t texture) const { return m_Textures[texture].mostDetailedMip; }
+		//The mip the last Update streamed towards, coarser than requested when the budget doesn't fit it
+		uint32_t GetTargetMip(uint32_t texture) const { return m_Textures[texture].targetMip; }
+		//The mip the requests of the last Update asked for
+		uint32_t GetWantedMip(uint32_t texture) const { return m_Textures[texture].wantedMip; }
+		uint64_t GetResidentSize() const { return m_ResidentSize; }
+		uint64_t GetBudget() const { return m_Budget; }
+		void SetBudget(uint64_t budget) { m_Budget = budget; }
+
+		//Totals since the streamer was made
+		uint64_t GetUploadedSize() const { return m_UploadedSize; }
+		uint32_t GetLoadCount() const { return m_NumLoads; }
+		uint32_t GetEvictionCount() const { return m_NumEvictions; }
+
+	private:
+		struct StreamedTexture
+		{
+			TextureFormat format;
+			uint32_t width;
+			uint32_t height;
+			uint32_t mipCount;
+			uint32_t alwaysResidentMip;
+			uint32_t mostDetailedMip;
+			uint32_t targetMip;
+			uint32_t wantedMip;
+			//Finest request of the frame, FLT_MAX when there was none
+			float texelsPerPixel;
+			//Update that last had a request for the texture
+			uint64_t lastRequest;
+		};
+
+		//A mip finer than the always resident ones that some texture wants and can be created from
+		struct Candidate
+		{
+			//Texels of the mip per screen pixel, mips sampled coarsest matter most
+			float texelsPerPixel;
+			uint32_t texture;
+			uint32_t mip;
+		};
+
+		uint64_t GetMipSize(const StreamedTexture& texture, uint32_t mip) const;
+		//Next coarser mip the texture can be created from, its always resident mip at most
+		uint32_t GetNextMip(const StreamedTexture& texture, uint32_t mip) const;
+		//Bytes that making mip the most detailed one adds to the texture at GetNextMip(mip)
+		uint64_t GetLoadSize(const StreamedTexture& texture, uint32_t mip) const;
+		//Bytes of mips [mostDetailedMip, mip count)
+		uint64_t GetResidentSize(const StreamedTexture& texture, uint32_t mostDetailedMip) const;
+		void ChooseTargets();
+		void Evict();
+		void Load();
+		bool SetMostDetailedMip(uint32_t texture, uint32_t mostDetailedMip);
+
+		IStreamingDevice& m_Device;
+		uint64_t m_Budget{};
+		uint64_t m_MaxUploadSize{};
+		std::vector<StreamedTexture> m_Textures{};
+		std::vector<Candidate> m_Candidates{};
+		uint64_t m_ResidentSize{};
+		uint64_t m_Frame{};
+
+		uint64_t m_UploadedSize{};
+		uint32_t m_NumLoads{};
+		uint32_t m_NumEvictions{};
+	};
+}
@@ -0,0 +1,23 @@
+#include "pch.h"
+#include "TextureStreamingDevice.h"
+#include "Texture.h"
+
+namespace dae
+{
+	TextureStreamingDevice::TextureStreamingDevice(ID3D11Device* pDevice, ID3D11DeviceContext* pDeviceContext)
+		: m_pDevice{ pDevice }
+		, m_pDeviceContext{ pDeviceContext }
+	{
+	}
+
+	uint32_t TextureStreamingDevice::AddTexture(Texture* pTexture)
+	{
+		m_pTextures.push_back(pTexture);
+		return static_cast<uint32_t>(m_pTextures.size() - 1);
+	}
+
+	bool TextureStreamingDevice::SetMostDetailedMip(uint32_t texture, uint32_t mostDetailedMip)
+	{
+		return m_pTextures[texture]->SetMostDetailedMip(m_pDevice, m_pDeviceContext, mostDetailedMip);
+	}
+}
@@ -0,0 +1,25 @@
+#pragma once
+#include <vector>
+#include "TextureStreamer.h"
+
+namespace dae
+{
+	class Texture;
+
+	//Streams the mips of textures loaded with isStreamed on the D3D11 device, textures are known by the order they were added in
+	class TextureStreamingDevice final : public IStreamingDevice
+	{
+	public:
+		TextureStreamingDevice(ID3D11Device* pDevice, ID3D11DeviceContext* pDeviceContext);
+
+		//pTexture has to be streamed and outlive the device
+		uint32_t AddTexture(Texture* pTexture);
+
+		virtual bool SetMostDetailedMip(uint32_t texture, uint32_t mostDetailedMip) override;
+
+	private:
+		ID3D11Device* m_pDevice{ nullptr };
+		ID3D11DeviceContext* m_pDeviceContext{ nullptr };
+		std::vector<Texture*> m_pTextures{};
+	};
+}
@@ -0,0 +1,844 @@
+#include "pch.h"
+#include "TriangleBvh.h"
+
+#include <cfloat>
+#include "ParallelFor.h"
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__SSE2__)
+#include <emmintrin.h>
+#define DAE_BVH_SSE2
+#endif
+
+namespace dae
+{
+	namespace
+	{
+		constexpr uint32_t NumBins{ 12 };
+		constexpr uint32_t MaxDepth{ 64 };
+		//Nodes with more triangles are binned on all threads, nodes with fewer are built as subtrees on one thread each
+		constexpr uint32_t SubtreeSize{ 1u << 14 };
+
+		struct Bounds
+		{
+			float min[3]{ FLT_MAX, FLT_MAX, FLT_MAX };
+			float max[3]{ -FLT_MAX, -FLT_MAX, -FLT_MAX };
+
+			void Grow(const float* pMin, const float* pMax)
+			{
+				for (int axis = 0; axis < 3; ++axis)
+				{
+					min[axis] = std::min(min[axis], pMin[axis]);
+					max[axis] = std::max(max[axis], pMax[axis]);
+				}
+			}
+
+			//Half the surface area, the heuristic only compares ratios
+			float GetArea() const
+			{
+				const float x{ max[0] - min[0] };
+				const float y{ max[1] - min[1] };
+				const float z{ max[2] - min[2] };
+				return x < 0.f ? 0.f : x * y + y * z + z * x;
+			}
+		};
+
+		//Triangle boxes binned by their centroids along every axis
+		struct Bins
+		{
+			Bounds bounds[3][NumBins]{};
+			uint32_t counts[3][NumBins]{};
+
+			void Merge(const Bins& other)
+			{
+				for (int axis = 0; axis < 3; ++axis)
+				{
+					for (uint32_t bin = 0; bin < NumBins; ++bin)
+					{
+						bounds[axis][bin].Grow(other.bounds[axis][bin].min, other.bounds[axis][bin].max);
+						counts[axis][bin] += other.counts[axis][bin];
+					}
+				}
+			}
+		};
+
+		void GrowCentroidBounds(const uint32_t* pSlots, uint32_t begin, uint32_t end, const float* pCentroids, Bounds& bounds)
+		{
+			for (uint32_t i = begin; i < end; ++i)
+				bounds.Grow(pCentroids + size_t(pSlots[i]) * 3, pCentroids + size_t(pSlots[i]) * 3);
+		}
+
+		//Axes the centroids don't spread along are left empty
+		void BinTriangles(const uint32_t* pSlots, uint32_t begin, uint32_t end, const float* pBoxes, const float* pCentroids,
+			const Bounds& centroidBounds, Bins& bins)
+		{
+			for (int axis = 0; axis < 3; ++axis)
+			{
+				const float extent{ centroidBounds.max[axis] - centroidBounds.min[axis] };
+				if (extent <= 0.f)
+					continue;
+
+				const float binScale{ NumBins / extent };
+				for (uint32_t i = begin; i < end; ++i)
+				{
+					const size_t slot{ pSlots[i] };
+					const uint32_t bin{ std::min(static_cast<uint32_t>((pCentroids[slot * 3 + axis] - centroidBounds.min[axis]) * binScale), NumBins - 1) };
+					bins.bounds[axis][bin].Grow(pBoxes + slot * 6, pBoxes + slot * 6 + 3);
+					++bins.counts[axis][bin];
+				}
+			}
+		}
+
+		float SqrDistanceToBox(const float* pPoint, const float* pMin, const float* pMax)
+		{
+			float sqrDistance{};
+			for (int axis = 0; axis < 3; ++axis)
+			{
+				const float below{ pMin[axis] - pPoint[axis] };
+				const float above{ pPoint[axis] - pMax[axis] };
+				const float outside{ std::max(std::max(below, above), 0.f) };
+				sqrDistance += outside * outside;
+			}
+
+			return sqrDistance;
+		}
+
+		float Dot(const float* pA, const float* pB)
+		{
+			return pA[0] * pB[0] + pA[1] * pB[1] + pA[2] * pB[2];
+		}
+
+		void Cross(const float* pA, const float* pB, float* pResult)
+		{
+			pResult[0] = pA[1] * pB[2] - pA[2] * pB[1];
+			pResult[1] = pA[2] * pB[0] - pA[0] * pB[2];
+			pResult[2] = pA[0] * pB[1] - pA[1] * pB[0];
+		}
+
+		//Distance the ray enters the box at, FLT_MAX when it misses the box before maxDistance
+		float GetBoxEntry(const float* pOrigin, const float* pInverseDirection, float maxDistance, const float* pMin, const float* pMax)
+		{
+			float enter{ 0.f };
+			float exit{ maxDistance };
+			for (int axis = 0; axis < 3; ++axis)
+			{
+				const float near{ (pMin[axis] - pOrigin[axis]) * pInverseDirection[axis] };
+				const float far{ (pMax[axis] - pOrigin[axis]) * pInverseDirection[axis] };
+				//Written so a NaN from a ray in a slab's plane doesn't reject the box
+				enter = std::max(enter, std::min(near, far));
+				exit = std::min(exit, std::max(near, far));
+			}
+
+			return enter <= exit ? enter : FLT_MAX;
+		}
+
+		//Distance along the ray to triangle abc, or a negative value on a miss (Moeller and Trumbore 1997)
+		float IntersectTriangle(const float* pOrigin, const float* pDirection, const float* a, const float* b, const float* c, float& u, float& v)
+		{
+			const float ab[3]{ b[0] - a[0], b[1] - a[1], b[2] - a[2] };
+			const float ac[3]{ c[0] - a[0], c[1] - a[1], c[2] - a[2] };
+			float p[3];
+			Cross(pDirection, ac, p);
+			const float determinant{ Dot(ab, p) };
+			if (determinant == 0.f)
+				return -1.f;
+
+			const float inverseDeterminant{ 1.f / determinant };
+			const float ao[3]{ pOrigin[0] - a[0], pOrigin[1] - a[1], pOrigin[2] - a[2] };
+			u = Dot(ao, p) * inverseDeterminant;
+			if (u < 0.f || u > 1.f)
+				return -1.f;
+
+			float q[3];
+			Cross(ao, ab, q);
+			v = Dot(pDirection, q) * inverseDeterminant;
+			if (v < 0.f || u + v > 1.f)
+				return -1.f;
+
+			return Dot(ac, q) * inverseDeterminant;
+		}
+
+		//Closest point on triangle abc to p and the feature it lies on (Ericson, Real-Time Collision Detection 5.1.5)
+		TriangleBvh::Feature ClosestPointOnTriangle(const float* p, const float* a, const float* b, const float* c, float* pClosest)
+		{
+			const float ab[3]{ b[0] - a[0], b[1] - a[1], b[2] - a[2] };
+			const float ac[3]{ c[0] - a[0], c[1] - a[1], c[2] - a[2] };
+			const float ap[3]{ p[0] - a[0], p[1] - a[1], p[2] - a[2] };
+
+			const auto store = [pClosest](const float* pOrigin, const float* pAxis0, float t0, const float* pAxis1, float t1)
+				{
+					for (int axis = 0; axis < 3; ++axis)
+						pClosest[axis] = pOrigin[axis] + pAxis0[axis] * t0 + pAxis1[axis] * t1;
+				};
+
+			const float d1{ Dot(ab, ap) };
+			const float d2{ Dot(ac, ap) };
+			if (d1 <= 0.f && d2 <= 0.f)
+			{
+				store(a, ab, 0.f, ac, 0.f);
+				return TriangleBvh::Feature::Vertex0;
+			}
+
+			const float bp[3]{ p[0] - b[0], p[1] - b[1], p[2] - b[2] };
+			const float d3{ Dot(ab, bp) };
+			const float d4{ Dot(ac, bp) };
+			if (d3 >= 0.f && d4 <= d3)
+			{
+				store(b, ab, 0.f, ac, 0.f);
+				return TriangleBvh::Feature::Vertex1;
+			}
+
+			const float vc{ d1 * d4 - d3 * d2 };
+			if (vc <= 0.f && d1 >= 0.f && d3 <= 0.f)
+			{
+				store(a, ab, d1 / (d1 - d3), ac, 0.f);
+				return TriangleBvh::Feature::Edge0;
+			}
+
+			const float cp[3]{ p[0] - c[0], p[1] - c[1], p[2] - c[2] };
+			const float d5{ Dot(ab, cp) };
+			const float d6{ Dot(ac, cp) };
+			if (d6 >= 0.f && d5 <= d6)
+			{
+				store(c, ab, 0.f, ac, 0.f);
+				return TriangleBvh::Feature::Vertex2;
+			}
+
+			const float vb{ d5 * d2 - d1 * d6 };
+			if (vb <= 0.f && d2 >= 0.f && d6 <= 0.f)
+			{
+				store(a, ab, 0.f, ac, d2 / (d2 - d6));
+				return TriangleBvh::Feature::Edge2;
+			}
+
+			const float va{ d3 * d6 - d5 * d4 };
+			if (va <= 0.f && d4 - d3 >= 0.f && d5 - d6 >= 0.f)
+			{
+				const float bc[3]{ c[0] - b[0], c[1] - b[1], c[2] - b[2] };
+				store(b, bc, (d4 - d3) / ((d4 - d3) + (d5 - d6)), ac, 0.f);
+				return TriangleBvh::Feature::Edge1;
+			}
+
+			const float denominator{ 1.f / (va + vb + vc) };
+			store(a, ab, vb * denominator, ac, vc * denominator);
+			return TriangleBvh::Feature::Face;
+		}
+	}
+
+	struct TriangleBvh::BuildState
+	{
+		//Slots are sorted through a permutation, the positions follow once at the end
+		std::vector<uint32_t> slots{};
+		//Box of every slot, min then max, and its centroid
+		std::vector<float> boxes{};
+		std::vector<float> centroids{};
+	};
+
+	TriangleBvh::TriangleBvh(const std::vector<Vertex>& vertices, const std::vector<uint32_t>& indices, size_t numThreads)
+	{
+		const size_t numTriangles{ indices.size() / 3 };
+		m_Triangles.reserve(numTriangles);
+		m_Positions.reserve(numTriangles * 9);
+
+		for (size_t triangleIdx = 0; triangleIdx < numTriangles; ++triangleIdx)
+		{
+			const Vector3& a = vertices[indices[triangleIdx * 3]].position;
+			const Vector3& b = vertices[indices[triangleIdx * 3 + 1]].position;
+			const Vector3& c = vertices[indices[triangleIdx * 3 + 2]].position;
+			if (Vector3::Cross(b - a, c - a).SqrMagnitude() <= 0.f)
+				continue;
+
+			m_Triangles.push_back(static_cast<uint32_t>(triangleIdx));
+			m_Positions.insert(m_Positions.end(), { a.x, a.y, a.z, b.x, b.y, b.z, c.x, c.y, c.z });
+		}
+
+		Build(numThreads);
+	}
+
+	void TriangleBvh::Build(size_t numThreads)
+	{
+		const uint32_t numTriangles{ static_cast<uint32_t>(m_Triangles.size()) };
+		if (numTriangles == 0)
+			return;
+
+		BuildState state{};
+		state.slots.resize(numTriangles);
+		state.boxes.resize(size_t(numTriangles) * 6);
+		state.centroids.resize(size_t(numTriangles) * 3);
+		Utils::ParallelFor(numTriangles, numThreads, [&](size_t begin, size_t end)
+			{
+				for (size_t slot = begin; slot < end; ++slot)
+				{
+					state.slots[slot] = static_cast<uint32_t>(slot);
+					const float* pCorners = m_Positions.data() + slot * 9;
+					float* pBox = state.boxes.data() + slot * 6;
+					for (int axis = 0; axis < 3; ++axis)
+					{
+						pBox[axis] = std::min(std::min(pCorners[axis], pCorners[3 + axis]), pCorners[6 + axis]);
+						pBox[3 + axis] = std::max(std::max(pCorners[axis], pCorners[3 + axis]), pCorners[6 + axis]);
+						state.centroids[slot * 3 + axis] = (pBox[axis] + pBox[3 + axis]) * .5f;
+					}
+				}
+			});
+
+		const size_t numJobs{ std::max(std::min(numThreads, size_t(numTriangles / SubtreeSize)), size_t{ 1 }) };
+		std::vector<Bounds> jobBounds(numJobs);
+		Utils::ParallelFor(numJobs, numJobs, [&](size_t beginJob, size_t endJob)
+			{
+				for (size_t job = beginJob; job < endJob; ++job)
+				{
+					for (size_t slot = numTriangles * job / numJobs; slot < numTriangles * (job + 1) / numJobs; ++slot)
+						jobBounds[job].Grow(state.boxes.data() + slot * 6, state.boxes.data() + slot * 6 + 3);
+				}
+			});
+
+		Bounds bounds{};
+		for (const Bounds& jobBound : jobBounds)
+			bounds.Grow(jobBound.min, jobBound.max);
+
+		m_Nodes.reserve(size_t(numTriangles) * 2);
+		m_Nodes.push_back(Node{ { bounds.min[0], bounds.min[1], bounds.min[2] }, 0, { bounds.max[0], bounds.max[1], bounds.max[2] }, numTriangles });
+
+		//Node and depth, deep nodes become leaves so queries never overflow their stack.
+		//The top of the tree is split on all threads, what's below it is left to subtrees of their own.
+		std::vector<std::pair<uint32_t, uint32_t>> pending{ { 0, 1 } };
+		std::vector<std::pair<uint32_t, uint32_t>> subtrees{};
+		while (!pending.empty())
+		{
+			const auto [nodeIdx, depth] = pending.back();
+			pending.pop_back();
+
+			if (m_Nodes[nodeIdx].count <= SubtreeSize)
+			{
+				subtrees.emplace_back(nodeIdx, depth);
+				continue;
+			}
+
+			if (!Split(m_Nodes, nodeIdx, depth, state, numThreads))
+				continue;
+
+			pending.emplace_back(m_Nodes[nodeIdx].first + 1, depth + 1);
+			pending.emplace_back(m_Nodes[nodeIdx].first, depth + 1);
+		}
+
+		//Subtrees are interleaved over the jobs and only touch their own slots, then get appended in order
+		std::vector<std::vector<Node>> subtreeNodes(subtrees.size());
+		const size_t numSubtreeJobs{ std::max(std::min(numThreads, subtrees.size()), size_t{ 1 }) };
+		Utils::ParallelFor(numSubtreeJobs, numSubtreeJobs, [&](size_t beginJob, size_t endJob)
+			{
+				for (size_t job = beginJob; job < endJob; ++job)
+				{
+					for (size_t subtree = job; subtree < subtrees.size(); subtree += numSubtreeJobs)
+					{
+						subtreeNodes[subtree].push_back(m_Nodes[subtrees[subtree].first]);
+						BuildSubtree(subtreeNodes[subtree], subtrees[subtree].second, state);
+					}
+				}
+			});
+
+		for (size_t subtree = 0; subtree < subtrees.size(); ++subtree)
+		{
+			//The subtree's root replaces its node, local node i > 0 lands at offset + i
+			const uint32_t offset{ static_cast<uint32_t>(m_Nodes.size()) - 1 };
+			for (size_t localIdx = 0; localIdx < subtreeNodes[subtree].size(); ++localIdx)
+			{
+				Node node{ subtreeNodes[subtree][localIdx] };
+				if (node.count == 0)
+					node.first += offset;
+
+				if (localIdx == 0)
+					m_Nodes[subtrees[subtree].first] = node;
+				else
+					m_Nodes.push_back(node);
+			}
+		}
+
+		//Store the triangles in leaf order, a leaf reads one contiguous run
+		std::vector<uint32_t> triangles(numTriangles);
+		std::vector<float> positions(m_Positions.size());
+		Utils::ParallelFor(numTriangles, numThreads, [&](size_t begin, size_t end)
+			{
+				for (size_t i = begin; i < end; ++i)
+				{
+					const size_t slot{ state.slots[i] };
+					triangles[i] = m_Triangles[slot];
+					std::copy(m_Positions.begin() + slot * 9, m_Positions.begin() + slot * 9 + 9, positions.begin() + i * 9);
+				}
+			});
+
+		m_Triangles.swap(triangles);
+		m_Positions.swap(positions);
+	}
+
+	bool TriangleBvh::Split(std::vector<Node>& nodes, uint32_t nodeIdx, uint32_t depth, BuildState& state, size_t numThreads)
+	{
+		const uint32_t first{ nodes[nodeIdx].first };
+		const uint32_t count{ nodes[nodeIdx].count };
+		if (count <= MaxLeafSize || depth >= MaxDepth)
+			return false;
+
+		//Only nodes of several subtrees' worth are worth binning on more than one thread
+		const size_t numJobs{ std::max(std::min(numThreads, size_t(count / SubtreeSize)), size_t{ 1 }) };
+		const auto getJobRange = [&](size_t job, uint32_t& begin, uint32_t& end)
+			{
+				begin = first + static_cast<uint32_t>(count * job / numJobs);
+				end = first + static_cast<uint32_t>(count * (job + 1) / numJobs);
+			};
+
+		Bounds centroidBounds{};
+		Bins bins{};
+		if (numJobs == 1)
+		{
+			GrowCentroidBounds(state.slots.data(), first, first + count, state.centroids.data(), centroidBounds);
+			BinTriangles(state.slots.data(), first, first + count, state.boxes.data(), state.centroids.data(), centroidBounds, bins);
+		}
+		else
+		{
+			//Merged in job order, though min, max and sums come out the same in any order
+			std::vector<Bounds> jobCentroidBounds(numJobs);
+			Utils::ParallelFor(numJobs, numJobs, [&](size_t beginJob, size_t endJob)
+				{
+					for (size_t job = beginJob; job < endJob; ++job)
+					{
+						uint32_t begin{}, end{};
+						getJobRange(job, begin, end);
+						GrowCentroidBounds(state.slots.data(), begin, end, state.centroids.data(), jobCentroidBounds[job]);
+					}
+				});
+
+			for (const Bounds& jobBounds : jobCentroidBounds)
+				centroidBounds.Grow(jobBounds.min, jobBounds.max);
+
+			std::vector<Bins> jobBins(numJobs);
+			Utils::ParallelFor(numJobs, numJobs, [&](size_t beginJob, size_t endJob)
+				{
+					for (size_t job = beginJob; job < endJob; ++job)
+					{
+						uint32_t begin{}, end{};
+						getJobRange(job, begin, end);
+						BinTriangles(state.slots.data(), begin, end, state.boxes.data(), state.centroids.data(), centroidBounds, jobBins[job]);
+					}
+				});
+
+			for (const Bins& jobBin : jobBins)
+				bins.Merge(jobBin);
+		}
+
+		//Sweep the bins of every axis for the cheapest split plane
+		float bestCost{ FLT_MAX };
+		int bestAxis{ -1 };
+		uint32_t bestBin{};
+		for (int axis = 0; axis < 3; ++axis)
+		{
+			if (centroidBounds.max[axis] - centroidBounds.min[axis] <= 0.f)
+				continue;
+
+			float leftCosts[NumBins]{};
+			Bounds left{};
+			uint32_t leftCount{};
+			for (uint32_t bin = 0; bin + 1 < NumBins; ++bin)
+			{
+				left.Grow(bins.bounds[axis][bin].min, bins.bounds[axis][bin].max);
+				leftCount += bins.counts[axis][bin];
+				leftCosts[bin] = left.GetArea() * leftCount;
+			}
+
+			Bounds right{};
+			uint32_t rightCount{};
+			for (uint32_t bin = NumBins - 1; bin > 0; --bin)
+			{
+				right.Grow(bins.bounds[axis][bin].min, bins.bounds[axis][bin].max);
+				rightCount += bins.counts[axis][bin];
+				const float cost{ leftCosts[bin - 1] + right.GetArea() * rightCount };
+				if (rightCount > 0 && rightCount < count && cost < bestCost)
+				{
+					bestCost = cost;
+					bestAxis = axis;
+					bestBin = bin;
+				}
+			}
+		}
+
+		//Identical centroids can't be split, small sets that are cheaper to test than to traverse aren't
+		Bounds nodeBounds{};
+		nodeBounds.Grow(nodes[nodeIdx].boundsMin, nodes[nodeIdx].boundsMax);
+		if (bestAxis < 0 || (bestCost + nodeBounds.GetArea() >= nodeBounds.GetArea() * count && count <= MaxLeafSize * 4))
+			return false;
+
+		const float binScale{ NumBins / (centroidBounds.max[bestAxis] - centroidBounds.min[bestAxis]) };
+		const auto middle = std::partition(state.slots.begin() + first, state.slots.begin() + first + count, [&](uint32_t slot)
+			{
+				return std::min(static_cast<uint32_t>((state.centroids[size_t(slot) * 3 + bestAxis] - centroidBounds.min[bestAxis]) * binScale), NumBins - 1) < bestBin;
+			});
+		const uint32_t leftCount{ static_cast<uint32_t>(middle - state.slots.begin()) - first };
+
+		//The children's bounds are the union of their bins, the same as growing them triangle by triangle
+		Bounds left{};
+		Bounds right{};
+		for (uint32_t bin = 0; bin < NumBins; ++bin)
+			(bin < bestBin ? left : right).Grow(bins.bounds[bestAxis][bin].min, bins.bounds[bestAxis][bin].max);
+
+		const uint32_t leftIdx{ static_cast<uint32_t>(nodes.size()) };
+		nodes.push_back(Node{ { left.min[0], left.min[1], left.min[2] }, first, { left.max[0], left.max[1], left.max[2] }, leftCount });
+		nodes.push_back(Node{ { right.min[0], right.min[1], right.min[2] }, first + leftCount, { right.max[0], right.max[1], right.max[2] }, count - leftCount });
+		nodes[nodeIdx].first = leftIdx;
+		nodes[nodeIdx].count = 0;
+		return true;
+	}
+
+	void TriangleBvh::BuildSubtree(std::vector<Node>& nodes, uint32_t depth, BuildState& state)
+	{
+		std::vector<std::pair<uint32_t, uint32_t>> pending{ { 0, depth } };
+		while (!pending.empty())
+		{
+			const auto [nodeIdx, nodeDepth] = pending.back();
+			pending.pop_back();
+
+			if (!Split(nodes, nodeIdx, nodeDepth, state, 1))
+				continue;
+
+			pending.emplace_back(nodes[nodeIdx].first + 1, nodeDepth + 1);
+			pending.emplace_back(nodes[nodeIdx].first, nodeDepth + 1);
+		}
+	}
+
+	bool TriangleBvh::FindClosest(const Vector3& position, float maxSqrDistance, ClosestHit& hit, const ClosestHit* pHint) const
+	{
+		if (m_Nodes.empty())
+			return false;
+
+		const float point[3]{ position.x, position.y, position.z };
+		float bestSqrDistance{ maxSqrDistance };
+		bool isFound{ false };
+
+		//Neighbouring queries mostly end on the same triangle, its distance is a bound that's often already exact
+		if (pHint && pHint->slot < m_Triangles.size())
+			isFound = TestTriangle(point, pHint->slot, bestSqrDistance, isFound, hit);
+
+		//Nodes wait with their distance, a closer hit found meanwhile can still skip them
+		struct PendingNode
+		{
+			uint32_t node;
+			float sqrDistance;
+		};
+
+		PendingNode stack[MaxDepth + 1];
+		uint32_t stackSize{};
+		stack[stackSize++] = PendingNode{ 0, SqrDistanceToBox(point, m_Nodes[0].boundsMin, m_Nodes[0].boundsMax) };
+
+		while (stackSize > 0)
+		{
+			const PendingNode pending{ stack[--stackSize] };
+			if (pending.sqrDistance > bestSqrDistance)
+				continue;
+
+			const Node& node = m_Nodes[pending.node];
+			if (node.count > 0)
+			{
+				for (uint32_t slot = node.first; slot < node.first + node.count; ++slot)
+					isFound = TestTriangle(point, slot, bestSqrDistance, isFound, hit);
+				continue;
+			}
+
+			//Visit the nearer child first, the farther one is often pruned by then
+			const Node& left = m_Nodes[node.first];
+			const Node& right = m_Nodes[node.first + 1];
+			const float leftSqrDistance{ SqrDistanceToBox(point, left.boundsMin, left.boundsMax) };
+			const float rightSqrDistance{ SqrDistanceToBox(point, right.boundsMin, right.boundsMax) };
+			const bool isLeftNearer{ leftSqrDistance <= rightSqrDistance };
+			const float nearSqrDistance{ isLeftNearer ? leftSqrDistance : rightSqrDistance };
+			const float farSqrDistance{ isLeftNearer ? rightSqrDistance : leftSqrDistance };
+
+			if (farSqrDistance <= bestSqrDistance)
+				stack[stackSize++] = PendingNode{ isLeftNearer ? node.first + 1 : node.first, farSqrDistance };
+			if (nearSqrDistance <= bestSqrDistance)
+				stack[stackSize++] = PendingNode{ isLeftNearer ? node.first : node.first + 1, nearSqrDistance };
+		}
+
+		return isFound;
+	}
+
+	bool TriangleBvh::IsOccluded(const Vector3& origin, const Vector3& direction, float maxDistance) const
+	{
+		if (m_Nodes.empty())
+			return false;
+
+		const float rayOrigin[3]{ origin.x, origin.y, origin.z };
+		const float rayDirection[3]{ direction.x, direction.y, direction.z };
+		const float inverseDirection[3]{ 1.f / direction.x, 1.f / direction.y, 1.f / direction.z };
+
+		uint32_t stack[MaxDepth + 1];
+		uint32_t stackSize{};
+		stack[stackSize++] = 0;
+
+		while (stackSize > 0)
+		{
+			const Node& node = m_Nodes[stack[--stackSize]];
+			if (GetBoxEntry(rayOrigin, inverseDirection, maxDistance, node.boundsMin, node.boundsMax) == FLT_MAX)
+				continue;
+
+			if (node.count > 0)
+			{
+				for (uint32_t slot = node.first; slot < node.first + node.count; ++slot)
+				{
+					const float* pCorners = m_Positions.data() + size_t(slot) * 9;
+					float u{}, v{};
+					const float distance{ IntersectTriangle(rayOrigin, rayDirection, pCorners, pCorners + 3, pCorners + 6, u, v) };
+					if (distance > 0.f && distance < maxDistance)
+						return true;
+				}
+				continue;
+			}
+
+			stack[stackSize++] = node.first + 1;
+			stack[stackSize++] = node.first;
+		}
+
+		return false;
+	}
+
+	bool TriangleBvh::Intersect(const Vector3& origin, const Vector3& direction, float maxDistance, RayHit& hit) const
+	{
+		if (m_Nodes.empty())
+			return false;
+
+		const float rayOrigin[3]{ origin.x, origin.y, origin.z };
+		const float rayDirection[3]{ direction.x, direction.y, direction.z };
+		const float inverseDirection[3]{ 1.f / direction.x, 1.f / direction.y, 1.f / direction.z };
+		float closest{ maxDistance };
+		bool isFound{ false };
+
+		//Nodes wait with their entry distance, a closer hit found meanwhile can still skip them
+		struct PendingNode
+		{
+			uint32_t node;
+			float entry;
+		};
+
+		PendingNode stack[MaxDepth + 1];
+		uint32_t stackSize{};
+		const float rootEntry{ GetBoxEntry(rayOrigin, inverseDirection, closest, m_Nodes[0].boundsMin, m_Nodes[0].boundsMax) };
+		if (rootEntry != FLT_MAX)
+			stack[stackSize++] = PendingNode{ 0, rootEntry };
+
+		while (stackSize > 0)
+		{
+			const PendingNode pending{ stack[--stackSize] };
+			if (pending.entry >= closest)
+				continue;
+
+			const Node& node = m_Nodes[pending.node];
+			if (node.count > 0)
+			{
+				for (uint32_t slot = node.first; slot < node.first + node.count; ++slot)
+				{
+					const float* pCorners = m_Positions.data() + size_t(slot) * 9;
+					float u{}, v{};
+					const float distance{ IntersectTriangle(rayOrigin, rayDirection, pCorners, pCorners + 3, pCorners + 6, u, v) };
+					if (distance > 0.f && distance < closest)
+					{
+						closest = distance;
+						hit = RayHit{ m_Triangles[slot], distance, u, v };
+						isFound = true;
+					}
+				}
+				continue;
+			}
+
+			//Visit the nearer child first, the farther one is often behind a hit by then
+			const float leftEntry{ GetBoxEntry(rayOrigin, inverseDirection, closest, m_Nodes[node.first].boundsMin, m_Nodes[node.first].boundsMax) };
+			const float rightEntry{ GetBoxEntry(rayOrigin, inverseDirection, closest, m_Nodes[node.first + 1].boundsMin, m_Nodes[node.first + 1].boundsMax) };
+			const bool isLeftNearer{ leftEntry <= rightEntry };
+			const float nearEntry{ isLeftNearer ? leftEntry : rightEntry };
+			const float farEntry{ isLeftNearer ? rightEntry : leftEntry };
+
+			if (farEntry != FLT_MAX)
+				stack[stackSize++] = PendingNode{ isLeftNearer ? node.first + 1 : node.first, farEntry };
+			if (nearEntry != FLT_MAX)
+				stack[stackSize++] = PendingNode{ isLeftNearer ? node.first : node.first + 1, nearEntry };
+		}
+
+		return isFound;
+	}
+
+	uint32_t TriangleBvh::IntersectPacket(const Vector3* pOrigins, const Vector3* pDirections, const float* pMaxDistances, RayHit* pHits) const
+	{
+#ifdef DAE_BVH_SSE2
+		static_assert(PacketSize == 4, "A packet fills one SSE register");
+		if (m_Nodes.empty())
+			return 0;
+
+		//The rays transposed, one register per component
+		alignas(16) float lanes[10][PacketSize];
+		for (uint32_t lane = 0; lane < PacketSize; ++lane)
+		{
+			for (int axis = 0; axis < 3; ++axis)
+			{
+				lanes[axis][lane] = pOrigins[lane][axis];
+				lanes[3 + axis][lane] = pDirections[lane][axis];
+				lanes[6 + axis][lane] = 1.f / pDirections[lane][axis];
+			}
+			lanes[9][lane] = pMaxDistances[lane];
+		}
+
+		const __m128 originX{ _mm_load_ps(lanes[0]) }, originY{ _mm_load_ps(lanes[1]) }, originZ{ _mm_load_ps(lanes[2]) };
+		const __m128 directionX{ _mm_load_ps(lanes[3]) }, directionY{ _mm_load_ps(lanes[4]) }, directionZ{ _mm_load_ps(lanes[5]) };
+		const __m128 inverseX{ _mm_load_ps(lanes[6]) }, inverseY{ _mm_load_ps(lanes[7]) }, inverseZ{ _mm_load_ps(lanes[8]) };
+		__m128 closest{ _mm_load_ps(lanes[9]) };
+		__m128 hitU{ _mm_setzero_ps() };
+		__m128 hitV{ _mm_setzero_ps() };
+		__m128i hitSlots{ _mm_set1_epi32(-1) };
+		const __m128 zero{ _mm_setzero_ps() };
+		const __m128 one{ _mm_set1_ps(1.f) };
+		const __m128 miss{ _mm_set1_ps(FLT_MAX) };
+
+		//Entry distance of every ray, FLT_MAX for rays that miss the box before their closest hit.
+		//Operands are in the order that makes NaNs behave like they do in GetBoxEntry.
+		const auto getEntries = [&](const Node& node)
+			{
+				const __m128 nearX{ _mm_mul_ps(_mm_sub_ps(_mm_set1_ps(node.boundsMin[0]), originX), inverseX) };
+				const __m128 farX{ _mm_mul_ps(_mm_sub_ps(_mm_set1_ps(node.boundsMax[0]), originX), inverseX) };
+				const __m128 nearY{ _mm_mul_ps(_mm_sub_ps(_mm_set1_ps(node.boundsMin[1]), originY), inverseY) };
+				const __m128 farY{ _mm_mul_ps(_mm_sub_ps(_mm_set1_ps(node.boundsMax[1]), originY), inverseY) };
+				const __m128 nearZ{ _mm_mul_ps(_mm_sub_ps(_mm_set1_ps(node.boundsMin[2]), originZ), inverseZ) };
+				const __m128 farZ{ _mm_mul_ps(_mm_sub_ps(_mm_set1_ps(node.boundsMax[2]), originZ), inverseZ) };
+
+				__m128 enter{ _mm_max_ps(_mm_min_ps(farX, nearX), zero) };
+				enter = _mm_max_ps(_mm_min_ps(farY, nearY), enter);
+				enter = _mm_max_ps(_mm_min_ps(farZ, nearZ), enter);
+				__m128 exit{ _mm_min_ps(_mm_max_ps(farX, nearX), closest) };
+				exit = _mm_min_ps(_mm_max_ps(farY, nearY), exit);
+				exit = _mm_min_ps(_mm_max_ps(farZ, nearZ), exit);
+
+				const __m128 isHit{ _mm_cmple_ps(enter, exit) };
+				return _mm_or_ps(_mm_and_ps(isHit, enter), _mm_andnot_ps(isHit, miss));
+			};
+
+		//Smallest entry of the packet, FLT_MAX when no ray enters
+		const auto getNearest = [](__m128 entries)
+			{
+				entries = _mm_min_ps(entries, _mm_shuffle_ps(entries, entries, _MM_SHUFFLE(2, 3, 0, 1)));
+				entries = _mm_min_ps(entries, _mm_shuffle_ps(entries, entries, _MM_SHUFFLE(1, 0, 3, 2)));
+				return _mm_cvtss_f32(entries);
+			};
+
+		struct PendingNode
+		{
+			__m128 entries;
+			uint32_t node;
+		};
+
+		PendingNode stack[MaxDepth + 1];
+		uint32_t stackSize{};
+		stack[stackSize++] = PendingNode{ getEntries(m_Nodes[0]), 0 };
+
+		while (stackSize > 0)
+		{
+			const PendingNode pending{ stack[--stackSize] };
+			if (_mm_movemask_ps(_mm_cmplt_ps(pending.entries, closest)) == 0)
+				continue;
+
+			const Node& node = m_Nodes[pending.node];
+			if (node.count > 0)
+			{
+				for (uint32_t slot = node.first; slot < node.first + node.count; ++slot)
+				{
+					//The same operations in the same order as IntersectTriangle, for the same results
+					const float* a = m_Positions.data() + size_t(slot) * 9;
+					const __m128 abX{ _mm_set1_ps(a[3] - a[0]) }, abY{ _mm_set1_ps(a[4] - a[1]) }, abZ{ _mm_set1_ps(a[5] - a[2]) };
+					const __m128 acX{ _mm_set1_ps(a[6] - a[0]) }, acY{ _mm_set1_ps(a[7] - a[1]) }, acZ{ _mm_set1_ps(a[8] - a[2]) };
+
+					const __m128 pX{ _mm_sub_ps(_mm_mul_ps(directionY, acZ), _mm_mul_ps(directionZ, acY)) };
+					const __m128 pY{ _mm_sub_ps(_mm_mul_ps(directionZ, acX), _mm_mul_ps(directionX, acZ)) };
+					const __m128 pZ{ _mm_sub_ps(_mm_mul_ps(directionX, acY), _mm_mul_ps(directionY, acX)) };
+					const __m128 determinant{ _mm_add_ps(_mm_add_ps(_mm_mul_ps(abX, pX), _mm_mul_ps(abY, pY)), _mm_mul_ps(abZ, pZ)) };
+					const __m128 inverseDeterminant{ _mm_div_ps(one, determinant) };
+
+					const __m128 aoX{ _mm_sub_ps(originX, _mm_set1_ps(a[0])) };
+					const __m128 aoY{ _mm_sub_ps(originY, _mm_set1_ps(a[1])) };
+					const __m128 aoZ{ _mm_sub_ps(originZ, _mm_set1_ps(a[2])) };
+					const __m128 u{ _mm_mul_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(aoX, pX), _mm_mul_ps(aoY, pY)), _mm_mul_ps(aoZ, pZ)), inverseDeterminant) };
+
+					const __m128 qX{ _mm_sub_ps(_mm_mul_ps(aoY, abZ), _mm_mul_ps(aoZ, abY)) };
+					const __m128 qY{ _mm_sub_ps(_mm_mul_ps(aoZ, abX), _mm_mul_ps(aoX, abZ)) };
+					const __m128 qZ{ _mm_sub_ps(_mm_mul_ps(aoX, abY), _mm_mul_ps(aoY, abX)) };
+					const __m128 v{ _mm_mul_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(directionX, qX), _mm_mul_ps(directionY, qY)), _mm_mul_ps(directionZ, qZ)), inverseDeterminant) };
+					const __m128 distance{ _mm_mul_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(acX, qX), _mm_mul_ps(acY, qY)), _mm_mul_ps(acZ, qZ)), inverseDeterminant) };
+
+					__m128 isHit{ _mm_cmpneq_ps(determinant, zero) };
+					isHit = _mm_and_ps(isHit, _mm_and_ps(_mm_cmpge_ps(u, zero), _mm_cmple_ps(u, one)));
+					isHit = _mm_and_ps(isHit, _mm_and_ps(_mm_cmpge_ps(v, zero), _mm_cmple_ps(_mm_add_ps(u, v), one)));
+					isHit = _mm_and_ps(isHit, _mm_and_ps(_mm_cmpgt_ps(distance, zero), _mm_cmplt_ps(distance, closest)));
+					if (_mm_movemask_ps(isHit) == 0)
+						continue;
+
+					closest = _mm_or_ps(_mm_and_ps(isHit, distance), _mm_andnot_ps(isHit, closest));
+					hitU = _mm_or_ps(_mm_and_ps(isHit, u), _mm_andnot_ps(isHit, hitU));
+					hitV = _mm_or_ps(_mm_and_ps(isHit, v), _mm_andnot_ps(isHit, hitV));
+					const __m128i isHitInt{ _mm_castps_si128(isHit) };
+					hitSlots = _mm_or_si128(_mm_and_si128(isHitInt, _mm_set1_epi32(static_cast<int>(slot))), _mm_andnot_si128(isHitInt, hitSlots));
+				}
+				continue;
+			}
+
+			//Visit the child the packet reaches first first
+			const __m128 leftEntries{ getEntries(m_Nodes[node.first]) };
+			const __m128 rightEntries{ getEntries(m_Nodes[node.first + 1]) };
+			const float leftNearest{ getNearest(leftEntries) };
+			const float rightNearest{ getNearest(rightEntries) };
+			const bool isLeftNearer{ leftNearest <= rightNearest };
+
+			if ((isLeftNearer ? rightNearest : leftNearest) != FLT_MAX)
+				stack[stackSize++] = isLeftNearer ? PendingNode{ rightEntries, node.first + 1 } : PendingNode{ leftEntries, node.first };
+			if ((isLeftNearer ? leftNearest : rightNearest) != FLT_MAX)
+				stack[stackSize++] = isLeftNearer ? PendingNode{ leftEntries, node.first } : PendingNode{ rightEntries, node.first + 1 };
+		}
+
+		alignas(16) float distances[PacketSize];
+		alignas(16) float us[PacketSize];
+		alignas(16) float vs[PacketSize];
+		alignas(16) int32_t slots[PacketSize];
+		_mm_store_ps(distances, closest);
+		_mm_store_ps(us, hitU);
+		_mm_store_ps(vs, hitV);
+		_mm_store_si128(reinterpret_cast<__m128i*>(slots), hitSlots);
+
+		uint32_t hitMask{};
+		for (uint32_t lane = 0; lane < PacketSize; ++lane)
+		{
+			if (slots[lane] < 0)
+				continue;
+
+			pHits[lane] = RayHit{ m_Triangles[slots[lane]], distances[lane], us[lane], vs[lane] };
+			hitMask |= 1u << lane;
+		}
+
+		return hitMask;
+#else
+		uint32_t hitMask{};
+		for (uint32_t lane = 0; lane < PacketSize; ++lane)
+		{
+			if (Intersect(pOrigins[lane], pDirections[lane], pMaxDistances[lane], pHits[lane]))
+				hitMask |= 1u << lane;
+		}
+
+		return hitMask;
+#endif
+	}
+
+	bool TriangleBvh::TestTriangle(const float* pPoint, uint32_t slot, float& bestSqrDistance, bool isFound, ClosestHit& hit) const
+	{
+		const float* pCorners = m_Positions.data() + size_t(slot) * 9;
+		float closest[3];
+		const Feature feature{ ClosestPointOnTriangle(pPoint, pCorners, pCorners + 3, pCorners + 6, closest) };
+		const float offset[3]{ pPoint[0] - closest[0], pPoint[1] - closest[1], pPoint[2] - closest[2] };
+		const float sqrDistance{ Dot(offset, offset) };
+		if (sqrDistance < bestSqrDistance || (!isFound && sqrDistance <= bestSqrDistance))
+		{
+			bestSqrDistance = sqrDistance;
+			hit = ClosestHit{ m_Triangles[slot], sqrDistance, Vector3{ closest[0], closest[1], closest[2] }, feature, slot };
+			return true;
+		}
+
+		return isFound;
+	}
+}
@@ -0,0 +1,97 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+#include "Vertex.h"
+
+namespace dae
+{
+	//Bounding volume hierarchy over the triangles of an indexed mesh, split with the surface area heuristic over binned centroids
+	class TriangleBvh final
+	{
+	public:
+		static constexpr uint32_t MaxLeafSize{ 4 };
+		//Rays IntersectPacket traverses together
+		static constexpr uint32_t PacketSize{ 4 };
+
+		//Where on its triangle a closest point lies
+		enum class Feature : uint8_t
+		{
+			Face,
+			//Edge i runs from corner i to corner (i + 1) % 3
+			Edge0,
+			Edge1,
+			Edge2,
+			Vertex0,
+			Vertex1,
+			Vertex2
+		};
+
+		struct ClosestHit
+		{
+			//Index of the triangle in the source index list, divided by three
+			uint32_t triangle;
+			float sqrDistance;
+			Vector3 point;
+			Feature feature;
+			//Position of the triangle in the tree, lets a nearby query start from it
+			uint32_t slot;
+		};
+
+		struct RayHit
+		{
+			//Index of the triangle in the source index list, divided by three
+			uint32_t triangle;
+			float distance;
+			//Barycentric weights of corners 1 and 2, corner 0 gets 1 - u - v
+			float u;
+			float v;
+		};
+
+		TriangleBvh() = default;
+		//Zero area triangles are left out, nothing can be closest to them that isn't closer to a neighbour and rays can't hit them.
+		//Large nodes are binned on numThreads threads, the nodes below them are built as subtrees on one thread each.
+		//The tree doesn't depend on numThreads.
+		TriangleBvh(const std::vector<Vertex>& vertices, const std::vector<uint32_t>& indices, size_t numThreads = 1);
+
+		//Finds the closest point on the mesh within sqrt(maxSqrDistance) of position, returns false when there is none.
+		//A tight maxSqrDistance prunes most of the tree, so does the hit of a nearby query as pHint: its triangle is tested first.
+		bool FindClosest(const Vector3& position, float maxSqrDistance, ClosestHit& hit, const ClosestHit* pHint = nullptr) const;
+		//True when the ray hits any triangle, from either side, at a distance in (0, maxDistance) along direction.
+		//Stops at the first hit found instead of looking for the closest one.
+		bool IsOccluded(const Vector3& origin, const Vector3& direction, float maxDistance) const;
+		//Closest triangle the ray hits, from either side, at a distance in (0, maxDistance) along direction
+		bool Intersect(const Vector3& origin, const Vector3& direction, float maxDistance, RayHit& hit) const;
+		//Closest hits of PacketSize rays traversed together: a node is visited when any of the rays reaches it.
+		//Pays off for coherent rays, like those through neighbouring pixels. Four rays per instruction with SSE2.
+		//Returns a bit per ray that hit something, the hits of the other rays are left as they are.
+		uint32_t IntersectPacket(const Vector3* pOrigins, const Vector3* pDirections, const float* pMaxDistances, RayHit* pHits) const;
+
+		size_t GetNodeCount() const { return m_Nodes.size(); }
+		size_t GetTriangleCount() const { return m_Triangles.size(); }
+
+	private:
+		//Inner nodes have their children at first and first + 1, leaves have count > 0 triangles from first on
+		struct Node
+		{
+			float boundsMin[3];
+			uint32_t first;
+			float boundsMax[3];
+			uint32_t count;
+		};
+
+		struct BuildState;
+
+		void Build(size_t numThreads);
+		//Splits the node with the surface area heuristic and appends its children, false when it stays a leaf
+		static bool Split(std::vector<Node>& nodes, uint32_t nodeIdx, uint32_t depth, BuildState& state, size_t numThreads);
+		//Splits nodes[0] down to the leaves on the calling thread
+		static void BuildSubtree(std::vector<Node>& nodes, uint32_t depth, BuildState& state);
+		//Keeps the closer of hit and the point on the triangle in slot
+		bool TestTriangle(const float* pPoint, uint32_t slot, float& bestSqrDistance, bool isFound, ClosestHit& hit) const;
+
+		std::vector<Node> m_Nodes{};
+		//Source triangle of every slot, and its corner positions, nine floats per slot in leaf order
+		std::vector<uint32_t> m_Triangles{};
+		std::vector<float> m_Positions{};
+	};
+}
@@ -1,165 +1,707 @@
 #pragma once
-#include <fstream>
+#include <charconv>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <unordered_map>
 #include "Math.h"
-#include "Mesh.h"
+#include "MappedFile.h"
+#include "ParallelFor.h"
+#include "SmoothNormals.h"
+#include "TangentSpace.h"
+#include "Vertex.h"
 #include <vector>
 
 namespace dae
 {
 	namespace Utils
 	{
-		//Just parses vertices and indices
-#pragma warning(push)
-#pragma warning(disable : 4505) //Warning unreferenced local function
-		static bool ParseOBJ(const std::string& filename, std::vector<Vertex>& vertices, std::vector<uint32_t>& indices, bool flipAxisAndWinding = true)
+		//Tokenizer helpers for ParseOBJ, they work directly on the mapped file and never allocate
+		namespace Obj
 		{
-			std::ifstream file(filename);
-			if (!file)
-				return false;
+			inline bool IsBlank(char c)
+			{
+				return c == ' ' || c == '\t' || c == '\r' || c == '\v' || c == '\f';
+			}
 
-			std::vector<Vector3> positions{};
-			std::vector<Vector3> normals{};
-			std::vector<Vector2> UVs{};
+			inline void SkipBlanks(const char*& pCursor, const char* pEnd)
+			{
+				while (pCursor < pEnd && IsBlank(*pCursor))
+					++pCursor;
+			}
 
-			vertices.clear();
-			indices.clear();
+			//Returns the start of the next line (or pEnd)
+			inline const char* NextLine(const char* pCursor, const char* pEnd)
+			{
+				if (pCursor >= pEnd)
+					return pEnd;
+
+				const void* pNewLine = std::memchr(pCursor, '\n', static_cast<size_t>(pEnd - pCursor));
+				return pNewLine ? static_cast<const char*>(pNewLine) + 1 : pEnd;
+			}
+
+			inline std::string_view ReadCommand(const char*& pCursor, const char* pEnd)
+			{
+				SkipBlanks(pCursor, pEnd);
+				const char* pStart = pCursor;
+				while (pCursor < pEnd && !IsBlank(*pCursor) && *pCursor != '\n')
+					++pCursor;
+
+				return { pStart, static_cast<size_t>(pCursor - pStart) };
+			}
+
+			inline float ReadFloat(const char*& pCursor, const char* pEnd)
+			{
+				SkipBlanks(pCursor, pEnd);
+				//from_chars doesn't accept an explicit plus sign
+				if (pCursor < pEnd && *pCursor == '+')
+					++pCursor;
+
+				float value{};
+				const auto [pNext, error] = std::from_chars(pCursor, pEnd, value);
+				if (error != std::errc{})
+					return 0.f;
+
+				pCursor = pNext;
+				return value;
+			}
 
-			std::string sCommand;
-			// start a while iteration ending when the end of file is reached (ios::eof)
-			while (!file.eof())
+			inline bool ReadIndex(const char*& pCursor, const char* pEnd, int64_t& value)
 			{
-				//read the first word of the string, use the >> operator (istream::operator>>) 
-				file >> sCommand;
-				//use conditional statements to process the different commands	
-				if (sCommand == "#")
+				SkipBlanks(pCursor, pEnd);
+				const auto [pNext, error] = std::from_chars(pCursor, pEnd, value);
+				if (error != std::errc{})
+					return false;
+
+				pCursor = pNext;
+				return true;
+			}
+
+			//Open-addressing map from a face corner (1-based position/uv/normal index triple and material) to its welded vertex
+			class CornerMap final
+			{
+			public:
+				explicit CornerMap(size_t expectedCount)
 				{
-					// Ignore Comment
+					size_t capacity{ 16 };
+					while (capacity < expectedCount * 2)
+						capacity <<= 1;
+
+					m_Slots.resize(capacity);
 				}
-				else if (sCommand == "v")
+
+				//Returns the vertex index stored for the corner, or stores newIndex and returns that
+				uint32_t FindOrInsert(uint32_t position, uint32_t uv, uint32_t normal, uint32_t material, uint32_t newIndex)
 				{
-					//Vertex
-					float x, y, z;
-					file >> x >> y >> z;
+					if ((m_Count + 1) * 2 > m_Slots.size())
+						Grow();
+
+					const size_t mask = m_Slots.size() - 1;
+					for (size_t slotIdx = Hash(position, uv, normal, material) & mask; ; slotIdx = (slotIdx + 1) & mask)
+					{
+						Slot& slot = m_Slots[slotIdx];
+						if (slot.position == 0)
+						{
+							slot = { position, uv, normal, material, newIndex };
+							++m_Count;
+							return newIndex;
+						}
 
-					positions.emplace_back(x, y, z);
+						if (slot.position == position && slot.uv == uv && slot.normal == normal && slot.material == material)
+							return slot.vertex;
+					}
 				}
-				else if (sCommand == "vt")
+
+			private:
+				//position 0 marks an empty slot, OBJ indices start at 1
+				struct Slot
 				{
-					// Vertex TexCoord
-					float u, v;
-					file >> u >> v;
-					UVs.emplace_back(u, 1 - v);
+					uint32_t position;
+					uint32_t uv;
+					uint32_t normal;
+					uint32_t material;
+					uint32_t vertex;
+				};
+
+				std::vector<Slot> m_Slots{};
+				size_t m_Count{};
+
+				static size_t Hash(uint32_t position, uint32_t uv, uint32_t normal, uint32_t material)
+				{
+					uint64_t hash = position * 0x9E3779B97F4A7C15ull;
+					hash ^= (uv + (hash >> 29)) * 0xBF58476D1CE4E5B9ull;
+					hash ^= (normal + (hash >> 31)) * 0x94D049BB133111EBull;
+					hash ^= (material + (hash >> 27)) * 0x9E3779B97F4A7C15ull;
+					return static_cast<size_t>(hash ^ (hash >> 32));
 				}
-				else if (sCommand == "vn")
+
+				void Grow()
 				{
-					// Vertex Normal
-					float x, y, z;
-					file >> x >> y >> z;
+					std::vector<Slot> oldSlots(m_Slots.size() * 2);
+					oldSlots.swap(m_Slots);
+					m_Count = 0;
+
+					for (const Slot& slot : oldSlots)
+					{
+						if (slot.position != 0)
+							FindOrInsert(slot.position, slot.uv, slot.normal, slot.material, slot.vertex);
+					}
+				}
+			};
+
+			//Face corner as 1-based OBJ indices, 0 when the attribute is missing
+			struct Corner
+			{
+				uint32_t position;
+				uint32_t uv;
+				uint32_t normal;
+			};
+
+			//Faces before the first usemtl of a chunk keep the material the previous chunk ended with
+			constexpr uint32_t InheritedMaterial{ UINT32_MAX };
+
+			//Everything one worker reads from its part of the file, in file order
+			struct Chunk
+			{
+				//Line counts of the pre-scan, their prefix sums resolve relative indices
+				size_t numPositions{};
+				size_t numNormals{};
+				size_t numUVs{};
+				size_t numFaces{};
 
-					normals.emplace_back(x, y, z);
+				std::vector<Vector3> positions{};
+				std::vector<Vector3> normals{};
+				std::vector<Vector2> UVs{};
+				//Corners of all faces, faceSizes tells where one face ends and the next starts
+				std::vector<Corner> corners{};
+				std::vector<uint32_t> faceSizes{};
+				std::vector<uint32_t> faceMaterials{};
+				std::vector<std::string> materialNames{};
+				uint32_t lastMaterial{ InheritedMaterial };
+				size_t numTriangles{};
+				bool isValid{ true };
+			};
+
+			//OBJ format uses 1-based arrays, negative indices count back from the last element read so far
+			inline bool ReadCornerIndex(const char*& pCursor, const char* pEnd, size_t numRead, uint32_t& index)
+			{
+				int64_t value{};
+				if (!ReadIndex(pCursor, pEnd, value))
+					return false;
+
+				if (value < 0)
+					value += int64_t(numRead) + 1;
+				if (value < 1 || value > int64_t(UINT32_MAX))
+					return false;
+
+				index = uint32_t(value);
+				return true;
+			}
+
+			//Counts the line types so every array is allocated exactly once
+			inline void CountLines(const char* pBegin, const char* pEnd, Chunk& chunk)
+			{
+				for (const char* pLine = pBegin; pLine < pEnd; pLine = NextLine(pLine, pEnd))
+				{
+					const char* pCursor = pLine;
+					const std::string_view command = ReadCommand(pCursor, pEnd);
+					if (command == "v") ++chunk.numPositions;
+					else if (command == "vt") ++chunk.numUVs;
+					else if (command == "vn") ++chunk.numNormals;
+					else if (command == "f") ++chunk.numFaces;
 				}
-				else if (sCommand == "f")
+			}
+
+			//Parses the lines in [pBegin, pEnd), the bases are the element counts of all earlier chunks.
+			//Face indices are only checked against the totals once all chunks are merged.
+			inline void ParseChunk(const char* pBegin, const char* pEnd, size_t positionBase, size_t UVBase, size_t normalBase, Chunk& chunk)
+			{
+				chunk.positions.reserve(chunk.numPositions);
+				chunk.normals.reserve(chunk.numNormals);
+				chunk.UVs.reserve(chunk.numUVs);
+				chunk.corners.reserve(chunk.numFaces * 3);
+				chunk.faceSizes.reserve(chunk.numFaces);
+				chunk.faceMaterials.reserve(chunk.numFaces);
+
+				uint32_t material{ InheritedMaterial };
+				for (const char* pLine = pBegin; pLine < pEnd; pLine = NextLine(pLine, pEnd))
 				{
-					//if a face is read:
-					//construct the 3 vertices, add them to the vertex array
-					//add three indices to the index array
-					//add the material index as attibute to the attribute array
-					//
-					// Faces or triangles
-					Vertex vertex{};
-					size_t iPosition, iTexCoord, iNormal;
+					const char* pCursor = pLine;
+					//read the first word of the line, comments, groups, objects and unknown commands are skipped
+					const std::string_view command = ReadCommand(pCursor, pEnd);
 
-					uint32_t tempIndices[3];
-					for (size_t iFace = 0; iFace < 3; iFace++)
+					if (command == "v")
 					{
-						// OBJ format uses 1-based arrays
-						file >> iPosition;
-						vertex.position = positions[iPosition - 1];
+						//Vertex
+						const float x = ReadFloat(pCursor, pEnd);
+						const float y = ReadFloat(pCursor, pEnd);
+						const float z = ReadFloat(pCursor, pEnd);
 
-						if ('/' == file.peek())//is next in buffer ==  '/' ?
+						chunk.positions.emplace_back(x, y, z);
+					}
+					else if (command == "vt")
+					{
+						// Vertex TexCoord
+						const float u = ReadFloat(pCursor, pEnd);
+						const float v = ReadFloat(pCursor, pEnd);
+						chunk.UVs.emplace_back(u, 1 - v);
+					}
+					else if (command == "vn")
+					{
+						// Vertex Normal
+						const float x = ReadFloat(pCursor, pEnd);
+						const float y = ReadFloat(pCursor, pEnd);
+						const float z = ReadFloat(pCursor, pEnd);
+
+						chunk.normals.emplace_back(x, y, z);
+					}
+					else if (command == "usemtl")
+					{
+						//The name runs to the end of the line
+						SkipBlanks(pCursor, pEnd);
+						const char* pNameEnd = NextLine(pCursor, pEnd);
+						while (pNameEnd > pCursor && (pNameEnd[-1] == '\n' || IsBlank(pNameEnd[-1])))
+							--pNameEnd;
+
+						const std::string_view name{ pCursor, static_cast<size_t>(pNameEnd - pCursor) };
+						const auto it = std::find(chunk.materialNames.begin(), chunk.materialNames.end(), name);
+						material = static_cast<uint32_t>(it - chunk.materialNames.begin());
+						if (it == chunk.materialNames.end())
+							chunk.materialNames.emplace_back(name);
+
+						chunk.lastMaterial = material;
+					}
+					else if (command == "f")
+					{
+						// Faces, polygons are triangulated once every position is known
+						//Corners without uv/normal keep the previous corner's within the same face
+						Corner corner{};
+						uint32_t numCorners{};
+						for (;;)
 						{
-							file.ignore();//read and ignore one element ('/')
+							SkipBlanks(pCursor, pEnd);
+							if (pCursor == pEnd || *pCursor == '\n' || *pCursor == '#')
+								break;
 
-							if ('/' != file.peek())
+							if (!ReadCornerIndex(pCursor, pEnd, positionBase + chunk.positions.size(), corner.position))
 							{
-								// Optional texture coordinate
-								file >> iTexCoord;
-								vertex.uv = UVs[iTexCoord - 1];
+								chunk.isValid = false;
+								return;
 							}
 
-							if ('/' == file.peek())
+							if (pCursor < pEnd && *pCursor == '/')
 							{
-								file.ignore();
+								++pCursor;
 
-								// Optional vertex normal
-								file >> iNormal;
-								vertex.normal = normals[iNormal - 1];
+								// Optional texture coordinate
+								if (pCursor < pEnd && *pCursor != '/' && !ReadCornerIndex(pCursor, pEnd, UVBase + chunk.UVs.size(), corner.uv))
+								{
+									chunk.isValid = false;
+									return;
+								}
+
+								if (pCursor < pEnd && *pCursor == '/')
+								{
+									++pCursor;
+
+									// Optional vertex normal
+									if (!ReadCornerIndex(pCursor, pEnd, normalBase + chunk.normals.size(), corner.normal))
+									{
+										chunk.isValid = false;
+										return;
+									}
+								}
 							}
+
+							chunk.corners.push_back(corner);
+							++numCorners;
+						}
+
+						if (numCorners < 3)
+						{
+							chunk.isValid = false;
+							return;
 						}
 
-						vertices.push_back(vertex);
-						tempIndices[iFace] = uint32_t(vertices.size()) - 1;
-						//indices.push_back(uint32_t(vertices.size()) - 1);
+						chunk.faceSizes.push_back(numCorners);
+						chunk.faceMaterials.push_back(material);
+						chunk.numTriangles += numCorners - 2;
 					}
+				}
+			}
+
+			inline float Cross2D(const Vector2& a, const Vector2& b, const Vector2& c)
+			{
+				return (b.x - a.x) * (c.y - a.y) - (b.y - a.y) * (c.x - a.x);
+			}
+
+			//Writes the numCorners - 2 triangles of a face, keeping its winding.
+			//Quads take the diagonal that keeps both halves facing the same way, larger polygons are ear clipped in the plane of their
+			//Newell normal. Faces without a valid ear, such as self-intersecting ones, fall back to clipping the next corner.
+			inline void TriangulateFace(const Corner* pFace, uint32_t numCorners, const std::vector<Vector3>& positions, Corner* pTriangles)
+			{
+				if (numCorners == 3)
+				{
+					std::copy(pFace, pFace + 3, pTriangles);
+					return;
+				}
+
+				const auto positionOf = [&](uint32_t corner) -> const Vector3& { return positions[pFace[corner].position - 1]; };
+
+				//Newell's method, robust against slightly non-planar faces
+				Vector3 normal{};
+				for (uint32_t corner = 0; corner < numCorners; ++corner)
+				{
+					const Vector3& current = positionOf(corner);
+					const Vector3& next = positionOf((corner + 1) % numCorners);
+					normal.x += (current.y - next.y) * (current.z + next.z);
+					normal.y += (current.z - next.z) * (current.x + next.x);
+					normal.z += (current.x - next.x) * (current.y + next.y);
+				}
+
+				if (numCorners == 4)
+				{
+					const Vector3& p0 = positionOf(0);
+					const bool isFirstDiagonalValid{ Vector3::Dot(Vector3::Cross(positionOf(1) - p0, positionOf(2) - p0), normal) > 0.f &&
+						Vector3::Dot(Vector3::Cross(positionOf(2) - p0, positionOf(3) - p0), normal) > 0.f };
+					const uint32_t first{ isFirstDiagonalValid ? 0u : 1u };
+					const uint32_t order[6]{ first, first + 1, (first + 2) % 4, first, (first + 2) % 4, (first + 3) % 4 };
+					for (int i = 0; i < 6; ++i)
+						pTriangles[i] = pFace[order[i]];
+					return;
+				}
 
-					indices.push_back(tempIndices[0]);
-					if (flipAxisAndWinding)
+				//Drop the dominant axis, the remaining two are ordered so the face winds counterclockwise in 2D
+				const Vector3 absNormal{ fabsf(normal.x), fabsf(normal.y), fabsf(normal.z) };
+				const int axis{ absNormal.x > absNormal.y && absNormal.x > absNormal.z ? 0 : absNormal.y > absNormal.z ? 1 : 2 };
+				const bool isFlipped{ normal[axis] < 0.f };
+				std::vector<Vector2> projected(numCorners);
+				for (uint32_t corner = 0; corner < numCorners; ++corner)
+				{
+					const Vector3& position = positionOf(corner);
+					const float u{ position[(axis + 1) % 3] };
+					const float v{ position[(axis + 2) % 3] };
+					projected[corner] = isFlipped ? Vector2{ v, u } : Vector2{ u, v };
+				}
+
+				std::vector<uint32_t> next(numCorners), previous(numCorners);
+				for (uint32_t corner = 0; corner < numCorners; ++corner)
+				{
+					next[corner] = (corner + 1) % numCorners;
+					previous[corner] = (corner + numCorners - 1) % numCorners;
+				}
+
+				const auto isEar = [&](uint32_t corner)
 					{
-						indices.push_back(tempIndices[2]);
-						indices.push_back(tempIndices[1]);
-					}
-					else
+						const Vector2& a = projected[previous[corner]];
+						const Vector2& b = projected[corner];
+						const Vector2& c = projected[next[corner]];
+						if (Cross2D(a, b, c) <= 0.f)
+							return false;
+
+						for (uint32_t other = next[next[corner]]; other != previous[corner]; other = next[other])
+						{
+							const Vector2& p = projected[other];
+							if (Cross2D(a, b, p) >= 0.f && Cross2D(b, c, p) >= 0.f && Cross2D(c, a, p) >= 0.f)
+								return false;
+						}
+						return true;
+					};
+
+				uint32_t corner{ 0 };
+				uint32_t numLeft{ numCorners };
+				uint32_t numTried{};
+				while (numLeft > 3)
+				{
+					if (!isEar(corner) && ++numTried < numLeft)
 					{
-						indices.push_back(tempIndices[1]);
-						indices.push_back(tempIndices[2]);
+						corner = next[corner];
+						continue;
 					}
+
+					*pTriangles++ = pFace[previous[corner]];
+					*pTriangles++ = pFace[corner];
+					*pTriangles++ = pFace[next[corner]];
+
+					next[previous[corner]] = next[corner];
+					previous[next[corner]] = previous[corner];
+					corner = next[corner];
+					--numLeft;
+					numTried = 0;
 				}
-				//read till end of line and ignore all remaining chars
-				file.ignore(1000, '\n');
+
+				*pTriangles++ = pFace[previous[corner]];
+				*pTriangles++ = pFace[corner];
+				*pTriangles++ = pFace[next[corner]];
 			}
+		}
+
+		//Triangles of one usemtl material, faces before the first usemtl get an empty name
+		struct ObjMaterialRange
+		{
+			std::string material;
+			uint32_t indexStart;
+			uint32_t indexCount;
+		};
+
+		//Just parses vertices and indices
+		//Faces of any size are triangulated and may use negative (relative) indices.
+		//Triangles are grouped by usemtl material in order of first use, pMaterialRanges receives the groups.
+		//weldVertices shares one vertex between all face corners with the same position/uv/normal indices and material,
+		//otherwise every corner gets its own vertex.
+		//numThreads > 1 parses the file in line-aligned chunks on worker threads, the output doesn't depend on it.
+		//Normals are generated when the file has none.
+#pragma warning(push)
+#pragma warning(disable : 4505) //Warning unreferenced local function
+		static bool ParseOBJ(const std::string& filename, std::vector<Vertex>& vertices, std::vector<uint32_t>& indices, bool flipAxisAndWinding = true,
+			bool weldVertices = false, size_t numThreads = 1, std::vector<ObjMaterialRange>* pMaterialRanges = nullptr)
+		{
+			const MappedFile file{ filename };
+			if (!file.IsOpen())
+				return false;
 
-			//Cheap Tangent Calculations
-			for (uint32_t i = 0; i < indices.size(); i += 3)
+			const char* const pBegin = file.GetData();
+			const char* const pEnd = pBegin + file.GetSize();
+
+			vertices.clear();
+			indices.clear();
+			if (pMaterialRanges)
+				pMaterialRanges->clear();
+
+			//Split on line boundaries, small files aren't worth the thread startup
+			constexpr size_t minChunkSize{ 256 * 1024 };
+			const size_t numChunks{ std::max(size_t{ 1 }, std::min(numThreads, file.GetSize() / minChunkSize)) };
+
+			std::vector<const char*> chunkStarts(numChunks + 1, pEnd);
+			chunkStarts[0] = pBegin;
+			for (size_t chunkIdx = 1; chunkIdx < numChunks; ++chunkIdx)
+			{
+				const char* pSplit = std::max(pBegin + file.GetSize() * chunkIdx / numChunks, chunkStarts[chunkIdx - 1]);
+				chunkStarts[chunkIdx] = pSplit > pBegin ? Obj::NextLine(pSplit - 1, pEnd) : pBegin;
+			}
+
+			//Count first, relative indices need to know how many elements the earlier chunks hold
+			std::vector<Obj::Chunk> chunks(numChunks);
+			ParallelFor(numChunks, numChunks, [&](size_t begin, size_t end)
+				{
+					for (size_t chunkIdx = begin; chunkIdx < end; ++chunkIdx)
+						Obj::CountLines(chunkStarts[chunkIdx], chunkStarts[chunkIdx + 1], chunks[chunkIdx]);
+				});
+
+			//Prefix sums give every chunk its offset in the merged arrays
+			std::vector<size_t> positionBase(numChunks + 1), normalBase(numChunks + 1), UVBase(numChunks + 1);
+			for (size_t chunkIdx = 0; chunkIdx < numChunks; ++chunkIdx)
 			{
-				uint32_t index0 = indices[i];
-				uint32_t index1 = indices[size_t(i) + 1];
-				uint32_t index2 = indices[size_t(i) + 2];
+				positionBase[chunkIdx + 1] = positionBase[chunkIdx] + chunks[chunkIdx].numPositions;
+				normalBase[chunkIdx + 1] = normalBase[chunkIdx] + chunks[chunkIdx].numNormals;
+				UVBase[chunkIdx + 1] = UVBase[chunkIdx] + chunks[chunkIdx].numUVs;
+			}
+
+			ParallelFor(numChunks, numChunks, [&](size_t begin, size_t end)
+				{
+					for (size_t chunkIdx = begin; chunkIdx < end; ++chunkIdx)
+						Obj::ParseChunk(chunkStarts[chunkIdx], chunkStarts[chunkIdx + 1], positionBase[chunkIdx], UVBase[chunkIdx], normalBase[chunkIdx], chunks[chunkIdx]);
+				});
+
+			std::vector<size_t> cornerBase(numChunks + 1), faceBase(numChunks + 1), triangleBase(numChunks + 1);
+			for (size_t chunkIdx = 0; chunkIdx < numChunks; ++chunkIdx)
+			{
+				if (!chunks[chunkIdx].isValid)
+					return false;
+
+				cornerBase[chunkIdx + 1] = cornerBase[chunkIdx] + chunks[chunkIdx].corners.size();
+				faceBase[chunkIdx + 1] = faceBase[chunkIdx] + chunks[chunkIdx].faceSizes.size();
+				triangleBase[chunkIdx + 1] = triangleBase[chunkIdx] + chunks[chunkIdx].numTriangles;
+			}
+
+			//Materials get global ids in order of first use, a chunk inherits the material the one before it ended with
+			std::vector<std::string> materialNames{};
+			std::unordered_map<std::string, uint32_t> materialIds{};
+			const auto getMaterialId = [&](const std::string& name)
+				{
+					const auto [it, isNew] = materialIds.try_emplace(name, static_cast<uint32_t>(materialNames.size()));
+					if (isNew)
+						materialNames.push_back(name);
+					return it->second;
+				};
+
+			std::vector<std::vector<uint32_t>> chunkMaterialIds(numChunks);
+			std::vector<uint32_t> inheritedMaterials(numChunks);
+			uint32_t currentMaterial{ Obj::InheritedMaterial };
+			for (size_t chunkIdx = 0; chunkIdx < numChunks; ++chunkIdx)
+			{
+				const Obj::Chunk& chunk = chunks[chunkIdx];
+				if (currentMaterial == Obj::InheritedMaterial && !chunk.faceMaterials.empty() && chunk.faceMaterials[0] == Obj::InheritedMaterial)
+					currentMaterial = getMaterialId("");
+
+				inheritedMaterials[chunkIdx] = currentMaterial;
+				for (const std::string& name : chunk.materialNames)
+					chunkMaterialIds[chunkIdx].push_back(getMaterialId(name));
+
+				if (chunk.lastMaterial != Obj::InheritedMaterial)
+					currentMaterial = chunkMaterialIds[chunkIdx][chunk.lastMaterial];
+			}
+
+			std::vector<Vector3> positions(positionBase[numChunks]);
+			std::vector<Vector3> normals(normalBase[numChunks]);
+			std::vector<Vector2> UVs(UVBase[numChunks]);
+
+			//Merge the chunks and check every face index against the merged arrays
+			std::vector<char> isChunkValid(numChunks, true);
+			ParallelFor(numChunks, numChunks, [&](size_t begin, size_t end)
+				{
+					for (size_t chunkIdx = begin; chunkIdx < end; ++chunkIdx)
+					{
+						const Obj::Chunk& chunk = chunks[chunkIdx];
+						std::copy(chunk.positions.begin(), chunk.positions.end(), positions.begin() + positionBase[chunkIdx]);
+						std::copy(chunk.normals.begin(), chunk.normals.end(), normals.begin() + normalBase[chunkIdx]);
+						std::copy(chunk.UVs.begin(), chunk.UVs.end(), UVs.begin() + UVBase[chunkIdx]);
+
+						for (const Obj::Corner& corner : chunk.corners)
+						{
+							if (corner.position > positions.size() || corner.uv > UVs.size() || corner.normal > normals.size())
+								isChunkValid[chunkIdx] = false;
+						}
+					}
+				});
+
+			if (std::find(isChunkValid.begin(), isChunkValid.end(), false) != isChunkValid.end())
+				return false;
+
+			//Triangulate every face in place of the merged triangle list
+			const size_t numTriangles{ triangleBase[numChunks] };
+			std::vector<Obj::Corner> triangleCorners(numTriangles * 3);
+			std::vector<uint32_t> triangleMaterials(numTriangles);
+			ParallelFor(numChunks, numChunks, [&](size_t begin, size_t end)
+				{
+					for (size_t chunkIdx = begin; chunkIdx < end; ++chunkIdx)
+					{
+						const Obj::Chunk& chunk = chunks[chunkIdx];
+						const Obj::Corner* pFace = chunk.corners.data();
+						size_t triangle{ triangleBase[chunkIdx] };
+						for (size_t faceIdx = 0; faceIdx < chunk.faceSizes.size(); ++faceIdx)
+						{
+							const uint32_t numCorners{ chunk.faceSizes[faceIdx] };
+							const uint32_t localMaterial{ chunk.faceMaterials[faceIdx] };
+							const uint32_t material{ localMaterial == Obj::InheritedMaterial ? inheritedMaterials[chunkIdx] : chunkMaterialIds[chunkIdx][localMaterial] };
+
+							Obj::TriangulateFace(pFace, numCorners, positions, &triangleCorners[triangle * 3]);
+							std::fill(triangleMaterials.begin() + triangle, triangleMaterials.begin() + triangle + numCorners - 2, material);
+							pFace += numCorners;
+							triangle += numCorners - 2;
+						}
+					}
+				});
 
-				const Vector3& p0 = vertices[index0].position;
-				const Vector3& p1 = vertices[index1].position;
-				const Vector3& p2 = vertices[index2].position;
-				const Vector2& uv0 = vertices[index0].uv;
-				const Vector2& uv1 = vertices[index1].uv;
-				const Vector2& uv2 = vertices[index2].uv;
+			chunks.clear();
 
-				const Vector3 edge0 = p1 - p0;
-				const Vector3 edge1 = p2 - p0;
-				const Vector2 diffX = Vector2(uv1.x - uv0.x, uv2.x - uv0.x);
-				const Vector2 diffY = Vector2(uv1.y - uv0.y, uv2.y - uv0.y);
-				float r = 1.f / Vector2::Cross(diffX, diffY);
+			//Group the triangles by material, a stable counting sort keeps the file order within each material
+			std::vector<uint32_t> materialStarts(materialNames.size() + 1, 0);
+			for (const uint32_t material : triangleMaterials)
+				++materialStarts[material + 1];
+			for (size_t material = 0; material < materialNames.size(); ++material)
+				materialStarts[material + 1] += materialStarts[material];
 
-				Vector3 tangent = (edge0 * diffY.y - edge1 * diffY.x) * r;
-				vertices[index0].tangent += tangent;
-				vertices[index1].tangent += tangent;
-				vertices[index2].tangent += tangent;
+			std::vector<Obj::Corner> corners{};
+			if (materialNames.size() > 1)
+			{
+				corners.resize(triangleCorners.size());
+				std::vector<uint32_t> fillCursor(materialStarts.begin(), materialStarts.end() - 1);
+				for (size_t triangle = 0; triangle < numTriangles; ++triangle)
+				{
+					const uint32_t sortedTriangle{ fillCursor[triangleMaterials[triangle]]++ };
+					std::copy_n(&triangleCorners[triangle * 3], 3, &corners[size_t(sortedTriangle) * 3]);
+				}
+
+				triangleCorners.clear();
+				triangleCorners.shrink_to_fit();
+				for (size_t material = 0; material < materialNames.size(); ++material)
+					std::fill(triangleMaterials.begin() + materialStarts[material], triangleMaterials.begin() + materialStarts[material + 1], uint32_t(material));
+			}
+			else
+			{
+				corners = std::move(triangleCorners);
 			}
 
-			//Create the Tangents (reject)
-			for (auto& v : vertices)
+			if (pMaterialRanges)
 			{
-				v.tangent = Vector3::Reject(v.tangent, v.normal).Normalized();
+				for (size_t material = 0; material < materialNames.size(); ++material)
+				{
+					//A usemtl without faces doesn't get a range
+					if (materialStarts[material + 1] > materialStarts[material])
+						pMaterialRanges->push_back(ObjMaterialRange{ materialNames[material], materialStarts[material] * 3, (materialStarts[material + 1] - materialStarts[material]) * 3 });
+				}
+			}
 
-				if (flipAxisAndWinding)
+			//Assign a vertex to every corner, keeping the corner each vertex was created from
+			std::vector<uint32_t> vertexCorners{};
+			indices.resize(corners.size());
+			if (weldVertices)
+			{
+				//Welded meshes usually end up with about as many vertices as the largest attribute array
+				const size_t expectedVertices{ std::max(positions.size(), std::max(UVs.size(), normals.size())) };
+				vertexCorners.reserve(expectedVertices);
+				Obj::CornerMap cornerMap{ expectedVertices };
+
+				for (size_t cornerIdx = 0; cornerIdx < corners.size(); ++cornerIdx)
+				{
+					const Obj::Corner& corner = corners[cornerIdx];
+					const uint32_t newIndex = uint32_t(vertexCorners.size());
+					indices[cornerIdx] = cornerMap.FindOrInsert(corner.position, corner.uv, corner.normal, triangleMaterials[cornerIdx / 3], newIndex);
+					if (indices[cornerIdx] == newIndex)
+						vertexCorners.push_back(uint32_t(cornerIdx));
+				}
+			}
+			else
+			{
+				vertexCorners.resize(corners.size());
+				for (size_t cornerIdx = 0; cornerIdx < corners.size(); ++cornerIdx)
 				{
-					v.position.z *= -1.f;
-					v.normal.z *= -1.f;
-					v.tangent.z *= -1.f;
+					indices[cornerIdx] = uint32_t(cornerIdx);
+					vertexCorners[cornerIdx] = uint32_t(cornerIdx);
 				}
+			}
 
+			if (flipAxisAndWinding)
+			{
+				for (size_t i = 0; i + 2 < indices.size(); i += 3)
+					std::swap(indices[i + 1], indices[i + 2]);
 			}
 
+			vertices.resize(vertexCorners.size());
+			ParallelFor(vertices.size(), numThreads, [&](size_t begin, size_t end)
+				{
+					for (size_t vertexIdx = begin; vertexIdx < end; ++vertexIdx)
+					{
+						const Obj::Corner& corner = corners[vertexCorners[vertexIdx]];
+						Vertex& vertex = vertices[vertexIdx];
+						vertex.position = positions[corner.position - 1];
+						if (corner.uv > 0) vertex.uv = UVs[corner.uv - 1];
+						if (corner.normal > 0) vertex.normal = normals[corner.normal - 1];
+					}
+				});
+
+			if (flipAxisAndWinding)
+			{
+				ParallelFor(vertices.size(), numThreads, [&](size_t begin, size_t end)
+					{
+						for (size_t vertexIdx = begin; vertexIdx < end; ++vertexIdx)
+						{
+							vertices[vertexIdx].position.z *= -1.f;
+							vertices[vertexIdx].normal.z *= -1.f;
+						}
+					});
+			}
+
+			//Files without vn records, such as raw scans, get smooth normals
+			if (normals.empty())
+				SmoothNormals::Generate(vertices, indices, SmoothNormals::DefaultCreaseAngle, numThreads);
+
+			//Tangents in the final space, so their handedness matches the winding the mesh is drawn with
+			TangentSpace::Generate(vertices, indices, numThreads);
+
 			return true;
 		}
 #pragma warning(pop)
 	}
-}
\ No newline at end of file
+}
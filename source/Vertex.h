@@ -0,0 +1,11 @@
+#pragma once
+#include "Math.h"
+
+struct Vertex
+{
+	dae::Vector3 position;
+	dae::ColorRGB color;
+	dae::Vector2 uv;
+	dae::Vector3 normal;
+	dae::Vector4 tangent; //xyz direction, w handedness: bitangent = w * cross(normal, tangent)
+};
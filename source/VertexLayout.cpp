@@ -0,0 +1,499 @@
+#include "pch.h"
+#include "VertexLayout.h"
+
+#include <cstring>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__SSE2__)
+#include <emmintrin.h>
+#define DAE_VERTEX_SSE2
+#endif
+
+namespace dae
+{
+	namespace VertexCodec
+	{
+		namespace
+		{
+			constexpr float Snorm16Scale{ 32767.f };
+			constexpr float Unorm16Scale{ 65535.f };
+
+			//Round to nearest even, matching the SIMD conversions
+			int32_t RoundToInt(float value)
+			{
+				return static_cast<int32_t>(std::nearbyint(value));
+			}
+
+			uint32_t FloatBits(float value)
+			{
+				uint32_t bits;
+				std::memcpy(&bits, &value, sizeof(bits));
+				return bits;
+			}
+
+			float BitsToFloat(uint32_t bits)
+			{
+				float value;
+				std::memcpy(&value, &bits, sizeof(value));
+				return value;
+			}
+
+			//Round to nearest even, overflow goes to infinity, NaN stays NaN (F. Giesen)
+			uint16_t ToHalf(float value)
+			{
+				constexpr uint32_t f32Infinity{ 255u << 23 };
+				constexpr uint32_t f16Max{ (127u + 16u) << 23 };
+				constexpr uint32_t denormMagic{ ((127u - 15u) + (23u - 10u) + 1u) << 23 };
+				constexpr uint32_t normalLimit{ 113u << 23 };
+				constexpr uint32_t roundBias{ 0xC8000FFFu }; //((15 - 127) << 23) + 0xFFF
+
+				uint32_t bits{ FloatBits(value) };
+				const uint32_t sign{ bits & 0x80000000u };
+				bits ^= sign;
+
+				uint32_t half;
+				if (bits >= f16Max)
+					half = bits > f32Infinity ? 0x7E00u : 0x7C00u;
+				else if (bits < normalLimit)
+					half = FloatBits(BitsToFloat(bits) + BitsToFloat(denormMagic)) - denormMagic;
+				else
+					half = (bits + roundBias + ((bits >> 13) & 1u)) >> 13;
+
+				return static_cast<uint16_t>(half | (sign >> 16));
+			}
+
+			float FromHalf(uint16_t half)
+			{
+				constexpr uint32_t magic{ (254u - 15u) << 23 };
+				constexpr uint32_t wasInfNaN{ (127u + 16u) << 23 };
+
+				float value{ BitsToFloat((half & 0x7FFFu) << 13) * BitsToFloat(magic) };
+				if (value >= BitsToFloat(wasInfNaN))
+					value = BitsToFloat(FloatBits(value) | (255u << 23));
+
+				return BitsToFloat(FloatBits(value) | ((half & 0x8000u) << 16));
+			}
+
+			//Moves the component one step towards zero when its lowest bit doesn't match, which never reaches -32768
+			void SetHandedness(int16_t& component, float handedness)
+			{
+				const int16_t bit{ handedness < 0.f ? int16_t{ 1 } : int16_t{ 0 } };
+				if ((component & 1) != bit)
+					component = static_cast<int16_t>(component > 0 ? component - 1 : component + 1);
+			}
+
+			void ToOctahedral(const Vector3& normal, int16_t* pDestination)
+			{
+				const float absSum{ fabsf(normal.x) + fabsf(normal.y) + fabsf(normal.z) };
+				const float invSum{ absSum > 0.f ? 1.f / absSum : 0.f };
+				float u{ normal.x * invSum };
+				float v{ normal.y * invSum };
+
+				//Fold the lower hemisphere over the diagonals
+				if (normal.z < 0.f)
+				{
+					const float foldedU{ (1.f - fabsf(v)) * (u >= 0.f ? 1.f : -1.f) };
+					const float foldedV{ (1.f - fabsf(u)) * (v >= 0.f ? 1.f : -1.f) };
+					u = foldedU;
+					v = foldedV;
+				}
+
+				pDestination[0] = static_cast<int16_t>(RoundToInt(Clamp(u, -1.f, 1.f) * Snorm16Scale));
+				pDestination[1] = static_cast<int16_t>(RoundToInt(Clamp(v, -1.f, 1.f) * Snorm16Scale));
+			}
+
+			Vector3 FromOctahedral(const int16_t* pSource)
+			{
+				Vector3 normal{ std::max(pSource[0] / Snorm16Scale, -1.f), std::max(pSource[1] / Snorm16Scale, -1.f), 0.f };
+				normal.z = 1.f - fabsf(normal.x) - fabsf(normal.y);
+
+				const float fold{ Saturate(-normal.z) };
+				normal.x += normal.x >= 0.f ? -fold : fold;
+				normal.y += normal.y >= 0.f ? -fold : fold;
+
+				return normal.Normalized();
+			}
+
+#ifdef DAE_VERTEX_SSE2
+			__m128i FloatToHalf4(__m128 value)
+			{
+				const __m128i signMask = _mm_set1_epi32(static_cast<int>(0x80000000u));
+				const __m128i f32Infinity = _mm_set1_epi32(255 << 23);
+				const __m128i f16MaxMinusOne = _mm_set1_epi32(((127 + 16) << 23) - 1);
+				const __m128i denormMagic = _mm_set1_epi32(((127 - 15) + (23 - 10) + 1) << 23);
+				const __m128i normalLimit = _mm_set1_epi32(113 << 23);
+				const __m128i roundBias = _mm_set1_epi32(static_cast<int>(0xC8000FFFu));
+				const __m128i one = _mm_set1_epi32(1);
+
+				__m128i bits = _mm_castps_si128(value);
+				const __m128i sign = _mm_and_si128(bits, signMask);
+				bits = _mm_xor_si128(bits, sign);
+
+				//bits has no sign bit left, so signed compares are fine
+				const __m128i isOverflow = _mm_cmpgt_epi32(bits, f16MaxMinusOne);
+				const __m128i isNaN = _mm_cmpgt_epi32(bits, f32Infinity);
+				const __m128i isSubnormal = _mm_cmpgt_epi32(normalLimit, bits);
+
+				const __m128i overflow = _mm_or_si128(_mm_set1_epi32(0x7C00), _mm_and_si128(isNaN, _mm_set1_epi32(0x0200)));
+				const __m128i subnormal = _mm_sub_epi32(_mm_castps_si128(_mm_add_ps(_mm_castsi128_ps(bits), _mm_castsi128_ps(denormMagic))), denormMagic);
+				const __m128i mantissaOdd = _mm_and_si128(_mm_srli_epi32(bits, 13), one);
+				const __m128i normal = _mm_srli_epi32(_mm_add_epi32(_mm_add_epi32(bits, roundBias), mantissaOdd), 13);
+
+				__m128i half = _mm_or_si128(_mm_and_si128(isSubnormal, subnormal), _mm_andnot_si128(isSubnormal, normal));
+				half = _mm_or_si128(_mm_and_si128(isOverflow, overflow), _mm_andnot_si128(isOverflow, half));
+				return _mm_or_si128(half, _mm_srli_epi32(sign, 16));
+			}
+
+			__m128 HalfToFloat4(__m128i half)
+			{
+				const __m128 magic = _mm_castsi128_ps(_mm_set1_epi32((254 - 15) << 23));
+				const __m128 wasInfNaN = _mm_castsi128_ps(_mm_set1_epi32((127 + 16) << 23));
+
+				__m128 value = _mm_mul_ps(_mm_castsi128_ps(_mm_slli_epi32(_mm_and_si128(half, _mm_set1_epi32(0x7FFF)), 13)), magic);
+				const __m128 isInfNaN = _mm_cmpge_ps(value, wasInfNaN);
+				value = _mm_or_ps(value, _mm_and_ps(isInfNaN, _mm_castsi128_ps(_mm_set1_epi32(255 << 23))));
+				return _mm_or_ps(value, _mm_castsi128_ps(_mm_slli_epi32(_mm_and_si128(half, _mm_set1_epi32(0x8000)), 16)));
+			}
+
+			__m128 Abs4(__m128 value)
+			{
+				return _mm_andnot_ps(_mm_set1_ps(-0.f), value);
+			}
+
+			//+1 or -1 with the sign of value, +0 counts as positive
+			__m128 SignNotZero4(__m128 value)
+			{
+				const __m128 isNegative = _mm_cmplt_ps(value, _mm_setzero_ps());
+				return _mm_or_ps(_mm_and_ps(isNegative, _mm_set1_ps(-1.f)), _mm_andnot_ps(isNegative, _mm_set1_ps(1.f)));
+			}
+#endif
+		}
+
+		std::vector<VertexAttribute> GetAttributes(VertexLayout layout)
+		{
+			switch (layout)
+			{
+			case VertexLayout::Compact:
+				return {
+					{ "POSITION", AttributeFormat::Float32x3, offsetof(CompactVertex, position) },
+					{ "TEXCOORD", AttributeFormat::Float16x2, offsetof(CompactVertex, uv) },
+					{ "NORMAL", AttributeFormat::Snorm16x2, offsetof(CompactVertex, normal) },
+					{ "TANGENT", AttributeFormat::Snorm16x2, offsetof(CompactVertex, tangent) } };
+			case VertexLayout::CompactQuantized:
+				return {
+					{ "POSITION", AttributeFormat::Unorm16x4, offsetof(QuantizedVertex, position) },
+					{ "TEXCOORD", AttributeFormat::Float16x2, offsetof(QuantizedVertex, uv) },
+					{ "NORMAL", AttributeFormat::Snorm16x2, offsetof(QuantizedVertex, normal) },
+					{ "TANGENT", AttributeFormat::Snorm16x2, offsetof(QuantizedVertex, tangent) } };
+			case VertexLayout::Full:
+			default:
+				return {
+					{ "POSITION", AttributeFormat::Float32x3, offsetof(Vertex, position) },
+					{ "COLOR", AttributeFormat::Float32x3, offsetof(Vertex, color) },
+					{ "TEXCOORD", AttributeFormat::Float32x2, offsetof(Vertex, uv) },
+					{ "NORMAL", AttributeFormat::Float32x3, offsetof(Vertex, normal) },
+					{ "TANGENT", AttributeFormat::Float32x4, offsetof(Vertex, tangent) } };
+			}
+		}
+
+		uint32_t GetStride(VertexLayout layout)
+		{
+			switch (layout)
+			{
+			case VertexLayout::Compact: return sizeof(CompactVertex);
+			case VertexLayout::CompactQuantized: return sizeof(QuantizedVertex);
+			case VertexLayout::Full:
+			default: return sizeof(Vertex);
+			}
+		}
+
+		EncodedVertices Encode(const std::vector<Vertex>& vertices, VertexLayout layout)
+		{
+			EncodedVertices encoded{};
+			encoded.layout = layout;
+			encoded.stride = GetStride(layout);
+			encoded.count = static_cast<uint32_t>(vertices.size());
+			encoded.data.resize(size_t(encoded.stride) * encoded.count);
+
+			if (!vertices.empty())
+			{
+				encoded.boundsMin = vertices[0].position;
+				encoded.boundsMax = vertices[0].position;
+				for (const Vertex& vertex : vertices)
+				{
+					for (int axis = 0; axis < 3; ++axis)
+					{
+						encoded.boundsMin[axis] = std::min(encoded.boundsMin[axis], vertex.position[axis]);
+						encoded.boundsMax[axis] = std::max(encoded.boundsMax[axis], vertex.position[axis]);
+					}
+				}
+			}
+
+			if (layout == VertexLayout::Full)
+			{
+				if (!vertices.empty())
+					std::memcpy(encoded.data.data(), vertices.data(), encoded.data.size());
+				return encoded;
+			}
+
+			//Run every attribute through its kernel as one stream, then interleave
+			const size_t count{ vertices.size() };
+			std::vector<float> uvs(count * 2);
+			std::vector<Vector3> normals(count);
+			std::vector<Vector3> tangents(count);
+			for (size_t i = 0; i < count; ++i)
+			{
+				uvs[i * 2] = vertices[i].uv.x;
+				uvs[i * 2 + 1] = vertices[i].uv.y;
+				normals[i] = vertices[i].normal;
+				tangents[i] = vertices[i].tangent.GetXYZ();
+			}
+
+			std::vector<uint16_t> halfUVs(count * 2);
+			std::vector<int16_t> octNormals(count * 2);
+			std::vector<int16_t> octTangents(count * 2);
+			FloatToHalf(uvs.data(), halfUVs.data(), count * 2);
+			EncodeOctahedral(normals.data(), octNormals.data(), count);
+			EncodeOctahedral(tangents.data(), octTangents.data(), count);
+			for (size_t i = 0; i < count; ++i)
+				SetHandedness(octTangents[i * 2 + 1], vertices[i].tangent.w);
+
+			if (layout == VertexLayout::Compact)
+			{
+				CompactVertex* pVertices = reinterpret_cast<CompactVertex*>(encoded.data.data());
+				for (size_t i = 0; i < count; ++i)
+				{
+					pVertices[i].position[0] = vertices[i].position.x;
+					pVertices[i].position[1] = vertices[i].position.y;
+					pVertices[i].position[2] = vertices[i].position.z;
+					std::memcpy(pVertices[i].uv, &halfUVs[i * 2], sizeof(pVertices[i].uv));
+					std::memcpy(pVertices[i].normal, &octNormals[i * 2], sizeof(pVertices[i].normal));
+					std::memcpy(pVertices[i].tangent, &octTangents[i * 2], sizeof(pVertices[i].tangent));
+				}
+				return encoded;
+			}
+
+			//Quantize positions to the bounds, flat axes map everything to 0
+			const Vector3 extent{ encoded.boundsMax - encoded.boundsMin };
+			const Vector3 toUnorm{ extent.x > 0.f ? Unorm16Scale / extent.x : 0.f,
+				extent.y > 0.f ? Unorm16Scale / extent.y : 0.f,
+				extent.z > 0.f ? Unorm16Scale / extent.z : 0.f };
+
+			QuantizedVertex* pVertices = reinterpret_cast<QuantizedVertex*>(encoded.data.data());
+			size_t i{};
+#ifdef DAE_VERTEX_SSE2
+			const __m128 boundsMin = _mm_setr_ps(encoded.boundsMin.x, encoded.boundsMin.y, encoded.boundsMin.z, 0.f);
+			const __m128 scale = _mm_setr_ps(toUnorm.x, toUnorm.y, toUnorm.z, 0.f);
+			const __m128 maxValue = _mm_set1_ps(Unorm16Scale);
+			for (; i + 2 <= count; i += 2)
+			{
+				//Two xyz0 positions per iteration, packed straight into the 4 x uint16 position slots
+				const Vector3& p0 = vertices[i].position;
+				const Vector3& p1 = vertices[i + 1].position;
+				const __m128 q0 = _mm_min_ps(_mm_max_ps(_mm_mul_ps(_mm_sub_ps(_mm_setr_ps(p0.x, p0.y, p0.z, 0.f), boundsMin), scale), _mm_setzero_ps()), maxValue);
+				const __m128 q1 = _mm_min_ps(_mm_max_ps(_mm_mul_ps(_mm_sub_ps(_mm_setr_ps(p1.x, p1.y, p1.z, 0.f), boundsMin), scale), _mm_setzero_ps()), maxValue);
+
+				//Bias into int16 range so the signed pack doesn't saturate
+				const __m128i bias = _mm_set1_epi32(32768);
+				const __m128i packed = _mm_xor_si128(_mm_packs_epi32(_mm_sub_epi32(_mm_cvtps_epi32(q0), bias), _mm_sub_epi32(_mm_cvtps_epi32(q1), bias)), _mm_set1_epi16(static_cast<short>(0x8000)));
+
+				alignas(16) uint16_t positions[8];
+				_mm_store_si128(reinterpret_cast<__m128i*>(positions), packed);
+				std::memcpy(pVertices[i].position, positions, sizeof(uint16_t) * 4);
+				std::memcpy(pVertices[i + 1].position, positions + 4, sizeof(uint16_t) * 4);
+				pVertices[i].position[3] = 0;
+				pVertices[i + 1].position[3] = 0;
+			}
+#endif
+			for (; i < count; ++i)
+			{
+				for (int axis = 0; axis < 3; ++axis)
+				{
+					const float quantized{ Clamp((vertices[i].position[axis] - encoded.boundsMin[axis]) * toUnorm[axis], 0.f, Unorm16Scale) };
+					pVertices[i].position[axis] = static_cast<uint16_t>(RoundToInt(quantized));
+				}
+				pVertices[i].position[3] = 0;
+			}
+
+			for (i = 0; i < count; ++i)
+			{
+				std::memcpy(pVertices[i].uv, &halfUVs[i * 2], sizeof(pVertices[i].uv));
+				std::memcpy(pVertices[i].normal, &octNormals[i * 2], sizeof(pVertices[i].normal));
+				std::memcpy(pVertices[i].tangent, &octTangents[i * 2], sizeof(pVertices[i].tangent));
+			}
+
+			return encoded;
+		}
+
+		std::vector<Vertex> Decode(const EncodedVertices& encoded)
+		{
+			return Decode(encoded.layout, encoded.data.data(), encoded.count, encoded.boundsMin, encoded.boundsMax);
+		}
+
+		std::vector<Vertex> Decode(VertexLayout layout, const void* pData, uint32_t count, const Vector3& boundsMin, const Vector3& boundsMax)
+		{
+			std::vector<Vertex> vertices(count);
+			if (count == 0)
+				return vertices;
+
+			if (layout == VertexLayout::Full)
+			{
+				std::memcpy(vertices.data(), pData, sizeof(Vertex) * count);
+				return vertices;
+			}
+
+			const uint8_t* pBytes = static_cast<const uint8_t*>(pData);
+			const uint32_t stride{ GetStride(layout) };
+			const size_t uvOffset{ layout == VertexLayout::Compact ? offsetof(CompactVertex, uv) : offsetof(QuantizedVertex, uv) };
+			const size_t normalOffset{ layout == VertexLayout::Compact ? offsetof(CompactVertex, normal) : offsetof(QuantizedVertex, normal) };
+			const size_t tangentOffset{ layout == VertexLayout::Compact ? offsetof(CompactVertex, tangent) : offsetof(QuantizedVertex, tangent) };
+
+			std::vector<uint16_t> halfUVs(size_t(count) * 2);
+			std::vector<int16_t> octNormals(size_t(count) * 2);
+			std::vector<int16_t> octTangents(size_t(count) * 2);
+			for (size_t i = 0; i < count; ++i)
+			{
+				const uint8_t* pVertex = pBytes + i * stride;
+				std::memcpy(&halfUVs[i * 2], pVertex + uvOffset, sizeof(uint16_t) * 2);
+				std::memcpy(&octNormals[i * 2], pVertex + normalOffset, sizeof(int16_t) * 2);
+				std::memcpy(&octTangents[i * 2], pVertex + tangentOffset, sizeof(int16_t) * 2);
+			}
+
+			std::vector<float> uvs(size_t(count) * 2);
+			std::vector<Vector3> normals(count);
+			std::vector<Vector3> tangents(count);
+			HalfToFloat(halfUVs.data(), uvs.data(), size_t(count) * 2);
+			DecodeOctahedral(octNormals.data(), normals.data(), count);
+			DecodeOctahedral(octTangents.data(), tangents.data(), count);
+
+			const Vector3 extent{ boundsMax - boundsMin };
+			for (size_t i = 0; i < count; ++i)
+			{
+				Vertex& vertex = vertices[i];
+				const uint8_t* pVertex = pBytes + i * stride;
+				if (layout == VertexLayout::Compact)
+				{
+					std::memcpy(&vertex.position, pVertex + offsetof(CompactVertex, position), sizeof(float) * 3);
+				}
+				else
+				{
+					uint16_t position[3];
+					std::memcpy(position, pVertex + offsetof(QuantizedVertex, position), sizeof(position));
+					for (int axis = 0; axis < 3; ++axis)
+						vertex.position[axis] = boundsMin[axis] + position[axis] / Unorm16Scale * extent[axis];
+				}
+
+				vertex.uv = { uvs[i * 2], uvs[i * 2 + 1] };
+				vertex.normal = normals[i];
+				vertex.tangent = Vector4{ tangents[i], octTangents[i * 2 + 1] & 1 ? -1.f : 1.f };
+			}
+
+			return vertices;
+		}
+
+		void FloatToHalf(const float* pSource, uint16_t* pDestination, size_t count)
+		{
+			size_t i{};
+#ifdef DAE_VERTEX_SSE2
+			for (; i + 4 <= count; i += 4)
+			{
+				//Sign extend the 16 bit results so the signed pack keeps them intact
+				const __m128i half = FloatToHalf4(_mm_loadu_ps(pSource + i));
+				const __m128i signExtended = _mm_srai_epi32(_mm_slli_epi32(half, 16), 16);
+				_mm_storel_epi64(reinterpret_cast<__m128i*>(pDestination + i), _mm_packs_epi32(signExtended, signExtended));
+			}
+#endif
+			for (; i < count; ++i)
+				pDestination[i] = ToHalf(pSource[i]);
+		}
+
+		void HalfToFloat(const uint16_t* pSource, float* pDestination, size_t count)
+		{
+			size_t i{};
+#ifdef DAE_VERTEX_SSE2
+			for (; i + 4 <= count; i += 4)
+			{
+				const __m128i half = _mm_unpacklo_epi16(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(pSource + i)), _mm_setzero_si128());
+				_mm_storeu_ps(pDestination + i, HalfToFloat4(half));
+			}
+#endif
+			for (; i < count; ++i)
+				pDestination[i] = FromHalf(pSource[i]);
+		}
+
+		void EncodeOctahedral(const Vector3* pSource, int16_t* pDestination, size_t count)
+		{
+			size_t i{};
+#ifdef DAE_VERTEX_SSE2
+			const __m128 zero = _mm_setzero_ps();
+			const __m128 one = _mm_set1_ps(1.f);
+			const __m128 scale = _mm_set1_ps(Snorm16Scale);
+			for (; i + 4 <= count; i += 4)
+			{
+				const Vector3* p = pSource + i;
+				const __m128 x = _mm_setr_ps(p[0].x, p[1].x, p[2].x, p[3].x);
+				const __m128 y = _mm_setr_ps(p[0].y, p[1].y, p[2].y, p[3].y);
+				const __m128 z = _mm_setr_ps(p[0].z, p[1].z, p[2].z, p[3].z);
+
+				const __m128 absSum = _mm_add_ps(_mm_add_ps(Abs4(x), Abs4(y)), Abs4(z));
+				const __m128 hasLength = _mm_cmpgt_ps(absSum, zero);
+				const __m128 invSum = _mm_and_ps(hasLength, _mm_div_ps(one, _mm_or_ps(absSum, _mm_andnot_ps(hasLength, one))));
+				__m128 u = _mm_mul_ps(x, invSum);
+				__m128 v = _mm_mul_ps(y, invSum);
+
+				const __m128 isLower = _mm_cmplt_ps(z, zero);
+				const __m128 foldedU = _mm_mul_ps(_mm_sub_ps(one, Abs4(v)), SignNotZero4(u));
+				const __m128 foldedV = _mm_mul_ps(_mm_sub_ps(one, Abs4(u)), SignNotZero4(v));
+				u = _mm_or_ps(_mm_and_ps(isLower, foldedU), _mm_andnot_ps(isLower, u));
+				v = _mm_or_ps(_mm_and_ps(isLower, foldedV), _mm_andnot_ps(isLower, v));
+
+				const __m128i snormU = _mm_cvtps_epi32(_mm_mul_ps(_mm_min_ps(_mm_max_ps(u, _mm_set1_ps(-1.f)), one), scale));
+				const __m128i snormV = _mm_cvtps_epi32(_mm_mul_ps(_mm_min_ps(_mm_max_ps(v, _mm_set1_ps(-1.f)), one), scale));
+
+				//u0 v0 u1 v1 | u2 v2 u3 v3
+				const __m128i packed = _mm_packs_epi32(_mm_unpacklo_epi32(snormU, snormV), _mm_unpackhi_epi32(snormU, snormV));
+				_mm_storeu_si128(reinterpret_cast<__m128i*>(pDestination + i * 2), packed);
+			}
+#endif
+			for (; i < count; ++i)
+				ToOctahedral(pSource[i], pDestination + i * 2);
+		}
+
+		void DecodeOctahedral(const int16_t* pSource, Vector3* pDestination, size_t count)
+		{
+			size_t i{};
+#ifdef DAE_VERTEX_SSE2
+			const __m128 zero = _mm_setzero_ps();
+			const __m128 one = _mm_set1_ps(1.f);
+			const __m128 minusOne = _mm_set1_ps(-1.f);
+			const __m128 scale = _mm_set1_ps(Snorm16Scale);
+			for (; i + 4 <= count; i += 4)
+			{
+				const __m128i packed = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pSource + i * 2));
+				const __m128 low = _mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpacklo_epi16(packed, packed), 16));
+				const __m128 high = _mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpackhi_epi16(packed, packed), 16));
+
+				__m128 x = _mm_max_ps(_mm_div_ps(_mm_shuffle_ps(low, high, _MM_SHUFFLE(2, 0, 2, 0)), scale), minusOne);
+				__m128 y = _mm_max_ps(_mm_div_ps(_mm_shuffle_ps(low, high, _MM_SHUFFLE(3, 1, 3, 1)), scale), minusOne);
+				const __m128 z = _mm_sub_ps(_mm_sub_ps(one, Abs4(x)), Abs4(y));
+
+				const __m128 fold = _mm_min_ps(_mm_max_ps(_mm_sub_ps(zero, z), zero), one);
+				const __m128 isPositiveX = _mm_cmpge_ps(x, zero);
+				const __m128 isPositiveY = _mm_cmpge_ps(y, zero);
+				x = _mm_add_ps(x, _mm_or_ps(_mm_and_ps(isPositiveX, _mm_sub_ps(zero, fold)), _mm_andnot_ps(isPositiveX, fold)));
+				y = _mm_add_ps(y, _mm_or_ps(_mm_and_ps(isPositiveY, _mm_sub_ps(zero, fold)), _mm_andnot_ps(isPositiveY, fold)));
+
+				const __m128 length = _mm_sqrt_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(x, x), _mm_mul_ps(y, y)), _mm_mul_ps(z, z)));
+				alignas(16) float xs[4], ys[4], zs[4];
+				_mm_store_ps(xs, _mm_div_ps(x, length));
+				_mm_store_ps(ys, _mm_div_ps(y, length));
+				_mm_store_ps(zs, _mm_div_ps(z, length));
+
+				for (size_t lane = 0; lane < 4; ++lane)
+					pDestination[i + lane] = { xs[lane], ys[lane], zs[lane] };
+			}
+#endif
+			for (; i < count; ++i)
+				pDestination[i] = FromOctahedral(pSource + i * 2);
+		}
+	}
+}
@@ -0,0 +1,79 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+#include "Vertex.h"
+
+namespace dae
+{
+	enum class VertexLayout : uint32_t
+	{
+		Full,				//Vertex as is: 60 bytes
+		Compact,			//float3 position, half2 uv, octahedral snorm16 normal and tangent, no color: 24 bytes.
+							//The tangent's handedness is the lowest bit of its second component, set for -1.
+		CompactQuantized	//Compact with unorm16 positions relative to the mesh bounds: 20 bytes
+	};
+
+	enum class AttributeFormat
+	{
+		Float32x2,
+		Float32x3,
+		Float32x4,
+		Float16x2,
+		Unorm16x4,
+		Snorm16x2
+	};
+
+	struct VertexAttribute
+	{
+		const char* semantic;
+		AttributeFormat format;
+		uint32_t offset;
+	};
+
+	struct CompactVertex
+	{
+		float position[3];
+		uint16_t uv[2];
+		int16_t normal[2];
+		int16_t tangent[2];
+	};
+
+	struct QuantizedVertex
+	{
+		uint16_t position[4];
+		uint16_t uv[2];
+		int16_t normal[2];
+		int16_t tangent[2];
+	};
+
+	//Vertex data in one of the layouts, ready to be uploaded
+	struct EncodedVertices
+	{
+		VertexLayout layout{ VertexLayout::Full };
+		uint32_t stride{};
+		uint32_t count{};
+		std::vector<uint8_t> data{};
+
+		//Positions of a quantized layout are stored relative to these
+		Vector3 boundsMin{};
+		Vector3 boundsMax{};
+	};
+
+	namespace VertexCodec
+	{
+		std::vector<VertexAttribute> GetAttributes(VertexLayout layout);
+		uint32_t GetStride(VertexLayout layout);
+
+		EncodedVertices Encode(const std::vector<Vertex>& vertices, VertexLayout layout);
+		//Decoded vertices have no color in the compact layouts
+		std::vector<Vertex> Decode(const EncodedVertices& encoded);
+		std::vector<Vertex> Decode(VertexLayout layout, const void* pData, uint32_t count, const Vector3& boundsMin, const Vector3& boundsMax);
+
+		//Kernels, four values per SIMD iteration
+		void FloatToHalf(const float* pSource, uint16_t* pDestination, size_t count);
+		void HalfToFloat(const uint16_t* pSource, float* pDestination, size_t count);
+		//Unit vectors to/from octahedral coordinates stored as snorm16 pairs
+		void EncodeOctahedral(const Vector3* pSource, int16_t* pDestination, size_t count);
+		void DecodeOctahedral(const int16_t* pSource, Vector3* pDestination, size_t count);
+	}
+}
@@ -0,0 +1,151 @@
+#include "pch.h"
+#include "VertexLightBaker.h"
+
+#include <cmath>
+#include "HalfEdgeMesh.h"
+#include "ParallelFor.h"
+#include "TriangleBvh.h"
+
+namespace dae
+{
+	namespace VertexLightBaker
+	{
+		namespace
+		{
+			//Vertices per job at a time, small enough to even out cheap open and expensive enclosed parts of the mesh
+			constexpr size_t ChunkSize{ 64 };
+			//Ray origins leave the surface by this fraction of the bounds diagonal, so they don't hit their own triangles
+			constexpr float SurfaceOffset{ 1e-4f };
+
+			uint32_t Hash(uint32_t value)
+			{
+				value ^= value >> 16;
+				value *= 0x7FEB352Du;
+				value ^= value >> 15;
+				value *= 0x846CA68Bu;
+				return value ^ (value >> 16);
+			}
+
+			float ToUnitFloat(uint32_t bits)
+			{
+				return static_cast<float>(bits >> 8) * (1.f / 16777216.f);
+			}
+
+			//Van der Corput sequence, the second coordinate of the Hammersley set
+			float RadicalInverse(uint32_t bits)
+			{
+				bits = (bits << 16) | (bits >> 16);
+				bits = ((bits & 0x55555555u) << 1) | ((bits & 0xAAAAAAAAu) >> 1);
+				bits = ((bits & 0x33333333u) << 2) | ((bits & 0xCCCCCCCCu) >> 2);
+				bits = ((bits & 0x0F0F0F0Fu) << 4) | ((bits & 0xF0F0F0F0u) >> 4);
+				bits = ((bits & 0x00FF00FFu) << 8) | ((bits & 0xFF00FF00u) >> 8);
+				return ToUnitFloat(bits);
+			}
+
+			float Wrap(float value)
+			{
+				return value >= 1.f ? value - 1.f : value;
+			}
+
+			//Orthonormal basis around a unit normal without a branch on its direction (Duff et al. 2017)
+			void BuildBasis(const Vector3& normal, Vector3& tangent, Vector3& bitangent)
+			{
+				const float sign{ std::copysign(1.f, normal.z) };
+				const float a{ -1.f / (sign + normal.z) };
+				const float b{ normal.x * normal.y * a };
+				tangent = Vector3{ 1.f + sign * normal.x * normal.x * a, sign * b, -sign * normal.x };
+				bitangent = Vector3{ b, sign + normal.y * normal.y * a, -normal.y };
+			}
+		}
+
+		void Bake(std::vector<Vertex>& vertices, const std::vector<uint32_t>& indices, const Vector3* pLightDirection,
+			uint32_t numSamples, uint32_t seed, size_t numThreads)
+		{
+			if (vertices.empty())
+				return;
+
+			Vector3 boundsMin{ vertices[0].position };
+			Vector3 boundsMax{ vertices[0].position };
+			for (const Vertex& vertex : vertices)
+			{
+				for (int axis = 0; axis < 3; ++axis)
+				{
+					boundsMin[axis] = std::min(boundsMin[axis], vertex.position[axis]);
+					boundsMax[axis] = std::max(boundsMax[axis], vertex.position[axis]);
+				}
+			}
+
+			const float diagonal{ (boundsMax - boundsMin).Magnitude() };
+			const float occlusionDistance{ diagonal * OcclusionRange };
+			const float surfaceOffset{ diagonal * SurfaceOffset };
+			const Vector3 toLight{ pLightDirection ? -pLightDirection->Normalized() : Vector3::Zero };
+
+			//Samples are seeded per position rather than per vertex, so split vertices along seams agree
+			std::vector<uint32_t> positionIds{};
+			HalfEdgeMesh::WeldPositions(vertices, positionIds, numThreads);
+			const TriangleBvh bvh{ vertices, indices, numThreads };
+
+			const size_t numChunks{ (vertices.size() + ChunkSize - 1) / ChunkSize };
+			const size_t numJobs{ std::max(std::min(numThreads, numChunks), size_t{ 1 }) };
+			Utils::ParallelFor(numJobs, numJobs, [&](size_t beginJob, size_t endJob)
+				{
+					for (size_t job = beginJob; job < endJob; ++job)
+					{
+						for (size_t chunk = job; chunk < numChunks; chunk += numJobs)
+						{
+							const size_t end{ std::min((chunk + 1) * ChunkSize, vertices.size()) };
+							for (size_t vertexIdx = chunk * ChunkSize; vertexIdx < end; ++vertexIdx)
+							{
+								Vertex& vertex = vertices[vertexIdx];
+								const float normalLength{ vertex.normal.Magnitude() };
+								if (normalLength <= 0.f)
+								{
+									vertex.color = ColorRGB{ 1.f, pLightDirection ? 0.f : 1.f, 0.f };
+									continue;
+								}
+
+								const Vector3 normal{ vertex.normal.x / normalLength, vertex.normal.y / normalLength, vertex.normal.z / normalLength };
+								const Vector3 origin{ vertex.position.x + normal.x * surfaceOffset, vertex.position.y + normal.y * surfaceOffset,
+									vertex.position.z + normal.z * surfaceOffset };
+								Vector3 tangent{};
+								Vector3 bitangent{};
+								BuildBasis(normal, tangent, bitangent);
+
+								//Hammersley points shifted by a random offset per position: evenly spread, but without a pattern shared by neighbours
+								const uint32_t positionHash{ Hash(seed ^ Hash(positionIds[vertexIdx])) };
+								const float shiftU{ ToUnitFloat(positionHash) };
+								const float shiftV{ ToUnitFloat(Hash(positionHash)) };
+								uint32_t numUnoccluded{};
+								for (uint32_t sample = 0; sample < numSamples; ++sample)
+								{
+									//Cosine weighted: uniform on the disk, projected up onto the hemisphere
+									const float u{ Wrap((sample + .5f) / numSamples + shiftU) };
+									const float v{ Wrap(RadicalInverse(sample) + shiftV) };
+									const float radius{ std::sqrt(u) };
+									const float angle{ 6.28318530718f * v };
+									const float x{ radius * std::cos(angle) };
+									const float y{ radius * std::sin(angle) };
+									const float z{ std::sqrt(std::max(1.f - u, 0.f)) };
+									const Vector3 direction{ tangent.x * x + bitangent.x * y + normal.x * z, tangent.y * x + bitangent.y * y + normal.y * z,
+										tangent.z * x + bitangent.z * y + normal.z * z };
+
+									if (!bvh.IsOccluded(origin, direction, occlusionDistance))
+										++numUnoccluded;
+								}
+
+								float lambert{ 1.f };
+								if (pLightDirection)
+								{
+									lambert = std::max(normal.x * toLight.x + normal.y * toLight.y + normal.z * toLight.z, 0.f);
+									if (lambert > 0.f && bvh.IsOccluded(origin, toLight, diagonal))
+										lambert = 0.f;
+								}
+
+								vertex.color = ColorRGB{ numSamples > 0 ? static_cast<float>(numUnoccluded) / numSamples : 1.f, lambert, 0.f };
+							}
+						}
+					}
+				});
+		}
+	}
+}
@@ -0,0 +1,23 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+#include "Vertex.h"
+
+namespace dae
+{
+	//Bakes ambient occlusion and a static directional light into Vertex::color, ray traced against a bounding volume hierarchy of the mesh
+	namespace VertexLightBaker
+	{
+		constexpr uint32_t DefaultSampleCount{ 64 };
+		//Occlusion rays reach this fraction of the bounds diagonal, so far away parts of the mesh don't darken each other
+		constexpr float OcclusionRange{ .25f };
+
+		//Writes r: ambient occlusion, the unoccluded fraction of numSamples cosine weighted rays around the vertex normal,
+		//g: the Lambert term saturate(dot(normal, -lightDirection)) of the light at pLightDirection, zero where the light is shadowed,
+		//b: unused, zero. Without a light g is one, so a shader can multiply by it either way.
+		//Every vertex draws its samples from seed and its position, vertices on the same position with the same normal get the same result.
+		//Chunks of vertices are interleaved over numThreads threads, the result doesn't depend on numThreads.
+		void Bake(std::vector<Vertex>& vertices, const std::vector<uint32_t>& indices, const Vector3* pLightDirection = nullptr,
+			uint32_t numSamples = DefaultSampleCount, uint32_t seed = 0, size_t numThreads = 1);
+	}
+}
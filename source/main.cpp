@@ -65,6 +65,8 @@ int main(int argc, char* args[])
 					pRenderer->ToggleNormalMap();
 				if (e.key.keysym.scancode == SDL_SCANCODE_F7)
 					pRenderer->ToggleFireFX();
+				if (e.key.keysym.scancode == SDL_SCANCODE_F8)
+					pRenderer->TogglePicking();
 				break;
 			default: ;
 			}
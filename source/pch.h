@@ -7,6 +7,8 @@
 #include <memory>
 #define NOMINMAX  //for directx
 
+//Tools like the asset cooker define DAE_HEADLESS, they build without a window or a device on any platform
+#if !defined(DAE_HEADLESS)
 // SDL Headers
 #include "SDL.h"
 #include "SDL_syswm.h"
@@ -18,6 +20,7 @@
 #include <d3d11.h>
 #include <d3dcompiler.h>
 #include <d3dx11effect.h>
+#endif
 
 // Framework Headers
 #include "Timer.h"